@@ -0,0 +1,165 @@
+#!/usr/bin/env python
+# Copyright (c) 2017-2019 The WaykiChain Developers
+# Distributed under the MIT/X11 software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+# Measure the initial block download of a fresh regtest node from N local peers.
+#
+# The chain is taken from an existing regtest datadir (--chaindir, the directory
+# containing WaykiChain.conf and regtest/), copied to the N peers, then a fresh
+# node connects to all of them and the blocks/s until it reaches the height of
+# the peers is reported, for each -headersfirst mode given.
+
+# Add python-bitcoinrpc to module search path:
+import os
+import sys
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), "python-bitcoinrpc"))
+
+import shutil
+import subprocess
+import tempfile
+import time
+import traceback
+
+from bitcoinrpc.authproxy import AuthServiceProxy, JSONRPCException
+
+START_P2P_PORT=12000
+START_RPC_PORT=12100
+
+coind_processes = []
+
+def write_config(datadir, n):
+    with open(os.path.join(datadir, "WaykiChain.conf"), 'w') as f:
+        f.write("nettype=regtest\n")
+        f.write("rpcserver=1\n")
+        f.write("rpcuser=rt\n")
+        f.write("rpcpassword=rt\n")
+        f.write("rpcallowip=127.0.0.1\n")
+        f.write("port="+str(START_P2P_PORT+n)+"\n")
+        f.write("rpcport="+str(START_RPC_PORT+n)+"\n")
+        f.write("dnsseed=0\n")
+        f.write("genblock=0\n")
+
+def start_node(datadir, n, extra_args=[]):
+    args = [ "coind", "-datadir="+datadir ] + extra_args
+    coind_processes.append(subprocess.Popen(args))
+    rpc = AuthServiceProxy("http://rt:rt@127.0.0.1:%d"%(START_RPC_PORT+n,))
+    # wait for the RPC interface, which is up once the block index is loaded
+    for i in range(600):
+        try:
+            rpc.getblockcount()
+            return rpc
+        except Exception:
+            time.sleep(0.5)
+            rpc = AuthServiceProxy("http://rt:rt@127.0.0.1:%d"%(START_RPC_PORT+n,))
+    raise RuntimeError("node %d did not start"%(n,))
+
+def stop_nodes(nodes):
+    for node in nodes:
+        try:
+            node.stop()
+        except Exception:
+            pass
+    del nodes[:]
+    for process in coind_processes:
+        process.wait()
+    del coind_processes[:]
+
+def prepare_peers(chaindir, tmpdir, num_peers):
+    for i in range(num_peers):
+        datadir = os.path.join(tmpdir, "node"+str(i))
+        os.makedirs(datadir)
+        # the chain only, without the wallet, the peers and the logs of the source node
+        shutil.copytree(os.path.join(chaindir, "regtest"), os.path.join(datadir, "regtest"),
+                        ignore=shutil.ignore_patterns("wallet*", "peers.dat", "debug.log", "*.lock", "*.pid"))
+        write_config(datadir, i)
+
+def run_sync(tmpdir, num_peers, headers_first):
+    """
+    Start the peers and a fresh node connected to all of them,
+    return the height and the blocks/s of the fresh node
+    """
+    nodes = []
+    try:
+        for i in range(num_peers):
+            nodes.append(start_node(os.path.join(tmpdir, "node"+str(i)), i))
+        height = nodes[0].getblockcount()
+
+        n = num_peers
+        datadir = os.path.join(tmpdir, "node"+str(n))
+        if os.path.isdir(datadir):
+            shutil.rmtree(datadir)
+        os.makedirs(datadir)
+        write_config(datadir, n)
+        args = [ "-headersfirst=%d"%(headers_first,), "-listen=0" ]
+        args += [ "-connect=127.0.0.1:"+str(START_P2P_PORT+i) for i in range(num_peers) ]
+        fresh = start_node(datadir, n, args)
+        nodes.append(fresh)
+
+        start = time.time()
+        last_count = fresh.getblockcount()
+        last_progress = start
+        while last_count < height:
+            time.sleep(1)
+            count = fresh.getblockcount()
+            now = time.time()
+            if count > last_count:
+                last_count = count
+                last_progress = now
+            elif now - last_progress > 300:
+                raise RuntimeError("no progress at height %d of %d"%(count, height))
+        elapsed = max(time.time() - start, 0.001)
+        return height, height / elapsed
+    finally:
+        stop_nodes(nodes)
+
+def main():
+    import optparse
+
+    parser = optparse.OptionParser(usage="%prog [options]")
+    parser.add_option("--nocleanup", dest="nocleanup", default=False, action="store_true",
+                      help="Leave the test.* datadirs on exit or error")
+    parser.add_option("--srcdir", dest="srcdir", default="../../src",
+                      help="Source directory containing coind (default: %default)")
+    parser.add_option("--tmpdir", dest="tmpdir", default=tempfile.mkdtemp(prefix="test"),
+                      help="Root directory for datadirs")
+    parser.add_option("--chaindir", dest="chaindir",
+                      help="Datadir of a regtest node with the chain to sync")
+    parser.add_option("--peers", dest="peers", type="int", default=4,
+                      help="Number of peers serving the chain (default: %default)")
+    parser.add_option("--modes", dest="modes", default="0,1",
+                      help="Comma separated -headersfirst values to measure (default: %default)")
+    (options, args) = parser.parse_args()
+
+    if not options.chaindir or not os.path.isdir(os.path.join(options.chaindir, "regtest")):
+        parser.error("--chaindir must be a datadir with a regtest chain")
+
+    os.environ['PATH'] = options.srcdir+":"+os.environ['PATH']
+
+    success = False
+    try:
+        print("Initializing test directory "+options.tmpdir)
+        prepare_peers(options.chaindir, options.tmpdir, options.peers)
+
+        for mode in [ int(m) for m in options.modes.split(",") ]:
+            height, rate = run_sync(options.tmpdir, options.peers, mode)
+            print("headersfirst=%d: %d blocks from %d peers, %.1f blocks/s"%(mode, height, options.peers, rate))
+
+        success = True
+
+    except Exception as e:
+        print("Unexpected exception caught during testing: "+str(e))
+        traceback.print_tb(sys.exc_info()[2])
+
+    if not options.nocleanup:
+        print("Cleaning up")
+        shutil.rmtree(options.tmpdir)
+
+    if success:
+        sys.exit(0)
+    else:
+        print("Failed")
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -98,6 +98,7 @@ public:
     bool Cancels(const CAlert& alert) const;
     bool AppliesTo(int nVersion, string strSubVerIn) const;
     bool AppliesToMe() const;
+    // requires LOCK(cs_mapAlerts), which guards the setKnown of the nodes
     bool RelayTo(CNode* pNode) const;
     bool CheckSignature() const;
     bool ProcessAlert(bool fThread = true);
@@ -0,0 +1,137 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "logwriter.h"
+#include "commons/util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+void CLogWriter::Start(size_t queueSize) {
+    Stop();
+    if (queueSize == 0)
+        return;
+
+    if (!spQueue || spQueue->Capacity() < queueSize)
+        spQueue.reset(new CMpscRingBuffer<CLogRecord>(queueSize));
+
+    fQuit  = false;
+    thread = std::thread([this]() {
+        RenameThread("coin-logwriter");
+        Worker();
+    });
+    fRunning.store(true, std::memory_order_release);
+}
+
+void CLogWriter::Stop() {
+    if (!thread.joinable())
+        return;
+
+    // seq_cst with the pushes: a push either sees the writer stopping or is counted in nPushing below
+    fStopping.store(true);
+    fRunning.store(false);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condWorker.notify_all();
+    thread.join();
+
+    // the pushes begun while the writer was running, drained here so the ones waiting on a full queue finish
+    while (nPushing.load() > 0) {
+        Drain();
+        std::this_thread::yield();
+    }
+    Drain();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fStopping.store(false);
+    }
+    condStopped.notify_all();
+}
+
+bool CLogWriter::Push(CLogRecord &&record) {
+    nPushing++;
+    if (!fRunning.load()) {
+        nPushing--;
+        // the caller writes the record itself, after the ones still queued
+        if (fStopping.load()) {
+            std::unique_lock<std::mutex> lock(mtx);
+            condStopped.wait(lock, [this]() { return !fStopping.load(); });
+        }
+        return false;
+    }
+
+    // the record is only moved from when queued
+    if (!spQueue->TryPush(std::move(record))) {
+        nFullCount.fetch_add(1, std::memory_order_relaxed);
+        do {
+            condWorker.notify_one();
+            std::this_thread::yield();
+        } while (!spQueue->TryPush(std::move(record)));
+    }
+
+    // the writer wakes up on its own, so the logging threads rarely touch the condition variable
+    if (spQueue->Size() >= spQueue->Capacity() / 2)
+        condWorker.notify_one();
+
+    nPushing--;
+    return true;
+}
+
+void CLogWriter::GetStats(CLogWriterStats &statsOut) {
+    std::unique_lock<std::mutex> lock(mtx);
+    statsOut           = stats;
+    statsOut.fullCount = nFullCount.load(std::memory_order_relaxed);
+}
+
+void CLogWriter::Worker() {
+    while (true) {
+        size_t count = Drain();
+
+        if (fReopenDebugLog) {
+            fReopenDebugLog = false;
+            ReopenDebugLogs();
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (fQuit)
+            break;
+
+        if (count == 0)
+            condWorker.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_INTERVAL_MILLIS));
+    }
+
+    Drain();
+}
+
+size_t CLogWriter::Drain() {
+    if (!spQueue)
+        return 0;
+
+    // the files written in this batch, flushed once at the end, there are only a few of them
+    std::vector<DebugLogFile *> files;
+    CLogRecord record;
+    size_t count = 0;
+    while (spQueue->TryPop(record)) {
+        WriteLogFile(*record.pLogFile, record.nTime, record.str);
+        if (std::find(files.begin(), files.end(), record.pLogFile) == files.end())
+            files.push_back(record.pLogFile);
+
+        ++count;
+    }
+
+    for (auto pLogFile : files)
+        FlushLogFile(*pLogFile);
+
+    if (count > 0) {
+        std::unique_lock<std::mutex> lock(mtx);
+        stats.recordCount += count;
+        stats.writeCount++;
+    }
+
+    return count;
+}
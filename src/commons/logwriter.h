@@ -0,0 +1,147 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_LOGWRITER_H
+#define COIN_LOGWRITER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+struct DebugLogFile;
+
+/**
+ * A bounded queue of many producers and one consumer without locks, after the bounded queue of D. Vyukov: each cell
+ * has a sequence telling whether it is free for the producer of its position or filled for the consumer. A producer
+ * claims a position by a CAS of the enqueue position, so the producers never wait for each other to finish a push.
+ */
+template <typename T>
+class CMpscRingBuffer {
+public:
+    // the capacity is rounded up to a power of 2
+    explicit CMpscRingBuffer(size_t capacityIn) : enqueuePos(0), dequeuePos(0) {
+        size_t capacity = 2;
+        while (capacity < capacityIn)
+            capacity <<= 1;
+        mask = capacity - 1;
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const { return mask + 1; }
+    size_t Size() const {
+        return enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    /** Push the item, false if the queue is full. Any thread. */
+    bool TryPush(T &&item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell   = cells[pos & mask];
+            size_t seq   = cell.sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Pop the oldest item, false if the queue is empty. The consumer thread only. */
+    bool TryPop(T &item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = cells[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+            return false;  // empty, or the producer of the position has not finished
+
+        item = std::move(cell.data);
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    // apart from each other, the producers and the consumer do not bounce the same cache line
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+};
+
+struct CLogRecord {
+    DebugLogFile *pLogFile = nullptr;
+    int64_t nTime          = 0;  // when it was logged, for the timestamp
+    string str;
+};
+
+struct CLogWriterStats {
+    uint64_t recordCount = 0;
+    uint64_t writeCount  = 0;  // batches written, each flushed once
+    uint64_t fullCount   = 0;  // pushes that waited for the writer on a full queue
+};
+
+/**
+ * Writes the log records in a background thread. The logging threads only format the record and push it to the
+ * ring buffer; the writer drains it in batches into the buffered log files and flushes each file once per batch.
+ * When the queue is full the logging thread yields until the writer makes room, so no record is lost or reordered.
+ * Without the writer the records are written in the logging thread.
+ */
+class CLogWriter {
+public:
+    CLogWriter() : fRunning(false), fStopping(false), fQuit(false), nPushing(0), nFullCount(0) {}
+    ~CLogWriter() { Stop(); }
+
+    void Start(size_t queueSize);
+    /**
+     * Stop the thread after writing the queued records and the ones of the pushes in progress. The pushes begun
+     * meanwhile wait for it before returning false, so the records written in the logging thread come after them.
+     */
+    void Stop();
+    bool IsRunning() const { return fRunning.load(std::memory_order_acquire); }
+
+    /** Queue the record, false if the writer is not running, once the queued records are written. */
+    bool Push(CLogRecord &&record);
+
+    void GetStats(CLogWriterStats &statsOut);
+
+private:
+    void Worker();
+    // write the queued records, return the number of them
+    size_t Drain();
+
+private:
+    std::unique_ptr<CMpscRingBuffer<CLogRecord>> spQueue;
+    std::thread thread;
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::condition_variable condStopped;
+    std::atomic<bool> fRunning;
+    std::atomic<bool> fStopping;  // set before fRunning is cleared, until Stop() has written the queued records
+    bool fQuit;
+    std::atomic<uint32_t> nPushing;  // the pushes in progress, waited for by Stop() before its last drain
+    std::atomic<uint64_t> nFullCount;
+    CLogWriterStats stats;
+};
+
+#endif  // COIN_LOGWRITER_H
@@ -3,6 +3,7 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 #include "commons/util.h"
+#include "commons/logwriter.h"
 #include "config/chainparams.h"
 #include "config/configuration.h"
 #include "netbase.h"
@@ -192,6 +193,35 @@ static boost::once_flag debugPrintInitFlag = BOOST_ONCE_INIT;
 // static boost::mutex* mutexDebugLog = NULL;
 
 static map<string, DebugLogFile> g_DebugLogs;
+// set once the log files are opened, the categories may be resolved then
+static std::atomic<bool> fDebugLogsOpened(false);
+// after g_DebugLogs, destroyed before it
+static CLogWriter logWriter;
+
+CLogCategory logCategoryError("ERROR");
+
+static bool OpenLogFile(DebugLogFile& log) {
+    log.m_fileout = fopen(log.m_path.c_str(), "a");
+    if (!log.m_fileout) {
+        log.m_fileSize = 0;
+        return false;
+    }
+
+    // written in batches and flushed by the writer, or flushed on each write without it
+    setvbuf(log.m_fileout, NULL, _IOFBF, LOG_FILE_BUFFER_SIZE);
+    fseek(log.m_fileout, 0, SEEK_END);
+    long size      = ftell(log.m_fileout);
+    log.m_fileSize = size > 0 ? size : 0;
+    return true;
+}
+
+static void OpenDebugLog(const string& category) {
+    DebugLogFile& log = g_DebugLogs[category];
+    log.m_path        = (GetDataDir() / (category + ".log")).string();
+    if (OpenLogFile(log)) {
+        log.m_mutexDebugLog = new boost::mutex();
+    }
+}
 
 static void DebugPrintInit() {
     const vector<string>& categories = SysCfg().GetMultiArgs("-debug");
@@ -201,27 +231,11 @@ static void DebugPrintInit() {
     set<string> nologfiles(nocategories.begin(), nocategories.end());
 
     if (SysCfg().IsDebugAll()) {
-        logfiles.clear();
-        logfiles = nologfiles;
-        logfiles.insert("debug");
-
-        for (auto& tmp : logfiles) {
+        // the categories of -nodebug are kept without a file, so they are not logged to debug.log
+        for (auto& tmp : nologfiles) {
             g_DebugLogs[tmp];
         }
-
-        {
-            FILE* fileout = NULL;
-            boost::filesystem::path pathDebug;
-            string file = "debug.log";
-            pathDebug   = GetDataDir() / file;
-            fileout     = fopen(pathDebug.string().c_str(), "a");
-            if (fileout) {
-                DebugLogFile& log = g_DebugLogs["debug"];
-                setbuf(fileout, NULL);  // unbuffered
-                log.m_fileout       = fileout;
-                log.m_mutexDebugLog = new boost::mutex();
-            }
-        }
+        OpenDebugLog("debug");
 
     } else {
         for (auto& tmp : nologfiles) {
@@ -230,19 +244,11 @@ static void DebugPrintInit() {
         logfiles.insert("debug");
 
         for (auto& cat : logfiles) {
-            FILE* fileout = NULL;
-            boost::filesystem::path pathDebug;
-            string file = cat + ".log";
-            pathDebug   = GetDataDir() / file;
-            fileout     = fopen(pathDebug.string().c_str(), "a");
-            if (fileout) {
-                DebugLogFile& log = g_DebugLogs[cat];
-                setbuf(fileout, NULL);  // unbuffered
-                log.m_fileout       = fileout;
-                log.m_mutexDebugLog = new boost::mutex();
-            }
+            OpenDebugLog(cat);
         }
     }
+
+    fDebugLogsOpened.store(true, std::memory_order_release);
 }
 
 int LogPrintStr(const string& str) { return LogPrintStr(NULL, str); }
@@ -254,45 +260,69 @@ string GetLogHead(int line, const char* file, const char* category) {
     }
     return string("");
 }
+
 /**
- *  日志文件预处理。写日志文件前被调用，检测文件A是否超长
- *  当超长则先将原文件A重命名为Abak，再打开并创建A文件，删除重命名文件Abak，返回。
- * @param path  	文件路径
- * @param len  		写入数据的长度
- * @param stream  	文件的句柄
- * @return
+ * Write to the log file. When it would exceed -logmaxsize, it is renamed to <file>bak, replacing the previous one,
+ * and a new file is started. The size is counted on the writes, the file position is not asked for each write.
  */
-int LogFilePreProcess(const char* path, size_t len, FILE** stream) {
-    if ((NULL == path) || (len <= 0) || (NULL == *stream)) {
-        //    	assert(0);
-        return -1;
+int WriteLogFile(DebugLogFile& log, int64_t nTime, const string& str) {
+    if (log.m_mutexDebugLog == NULL)
+        return 0;
+
+    boost::mutex::scoped_lock scoped_lock(*log.m_mutexDebugLog);
+    if (log.m_fileout == NULL)
+        return 0;
+
+    string timeFormat;
+    if (SysCfg().IsLogTimestamps() && log.m_newLine)
+        timeFormat = DateTimeStrFormat("%Y-%m-%d %H:%M:%S ", nTime);
+
+    if (log.m_fileSize > 0 && log.m_fileSize + timeFormat.size() + str.size() > SysCfg().GetLogMaxSize()) {
+        fclose(log.m_fileout);
+        string bkFile = log.m_path + "bak";
+        remove(bkFile.c_str());
+        rename(log.m_path.c_str(), bkFile.c_str());
+        if (!OpenLogFile(log))
+            return 0;
     }
-    int lSize = ftell(*stream);                            // 当前文件长度
-    if (lSize + len > (size_t)SysCfg().GetLogMaxSize()) {  // 文件超长，关闭，删除，再创建
-        FILE* fileout = NULL;
-        //      cout<<"file name:" << path <<"free point:"<< static_cast<const void*>(*stream)<<
-        //      "lSize: "<< lSize << "len: " << len<<endl;
-        fclose(*stream);
-
-        string bkFile = strprintf("%sbak", path);
-        rename(path, bkFile.c_str());  // 原文件重命名
-        fileout = fopen(path, "a+");   // 重新打开， 类似于删除文件.
-        if (fileout) {
-            //		    cout << "file new:" <<static_cast<const void*>(fileout) << endl;
-            *stream = fileout;
-            if (remove(bkFile.c_str()) != 0)  // 删除重命名文件
-            {
-                //				 assert(0);
-                return -1;
-            }
-        } else {
-            //         cout<<"LogFilePreProcess create new file err"<<endl;
-            return -1;
-        }
+
+    int ret = 0;
+    if (!timeFormat.empty())
+        ret += fwrite(timeFormat.data(), 1, timeFormat.size(), log.m_fileout);
+    ret += fwrite(str.data(), 1, str.size(), log.m_fileout);
+    log.m_fileSize += ret;
+    log.m_newLine = !str.empty() && str[str.size() - 1] == '\n';
+    return ret;
+}
+
+void FlushLogFile(DebugLogFile& log) {
+    if (log.m_mutexDebugLog == NULL)
+        return;
+
+    boost::mutex::scoped_lock scoped_lock(*log.m_mutexDebugLog);
+    if (log.m_fileout)
+        fflush(log.m_fileout);
+}
+
+void ReopenDebugLogs() {
+    if (!fDebugLogsOpened.load(std::memory_order_acquire))
+        return;
+
+    for (auto& item : g_DebugLogs) {
+        DebugLogFile& log = item.second;
+        if (log.m_mutexDebugLog == NULL)
+            continue;
+
+        boost::mutex::scoped_lock scoped_lock(*log.m_mutexDebugLog);
+        if (log.m_fileout)
+            fclose(log.m_fileout);
+        OpenLogFile(log);
     }
-    return 1;
 }
 
+void StartLogWriter(size_t queueSize) { logWriter.Start(queueSize); }
+
+void StopLogWriter() { logWriter.Stop(); }
 
 bool FindLogFile(const char* category, DebugLogFileIt &logFileIt) {
 
@@ -307,7 +337,8 @@ bool FindLogFile(const char* category, DebugLogFileIt &logFileIt) {
         if (NULL != category) {
             logFileIt = g_DebugLogs.find(category);
             if (logFileIt != g_DebugLogs.end()) {
-                return true;
+                // a category of -nodebug
+                return logFileIt->second.m_mutexDebugLog != NULL;
             }
         }
         logFileIt = g_DebugLogs.find("debug");
@@ -318,7 +349,23 @@ bool FindLogFile(const char* category, DebugLogFileIt &logFileIt) {
     }
 }
 
-int LogPrintStr(const std::string &logName, DebugLogFile &logFile, const string& str) {
+bool LogAcceptCategory(const char* category) {
+    DebugLogFileIt it;
+    return FindLogFile(category, it);
+}
+
+DebugLogEntry* CLogCategory::Resolve() {
+    DebugLogFileIt it;
+    DebugLogEntry* pEntry = FindLogFile(category, it) ? &*it : nullptr;
+    // before the config is read the categories are not known yet, they are looked up again
+    if (fDebugLogsOpened.load(std::memory_order_acquire)) {
+        pLogEntry.store(pEntry, std::memory_order_relaxed);
+        fResolved.store(true, std::memory_order_release);
+    }
+    return pEntry;
+}
+
+int LogPrintStr(const std::string &logName, DebugLogFile &logFile, string str) {
 
     if (!SysCfg().IsDebug()) {
         return 0;
@@ -333,28 +380,20 @@ int LogPrintStr(const std::string &logName, DebugLogFile &logFile, const string&
         ret = fwrite(str.data(), 1, str.size(), stdout);
     }
     if (SysCfg().IsPrintLogToFile()) {
-        DebugLogFile& log = logFile;
-        boost::mutex::scoped_lock scoped_lock(*log.m_mutexDebugLog);
-
-        boost::filesystem::path pathDebug;
-        string file = logName + ".log";   //  it->first.c_str() = "INFO"
-        pathDebug   = GetDataDir() / file;  // /home/share/bille/Coin_test/regtest/INFO.log
-        // Debug print useful for profiling
-        if (SysCfg().IsLogTimestamps() && log.m_newLine) {
-            string timeFormat = DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime());
-            LogFilePreProcess(pathDebug.string().c_str(), timeFormat.length() + 1 + str.size(),
-                              &log.m_fileout);
-            ret += fprintf(log.m_fileout, "%s ", timeFormat.c_str());
-            //			ret += fprintf(log.m_fileout, "%s ", DateTimeStrFormat("%Y-%m-%d %H:%M:%S",
-            //GetTime()).c_str());
-        }
-        if (!str.empty() && str[str.size() - 1] == '\n') {
-            log.m_newLine = true;
-        } else {
-            log.m_newLine = false;
+        CLogRecord record;
+        record.pLogFile = &logFile;
+        record.nTime    = GetTime();
+        record.str      = std::move(str);
+        ret             = record.str.size();
+        if (logWriter.Push(std::move(record)))
+            return ret;
+
+        if (fReopenDebugLog) {
+            fReopenDebugLog = false;
+            ReopenDebugLogs();
         }
-        LogFilePreProcess(pathDebug.string().c_str(), str.size(), &log.m_fileout);
-        ret = fwrite(str.data(), 1, str.size(), log.m_fileout);
+        ret = WriteLogFile(logFile, record.nTime, record.str);
+        FlushLogFile(logFile);
     }
     return ret;
 }
@@ -17,6 +17,7 @@
 
 #include <stdarg.h>
 #include <stdint.h>
+#include <atomic>
 #include <cstdio>
 #include <exception>
 #include <map>
@@ -87,7 +88,7 @@ inline void MilliSleep(int64_t n) {
 }
 
 struct DebugLogFile {
-    DebugLogFile() : m_newLine(true), m_fileout(NULL), m_mutexDebugLog(NULL) {}
+    DebugLogFile() : m_newLine(true), m_fileout(NULL), m_fileSize(0), m_mutexDebugLog(NULL) {}
     ~DebugLogFile() {
         if (m_fileout) {
             fclose(m_fileout);
@@ -98,12 +99,40 @@ struct DebugLogFile {
             m_mutexDebugLog = NULL;
         }
     }
+    string m_path;
     bool m_newLine;
     FILE* m_fileout;
+    uint64_t m_fileSize;  // counted on the writes, for the rotation
     boost::mutex* m_mutexDebugLog;
 };
 
 typedef map<string, DebugLogFile>::iterator DebugLogFileIt;
+typedef map<string, DebugLogFile>::value_type DebugLogEntry;
+
+/**
+ * The log file of a category, resolved once the log files are opened. Kept by each call site of LogPrint, so a
+ * category which is off costs a load and a branch, and the arguments of the log are not formatted.
+ */
+class CLogCategory {
+public:
+    constexpr explicit CLogCategory(const char* categoryIn)
+        : category(categoryIn), pLogEntry(nullptr), fResolved(false) {}
+
+    // nullptr if the category is off
+    DebugLogEntry* Get() {
+        if (fResolved.load(std::memory_order_acquire))
+            return pLogEntry.load(std::memory_order_relaxed);
+        return Resolve();
+    }
+
+private:
+    DebugLogEntry* Resolve();
+
+private:
+    const char* category;
+    std::atomic<DebugLogEntry*> pLogEntry;
+    std::atomic<bool> fResolved;
+};
 
 extern string strMiscWarning;
 extern bool fNoListen;
@@ -124,20 +153,38 @@ int LogPrintStr(const string& str);
 extern string GetLogHead(int line, const char* file, const char* category);
 int LogPrintStr(const char* category, const string& str);
 
-int LogPrintStr(const std::string& logName, DebugLogFile& logFile, const string& str);
+int LogPrintStr(const std::string& logName, DebugLogFile& logFile, string str);
+
+/* Write to the log file, rotating it above -logmaxsize. Used by the log writer thread and without it */
+int WriteLogFile(DebugLogFile& logFile, int64_t nTime, const string& str);
+void FlushLogFile(DebugLogFile& logFile);
+/* Reopen the log files, e.g. after they were moved on SIGHUP */
+void ReopenDebugLogs();
+/* Write the log files in a background thread through a queue of queueSize records */
+void StartLogWriter(size_t queueSize);
+void StopLogWriter();
+
+extern CLogCategory logCategoryError;
 
 #define strprintf tfm::format
 
 #define ERRORMSG(...) error2(__LINE__, __FILE__, __VA_ARGS__)
 
-#define LogPrint(tag, ...)                                                                           \
-    {                                                                                                \
-        DebugLogFileIt __logFileIt;                                                                  \
-        if (FindLogFile(tag, __logFileIt)) {                                                         \
-            LogTrace(tag, __logFileIt->first, __logFileIt->second, __LINE__, __FILE__, __VA_ARGS__); \
-        }                                                                                            \
+#define LogPrint(tag, ...)                                                                                   \
+    {                                                                                                        \
+        static CLogCategory __logCategory(tag);                                                              \
+        if (DebugLogEntry* __pLogEntry = __logCategory.Get()) {                                              \
+            LogTrace(tag, __pLogEntry->first, __pLogEntry->second, __LINE__, __FILE__, __VA_ARGS__);         \
+        }                                                                                                    \
     }
 
+/* Whether the category is on, to skip the debug loops around LogPrint. Resolved once per call site */
+#define LOG_CATEGORY_ENABLED(tag)                   \
+    ([]() -> bool {                                 \
+        static CLogCategory __logCategory(tag);     \
+        return __logCategory.Get() != nullptr;      \
+    }())
+
 #define MAKE_ERROR_AND_TRACE_FUNC(n)                                                                                 \
     /*   Print to debug.log if -debug=category switch is given OR category is NULL. */                               \
     template <TINYFORMAT_ARGTYPES(n)>                                                                                \
@@ -146,10 +193,12 @@ int LogPrintStr(const std::string& logName, DebugLogFile& logFile, const string&
         return LogPrintStr(logName, logFile,                                                                         \
                            GetLogHead(line, file, category) + tfm::format(format, TINYFORMAT_PASSARGS(n)));          \
     }                                                                                                                \
-    /*   Log error and return false */                                                                               \
+    /*   Log error and return false, the message is only formatted if the ERROR category is on */                   \
     template <TINYFORMAT_ARGTYPES(n)>                                                                                \
     static inline bool error2(int line, const char* file, const char* format1, TINYFORMAT_VARARGS(n)) {              \
-        LogPrintStr("ERROR", GetLogHead(line, file, "ERROR") + tfm::format(format1, TINYFORMAT_PASSARGS(n)) + "\n"); \
+        if (DebugLogEntry* pLogEntry = logCategoryError.Get())                                                       \
+            LogPrintStr(pLogEntry->first, pLogEntry->second,                                                         \
+                        GetLogHead(line, file, "ERROR") + tfm::format(format1, TINYFORMAT_PASSARGS(n)) + "\n");      \
         return false;                                                                                                \
     }
 
@@ -157,7 +206,8 @@ TINYFORMAT_FOREACH_ARGNUM(MAKE_ERROR_AND_TRACE_FUNC)
 
 static inline bool error2(int line, const char* file, const char* format) {
     //	LogPrintStr(tfm::format("[%s:%d]: ", file, line)+string("ERROR: ") + format + "\n");
-    LogPrintStr("ERROR", GetLogHead(line, file, "ERROR") + format + "\n");
+    if (DebugLogEntry* pLogEntry = logCategoryError.Get())
+        LogPrintStr(pLogEntry->first, pLogEntry->second, GetLogHead(line, file, "ERROR") + format + "\n");
     return false;
 }
 
@@ -40,6 +40,7 @@ public:
         nBlockIntervalStableCoinRelease    = BLOCK_INTERVAL_STABLE_COIN_RELEASE;
         nFeatureForkHeight                 = IniCfg().GetFeatureForkHeight(MAIN_NET);
         nStableCoinGenesisHeight           = IniCfg().GetStableCoinGenesisHeight(MAIN_NET);
+        nFeatureForkV3Height               = IniCfg().GetFeatureForkV3Height(MAIN_NET);
         assert(CreateGenesisBlockRewardTx(genesis.vptx, MAIN_NET));
         assert(CreateGenesisDelegateTx(genesis.vptx, MAIN_NET));
         genesis.SetPrevBlockHash(uint256());
@@ -137,6 +138,8 @@ public:
         nStableCoinGenesisHeight = GetArg("-stablecoingenesisheight", IniCfg().GetStableCoinGenesisHeight(TEST_NET));
         nFeatureForkHeight =
             std::max((int64_t)nStableCoinGenesisHeight + 1, GetArg("-featureforkheight", IniCfg().GetFeatureForkHeight(TEST_NET)));
+        nFeatureForkV3Height =
+            std::max((int64_t)nFeatureForkHeight + 1, GetArg("-featureforkv3height", IniCfg().GetFeatureForkV3Height(TEST_NET)));
         fServer = true;
 
         return true;
@@ -156,6 +159,7 @@ public:
         strDataDir               = "regtest";
         nFeatureForkHeight       = IniCfg().GetFeatureForkHeight(REGTEST_NET);
         nStableCoinGenesisHeight = IniCfg().GetStableCoinGenesisHeight(REGTEST_NET);
+        nFeatureForkV3Height     = IniCfg().GetFeatureForkV3Height(REGTEST_NET);
         genesis.SetTime(IniCfg().GetStartTimeInit(REGTEST_NET));
         genesis.SetNonce(68);
         genesis.vptx.clear();
@@ -182,6 +186,8 @@ public:
         nStableCoinGenesisHeight = GetArg("-stablecoingenesisheight", IniCfg().GetStableCoinGenesisHeight(REGTEST_NET));
         nFeatureForkHeight =
             std::max((int64_t)nStableCoinGenesisHeight + 1, GetArg("-featureforkheight", IniCfg().GetFeatureForkHeight(REGTEST_NET)));
+        nFeatureForkV3Height =
+            std::max((int64_t)nFeatureForkHeight + 1, GetArg("-featureforkv3height", IniCfg().GetFeatureForkV3Height(REGTEST_NET)));
         fServer = true;
 
         return true;
@@ -430,11 +436,13 @@ CBaseParams::CBaseParams() {
     fReindex                = false;
     fBenchmark              = false;
     fTxIndex                = false;
+    fAddressIndex           = false;
     fLogFailures            = false;
     nLogMaxSize             = 100 * 1024 * 1024;  // 100M
     nTxCacheHeight          = 500;
     nTimeBestReceived       = 0;
     nViewCacheSize          = 2000000;
+    nFlushBlockInterval     = DEFAULT_FLUSH_BLOCK_INTERVAL;
     payTxFee                = 10000;
     nDefaultPort            = 0;
     fPrintLogToConsole      = 0;
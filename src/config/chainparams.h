@@ -68,10 +68,12 @@ protected:
     mutable bool fReindex;
     mutable bool fBenchmark;
     mutable bool fTxIndex;
+    mutable bool fAddressIndex;
     mutable bool fLogFailures;
     mutable int64_t nTimeBestReceived;
     mutable uint64_t payTxFee;
     mutable uint32_t nViewCacheSize;
+    mutable int32_t nFlushBlockInterval;
     mutable int32_t nTxCacheHeight;
     mutable uint32_t nLogMaxSize;  // to limit the maximum log file size in bytes
 
@@ -121,12 +123,14 @@ public:
         te += strprintf("fReindex:%d\n",                            fReindex);
         te += strprintf("fBenchmark:%d\n",                          fBenchmark);
         te += strprintf("fTxIndex:%d\n",                            fTxIndex);
+        te += strprintf("fAddressIndex:%d\n",                       fAddressIndex);
         te += strprintf("fLogFailures:%d\n",                        fLogFailures);
         te += strprintf("nTimeBestReceived:%llu\n",                 nTimeBestReceived);
         te += strprintf("paytxfee:%llu\n",                          payTxFee);
         te += strprintf("nBlockIntervalPreStableCoinRelease:%u\n",  nBlockIntervalPreStableCoinRelease);
         te += strprintf("nBlockIntervalStableCoinRelease:%u\n",     nBlockIntervalStableCoinRelease);
         te += strprintf("nViewCacheSize:%u\n",                      nViewCacheSize);
+        te += strprintf("nFlushBlockInterval:%d\n",                 nFlushBlockInterval);
         te += strprintf("nTxCacheHeight:%u\n",                      nTxCacheHeight);
         te += strprintf("nLogMaxSize:%u\n",                         nLogMaxSize);
 
@@ -181,18 +185,22 @@ public:
     bool IsReindex() const { return fReindex; }
     bool IsBenchmark() const { return fBenchmark; }
     bool IsTxIndex() const { return fTxIndex; }
+    bool IsAddressIndex() const { return fAddressIndex; }
     bool IsLogFailures() const { return fLogFailures; };
     int64_t GetBestRecvTime() const { return nTimeBestReceived; }
     uint32_t GetViewCacheSize() const { return nViewCacheSize; }
+    int32_t GetFlushBlockInterval() const { return nFlushBlockInterval; }
     int32_t GetTxCacheHeight() const { return nTxCacheHeight; }
     uint32_t GetLogMaxSize() const { return nLogMaxSize; }
     void SetImporting(bool flag) const { fImporting = flag; }
     void SetReIndex(bool flag) const { fReindex = flag; }
     void SetBenchMark(bool flag) const { fBenchmark = flag; }
     void SetTxIndex(bool flag) const { fTxIndex = flag; }
+    void SetAddressIndex(bool flag) const { fAddressIndex = flag; }
     void SetLogFailures(bool flag) const { fLogFailures = flag; }
     void SetBestRecvTime(int64_t nTime) const { nTimeBestReceived = nTime; }
     void SetViewCacheSize(uint32_t nSize) const { nViewCacheSize = nSize; }
+    void SetFlushBlockInterval(int32_t nInterval) const { nFlushBlockInterval = nInterval; }
     void SetTxCacheHeight(int32_t height) const { nTxCacheHeight = height; }
     const MessageStartChars& MessageStart() const { return pchMessageStart; }
     const vector<uint8_t>& AlertKey() const { return vAlertPubKey; }
@@ -201,6 +209,7 @@ public:
     uint32_t GetBlockIntervalStableCoinRelease() const { return nBlockIntervalStableCoinRelease; }
     uint32_t GetFeatureForkHeight() const { return nFeatureForkHeight; }
     uint32_t GetStableCoinGenesisHeight() const { return nStableCoinGenesisHeight; }
+    uint32_t GetFeatureForkV3Height() const { return nFeatureForkV3Height; }
     CRegID GetFcoinGenesisRegId() const { return CRegID(nStableCoinGenesisHeight, kFcoinGenesisIssueTxIndex); }
     CRegID GetDexMatchSvcRegId() const    { return CRegID(nStableCoinGenesisHeight, kDexMatchSvcRegisterTxIndex); }
     virtual uint64_t GetMaxFee() const { return 1000 * COIN; }
@@ -251,6 +260,7 @@ protected:
     string alartPKey;
     uint32_t nStableCoinGenesisHeight;
     uint32_t nFeatureForkHeight;
+    uint32_t nFeatureForkV3Height;
     uint32_t nBlockIntervalPreStableCoinRelease;
     uint32_t nBlockIntervalStableCoinRelease;
     string strDataDir;
@@ -129,6 +129,17 @@ uint32_t G_CONFIG_TABLE::GetFeatureForkHeight(const NET_TYPE type) const {
     return 0;
 }
 
+uint32_t G_CONFIG_TABLE::GetFeatureForkV3Height(const NET_TYPE type) const {
+    switch (type) {
+        case MAIN_NET: return nFeatureForkV3Height_mainNet;
+        case TEST_NET: return nFeatureForkV3Height_testNet;
+        case REGTEST_NET: return nFeatureForkV3Height_regtestNet;
+        default: assert(0);
+    }
+
+    return 0;
+}
+
 uint32_t G_CONFIG_TABLE::GetStableCoinGenesisHeight(const NET_TYPE type) const {
    switch (type) {
         case MAIN_NET: return nStableScoinGenesisHeight_mainNet;
@@ -349,3 +360,8 @@ uint32_t G_CONFIG_TABLE::nFeatureForkHeight_regtestNet = 10;
 uint32_t G_CONFIG_TABLE::nStableScoinGenesisHeight_mainNet     = 5880000;
 uint32_t G_CONFIG_TABLE::nStableScoinGenesisHeight_testNet     = 500;
 uint32_t G_CONFIG_TABLE::nStableScoinGenesisHeight_regtestNet  = 8;
+
+// Block height to enable the consensus changes after the stable coin release, not scheduled yet on main and test net
+uint32_t G_CONFIG_TABLE::nFeatureForkV3Height_mainNet    = INT32_MAX;
+uint32_t G_CONFIG_TABLE::nFeatureForkV3Height_testNet    = INT32_MAX;
+uint32_t G_CONFIG_TABLE::nFeatureForkV3Height_regtestNet = 20;
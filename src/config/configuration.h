@@ -49,6 +49,7 @@ public:
     uint64_t GetCoinInitValue() const { return InitialCoin; };
 	uint32_t GetFeatureForkHeight(const NET_TYPE type) const;
     uint32_t GetStableCoinGenesisHeight(const NET_TYPE type) const;
+    uint32_t GetFeatureForkV3Height(const NET_TYPE type) const;
     const vector<string> GetStableCoinGenesisTxid(const NET_TYPE type) const;
 
 private:
@@ -147,6 +148,11 @@ private:
     static uint32_t nStableScoinGenesisHeight_mainNet;
     static uint32_t nStableScoinGenesisHeight_testNet;
     static uint32_t nStableScoinGenesisHeight_regtestNet;
+
+    /* Block height to enable the consensus changes after the stable coin release */
+    static uint32_t nFeatureForkV3Height_mainNet;
+    static uint32_t nFeatureForkV3Height_testNet;
+    static uint32_t nFeatureForkV3Height_regtestNet;
 };
 
 inline FeatureForkVersionEnum GetFeatureForkVersion(const int32_t currBlockHeight) {
@@ -156,6 +162,11 @@ inline FeatureForkVersionEnum GetFeatureForkVersion(const int32_t currBlockHeigh
         return MAJOR_VER_R1;
 }
 
+// whether the consensus changes scheduled after the stable coin release are enabled at the height
+inline bool IsFeatureForkV3(const int32_t currBlockHeight) {
+    return currBlockHeight >= (int32_t)SysCfg().GetFeatureForkV3Height();
+}
+
 inline uint32_t GetBlockInterval(const int32_t currBlockHeight) {
     FeatureForkVersionEnum featureForkVersion = GetFeatureForkVersion(currBlockHeight);
     switch (featureForkVersion) {
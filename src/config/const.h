@@ -107,6 +107,24 @@ static const uint32_t MAX_ORPHAN_BLOCKS = 750;
 static const int32_t MAX_BLOCKS_IN_TRANSIT_PER_PEER = 128;
 /** Timeout in seconds before considering a block download peer unresponsive. */
 static const uint32_t BLOCK_DOWNLOAD_TIMEOUT  = 60;
+/** -headersfirst default, sync the headers from one peer and the blocks from all the peers */
+static const bool DEFAULT_HEADERS_FIRST = true;
+/** Maximum number of headers in a headers message */
+static const int32_t MAX_HEADERS_RESULTS = 2000;
+/** Maximum number of headers synced ahead of the active chain tip */
+static const int32_t MAX_HEADERS_AHEAD = 50000;
+/** The blocks above the tip downloaded in parallel, kept as orphans until connected, below MAX_ORPHAN_BLOCKS */
+static const int32_t BLOCK_DOWNLOAD_WINDOW = 512;
+/** Number of blocks of the download window that can be requested at any given time from a single peer */
+static const int32_t MAX_WINDOW_BLOCKS_IN_TRANSIT_PER_PEER = 32;
+/** Timeout in seconds of the block next to the tip, holding up the validation of the download window */
+static const int64_t BLOCK_STALLING_TIMEOUT = 5;
+/** -compactblocks default, relay the new blocks as compact blocks to the peers asking for them */
+static const bool DEFAULT_COMPACT_BLOCKS = true;
+/** Version of the compact block messages announced by sendcmpct */
+static const uint64_t COMPACT_BLOCKS_VERSION = 1;
+/** Lower bound of the serialized tx size, to bound the tx count of a compact block */
+static const uint32_t MIN_COMPACT_BLOCK_TX_SIZE = 10;
 
 /** Minimum disk space required */
 static const uint64_t MIN_DISK_SPACE = 52428800;
@@ -122,6 +140,42 @@ static const int64_t DEFAULT_DB_CACHE = 100;
 static const int64_t MAX_DB_CACHE = sizeof(void *) > 4 ? 4096 : 1024;
 /** min. -dbcache in (MiB) */
 static const int64_t MIN_DB_CACHE = 4;
+/** -maxmempool default (MiB), the total size of transactions kept in mempool */
+static const int64_t DEFAULT_MAX_MEMPOOL_SIZE = 300;
+/** The full mempool is trimmed down to this percent of -maxmempool, then its cache is rebuilt once */
+static const uint64_t MEMPOOL_TRIM_LOW_WATER_PERCENT = 90;
+/** Maximum number of signature verification threads (-par) */
+static const int32_t MAX_SIGCHECK_THREADS = 16;
+/** -par default (number of signature verification threads, 0 = auto) */
+static const int32_t DEFAULT_SIGCHECK_THREADS = 0;
+/** Maximum number of tx admission precheck threads (-txadmissionthreads) */
+static const int32_t MAX_TX_ADMISSION_THREADS = 16;
+/** -txadmissionthreads default (0 = admit txs from network in the message handler thread) */
+static const int32_t DEFAULT_TX_ADMISSION_THREADS = 2;
+/** Maximum number of p2p message handler threads (-msghandlerthreads) */
+static const int32_t MAX_MESSAGE_HANDLER_THREADS = 16;
+/** -msghandlerthreads default, the messages of a peer are always handled in order by one thread at a time */
+static const int32_t DEFAULT_MESSAGE_HANDLER_THREADS = 4;
+/** Maximum number of txs waiting for admission before falling back to the message handler thread */
+static const uint32_t MAX_TX_ADMISSION_QUEUE_SIZE = 10000;
+/** -flushblocks default, the number of blocks connected or disconnected between chain state flushes */
+static const int32_t DEFAULT_FLUSH_BLOCK_INTERVAL = 10;
+/** Maximum seconds between chain state flushes */
+static const int64_t MAX_FLUSH_INTERVAL_SECONDS = 60;
+/** -forkstatecache default (MiB), the memory of the states kept for validating the forked chains */
+static const int64_t DEFAULT_FORK_STATE_CACHE_SIZE = 64;
+/** The states of the forked chains further than this number of blocks below the tip are dropped */
+static const int32_t MAX_FORK_STATE_DEPTH = 100;
+/** The memory of a node of the cache maps and sets besides its data, i.e. the links and the allocation header */
+static const uint32_t CACHE_NODE_OVERHEAD = 48;
+/** -logqueuesize default, the number of log records queued for the log writer thread (0 = write in the caller) */
+static const int32_t DEFAULT_LOG_QUEUE_SIZE = 16384;
+/** Milliseconds the log writer thread sleeps when there is nothing to write */
+static const int64_t LOG_WRITER_INTERVAL_MILLIS = 50;
+/** Bytes buffered by each log file between the flushes */
+static const size_t LOG_FILE_BUFFER_SIZE = 64 * 1024;
+/** -luavmcache default, the number of contracts whose compiled code is cached (0 = no cache) */
+static const int32_t DEFAULT_LUAVM_CACHE_SIZE = 256;
 
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int32_t BLOCK_REWARD_MATURITY = 100;
@@ -5,6 +5,7 @@
 
 #include "contract.h"
 #include "config/const.h"
+#include "config/configuration.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // class CLuaContract
@@ -22,8 +23,16 @@ bool CLuaContract::IsValid() {
     return true;
 }
 
-bool CUniversalContract::IsValid() {
-    if (vm_type == VMType::LUA_VM) {
+bool CUniversalContract::IsLuaVM(const int32_t height) const {
+    return vm_type == VMType::LUA_VM || IsStrArguments(height);
+}
+
+bool CUniversalContract::IsStrArguments(const int32_t height) const {
+    return vm_type == VMType::LUA_VM_STR && IsFeatureForkV3(height);
+}
+
+bool CUniversalContract::IsValid(const int32_t height) {
+    if (IsLuaVM(height)) {
         if (code.compare(0, LUA_CONTRACT_HEADLINE.size(), LUA_CONTRACT_HEADLINE))
             return false;  // lua script shebang existing verified
     }
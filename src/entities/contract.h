@@ -66,7 +66,8 @@ enum VMType : uint8_t {
     NULL_VM     = 0,
     LUA_VM      = 1,
     WASM_VM     = 2,
-    EVM         = 3
+    EVM         = 3,
+    LUA_VM_STR  = 4     //!< lua vm passing the contract arguments as one string instead of a byte table
 };
 
 /**
@@ -100,6 +101,11 @@ public:
 public:
     inline uint32_t GetContractSize() const { return GetSerializeSize(SER_DISK, CLIENT_VERSION); }
 
+    // LUA_VM_STR is a lua vm since the feature fork v3, before it the contract is run as the other vm types
+    bool IsLuaVM(const int32_t height) const;
+    // whether the arguments are passed to the contract as one string
+    bool IsStrArguments(const int32_t height) const;
+
     bool IsEmpty() const { return vm_type == VMType::NULL_VM && code.empty() && memo.empty() && abi.empty(); }
 
     void SetEmpty() {
@@ -117,7 +123,7 @@ public:
         READWRITE(abi);
     )
 
-    bool IsValid();
+    bool IsValid(const int32_t height);
 };
 
 #endif  // ENTITIES_CONTRACT_H
\ No newline at end of file
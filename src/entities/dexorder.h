@@ -158,6 +158,48 @@ struct CDEXActiveOrder {
     }
 };
 
+enum OrderBookAction: uint8_t {
+    ORDER_BOOK_NONE     = 0,
+    ORDER_BOOK_PUT      = 1, //!< order created or partly dealt, put into the book with the new state
+    ORDER_BOOK_ERASE    = 2  //!< order fulfilled or canceled, erased from the book
+};
+
+static const EnumTypeMap<OrderBookAction, string> ORDER_BOOK_ACTION_NAMES = {
+    {ORDER_BOOK_NONE, "NONE"}, {ORDER_BOOK_PUT, "PUT"}, {ORDER_BOOK_ERASE, "ERASE"}
+};
+
+inline const string &GetOrderBookActionName(OrderBookAction action) {
+    auto it = ORDER_BOOK_ACTION_NAMES.find(action);
+    if (it != ORDER_BOOK_ACTION_NAMES.end())
+        return it->second;
+    return EMPTY_STRING;
+}
+
+// for the order book change db: {height, orderId} -> the last change of the order in the block
+struct CDEXOrderBookChange {
+    OrderBookAction action  = ORDER_BOOK_NONE;  //!< action on the book
+    CDEXOrderDetail order   = CDEXOrderDetail();//!< order state after the change, the last state when erased
+
+    CDEXOrderBookChange() {}
+
+    CDEXOrderBookChange(OrderBookAction actionIn, const CDEXOrderDetail &orderIn):
+        action(actionIn), order(orderIn)
+    {}
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE((uint8_t&)action);
+        READWRITE(order);
+    )
+
+    bool IsEmpty() const {
+        return action == ORDER_BOOK_NONE;
+    }
+    void SetEmpty() {
+        action = ORDER_BOOK_NONE;
+        order.SetEmpty();
+    }
+};
+
 // order txid -> sys order data
 // order txid:
 //   (1) CCDPStakeTx, create sys buy market order for WGRT by WUSD when alter CDP and the interest is WUSD
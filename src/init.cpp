@@ -14,6 +14,7 @@
 
 #include "rpc/core/rpcserver.h"
 #include "vm/luavm/lua/lua.h"
+#include "vm/luavm/luavmcache.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include "main.h"
@@ -23,7 +24,12 @@
 #include "persistence/accountdb.h"
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
+#include "persistence/memcachedb.h"
+#include "persistence/forkstate.h"
 #include "tx/tx.h"
+#include "p2p/compactblock.h"
+#include "p2p/headerssync.h"
+#include "tx/txadmission.h"
 #include "commons/util.h"
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
@@ -136,6 +142,8 @@ void Shutdown() {
 
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
+    txAdmissionQueue.Stop();
+    sigCheckQueue.Stop();
 
     {
         LOCK(cs_main);
@@ -147,6 +155,16 @@ void Shutdown() {
 
         if (pCdMan != nullptr) {
             pCdMan->Flush();
+            if (chainActive.Tip()) {
+                int64_t nStart       = GetTimeMillis();
+                uint64_t slideWindow = 0;
+                pCdMan->pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+                if (CMemCacheDB().Write(chainActive.Tip()->GetBlockHash(), SysCfg().GetTxCacheHeight(), slideWindow,
+                                        *pCdMan->pTxCache, *pCdMan->pPpCache))
+                    LogPrint("INFO", "Saved transaction and price point memory caches to memcache.dat (%dms)\n",
+                             GetTimeMillis() - nStart);
+            }
+            forkStates.Clear();
             delete pCdMan;
             pCdMan = nullptr;
         }
@@ -163,6 +181,7 @@ void Shutdown() {
     ECC_Stop();
 
     LogPrint("INFO", "Shutdown() : done\n");
+    StopLogWriter();
     printf("Shutdown : done\n");
 }
 
@@ -212,12 +231,20 @@ string HelpMessage() {
     strUsage += "  -daemon                " + _("Run in the background as a daemon and accept commands") + "\n";
 #endif
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
+    strUsage += "  -maxmempool=<n>        " + strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %d)"), DEFAULT_MAX_MEMPOOL_SIZE) + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -flushblocks=<n>       " + strprintf(_("Flush the chain state to disk every <n> blocks (default: %d)"), DEFAULT_FLUSH_BLOCK_INTERVAL) + "\n";
+    strUsage += "  -flushcache=<n>        " + _("Flush the chain state to disk when its caches exceed <n> megabytes (default: derived from -dbcache)") + "\n";
+    strUsage += "  -forkstatecache=<n>    " + strprintf(_("Keep the states for validating the forked chains below <n> megabytes (default: %d)"), DEFAULT_FORK_STATE_CACHE_SIZE) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
     strUsage += "  -txindex               " + _("Maintain a full transaction index (default: 0)") + "\n";
+    strUsage += "  -addressindex          " + _("Maintain an address to transaction index, used by getaddresstxs (default: 0)") + "\n";
     strUsage += "  -logfailures           " + _("Log failures into level db in detail (default: 0)") + "\n";
+    strUsage += "  -par=<n>               " + strprintf(_("Set the number of signature verification threads (%d to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int32_t)boost::thread::hardware_concurrency(), MAX_SIGCHECK_THREADS, DEFAULT_SIGCHECK_THREADS) + "\n";
+    strUsage += "  -luavmcache=<n>        " + strprintf(_("Cache the compiled code of up to <n> lua contracts (0 = off, default: %d)"), DEFAULT_LUAVM_CACHE_SIZE) + "\n";
+    strUsage += "  -txadmissionthreads=<n> " + strprintf(_("Set the number of threads checking transactions from network before mempool admission (0 to %d, 0 = none, default: %d)"), MAX_TX_ADMISSION_THREADS, DEFAULT_TX_ADMISSION_THREADS) + "\n";
 
     strUsage += "\n" + _("Connection options:") + "\n";
     strUsage += "  -addnode=<ip>          " + _("Add a node to connect to and attempt to keep the connection open") + "\n";
@@ -233,6 +260,9 @@ string HelpMessage() {
     strUsage += "  -listen                " + _("Accept connections from outside (default: 1 if no -proxy or -connect)") + "\n";
     strUsage += "  -maxconnections=<n>    " + _("Maintain at most <n> connections to peers (default: 125)") + "\n";
     strUsage += "  -maxreceivebuffer=<n>  " + _("Maximum per-connection receive buffer, <n>*1000 bytes (default: 5000)") + "\n";
+    strUsage += "  -compactblocks         " + strprintf(_("Relay the new blocks as compact blocks to the peers asking for them, and ask the peers for them (default: %u)"), DEFAULT_COMPACT_BLOCKS) + "\n";
+    strUsage += "  -headersfirst          " + strprintf(_("Sync the headers from one peer first, then the blocks from all the peers in parallel (default: %u)"), DEFAULT_HEADERS_FIRST) + "\n";
+    strUsage += "  -msghandlerthreads=<n> " + strprintf(_("Set the number of threads handling the messages of the peers (1 to %d, default: %d)"), MAX_MESSAGE_HANDLER_THREADS, DEFAULT_MESSAGE_HANDLER_THREADS) + "\n";
     strUsage += "  -maxsendbuffer=<n>     " + _("Maximum per-connection send buffer, <n>*1000 bytes (default: 1000)") + "\n";
     strUsage += "  -onion=<ip:port>       " + _("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: -proxy)") + "\n";
     strUsage += "  -onlynet=<net>         " + _("Only connect to nodes in network <net> (IPv4, IPv6 or Tor)") + "\n";
@@ -281,6 +311,8 @@ string HelpMessage() {
     strUsage += " addrman, alert, coindb, db, lock, rand, rpc, selectcoins, mempool, net";
     strUsage += "  -help-debug            " + _("Show all debugging options (usage: --help -help-debug)") + "\n";
     strUsage += "  -logtimestamps         " + _("Prepend debug output with timestamp (default: 1)") + "\n";
+    strUsage += "  -logmaxsize=<n>        " + _("Move a log file aside to <file>bak when it exceeds <n> megabytes (default: 100)") + "\n";
+    strUsage += "  -logqueuesize=<n>      " + strprintf(_("Write the logs in a background thread through a queue of <n> records, 0 to write them in the logging thread (default: %d)"), DEFAULT_LOG_QUEUE_SIZE) + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
         strUsage += "  -limitfreerelay=<n>    " + _("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:15)") + "\n";
         strUsage += "  -maxsigcachesize=<n>   " + _("Limit size of signature cache to <n> entries (default: 50000)") + "\n";
@@ -503,6 +535,24 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetBenchMark(SysCfg().GetBoolArg("-benchmark", false));
     mempool.SetSanityCheck(SysCfg().GetBoolArg("-checkmempool", RegTest()));
+    mempool.SetMaxSize(max<int64_t>(SysCfg().GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE), 1) * 1000000);
+
+    // -par=0 means autodetect, but nSigCheckThreads == 0 means no concurrency
+    int32_t nSigCheckThreads = SysCfg().GetArg("-par", DEFAULT_SIGCHECK_THREADS);
+    if (nSigCheckThreads <= 0)
+        nSigCheckThreads += boost::thread::hardware_concurrency();
+    if (nSigCheckThreads <= 1)
+        nSigCheckThreads = 0;
+    else if (nSigCheckThreads > MAX_SIGCHECK_THREADS)
+        nSigCheckThreads = MAX_SIGCHECK_THREADS;
+
+    int32_t nTxAdmissionThreads = SysCfg().GetArg("-txadmissionthreads", DEFAULT_TX_ADMISSION_THREADS);
+    nTxAdmissionThreads = max<int32_t>(min<int32_t>(nTxAdmissionThreads, MAX_TX_ADMISSION_THREADS), 0);
+
+    luaVMCache.SetMaxChunks(max<int32_t>(SysCfg().GetArg("-luavmcache", DEFAULT_LUAVM_CACHE_SIZE), 0));
+
+    headersSync.SetEnabled(SysCfg().GetBoolArg("-headersfirst", DEFAULT_HEADERS_FIRST));
+    fCompactBlocks = SysCfg().GetBoolArg("-compactblocks", DEFAULT_COMPACT_BLOCKS);
 
     setvbuf(stdout, nullptr, _IOLBF, 0);
 
@@ -541,6 +591,8 @@ bool AppInit(boost::thread_group &threadGroup) {
     // if (GetBoolArg("-shrinkdebugfile", !fDebug))
     //     ShrinkDebugFile();
 
+    StartLogWriter(std::max<int64_t>(SysCfg().GetArg("-logqueuesize", DEFAULT_LOG_QUEUE_SIZE), 0));
+
     LogPrint("INFO", "%s version %s (%s)\n", IniCfg().GetCoinName().c_str(), FormatFullVersion().c_str(), CLIENT_DATE);
     printf("%s version %s (%s)\n", IniCfg().GetCoinName().c_str(), FormatFullVersion().c_str(), CLIENT_DATE.c_str());
     LogPrint("INFO", "Using OpenSSL version %s\n", SSLeay_version(SSLEAY_VERSION));
@@ -572,6 +624,16 @@ bool AppInit(boost::thread_group &threadGroup) {
     LogPrint("INFO", "Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     printf("Using at most %i connections (      %i file descriptors available)\n", nMaxConnections, nFD);
 
+    if (nSigCheckThreads) {
+        LogPrint("INFO", "Using %u threads for signature verification\n", nSigCheckThreads);
+        sigCheckQueue.Start(nSigCheckThreads - 1);
+    }
+
+    if (nTxAdmissionThreads) {
+        LogPrint("INFO", "Using %u threads for transaction admission\n", nTxAdmissionThreads);
+        txAdmissionQueue.Start(nTxAdmissionThreads);
+    }
+
     RegisterNodeSignals(GetNodeSignals());
 
     int32_t nSocksVersion = SysCfg().GetArg("-socks", 5);
@@ -708,6 +770,10 @@ bool AppInit(boost::thread_group &threadGroup) {
     nTotalCache -= nDelegateDBCache;
 
     SysCfg().SetViewCacheSize(nTotalCache / 300);  // coins in memory require around 300 bytes
+    if (SysCfg().GetArg("-flushcache", 0) > 0)
+        SysCfg().SetViewCacheSize(std::min<int64_t>(SysCfg().GetArg("-flushcache", 0), MAX_DB_CACHE) << 20);
+    SysCfg().SetFlushBlockInterval(std::max<int64_t>(SysCfg().GetArg("-flushblocks", DEFAULT_FLUSH_BLOCK_INTERVAL), 1));
+    forkStates.SetMaxCacheSize(std::max<int64_t>(SysCfg().GetArg("-forkstatecache", DEFAULT_FORK_STATE_CACHE_SIZE), 0) << 20);
 
     try {
         pWalletMain = CWallet::GetInstance();
@@ -726,13 +792,19 @@ bool AppInit(boost::thread_group &threadGroup) {
         do {
             try {
                 UnloadBlockIndex();
+                forkStates.Clear();
                 delete pCdMan;
 
                 bool fReIndex = SysCfg().IsReindex();
                 pCdMan = new CCacheDBManager(fReIndex, false, nAccountDBCache, nContractDBCache, nDelegateDBCache,
                                              nBlockTreeDBCache);
-                if (fReIndex)
+                if (fReIndex) {
                     pCdMan->pBlockTreeDb->WriteReindexing(true);
+                    pCdMan->pDbFlusher->DiscardJournal();
+                } else if (!pCdMan->pDbFlusher->Recover()) {
+                    strLoadError = _("Error replaying the chain state journal");
+                    break;
+                }
 
                 mempool.SetMemPoolCache(pCdMan);
 
@@ -758,6 +830,12 @@ bool AppInit(boost::thread_group &threadGroup) {
                     break;
                 }
 
+                // Check for changed -addressindex state
+                if (SysCfg().IsAddressIndex() != SysCfg().GetBoolArg("-addressindex", false)) {
+                    strLoadError = _("You need to rebuild the database using -reindex to change -addressindex");
+                    break;
+                }
+
                 if (!VerifyDB(SysCfg().GetArg("-checklevel", 3), SysCfg().GetArg("-checkblocks", 288))) {
                     strLoadError = _("Corrupted block database detected");
                     break;
@@ -825,9 +903,20 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (!ActivateBestChain(state))
         return InitError("Failed to connect best block");
 
+    // the price point memory cache keeps the blocks of the median price slide window
+    uint64_t slideWindow = 0;
+    pCdMan->pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+
     nStart                   = GetTimeMillis();
     CBlockIndex *pBlockIndex = chainActive.Tip();
-    int32_t nCacheHeight         = SysCfg().GetTxCacheHeight();
+    bool fMemCacheLoaded     = pBlockIndex && CMemCacheDB().Read(pBlockIndex->GetBlockHash(), SysCfg().GetTxCacheHeight(),
+                                                             slideWindow, *pCdMan->pTxCache, *pCdMan->pPpCache);
+    if (fMemCacheLoaded) {
+        LogPrint("INFO", "Loaded transaction and price point memory caches from memcache.dat (%dms)\n",
+                 GetTimeMillis() - nStart);
+    }
+
+    int32_t nCacheHeight         = fMemCacheLoaded ? 0 : SysCfg().GetTxCacheHeight();
     int32_t nCount               = 0;
     CBlock block;
     while (pBlockIndex && nCacheHeight-- > 0) {
@@ -840,21 +929,21 @@ bool AppInit(boost::thread_group &threadGroup) {
         pBlockIndex = pBlockIndex->pprev;
         ++nCount;
     }
-    LogPrint("INFO", "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
+    if (!fMemCacheLoaded)
+        LogPrint("INFO", "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
     nStart       = GetTimeMillis();
     pBlockIndex  = chainActive.Tip();
-    nCacheHeight = 11;  // TODO: parameterize 11.
+    nCacheHeight = slideWindow;
     nCount       = 0;
 
-
-    if (pBlockIndex) {
+    if (pBlockIndex && !fMemCacheLoaded) {
         if (!ReadBlockFromDisk(pBlockIndex, block))
             return InitError("Failed to read block from disk");
         pCdMan->pPpCache->SetLatestBlockMedianPricePoints(block.GetBlockMedianPrice());
     }
 
-    while (pBlockIndex && nCacheHeight-- > 0) {
+    while (pBlockIndex && !fMemCacheLoaded && nCacheHeight-- > 0) {
         if (!ReadBlockFromDisk(pBlockIndex, block))
             return InitError("Failed to read block from disk");
 
@@ -864,7 +953,8 @@ bool AppInit(boost::thread_group &threadGroup) {
         pBlockIndex = pBlockIndex->pprev;
         ++nCount;
     }
-    LogPrint("INFO", "Added the latest %d blocks to price point memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
+    if (!fMemCacheLoaded)
+        LogPrint("INFO", "Added the latest %d blocks to price point memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
     vector<boost::filesystem::path> vImportFiles;
     if (SysCfg().IsArgCount("-loadblock")) {
@@ -22,6 +22,7 @@
 #include "json/json_spirit_value.h"
 #include "json/json_spirit_writer_template.h"
 #include "p2p/chainmessage.h"
+#include "persistence/forkstate.h"
 
 #include <sstream>
 #include <algorithm>
@@ -48,10 +49,15 @@ CCacheDBManager *pCdMan = nullptr;
 CCriticalSection cs_main;
 CTxMemPool mempool;
 map<uint256, CBlockIndex *> mapBlockIndex;
+CCriticalSection cs_mapBlockIndex;
+// the tip of chainActive published to the readers without cs_main, guarded by cs_mapBlockIndex
+static const CBlockIndex *pPublishedTip = nullptr;
 int32_t nSyncTipHeight = 0;
 string externalIp;
-map<uint256, std::shared_ptr<CCacheWrapper> > mapForkCache;
 CSignatureCache signatureCache;
+CSignatureCheckQueue sigCheckQueue;
+// signature checks deferred by CheckBlock() on the current thread, null when verifying inline
+static thread_local vector<CSignatureCheck> *pDeferredSigChecks = nullptr;
 CChain chainActive;
 CChain chainMostWork;
 bool mining;        // could change from time to time due to vote change
@@ -93,19 +99,21 @@ namespace {
             mapBlocksInFlight.erase(entry.hash);
         for (const auto &hash : state->vBlocksToDownload)
             mapBlocksToDownload.erase(hash);
+        if (headersSync.GetPeer() == nodeid)
+            headersSync.Clear();
 
         mapNodeState.erase(nodeid);
     }
 
     // Requires cs_main.
-    void MarkBlockAsInFlight(NodeId nodeid, const uint256 &hash) {
+    void MarkBlockAsInFlight(NodeId nodeid, const uint256 &hash, bool fWindow = false) {
         CNodeState *state = State(nodeid);
         assert(state != nullptr);
 
         // Make sure it's not listed somewhere already.
         MarkBlockAsReceived(hash);
 
-        QueuedBlock newentry = {hash, GetTimeMicros(), state->nBlocksInFlight};
+        QueuedBlock newentry = {hash, GetTimeMicros(), state->nBlocksInFlight, fWindow};
         if (state->nBlocksInFlight == 0)
             state->nLastBlockReceive = newentry.nTime;  // Reset when a first request is sent.
         list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(), newentry);
@@ -160,6 +168,45 @@ CCriticalSection cs_nBlockSequenceId;
 // Blocks loaded from disk are assigned id 0, so start the counter at 1.
 uint32_t nBlockSequenceId = 1;
 
+// Reward txs of the recently connected blocks, indexed by height, so that maturing the reward
+// of the block BLOCK_REWARD_MATURITY back needs not to read that block from disk again.
+// Requires cs_main.
+class CRecentRewardTxRing {
+public:
+    CRecentRewardTxRing() : vRing(BLOCK_REWARD_MATURITY + 1), nHits(0), nMisses(0) {}
+
+    void Push(const int32_t height, const uint256 &blockHash, const std::shared_ptr<CBaseTx> &pRewardTx) {
+        Entry &entry    = vRing[height % vRing.size()];
+        entry.blockHash = blockHash;
+        entry.pRewardTx = pRewardTx;
+    }
+
+    std::shared_ptr<CBaseTx> Get(const int32_t height, const uint256 &blockHash) {
+        const Entry &entry = vRing[height % vRing.size()];
+        if (entry.pRewardTx && entry.blockHash == blockHash) {
+            ++nHits;
+            return entry.pRewardTx;
+        }
+
+        ++nMisses;
+        return nullptr;
+    }
+
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetMisses() const { return nMisses; }
+
+private:
+    struct Entry {
+        uint256 blockHash;
+        std::shared_ptr<CBaseTx> pRewardTx;
+    };
+
+    vector<Entry> vRing;
+    uint64_t nHits;
+    uint64_t nMisses;
+};
+CRecentRewardTxRing recentRewardTxs;
+
 
 
 
@@ -231,7 +278,15 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
     CNodeState *state = State(nodeid);
     if (state == nullptr)
         return false;
-    stats.nMisbehavior = state->nMisbehavior;
+    stats.nMisbehavior            = state->nMisbehavior;
+    stats.nCmpctBlocks            = state->nCmpctBlocks;
+    stats.nCmpctBlockRoundTrips   = state->nCmpctBlockRoundTrips;
+    stats.nCmpctBlockFailures     = state->nCmpctBlockFailures;
+    stats.nCmpctTxsFound          = state->nCmpctTxsFound;
+    stats.nCmpctTxsMissing        = state->nCmpctTxsMissing;
+    stats.nCmpctReconstructMillis = state->nCmpctReconstructMillis;
+    stats.nRelayedBlocks          = state->nRelayedBlocks;
+    stats.nRelayLatencyMillis     = state->nRelayLatencyMillis;
     return true;
 }
 
@@ -313,6 +368,34 @@ CBlockIndex *CChain::FindFork(const CBlockLocator &locator) const {
     return Genesis();
 }
 
+const CBlockIndex *CChainSnapshot::FindFork(const CBlockLocator &locator) const {
+    // Find the first block the caller has in the snapshot
+    for (const auto &hash : locator.vHave) {
+        const CBlockIndex *pIndex = LookupBlockIndex(hash);
+        if (pIndex && Contains(pIndex))
+            return pIndex;
+    }
+
+    return (*this)[0];
+}
+
+CChainSnapshot GetChainSnapshot() {
+    LOCK(cs_mapBlockIndex);
+    return CChainSnapshot(pPublishedTip);
+}
+
+CBlockIndex *LookupBlockIndex(const uint256 &hash) {
+    LOCK(cs_mapBlockIndex);
+    auto it = mapBlockIndex.find(hash);
+    return it != mapBlockIndex.end() ? it->second : nullptr;
+}
+
+// Requires cs_main. Publish the tip of chainActive to GetChainSnapshot().
+static void PublishChainTip() {
+    LOCK(cs_mapBlockIndex);
+    pPublishedTip = chainActive.Tip();
+}
+
 uint32_t LimitOrphanTxSize(uint32_t nMaxOrphans) {
     uint32_t nEvicted = 0;
     while (mapOrphanTransactions.size() > nMaxOrphans) {
@@ -328,7 +411,6 @@ uint32_t LimitOrphanTxSize(uint32_t nMaxOrphans) {
 }
 
 bool IsStandardTx(CBaseTx *pBaseTx, string &reason) {
-    AssertLockHeld(cs_main);
     if (pBaseTx->nVersion > CBaseTx::CURRENT_VERSION || pBaseTx->nVersion < 1) {
         reason = "version";
         return false;
@@ -351,6 +433,11 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
     if (signatureCache.Get(sigHash, signature, pubKey))
         return true;
 
+    if (pDeferredSigChecks != nullptr) {
+        pDeferredSigChecks->emplace_back(sigHash, signature, pubKey);
+        return true;
+    }
+
     if (!pubKey.Verify(sigHash, signature))
         return false;
 
@@ -360,13 +447,21 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
 
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx, bool fLimitFree,
                         bool fRejectInsaneFee) {
+    return AcceptToMemoryPool(pool, state, pBaseTx->GetNewInstance(), fLimitFree, fRejectInsaneFee);
+}
+
+bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, const std::shared_ptr<CBaseTx> &spBaseTx,
+                        bool fLimitFree, bool fRejectInsaneFee) {
     AssertLockHeld(cs_main);
 
+    CBaseTx *pBaseTx = spBaseTx.get();
+
     // is it already in the memory pool?
     uint256 hash = pBaseTx->GetHash();
-    if (pool.Exists(hash))
-        return state.Invalid(ERRORMSG("AcceptToMemoryPool() : txid: %s already in mempool", hash.GetHex()),
-            REJECT_INVALID, "tx-already-in-mempool");
+    if (pool.Exists(hash)) {
+        LogPrint("mempool", "AcceptToMemoryPool() : txid: %s already in mempool\n", hash.GetHex());
+        return state.Invalid(false, REJECT_INVALID, "tx-already-in-mempool");
+    }
 
     // is it a miner reward tx or median price tx?
     if (pBaseTx->IsBlockRewardTx() || pBaseTx->IsMedianPriceTx())
@@ -379,12 +474,12 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
         return state.DoS(0, ERRORMSG("AcceptToMemoryPool() : txid: %s is nonstandard transaction due to %s",
             hash.GetHex(), reason), REJECT_NONSTANDARD, reason);
 
-    auto spCW = std::make_shared<CCacheWrapper>(*mempool.cw);
+    CCacheSnapshot snapshot(*mempool.cw);
 
-    if (!pBaseTx->CheckTx(chainActive.Height(), *spCW, state))
+    if (!pBaseTx->CheckTx(chainActive.Height(), *snapshot, state))
         return ERRORMSG("AcceptToMemoryPool() : CheckTx failed, txid: %s", hash.GetHex());
 
-    CTxMemPoolEntry entry(pBaseTx, GetTime(), chainActive.Height());
+    CTxMemPoolEntry entry(spBaseTx, GetTime(), chainActive.Height());
     // TODO: consider different coin types.
     auto nFees = std::get<1>(entry.GetFees());
     auto nSize = entry.GetTxSize();
@@ -427,7 +522,7 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
     if (fRejectInsaneFee && nFees > SysCfg().GetMaxFee())
         return ERRORMSG("AcceptToMemoryPool() : txid: %s pay insane fees, %d > %d", hash.GetHex(), nFees, SysCfg().GetMaxFee());
 
-    return pool.AddUnchecked(hash, entry, state);
+    return pool.AddUnchecked(hash, std::move(entry), state);
 }
 
 int32_t CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex *&pindexRet) const {
@@ -729,11 +824,12 @@ void CheckForkWarningConditionsOnNewFork(CBlockIndex *pindexNewForkTip) {
     CheckForkWarningConditions();
 }
 
-// Requires cs_main.
 void Misbehaving(NodeId pNode, int32_t howmuch) {
     if (howmuch == 0)
         return;
 
+    // the read-only p2p handlers call it without cs_main
+    LOCK(cs_main);
     CNodeState *state = State(pNode);
     if (state == nullptr)
         return;
@@ -912,11 +1008,12 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
         return state.Abort(_("DisconnectBlock() : failed to delete block from price point memory cache"));
     }
 
-    // Load price points into price point memory cache.
-    // TODO: parameterize 11.
-    if (pIndex->height > 11) {
+    // Load price points into price point memory cache, which keeps the blocks of the median price slide window.
+    uint64_t slideWindow = 0;
+    cw.sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+    if (pIndex->height > (int32_t)slideWindow) {
         CBlockIndex *pReLoadBlockIndex = pIndex;
-        int32_t nCacheHeight           = 11;
+        int32_t nCacheHeight           = slideWindow;
         while (pReLoadBlockIndex && nCacheHeight-- > 0) {
             pReLoadBlockIndex = pReLoadBlockIndex->pprev;
         }
@@ -1081,6 +1178,28 @@ bool SaveTxIndex(const uint256 &txid, CCacheWrapper &cw, CValidationState &state
     return true;
 }
 
+// index the txs of the block by the involved addresses, ordered by height and index
+static bool SaveTxAddressIndex(const CBlock &block, int32_t height, CCacheWrapper &cw, CValidationState &state) {
+    if (!SysCfg().IsAddressIndex())
+        return true;
+
+    for (uint32_t index = 0; index < block.vptx.size(); ++index) {
+        const auto &pBaseTx = block.vptx[index];
+        const uint256 txid = pBaseTx->GetHash();
+        set<CKeyID> keyIds;
+        if (!pBaseTx->GetInvolvedKeyIds(cw, keyIds)) {
+            // the index is best effort, a tx with an unresolved uid is indexed by the addresses resolved
+            LogPrint("INFO", "SaveTxAddressIndex() : failed to get all involved addresses of tx %s\n", txid.GetHex());
+        }
+
+        for (const auto &keyId : keyIds) {
+            if (!cw.contractCache.SetTxHashByAddress(keyId, height, index, txid))
+                return state.Abort(_("Failed to write address index"));
+        }
+    }
+    return true;
+}
+
 // compute vote staking interest && revoke votes
 bool ComputeVoteStakingInterestAndRevokeVotes(const int32_t currHeight, CCacheWrapper &cw, CValidationState &state) {
     // acquire votes list
@@ -1387,6 +1506,22 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         }
     }
 
+    if (!SaveTxAddressIndex(block, pIndex->height, cw, state)) {
+        cw.DisableTxUndoLog();
+        return false;
+    }
+
+    if (!cw.dexCache.PruneOrderBookChanges(pIndex->height)) {
+        cw.DisableTxUndoLog();
+        return state.Abort(_("ConnectBlock() : failed to prune dex order book changes"));
+    }
+
+    // the cdp bookkeeping of the feature fork v3 starts from the cdps, as a node restarted before the fork has it
+    if (pIndex->height + 1 == (int32_t)SysCfg().GetFeatureForkV3Height() && !cw.cdpCache.RebuildRatioIndex()) {
+        cw.DisableTxUndoLog();
+        return state.Abort(_("ConnectBlock() : failed to rebuild the cdp ratio index"));
+    }
+
     blockUndo.vtxundo.push_back(cw.txUndo);
     cw.DisableTxUndoLog();
 
@@ -1398,16 +1533,21 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         }
 
         if (nullptr != pMatureIndex) {
-            CBlock matureBlock;
-            if (!ReadBlockFromDisk(pMatureIndex, matureBlock)) {
-                return state.DoS(100, ERRORMSG("ConnectBlock() : read mature block error"), REJECT_INVALID,
-                                 "bad-read-block");
+            std::shared_ptr<CBaseTx> pMatureRewardTx =
+                recentRewardTxs.Get(pMatureIndex->height, pMatureIndex->GetBlockHash());
+            if (!pMatureRewardTx) {
+                CBlock matureBlock;
+                if (!ReadBlockFromDisk(pMatureIndex, matureBlock)) {
+                    return state.DoS(100, ERRORMSG("ConnectBlock() : read mature block error"), REJECT_INVALID,
+                                     "bad-read-block");
+                }
+                pMatureRewardTx = matureBlock.vptx[0];
             }
 
             cw.EnableTxUndoLog(block.vptx[0]->GetHash());
-            if (!matureBlock.vptx[0]->ExecuteTx(pIndex->height, -1, cw, state)) {
+            if (!pMatureRewardTx->ExecuteTx(pIndex->height, -1, cw, state)) {
                 if (SysCfg().IsLogFailures()) {
-                    pCdMan->pLogCache->SetExecuteFail(pIndex->height, matureBlock.vptx[0]->GetHash(),
+                    pCdMan->pLogCache->SetExecuteFail(pIndex->height, pMatureRewardTx->GetHash(),
                                                       state.GetRejectCode(), state.GetRejectReason());
                 }
                 cw.DisableTxUndoLog();
@@ -1419,8 +1559,9 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     }
     int64_t nTime = GetTimeMicros() - nStart;
     if (SysCfg().IsBenchmark())
-        LogPrint("INFO", "- Connect %u transactions: %.2fms (%.3fms/tx)\n",
-                 (uint32_t)block.vptx.size(), 0.001 * nTime, 0.001 * nTime / block.vptx.size());
+        LogPrint("INFO", "- Connect %u transactions: %.2fms (%.3fms/tx), mature reward tx hits: %llu, misses: %llu\n",
+                 (uint32_t)block.vptx.size(), 0.001 * nTime, 0.001 * nTime / block.vptx.size(),
+                 recentRewardTxs.GetHits(), recentRewardTxs.GetMisses());
 
     if (fJustCheck)
         return true;
@@ -1451,19 +1592,10 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         return state.Abort(_("ConnectBlock() : failed add block into transaction memory cache"));
     }
 
+    // The evicted blocks are only referred to by hash and height, no need to read them from disk.
     if (pIndex->height > SysCfg().GetTxCacheHeight()) {
-        CBlockIndex *pDeleteBlockIndex = pIndex;
-        int32_t nCacheHeight           = SysCfg().GetTxCacheHeight();
-        while (pDeleteBlockIndex && nCacheHeight-- > 0) {
-            pDeleteBlockIndex = pDeleteBlockIndex->pprev;
-        }
-
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-            return state.Abort(_("ConnectBlock() : failed to read block"));
-        }
-
-        if (!cw.txCache.DeleteBlockFromCache(deleteBlock)) {
+        CBlockIndex *pDeleteBlockIndex = pIndex->GetAncestor(pIndex->height - SysCfg().GetTxCacheHeight());
+        if (!cw.txCache.DeleteBlockFromCache(pDeleteBlockIndex->GetBlockHash())) {
             return state.Abort(_("ConnectBlock() : failed delete block from transaction memory cache"));
         }
     }
@@ -1471,24 +1603,16 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     // Attention: should NOT to call AddBlockToCache() for price point memory cache, as everything
     // is ready when executing transactions.
 
-    // TODO: parameterize 11.
-    if (pIndex->height > 11) {
-        CBlockIndex *pDeleteBlockIndex = pIndex;
-        int32_t nCacheHeight           = 11;
-        while (pDeleteBlockIndex && nCacheHeight-- > 0) {
-            pDeleteBlockIndex = pDeleteBlockIndex->pprev;
-        }
-
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-            return state.Abort(_("ConnectBlock() : failed to read block"));
-        }
-
-        if (!cw.ppCache.DeleteBlockFromCache(deleteBlock)) {
+    uint64_t slideWindow = 0;
+    cw.sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+    if (pIndex->height > (int32_t)slideWindow) {
+        if (!cw.ppCache.DeleteBlockPricePoint(pIndex->height - slideWindow)) {
             return state.Abort(_("ConnectBlock() : failed delete block from price point memory cache"));
         }
     }
 
+    recentRewardTxs.Push(pIndex->height, pIndex->GetBlockHash(), block.vptx[0]);
+
     // Set best block to current account cache.
     assert(cw.accountCache.SetBestBlock(pIndex->GetBlockHash()));
     return true;
@@ -1496,13 +1620,14 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
 
 // Update the on-disk chain state.
 bool static WriteChainState(CValidationState &state) {
-    static int64_t nLastWrite = 0;
-    uint32_t cachesize        = pCdMan->pAccountCache->GetCacheSize() + pCdMan->pContractCache->GetCacheSize() +
+    static int64_t nLastWrite        = 0;
+    static int32_t nBlocksSinceWrite = 0;
+    uint32_t cachesize               = pCdMan->pAccountCache->GetCacheSize() + pCdMan->pContractCache->GetCacheSize() +
                          pCdMan->pDelegateCache->GetCacheSize() + pCdMan->pCdpCache->GetCacheSize();
 
-    if (!IsInitialBlockDownload()
+    if (++nBlocksSinceWrite >= SysCfg().GetFlushBlockInterval()
         || cachesize > SysCfg().GetViewCacheSize()
-        || GetTimeMicros() > nLastWrite + 60 * 1000000) {
+        || GetTimeMicros() > nLastWrite + MAX_FLUSH_INTERVAL_SECONDS * 1000000) {
         // Typical CCoins structures on disk are around 100 bytes in size.
         // Pushing a new one to the database can cause it to be written
         // twice (once in the log, and once in the tables). This is already
@@ -1513,10 +1638,12 @@ bool static WriteChainState(CValidationState &state) {
 
         FlushBlockFile();
         pCdMan->pBlockTreeDb->Sync();
-        pCdMan->Flush();
+        // written in the flusher thread, the state dbs stay consistent with the best block of the account db
+        if (!pCdMan->Flush(true))
+            return state.Abort(_("Failed to write the chain state"));
 
-        mapForkCache.clear();
-        nLastWrite = GetTimeMicros();
+        nLastWrite        = GetTimeMicros();
+        nBlocksSinceWrite = 0;
     }
     return true;
 }
@@ -1524,6 +1651,8 @@ bool static WriteChainState(CValidationState &state) {
 // Update chainActive and related internal data structures.
 void static UpdateTip(CBlockIndex *pIndexNew, const CBlock &block) {
     chainActive.SetTip(pIndexNew);
+    PublishChainTip();
+    headersSync.UpdateTip(pIndexNew);
 
     SyncTransaction(uint256(), nullptr, &block);
 
@@ -1557,6 +1686,30 @@ void static UpdateTip(CBlockIndex *pIndexNew, const CBlock &block) {
     }
 }
 
+// Move the root of the fork states to the new tip connected on it, the states on the old tip are kept. Without the
+// states of forked chains the states are dropped instead, the ones of the active chain are built again when needed.
+void static UpdateForkStateRoot(CBlockIndex *pIndexNew, CBlock &block) {
+    if (!forkStates.HasForkedStates() || forkStates.GetRootHash() != pIndexNew->pprev->GetBlockHash() ||
+        forkStates.Contains(pIndexNew->GetBlockHash())) {
+        forkStates.SetRoot(pCdMan, pIndexNew->GetBlockHash(), pIndexNew->height);
+        return;
+    }
+
+    // the state at the old tip, the new tip disconnected on the new root
+    CValidationState state;
+    CBlock prevBlock;
+    auto spCW = forkStates.CreateLayer(forkStates.GetRootHash());
+    if (!ReadBlockFromDisk(pIndexNew->pprev, prevBlock) || !DisconnectBlock(block, *spCW, pIndexNew, state)) {
+        LogPrint("INFO", "UpdateForkStateRoot() : failed to disconnect block [%d]: %s, drop the fork states\n",
+                 pIndexNew->height, pIndexNew->GetBlockHash().GetHex());
+        forkStates.SetRoot(pCdMan, pIndexNew->GetBlockHash(), pIndexNew->height);
+        return;
+    }
+    spCW->ppCache.SetLatestBlockMedianPricePoints(prevBlock.GetBlockMedianPrice());
+
+    forkStates.MoveRoot(pIndexNew->GetBlockHash(), pIndexNew->height, std::move(spCW));
+}
+
 // Disconnect chainActive's tip.
 bool static DisconnectTip(CValidationState &state) {
     CBlockIndex *pIndexDelete = chainActive.Tip();
@@ -1586,12 +1739,13 @@ bool static DisconnectTip(CValidationState &state) {
         return false;
     // Update chainActive and related variables.
     UpdateTip(pIndexDelete->pprev, block);
+    forkStates.SetRoot(pCdMan, pIndexDelete->pprev->GetBlockHash(), pIndexDelete->pprev->height);
     // Resurrect mempool transactions from the disconnected block.
     for (const auto &ptx : block.vptx) {
         list<std::shared_ptr<CBaseTx> > removed;
         CValidationState stateDummy;
         if (!ptx->IsBlockRewardTx()) {
-            if (!AcceptToMemoryPool(mempool, stateDummy, ptx.get(), false)) {
+            if (!AcceptToMemoryPool(mempool, stateDummy, ptx, false)) {
                 mempool.Remove(ptx.get(), removed, true);
             }
         } else {
@@ -1642,10 +1796,10 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
 
     // Update chainActive & related variables.
     UpdateTip(pIndexNew, block);
+    UpdateForkStateRoot(pIndexNew, block);
+
+    mempool.RemoveConfirmed(block.vptx);
 
-    for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
-    }
     return true;
 }
 
@@ -1771,22 +1925,26 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
         LOCK(cs_nBlockSequenceId);
         pIndexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
-    // LogPrint("INFO", "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
-    pIndexNew->pBlockHash                        = &((*mi).first);
-    map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
-    if (miPrev != mapBlockIndex.end()) {
-        pIndexNew->pprev  = (*miPrev).second;
-        pIndexNew->height = pIndexNew->pprev->height + 1;
-        pIndexNew->BuildSkip();
-    }
-    pIndexNew->nTx        = block.vptx.size();
-    pIndexNew->nChainWork = pIndexNew->height;
-    pIndexNew->nChainTx   = (pIndexNew->pprev ? pIndexNew->pprev->nChainTx : 0) + pIndexNew->nTx;
-    pIndexNew->nFile      = pos.nFile;
-    pIndexNew->nDataPos   = pos.nPos;
-    pIndexNew->nUndoPos   = 0;
-    pIndexNew->nStatus    = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA;
+    {
+        // complete the entry before the readers without cs_main can find it
+        LOCK(cs_mapBlockIndex);
+        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+        // LogPrint("INFO", "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
+        pIndexNew->pBlockHash                        = &((*mi).first);
+        map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
+        if (miPrev != mapBlockIndex.end()) {
+            pIndexNew->pprev  = (*miPrev).second;
+            pIndexNew->height = pIndexNew->pprev->height + 1;
+            pIndexNew->BuildSkip();
+        }
+        pIndexNew->nTx        = block.vptx.size();
+        pIndexNew->nChainWork = pIndexNew->height;
+        pIndexNew->nChainTx   = (pIndexNew->pprev ? pIndexNew->pprev->nChainTx : 0) + pIndexNew->nTx;
+        pIndexNew->nFile      = pos.nFile;
+        pIndexNew->nDataPos   = pos.nPos;
+        pIndexNew->nUndoPos   = 0;
+        pIndexNew->nStatus    = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA;
+    }
     setBlockIndexValid.insert(pIndexNew);
 
     if (!pCdMan->pBlockTreeDb->WriteBlockIndex(CDiskBlockIndex(pIndexNew)))
@@ -1867,145 +2025,102 @@ bool FindBlockPos(CValidationState &state, CDiskBlockPos &pos, uint32_t nAddSize
     return true;
 }
 
+// Roll the active chain back to the forked point in the fork states, each block disconnected once on the state at
+// the block above it, which is kept for the other forks.
+static bool DisconnectToForkPoint(CBlockIndex *pForkIndex, CValidationState &state) {
+    int64_t beginTime = GetTimeMillis();
+    CBlock block;
+    bool fHaveBlock = false;
+    for (CBlockIndex *pBlockIndex = chainActive.Tip(); pBlockIndex != pForkIndex; pBlockIndex = pBlockIndex->pprev) {
+        CBlockIndex *pPrevIndex = pBlockIndex->pprev;
+        if (forkStates.Contains(pPrevIndex->GetBlockHash())) {
+            fHaveBlock = false;
+            continue;
+        }
+
+        LogPrint("INFO", "ProcessForkedChain() : disconnect block [%d]: %s\n", pBlockIndex->height,
+                 pBlockIndex->GetBlockHash().GetHex());
+
+        CBlock prevBlock;
+        if ((!fHaveBlock && !ReadBlockFromDisk(pBlockIndex, block)) || !ReadBlockFromDisk(pPrevIndex, prevBlock))
+            return state.Abort(_("Failed to read block"));
+
+        auto spCW = forkStates.CreateLayer(pBlockIndex->GetBlockHash());
+        if (!DisconnectBlock(block, *spCW, pBlockIndex, state)) {
+            return ERRORMSG("ProcessForkedChain() : failed to disconnect block [%d]: %s", pBlockIndex->height,
+                            pBlockIndex->GetBlockHash().ToString());
+        }
+        // the latest median price points of the state are of the block it is at
+        spCW->ppCache.SetLatestBlockMedianPricePoints(prevBlock.GetBlockMedianPrice());
+        forkStates.Add(pPrevIndex->GetBlockHash(), pPrevIndex->height, pBlockIndex->GetBlockHash(), std::move(spCW));
+
+        block      = prevBlock;
+        fHaveBlock = true;
+    }
+
+    LogPrint("INFO", "ProcessForkedChain() : disconnect blocks elapse: %lld ms\n", GetTimeMillis() - beginTime);
+    return true;
+}
+
 bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValidationState &state) {
     if (pPreBlockIndex->GetBlockHash() == chainActive.Tip()->GetBlockHash())
         return true;  // No fork, return immediately.
 
-    auto spForkCW          = std::make_shared<CCacheWrapper>();
-    auto spCW              = std::make_shared<CCacheWrapper>(pCdMan);
-    bool forkChainTipFound = false;
-    uint256 forkChainTipBlockHash;
-    vector<CBlock> vPreBlocks;
-
-    // If the block's previous block is not the active chain's tip, find the forked point.
-    while (!chainActive.Contains(pPreBlockIndex)) {
-        if (!forkChainTipFound) {
-            if (mapForkCache.count(pPreBlockIndex->GetBlockHash())) {
-                forkChainTipBlockHash = pPreBlockIndex->GetBlockHash();
-                forkChainTipFound     = true;
-                LogPrint("INFO", "ProcessForkedChain() : fork chain's best block [%d]: %s\n",
-                         pPreBlockIndex->height, forkChainTipBlockHash.GetHex());
-            } else {
-                CBlock block;
-                if (!ReadBlockFromDisk(pPreBlockIndex, block))
-                    return state.Abort(_("Failed to read block"));
-
-                // Reserve the forked chain's blocks.
-                vPreBlocks.push_back(block);
-            }
-        }
+    if (forkStates.GetRootHash() != chainActive.Tip()->GetBlockHash())
+        forkStates.SetRoot(pCdMan, chainActive.Tip()->GetBlockHash(), chainActive.Height());
 
-        pPreBlockIndex = pPreBlockIndex->pprev;
+    // The forked chain's blocks without a state, down to the forked point or a block validated before.
+    vector<CBlockIndex *> vForkIndexes;
+    CBlockIndex *pForkIndex = pPreBlockIndex;
+    while (!chainActive.Contains(pForkIndex) && !forkStates.Contains(pForkIndex->GetBlockHash())) {
+        vForkIndexes.push_back(pForkIndex);
+        pForkIndex = pForkIndex->pprev;
 
         // FIXME: enable it to avoid forked chain attack.
-        // if (chainActive.Height() - pPreBlockIndex->height > SysCfg().GetMaxForkHeight())
+        // if (chainActive.Height() - pForkIndex->height > SysCfg().GetMaxForkHeight())
         //     return state.DoS(100, ERRORMSG(
         //         "ProcessForkedChain() : block at fork chain too earlier than tip block hash=%s block height=%d\n",
         //         block.GetHash().GetHex(), block.GetHeight()));
 
-        if (mapBlockIndex.find(pPreBlockIndex->GetBlockHash()) == mapBlockIndex.end())
+        if (mapBlockIndex.find(pForkIndex->GetBlockHash()) == mapBlockIndex.end())
             return state.DoS(10, ERRORMSG("ProcessForkedChain() : prev block not found"), 0, "bad-prevblk");
     }
 
-    if (mapForkCache.count(pPreBlockIndex->GetBlockHash())) {
-        uint256 blockHash   = pPreBlockIndex->GetBlockHash();
-        int32_t blockHeight = pPreBlockIndex->height;
-        *spCW               = *mapForkCache[blockHash];
-
-        LogPrint("INFO", "ProcessForkedChain() : found [%d]: %s in cache\n", blockHeight, blockHash.GetHex());
-    } else {
-        int64_t beginTime        = GetTimeMillis();
-        CBlockIndex *pBlockIndex = chainActive.Tip();
-
-        while (pPreBlockIndex != pBlockIndex) {
-            LogPrint("INFO", "ProcessForkedChain() : disconnect block [%d]: %s\n", pBlockIndex->height,
-                     pBlockIndex->GetBlockHash().GetHex());
-
-            CBlock block;
-            if (!ReadBlockFromDisk(pBlockIndex, block))
-                return state.Abort(_("Failed to read block"));
-
-            bool bfClean = true;
-            if (!DisconnectBlock(block, *spCW, pBlockIndex, state, &bfClean)) {
-                return ERRORMSG("ProcessForkedChain() : failed to disconnect block [%d]: %s", pBlockIndex->height,
-                                pBlockIndex->GetBlockHash().ToString());
-            }
-
-            pBlockIndex = pBlockIndex->pprev;
-        }  // Rollback the active chain to the forked point.
-
-        mapForkCache[pPreBlockIndex->GetBlockHash()] = spCW;
-        LogPrint("INFO", "ProcessForkedChain() : add [%d]: %s to cache\n", pPreBlockIndex->height,
-                 pPreBlockIndex->GetBlockHash().GetHex());
-
-        LogPrint("INFO", "ProcessForkedChain() : disconnect blocks elapse: %lld ms\n", GetTimeMillis() - beginTime);
-    }
-
-    if (forkChainTipFound) {
-        *spForkCW = *mapForkCache[forkChainTipBlockHash];
-    } else {
-        *spForkCW = *spCW;
+    if (forkStates.Get(pForkIndex->GetBlockHash()) != nullptr) {
+        LogPrint("INFO", "ProcessForkedChain() : found [%d]: %s in fork states\n", pForkIndex->height,
+                 pForkIndex->GetBlockHash().GetHex());
+    } else if (pForkIndex != chainActive.Tip() && !DisconnectToForkPoint(pForkIndex, state)) {
+        return false;
     }
 
-    uint256 forkChainBestBlockHash   = spForkCW->accountCache.GetBestBlock();
-    int32_t forkChainBestBlockHeight = mapBlockIndex[forkChainBestBlockHash]->height;
-    LogPrint("INFO", "ProcessForkedChain() : fork chain's best block [%d]: %s\n", forkChainBestBlockHeight,
-             forkChainBestBlockHash.GetHex());
-
-
-    {
-        // Set base to null and rebuild memory cache.
-        spForkCW->ppCache.Reset();
-
-        CBlockIndex *pBlockIndex = mapBlockIndex[forkChainBestBlockHash];
-        CBlock block;
-        if (pBlockIndex) {
-            if (!ReadBlockFromDisk(pBlockIndex, block))
-                return ERRORMSG("ProcessForkedChain() : failed to read block [%d]: %s", pBlockIndex->height,
-                                pBlockIndex->GetBlockHash().ToString());
-
-            spForkCW->ppCache.SetLatestBlockMedianPricePoints(block.GetBlockMedianPrice());
-        }
-
-        // TODO: parameterize 11
-        int32_t cacheHeight = 11;
-        while (pBlockIndex && cacheHeight-- > 0) {
-            if (!ReadBlockFromDisk(pBlockIndex, block))
-                return ERRORMSG("ProcessForkedChain() : failed to read block [%d]: %s", pBlockIndex->height,
-                                pBlockIndex->GetBlockHash().ToString());
-
-            if (!spForkCW->ppCache.AddBlockToCache(block))
-                return ERRORMSG("ProcessForkedChain() : failed to add block [%d]: %s to price point memory cache",
-                                pBlockIndex->height, pBlockIndex->GetBlockHash().ToString());
-
-            pBlockIndex = pBlockIndex->pprev;
-        }
-    }
+    // Connect the forked chain's blocks, each on the state at its previous block.
+    for (auto rIter = vForkIndexes.rbegin(); rIter != vForkIndexes.rend(); ++rIter) {
+        CBlockIndex *pConnBlockIndex = *rIter;
+        CBlock forkBlock;
+        if (!ReadBlockFromDisk(pConnBlockIndex, forkBlock))
+            return ERRORMSG("ProcessForkedChain() : failed to read block [%d]: %s", pConnBlockIndex->height,
+                            pConnBlockIndex->GetBlockHash().ToString());
 
-    // Connect all of the forked chain's blocks.
-    for (auto rIter = vPreBlocks.rbegin(); rIter != vPreBlocks.rend(); ++rIter) {
-        LogPrint("INFO", "ProcessForkedChain() : ConnectBlock block height=%d hash=%s\n", rIter->GetHeight(),
-                 rIter->GetHash().GetHex());
+        LogPrint("INFO", "ProcessForkedChain() : ConnectBlock block height=%d hash=%s\n", forkBlock.GetHeight(),
+                 forkBlock.GetHash().GetHex());
 
-        if (!ConnectBlock(*rIter, *spForkCW, mapBlockIndex[rIter->GetHash()], state, false)) {
-            return ERRORMSG("ProcessForkedChain() : ConnectBlock %s failed", rIter->GetHash().ToString());
+        const uint256 &prevHash = pConnBlockIndex->pprev->GetBlockHash();
+        auto spCW = forkStates.CreateLayer(prevHash);
+        if (!ConnectBlock(forkBlock, *spCW, pConnBlockIndex, state, false)) {
+            return ERRORMSG("ProcessForkedChain() : ConnectBlock %s failed", forkBlock.GetHash().ToString());
         }
 
-        CBlockIndex *pConnBlockIndex = mapBlockIndex[rIter->GetHash()];
         if (pConnBlockIndex->nStatus | BLOCK_FAILED_MASK) {
             pConnBlockIndex->nStatus = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA;
         }
-    }
-
-    if (!vPreBlocks.empty()) {
-        vector<CBlock>::iterator iterBlock = vPreBlocks.begin();
-        if (forkChainTipFound) {
-            mapForkCache.erase(forkChainTipBlockHash);
-        }
 
-        mapForkCache[iterBlock->GetHash()] = spForkCW;
+        forkStates.Add(pConnBlockIndex->GetBlockHash(), pConnBlockIndex->height, prevHash, std::move(spCW));
     }
 
+    LogPrint("INFO", "ProcessForkedChain() : fork chain's best block [%d]: %s, %u fork states, %llu bytes\n",
+             pPreBlockIndex->height, pPreBlockIndex->GetBlockHash().GetHex(), forkStates.GetSize(),
+             forkStates.GetCacheSize());
+
     return true;
 }
 
@@ -2034,14 +2149,28 @@ bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw,
     // recalculated many times during this block's validation.
     block.BuildMerkleTree();
 
+    // When signature check threads are running, CheckTx() only collects the signatures
+    // of the block, which are verified in a batch after all the stateful checks passed.
+    struct CDeferredSigChecksGuard {
+        CDeferredSigChecksGuard(vector<CSignatureCheck> *pChecks) { pDeferredSigChecks = pChecks; }
+        ~CDeferredSigChecksGuard() { pDeferredSigChecks = nullptr; }
+    };
+    bool fParallelSigCheck = fCheckTx && sigCheckQueue.IsRunning();
+    vector<CSignatureCheck> vSigChecks;
+    if (fParallelSigCheck)
+        vSigChecks.reserve(block.vptx.size());
+
     // Check for duplicate txids. This is caught by ConnectInputs(),
     // but catching it earlier avoids a potential DoS attack:
     set<uint256> uniqueTx;
     for (uint32_t i = 0; i < block.vptx.size(); i++) {
         uniqueTx.insert(block.GetTxid(i));
 
-        if (fCheckTx && !block.vptx[i]->CheckTx(block.GetHeight(), cw, state))
-            return ERRORMSG("CheckBlock() : CheckTx failed, txid: %s", block.vptx[i]->GetHash().GetHex());
+        if (fCheckTx) {
+            CDeferredSigChecksGuard guard(fParallelSigCheck ? &vSigChecks : nullptr);
+            if (!block.vptx[i]->CheckTx(block.GetHeight(), cw, state))
+                return ERRORMSG("CheckBlock() : CheckTx failed, txid: %s", block.vptx[i]->GetHash().GetHex());
+        }
 
         if (block.GetHeight() != 0 || block.GetHash() != SysCfg().GetGenesisBlockHash()) {
             if (0 != i && block.vptx[i]->IsBlockRewardTx())
@@ -2058,6 +2187,20 @@ bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw,
         return state.DoS(100, ERRORMSG("CheckBlock() : duplicate transaction"), REJECT_INVALID, "bad-tx-duplicated",
                          true);
 
+    if (fParallelSigCheck) {
+        int64_t nStart = GetTimeMicros();
+        if (!sigCheckQueue.Verify(vSigChecks, signatureCache))
+            return state.DoS(100, ERRORMSG("CheckBlock() : tx signature error, height: %u", block.GetHeight()),
+                             REJECT_INVALID, "bad-tx-signature");
+
+        if (SysCfg().IsBenchmark()) {
+            int64_t nTime = GetTimeMicros() - nStart;
+            LogPrint(LOG_CATEGORY_BENCH, "- Verify %u signatures: %.2fms (%.3fms/sig) with %u threads\n",
+                     vSigChecks.size(), MILLI * nTime, vSigChecks.empty() ? 0 : MILLI * nTime / vSigChecks.size(),
+                     sigCheckQueue.GetThreadCount());
+        }
+    }
+
     // Check merkle root
     if (fCheckMerkleRoot && block.GetMerkleRootHash() != block.vMerkleTree.back())
         return state.DoS(100, ERRORMSG("CheckBlock() : merkleRootHash mismatch, height: %u, merkleRootHash(in block: %s vs calculate: %s)",
@@ -2148,10 +2291,26 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp) {
 
     // Relay inventory, but don't relay old inventory during initial block download
     if (chainActive.Tip()->GetBlockHash() == blockHash) {
+        CInv inv(MSG_BLOCK, blockHash);
+        std::unique_ptr<CCompactBlock> pCmpctBlock;
         LOCK(cs_vNodes);
         for (auto pNode : vNodes) {
-            if (chainActive.Height() > (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
-                pNode->PushInventory(CInv(MSG_BLOCK, blockHash));
+            if (chainActive.Height() <= (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
+                continue;
+
+            // pushed at once to the peers asking for compact blocks, saving them the inv and getdata round trip
+            if (fCompactBlocks && pNode->fSendCompactBlocks) {
+                if (!pNode->AddInventoryKnown(inv))
+                    continue;
+
+                if (!pCmpctBlock) {
+                    pCmpctBlock.reset(new CCompactBlock(block, GetRand(std::numeric_limits<uint64_t>::max())));
+                    SetMostRecentCompactBlock(std::make_shared<const CBlock>(block));
+                }
+                pNode->PushMessage("cmpctblock", *pCmpctBlock);
+            } else {
+                pNode->PushInventory(inv);
+            }
         }
     }
 
@@ -2280,12 +2439,17 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
     AssertLockHeld(cs_main);
     // Check for duplicate
     uint256 blockHash = pBlock->GetHash();
-    if (mapBlockIndex.count(blockHash))
-        return state.Invalid(ERRORMSG("ProcessBlock() : block exists: %d %s",
-                            mapBlockIndex[blockHash]->height, blockHash.ToString()), 0, "duplicate");
+    // expected for the blocks relayed by several peers, not an error
+    if (mapBlockIndex.count(blockHash)) {
+        LogPrint("net", "ProcessBlock() : block exists: %d %s\n", mapBlockIndex[blockHash]->height,
+                 blockHash.ToString());
+        return state.Invalid(false, 0, "duplicate");
+    }
 
-    if (mapOrphanBlocks.count(blockHash))
-        return state.Invalid(ERRORMSG("ProcessBlock() : block (orphan) exists %s", blockHash.ToString()), 0, "duplicate");
+    if (mapOrphanBlocks.count(blockHash)) {
+        LogPrint("net", "ProcessBlock() : block (orphan) exists %s\n", blockHash.ToString());
+        return state.Invalid(false, 0, "duplicate");
+    }
 
     int64_t llBeginCheckBlockTime = GetTimeMillis();
     auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
@@ -2323,6 +2487,10 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
                 setOrphanBlock.insert(pblock2);
             }
 
+            // the parents of the blocks in the header chain are requested in the download window
+            if (headersSync.Contains(blockHash))
+                return true;
+
             // Ask this guy to fill in what we're missing
             LogPrint("net", "receive an orphan block height=%d hash=%s, %s it, leading to getblocks (current height=%d & orphan blocks=%d)\n",
                     pBlock->GetHeight(), pBlock->GetHash().GetHex(), success ? "keep" : "abandon",
@@ -2575,6 +2743,12 @@ bool static LoadBlockIndexDB() {
     SysCfg().SetTxIndex(bTxIndex);
     LogPrint("INFO", "LoadBlockIndexDB(): transaction index %s\n", bTxIndex ? "enabled" : "disabled");
 
+    // Check whether we have an address index
+    bool bAddressIndex = SysCfg().IsAddressIndex();
+    pCdMan->pBlockTreeDb->ReadFlag("addressindex", bAddressIndex);
+    SysCfg().SetAddressIndex(bAddressIndex);
+    LogPrint("INFO", "LoadBlockIndexDB(): address index %s\n", bAddressIndex ? "enabled" : "disabled");
+
     // Load pointer to end of best chain
     uint256 bestBlockHash = pCdMan->pAccountCache->GetBestBlock();
     const auto &it = mapBlockIndex.find(bestBlockHash);
@@ -2583,6 +2757,7 @@ bool static LoadBlockIndexDB() {
     }
 
     chainActive.SetTip(it->second);
+    PublishChainTip();
     LogPrint("INFO", "LoadBlockIndexDB(): hashBestChain=%s height=%d date=%s\n",
              chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(),
              DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()));
@@ -2680,9 +2855,13 @@ bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth) {
 }
 
 void UnloadBlockIndex() {
-    mapBlockIndex.clear();
+    {
+        LOCK(cs_mapBlockIndex);
+        mapBlockIndex.clear();
+    }
     setBlockIndexValid.clear();
     chainActive.SetTip(nullptr);
+    PublishChainTip();
     pindexBestInvalid = nullptr;
 }
 
@@ -2702,6 +2881,9 @@ bool InitBlockIndex() {
     // Use the provided setting for -txindex in the new database
     SysCfg().SetTxIndex(SysCfg().GetBoolArg("-txindex", true));
     pCdMan->pBlockTreeDb->WriteFlag("txindex", SysCfg().IsTxIndex());
+    // Use the provided setting for -addressindex in the new database
+    SysCfg().SetAddressIndex(SysCfg().GetBoolArg("-addressindex", false));
+    pCdMan->pBlockTreeDb->WriteFlag("addressindex", SysCfg().IsAddressIndex());
     LogPrint("INFO", "Initializing databases...\n");
 
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -2918,10 +3100,7 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
     //     return true;
     // }
 
-    {
-        LOCK(cs_main);
-        State(pFrom->GetId())->nLastBlockProcess = GetTimeMicros();
-    }
+    pFrom->nLastMsgProcess = GetTimeMicros();
 
     if (strCommand == "version") {
         int32_t res = ProcessVersionMessage(pFrom,strCommand, vRecv);
@@ -2937,6 +3116,9 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
 
     else if (strCommand == "verack") {
         pFrom->SetRecvVersion(min(pFrom->nVersion, PROTOCOL_VERSION));
+        // ask for the new blocks pushed as compact blocks
+        if (fCompactBlocks)
+            pFrom->PushMessage("sendcmpct", true, COMPACT_BLOCKS_VERSION);
     }
 
     else if (strCommand == "addr") {
@@ -2963,6 +3145,11 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
            return true;
     }
 
+    else if (strCommand == "headers" && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessHeadersMessage(pFrom, vRecv))
+            return false;
+    }
+
     else if (strCommand == "tx") {
         if(!ProcessTxMessage(pFrom, strCommand , vRecv))
             return false ;
@@ -2973,8 +3160,29 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
         ProcessBlockMessage(pFrom, vRecv);
     }
 
+    else if (strCommand == "sendcmpct") {
+        ProcessSendCmpctMessage(pFrom, vRecv);
+    }
+
+    else if (strCommand == "cmpctblock" && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessCompactBlockMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == "getblocktxn") {
+        if (!ProcessGetBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == "blocktxn" && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        ProcessBlockTxnMessage(pFrom, vRecv);
+    }
+
     else if (strCommand == "getaddr") {
-        pFrom->vAddrToSend.clear();
+        {
+            LOCK(pFrom->cs_addr);
+            pFrom->vAddrToSend.clear();
+        }
         vector<CAddress> vAddr = addrman.GetAddr();
         for (const auto &addr : vAddr)
             pFrom->PushAddress(addr);
@@ -3151,6 +3359,61 @@ bool ProcessMessages(CNode *pFrom) {
     return fOk;
 }
 
+// Requires cs_main.
+static void PushGetHeaders(CNode *pNode) {
+    // the last header first for the peer to continue after it, then the active chain in case the peer reorganized
+    CBlockLocator locator = chainActive.GetLocator();
+    if (headersSync.GetHeight() > chainActive.Height())
+        locator.vHave.insert(locator.vHave.begin(), headersSync.GetHash(headersSync.GetHeight()));
+    pNode->PushMessage("getheaders", locator, uint256());
+    headersSync.SetRequestTime(GetTimeMicros());
+    LogPrint("net", "getheaders from peer %s, header height=%d\n", pNode->addr.ToString(), headersSync.GetHeight());
+}
+
+// Requires cs_main. Whether the block next to the tip, in flight from the peer, holds up the validation of the
+// download window, most of which has arrived from the other peers.
+static bool IsStallingDownloadWindow(CNode *pNode, int64_t nNow) {
+    auto it = mapBlocksInFlight.find(headersSync.GetHash(chainActive.Height() + 1));
+    return it != mapBlocksInFlight.end() && it->second.first == pNode->GetId() &&
+           it->second.second->nTime < nNow - BLOCK_STALLING_TIMEOUT * 1000000 &&
+           mapOrphanBlocks.size() >= (size_t)BLOCK_DOWNLOAD_WINDOW / 2;
+}
+
+// Requires cs_main. Request the blocks of the header chain in the download window above the tip from the peer,
+// which is expected to have the blocks up to its starting height, or all of them if it is the sync peer.
+static void RequestDownloadWindow(CNode *pNode, CNodeState &state, vector<CInv> &vGetData) {
+    int32_t nTipHeight = chainActive.Height();
+    int32_t nEndHeight = min(headersSync.GetHeight(), nTipHeight + BLOCK_DOWNLOAD_WINDOW);
+    if (pNode->GetId() != headersSync.GetPeer())
+        nEndHeight = min(nEndHeight, pNode->nStartingHeight);
+
+    for (int32_t height = nTipHeight + 1;
+         height <= nEndHeight && state.nBlocksInFlight < MAX_WINDOW_BLOCKS_IN_TRANSIT_PER_PEER; ++height) {
+        uint256 hash = headersSync.GetHash(height);
+        if (hash.IsNull() || mapBlocksInFlight.count(hash) || mapOrphanBlocks.count(hash) || mapBlockIndex.count(hash))
+            continue;
+
+        vGetData.push_back(CInv(MSG_BLOCK, hash));
+        MarkBlockAsInFlight(pNode->GetId(), hash, true);
+        LogPrint("net", "Requesting block %d %s of the download window from %s, nBlocksInFlight=%d\n", height,
+                 hash.ToString(), state.name, state.nBlocksInFlight);
+    }
+}
+
+// Requires cs_main. Drop the requests of the download window unanswered for BLOCK_DOWNLOAD_TIMEOUT, instead of
+// disconnecting the peer, which may not have the blocks of the header chain, so that the other peers are asked.
+static void ExpireDownloadWindow(CNodeState &state, int64_t nNow) {
+    vector<uint256> vExpired;
+    for (const auto &queued : state.vBlocksInFlight) {
+        if (queued.fWindow && queued.nTime < nNow - BLOCK_DOWNLOAD_TIMEOUT * 1000000)
+            vExpired.push_back(queued.hash);
+    }
+    for (const auto &hash : vExpired) {
+        LogPrint("net", "Request of block %s of the download window from %s expired\n", hash.ToString(), state.name);
+        MarkBlockAsReceived(hash);
+    }
+}
+
 bool SendMessages(CNode *pTo, bool fSendTrickle) {
     {
         // Don't send anything until we get their version message
@@ -3198,8 +3461,10 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
                 LOCK(cs_vNodes);
                 for (auto pNode : vNodes) {
                     // Periodically clear setAddrKnown to allow refresh broadcasts
-                    if (nLastRebroadcast)
+                    if (nLastRebroadcast) {
+                        LOCK(pNode->cs_addr);
                         pNode->setAddrKnown.clear();
+                    }
 
                     // Rebroadcast our address
                     if (!fNoListen) {
@@ -3216,20 +3481,28 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         // Message: addr
         //
         if (fSendTrickle) {
+            vector<CAddress> vAddrNew;
+            {
+                LOCK(pTo->cs_addr);
+                vAddrNew.reserve(pTo->vAddrToSend.size());
+                for (const auto &addr : pTo->vAddrToSend) {
+                    // returns true if wasn't already contained in the set
+                    if (pTo->setAddrKnown.insert(addr).second)
+                        vAddrNew.push_back(addr);
+                }
+                pTo->vAddrToSend.clear();
+            }
+
             vector<CAddress> vAddr;
-            vAddr.reserve(pTo->vAddrToSend.size());
-            for (const auto &addr : pTo->vAddrToSend) {
-                // returns true if wasn't already contained in the set
-                if (pTo->setAddrKnown.insert(addr).second) {
-                    vAddr.push_back(addr);
-                    // receiver rejects addr messages larger than 1000
-                    if (vAddr.size() >= 1000) {
-                        pTo->PushMessage("addr", vAddr);
-                        vAddr.clear();
-                    }
+            vAddr.reserve(min<size_t>(vAddrNew.size(), 1000));
+            for (const auto &addr : vAddrNew) {
+                vAddr.push_back(addr);
+                // receiver rejects addr messages larger than 1000
+                if (vAddr.size() >= 1000) {
+                    pTo->PushMessage("addr", vAddr);
+                    vAddr.clear();
                 }
             }
-            pTo->vAddrToSend.clear();
             if (!vAddr.empty())
                 pTo->PushMessage("addr", vAddr);
         }
@@ -3255,8 +3528,30 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         if (pTo->fStartSync && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
             pTo->fStartSync = false;
             nSyncTipHeight  = pTo->nStartingHeight;
-            LogPrint("net", "start block sync lead to getblocks\n");
-            PushGetBlocks(pTo, chainActive.Tip(), uint256());
+            if (headersSync.IsEnabled()) {
+                LogPrint("net", "start block sync lead to getheaders\n");
+                headersSync.Start(pTo->GetId(), chainActive.Tip());
+            } else {
+                LogPrint("net", "start block sync lead to getblocks\n");
+                PushGetBlocks(pTo, chainActive.Tip(), uint256());
+            }
+        }
+
+        // Sync the headers ahead of the download window
+        if (pTo->GetId() == headersSync.GetPeer()) {
+            if (headersSync.IsStalling(GetTimeMicros())) {
+                // no peer has served the next block of the header chain, which the header peer has claimed to have
+                LogPrint("INFO", "Misbehaving: the download window stalled at height %d in the header chain of peer "
+                         "%s, stop syncing headers\n", chainActive.Height() + 1, state.name);
+                Misbehaving(pTo->GetId(), 100);
+                headersSync.Clear();
+            } else if (headersSync.NeedMoreHeaders()) {
+                PushGetHeaders(pTo);
+            } else if (headersSync.GetRequestTime() &&
+                       headersSync.GetRequestTime() < GetTimeMicros() - BLOCK_DOWNLOAD_TIMEOUT * 1000000) {
+                LogPrint("INFO", "Peer %s is stalling headers download, disconnecting\n", state.name);
+                pTo->fDisconnect = true;
+            }
         }
 
         // Resend wallet transactions that haven't gotten in a block yet
@@ -3313,18 +3608,29 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         // received a (requested) block in one minute, and that all blocks are
         // in flight for over two minutes, since we first had a chance to
         // process an incoming block.
+        // The requests of the download window are expired instead.
         int64_t nNow = GetTimeMicros();
-        if (!pTo->fDisconnect && state.nBlocksInFlight &&
-            state.nLastBlockReceive < state.nLastBlockProcess - BLOCK_DOWNLOAD_TIMEOUT * 1000000 &&
-            state.vBlocksInFlight.front().nTime < state.nLastBlockProcess - 2 * BLOCK_DOWNLOAD_TIMEOUT * 1000000) {
+        auto itOldest = std::find_if(state.vBlocksInFlight.begin(), state.vBlocksInFlight.end(),
+                                [](const QueuedBlock &queued) { return !queued.fWindow; });
+        if (!pTo->fDisconnect && itOldest != state.vBlocksInFlight.end() &&
+            state.nLastBlockReceive < pTo->nLastMsgProcess - BLOCK_DOWNLOAD_TIMEOUT * 1000000 &&
+            itOldest->nTime < pTo->nLastMsgProcess - 2 * BLOCK_DOWNLOAD_TIMEOUT * 1000000) {
             LogPrint("INFO", "Peer %s is stalling block download, disconnecting\n", state.name.c_str());
             pTo->fDisconnect = true;
         }
+        if (!pTo->fDisconnect && headersSync.IsSyncing() && IsStallingDownloadWindow(pTo, nNow)) {
+            LogPrint("INFO", "Peer %s is stalling the download window at height %d, disconnecting\n",
+                     state.name, chainActive.Height() + 1);
+            pTo->fDisconnect = true;
+        }
 
         //
         // Message: getdata (blocks)
         //
         vector<CInv> vGetData;
+        ExpireDownloadWindow(state, nNow);
+        if (!pTo->fDisconnect && !pTo->fClient && headersSync.IsSyncing())
+            RequestDownloadWindow(pTo, state, vGetData);
         int32_t index(0);
         while (!pTo->fDisconnect && state.nBlocksToDownload && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
             uint256 hash = state.vBlocksToDownload.front();
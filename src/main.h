@@ -30,6 +30,7 @@
 #include "persistence/block.h"
 #include "persistence/blockdb.h"
 #include "persistence/cachewrapper.h"
+#include "persistence/dbflusher.h"
 #include "persistence/delegatedb.h"
 #include "persistence/dexdb.h"
 #include "persistence/logdb.h"
@@ -62,9 +63,15 @@ class CBlockTreeDB;
 class CSysParamDBCache;
 
 extern CCriticalSection cs_main;
+/**
+ * Guards the changes of the entries of mapBlockIndex together with the published tip of chainActive, for the
+ * readers without cs_main. The writers hold cs_main as well, so the readers holding cs_main need not take it.
+ */
+extern CCriticalSection cs_mapBlockIndex;
 /** The currently-connected chain of blocks. */
 extern CChain chainActive;
 extern CSignatureCache signatureCache;
+extern CSignatureCheckQueue sigCheckQueue;
 
 extern CTxMemPool mempool;
 extern map<uint256, CBlockIndex *> mapBlockIndex;
@@ -128,6 +135,9 @@ void Misbehaving(NodeId nodeid, int32_t howmuch);
 bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signature, const CPubKey &pubKey);
 
 /** (try to) add transaction to memory pool **/
+bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, const std::shared_ptr<CBaseTx> &spBaseTx,
+                        bool fLimitFree, bool fRejectInsaneFee = false);
+/** (try to) add a copy of the transaction to memory pool **/
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
                         bool fLimitFree, bool fRejectInsaneFee = false);
 
@@ -135,6 +145,14 @@ std::shared_ptr<CBaseTx> CreateNewEmptyTransaction(uint8_t txType);
 
 struct CNodeStateStats {
     int32_t nMisbehavior;
+    uint32_t nCmpctBlocks;            // compact blocks received
+    uint32_t nCmpctBlockRoundTrips;   // compact blocks completed by getblocktxn
+    uint32_t nCmpctBlockFailures;     // compact blocks downloaded in full
+    uint64_t nCmpctTxsFound;          // txs of the compact blocks found locally
+    uint64_t nCmpctTxsMissing;        // txs of the compact blocks requested by getblocktxn
+    int64_t nCmpctReconstructMillis;  // total time from the compact blocks to the full blocks
+    uint32_t nRelayedBlocks;          // new blocks received at the tip
+    int64_t nRelayLatencyMillis;      // total time from the block time to the full blocks received at the tip
 };
 
 /** Check for standard transaction types
@@ -199,6 +217,51 @@ public:
     CBlockIndex *FindFork(const CBlockLocator &locator) const;
 }; //end of CChain
 
+/**
+ * An immutable view of chainActive at a published tip, for the p2p handlers serving the chain without cs_main.
+ * The block index entries are never freed while the node runs, and the hash, height, pprev and pskip of an entry
+ * never change once it is in mapBlockIndex, so the chain below a tip stays the same after chainActive moves on.
+ * The blocks are found by walking the skip list from the tip, O(log n) per lookup.
+ */
+class CChainSnapshot {
+private:
+    const CBlockIndex *pTip;
+
+public:
+    CChainSnapshot(const CBlockIndex *pTipIn = nullptr) : pTip(pTipIn) {}
+
+    const CBlockIndex *Tip() const { return pTip; }
+
+    int32_t Height() const { return pTip ? pTip->height : -1; }
+
+    /** Returns the index entry at a particular height in this chain, or nullptr if no such height exists. */
+    const CBlockIndex *operator[](int32_t height) const {
+        if (pTip == nullptr || height < 0 || height > pTip->height)
+            return nullptr;
+        return pTip->GetAncestor(height);
+    }
+
+    bool Contains(const CBlockIndex *pIndex) const {
+        return pIndex != nullptr && (*this)[pIndex->height] == pIndex;
+    }
+
+    /** Find the successor of a block in this chain, or nullptr if the given index is not found or is the tip. */
+    const CBlockIndex *Next(const CBlockIndex *pIndex) const {
+        if (Contains(pIndex))
+            return (*this)[pIndex->height + 1];
+        else
+            return nullptr;
+    }
+
+    /** Find the last common block between this chain and a locator. */
+    const CBlockIndex *FindFork(const CBlockLocator &locator) const;
+};
+
+/** The snapshot of chainActive at its last tip update, no cs_main required. */
+CChainSnapshot GetChainSnapshot();
+/** Find the block index entry of the hash, no cs_main required. Returns nullptr if not found. */
+CBlockIndex *LookupBlockIndex(const uint256 &hash);
+
 
 
 class CCacheDBManager {
@@ -234,6 +297,8 @@ public:
     CTxMemCache         *pTxCache;
     CPricePointMemCache *pPpCache;
 
+    CDBFlusher          *pDbFlusher;
+
 public:
     CCacheDBManager(bool fReIndex, bool fMemory, size_t nAccountDBCache, size_t nContractDBCache,
                     size_t nDelegateDBCache, size_t nBlockTreeDBCache) {
@@ -269,9 +334,16 @@ public:
         // memory-only cache
         pTxCache        = new CTxMemCache();
         pPpCache        = new CPricePointMemCache();
+
+        pDbFlusher      = new CDBFlusher({pSysParamDb, pAccountDb, pAssetDb, pContractDb, pDelegateDb, pCdpDb,
+                                          pDexDb, pLogDb, pTxReceiptDb}, GetDataDir() / "blocks" / "dbjournal.dat");
+        pDbFlusher->Start();
     }
 
     ~CCacheDBManager() {
+        // write the pending flush before the dbs are closed
+        delete pDbFlusher;      pDbFlusher = nullptr;
+
         delete pSysParamCache;  pSysParamCache = nullptr;
         delete pAccountCache;   pAccountCache = nullptr;
         delete pAssetCache;     pAssetCache = nullptr;
@@ -298,7 +370,14 @@ public:
         delete pPpCache;        pPpCache = nullptr;
     }
 
-    bool Flush() {
+    /**
+     * Flush the caches into the dbs as one atomic write. With fAsync the write runs in the flusher thread,
+     * and the flushed data is read from the frozen layers of the caches until written.
+     */
+    bool Flush(bool fAsync = false) {
+        if (!pDbFlusher->BeginFlush())
+            return false;
+
         if (pSysParamCache) pSysParamCache->Flush();
 
         if (pAccountCache) pAccountCache->Flush();
@@ -325,7 +404,7 @@ public:
         // if (pPpCache)
         //     pPpCache->Flush();
 
-        return true;
+        return pDbFlusher->EndFlush(fAsync);
     }
 };  // CCacheDBManager
 
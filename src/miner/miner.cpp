@@ -69,43 +69,16 @@ uint32_t GetElementForBurn(CBlockIndex *pIndex) {
     return newFuelRate;
 }
 
-// Sort transactions by priority and fee to decide priority orders to process transactions.
-void GetPriorityTx(vector<TxPriority> &vecPriority, const int32_t nFuelRate) {
+// Collect the unconfirmed transactions in the order of priority and fee rate, which the mempool keeps indexed.
+void GetPriorityTx(vector<TxPriority> &vecPriority) {
     vecPriority.reserve(mempool.memPoolTxs.size());
-    static double dPriority      = 0;
-    static double dFeePerKb      = 0;
-    static uint32_t nTxSize      = 0;
-    static TokenSymbol feeSymbol = SYMB::WUSD;
-    static uint64_t nFees        = 0;
-
-    uint64_t slideWindow;
-    pCdMan->pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
-    int32_t height = chainActive.Height();
-    // fee symbol should be WICC or WUSD only.
-    uint64_t scoinMedianPrice = 1 * PRICE_BOOST;
-    uint64_t bcoinMedianPrice = pCdMan->pPpCache->GetMedianPrice(height, slideWindow, CoinPricePair(SYMB::WICC, SYMB::USD));
-
-    auto GetFeeMedianPrice = [&](const TokenSymbol &symbol) -> uint64_t {
-        if (symbol == SYMB::WICC)
-            return bcoinMedianPrice;
-        else if (symbol == SYMB::WUSD)
-            return scoinMedianPrice;
-        else
-            return 0;
-    };
 
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi) {
-        CBaseTx *pBaseTx = mi->second.GetTransaction().get();
-        if (!pBaseTx->IsBlockRewardTx() && pCdMan->pTxCache->HaveTx(pBaseTx->GetHash()) == uint256()) {
-            nTxSize   = mi->second.GetTxSize();
-            feeSymbol = std::get<0>(mi->second.GetFees());
-            nFees     = std::get<1>(mi->second.GetFees());
-            dFeePerKb = (double(GetFeeMedianPrice(feeSymbol)) / PRICE_BOOST) * (nFees - pBaseTx->GetFuel(nFuelRate)) /
-                        (nTxSize / 1000.0);
-            LogPrint("MINER", "GetPriority, medianPrice: %llu, nFees: %llu, fuel: %llu, nTxSize: %u\n",
-                     GetFeeMedianPrice(feeSymbol), nFees, pBaseTx->GetFuel(nFuelRate), nTxSize);
-            dPriority = mi->second.GetPriority();
-            vecPriority.push_back(TxPriority(dPriority, dFeePerKb, mi->second.GetTransaction()));
+    for (const auto &entry : mempool.memPoolTxs.get<priority_tag>()) {
+        CBaseTx *pBaseTx = entry.GetTransaction().get();
+        if (!pBaseTx->IsBlockRewardTx() && pCdMan->pTxCache->HaveTx(entry.GetHash()) == uint256()) {
+            LogPrint("MINER", "GetPriorityTx, priority: %f, feePerKb: %f, nTxSize: %u\n", entry.GetPriority(),
+                     entry.GetFeePerKb(), entry.GetTxSize());
+            vecPriority.push_back(TxPriority(entry.GetPriority(), entry.GetFeePerKb(), entry.GetTransaction()));
         }
     }
 }
@@ -209,7 +182,7 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx)
     if (pBlock->GetMerkleRootHash() != pBlock->BuildMerkleTree())
         return ERRORMSG("VerifyRewardTx() : wrong merkle root hash");
 
-    auto spCW = std::make_shared<CCacheWrapper>(cwIn);
+    CCacheSnapshot snapshot(cwIn);
 
     CBlockIndex *pBlockIndex = mapBlockIndex[pBlock->GetPrevBlockHash()];
     if (pBlock->GetHeight() != 1 || pBlock->GetPrevBlockHash() != SysCfg().GetGenesisBlockHash()) {
@@ -218,7 +191,7 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx)
             return ERRORMSG("VerifyRewardTx() : read block info failed from disk");
 
         CAccount prevDelegateAcct;
-        if (!spCW->accountCache.GetAccount(previousBlock.vptx[0]->txUid, prevDelegateAcct))
+        if (!snapshot->accountCache.GetAccount(previousBlock.vptx[0]->txUid, prevDelegateAcct))
             return ERRORMSG("VerifyRewardTx() : failed to get previous delegate's account, regId=%s",
                 previousBlock.vptx[0]->txUid.ToString());
 
@@ -229,7 +202,7 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx)
     }
 
     CAccount account;
-    if (spCW->accountCache.GetAccount(pBlock->vptx[0]->txUid, account)) {
+    if (snapshot->accountCache.GetAccount(pBlock->vptx[0]->txUid, account)) {
         if (curDelegate.regid != account.regid) {
             return ERRORMSG("VerifyRewardTx() : delegate should be (%s) vs what we got (%s)",
                             curDelegate.regid.ToString(), account.regid.ToString());
@@ -257,11 +230,11 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx)
         uint64_t totalRunStep = 0;
         for (uint32_t i = 1; i < pBlock->vptx.size(); i++) {
             shared_ptr<CBaseTx> pBaseTx = pBlock->vptx[i];
-            if (spCW->txCache.HaveTx(pBaseTx->GetHash()) != uint256())
+            if (snapshot->txCache.HaveTx(pBaseTx->GetHash()) != uint256())
                 return ERRORMSG("VerifyRewardTx() : duplicate transaction, txid=%s", pBaseTx->GetHash().GetHex());
 
             CValidationState state;
-            if (!pBaseTx->ExecuteTx(pBlock->GetHeight(), i, *spCW, state)) {
+            if (!pBaseTx->ExecuteTx(pBlock->GetHeight(), i, *snapshot, state)) {
                 if (SysCfg().IsLogFailures()) {
                     pCdMan->pLogCache->SetExecuteFail(pBlock->GetHeight(), pBaseTx->GetHash(), state.GetRejectCode(),
                                                       state.GetRejectReason());
@@ -288,122 +261,191 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx)
     return true;
 }
 
-std::unique_ptr<CBlock> CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn) {
-    // Create new block
-    std::unique_ptr<CBlock> pBlock(new CBlock());
-    if (!pBlock.get())
-        return nullptr;
+void CBlockTemplate::Start(CBlock *pBlockIn, const uint32_t blockMaxSizeIn) {
+    pBlock         = pBlockIn;
+    height         = pBlock->GetHeight();
+    index          = pBlock->vptx.size() - 1;  // the reward txs are in front of the packed txs
+    fuelRate       = pBlock->GetFuelRate();
+    blockMaxSize   = blockMaxSizeIn;
+    totalBlockSize = ::GetSerializeSize(*pBlock, SER_NETWORK, PROTOCOL_VERSION);
+    totalRunStep   = 0;
+    totalFees      = 0;
+    totalFuel      = 0;
+    buildTime      = 0;
+    rewards        = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
+    setTriedTxs.clear();
+    txCw.Clear();
+}
 
-    pBlock->vptx.push_back(std::make_shared<CBlockRewardTx>());
+uint32_t CBlockTemplate::Fill(const int64_t deadline) {
+    assert(pBlock != nullptr);
+    int64_t startTime = GetTimeMillis();
+
+    // Get transactions sorted by priority rules from memory pool, priority by size first.
+    vector<TxPriority> txPriorities;
+    GetPriorityTx(txPriorities);
+    LogPrint("MINER", "CBlockTemplate::Fill() : got %lu transaction(s) sorted by priority rules\n",
+             txPriorities.size());
+
+    // Collect transactions into the block, except for those tried already.
+    uint32_t packedCount = 0;
+    for (auto iter = txPriorities.begin(); iter != txPriorities.end(); ++iter) {
+        if (deadline > 0 && GetTimeMillis() >= deadline) {
+            LogPrint("MINER", "CBlockTemplate::Fill() : reach the deadline, %lu transaction(s) left\n",
+                     txPriorities.end() - iter);
+            break;
+        }
 
-    // Largest block you're willing to create:
-    uint32_t nBlockMaxSize = SysCfg().GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
-    // Limit to between 1K and MAX_BLOCK_SIZE-1K for sanity:
-    nBlockMaxSize = std::max((uint32_t)1000, std::min((uint32_t)(MAX_BLOCK_SIZE - 1000), nBlockMaxSize));
+        if (setTriedTxs.count(std::get<2>(*iter)->GetHash()))
+            continue;
 
-    // Collect memory pool transactions into the block
-    {
-        LOCK2(cs_main, mempool.cs);
+        if (PackTx(*iter))
+            ++packedCount;
+    }
 
-        CBlockIndex *pIndexPrev = chainActive.Tip();
-        int32_t height          = pIndexPrev->height + 1;
-        int32_t index           = 0; // block reward tx
-        uint32_t fuelRate       = GetElementForBurn(pIndexPrev);
-        uint64_t totalBlockSize = ::GetSerializeSize(*pBlock, SER_NETWORK, PROTOCOL_VERSION);
-        uint64_t totalRunStep   = 0;
-        uint64_t totalFees      = 0;
-        uint64_t totalFuel      = 0;
-        uint64_t reward         = 0;
-
-        // Calculate && sort transactions from memory pool.
-        vector<TxPriority> txPriorities;
-        GetPriorityTx(txPriorities, fuelRate);
-        TxPriorityCompare comparer(false); // Priority by size first.
-        make_heap(txPriorities.begin(), txPriorities.end(), comparer);
-        LogPrint("MINER", "CreateNewBlockPreStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
-
-        // Collect transactions into the block.
-        for (auto item : txPriorities) {
-
-            CBaseTx *pBaseTx = std::get<2>(item).get();
-
-            uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
-            if (totalBlockSize + txSize >= nBlockMaxSize) {
-                LogPrint("MINER", "CreateNewBlockPreStableCoinRelease() : exceed max block size, txid: %s\n",
-                         pBaseTx->GetHash().GetHex());
-                continue;
-            }
+    buildTime += GetTimeMillis() - startTime;
 
-            auto spCW = std::make_shared<CCacheWrapper>(cwIn);
+    return packedCount;
+}
 
-            try {
-                CValidationState state;
-                pBaseTx->nFuelRate = fuelRate;
-                if (!pBaseTx->CheckTx(height, *spCW, state) || !pBaseTx->ExecuteTx(height, index + 1, *spCW, state)) {
-                    LogPrint("MINER", "CreateNewBlockPreStableCoinRelease() : failed to pack transaction, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
+bool CBlockTemplate::PackTx(const TxPriority &item) {
+    CBaseTx *pBaseTx = std::get<2>(item).get();
+    setTriedTxs.insert(pBaseTx->GetHash());
 
-                    if (SysCfg().IsLogFailures())
-                        pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                        state.GetRejectReason());
-                    continue;
-                }
+    uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
+    if (totalBlockSize + txSize >= blockMaxSize) {
+        LogPrint("MINER", "CBlockTemplate::PackTx() : exceed max block size, txid: %s\n", pBaseTx->GetHash().GetHex());
+        return false;
+    }
 
-                // Run step limits
-                if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
-                    LogPrint("MINER", "CreateNewBlockPreStableCoinRelease() : exceed max block run steps, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-                    continue;
-                }
-            } catch (std::exception &e) {
-                LogPrint("ERROR", "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
-                continue;
-            }
+    try {
+        CValidationState state;
+        pBaseTx->nFuelRate = fuelRate;
+        if (!pBaseTx->CheckTx(height, txCw, state) || !pBaseTx->ExecuteTx(height, index + 1, txCw, state)) {
+            LogPrint("MINER", "CBlockTemplate::PackTx() : failed to pack transaction, txid: %s\n",
+                     pBaseTx->GetHash().GetHex());
+
+            if (SysCfg().IsLogFailures())
+                pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
+                                                  state.GetRejectReason());
+            txCw.Clear();
+            return false;
+        }
+
+        // Run step limits
+        if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
+            LogPrint("MINER", "CBlockTemplate::PackTx() : exceed max block run steps, txid: %s\n",
+                     pBaseTx->GetHash().GetHex());
+            txCw.Clear();
+            return false;
+        }
+    } catch (std::exception &e) {
+        LogPrint("ERROR", "CBlockTemplate::PackTx() : unexpected exception: %s\n", e.what());
+        txCw.Clear();
+        return false;
+    }
 
-            // Need to re-sync all to cache layer except for transaction cache, as it depends on
-            // the global transaction cache to verify whether a transaction(txid) has been confirmed
-            // already in block.
-            spCW->Flush();
+    // Need to re-sync all to cache layer except for transaction cache, as it depends on
+    // the global transaction cache to verify whether a transaction(txid) has been confirmed
+    // already in block.
+    txCw.Flush();
+    // Leave the child layer empty and in sync with the template for the next transaction.
+    txCw.Clear();
 
-            auto fuel        = pBaseTx->GetFuel(fuelRate);
-            auto fees_symbol = std::get<0>(pBaseTx->GetFees());
-            auto fees        = std::get<1>(pBaseTx->GetFees());
-            assert(fees_symbol == SYMB::WICC);
+    auto fuel        = pBaseTx->GetFuel(fuelRate);
+    auto fees_symbol = std::get<0>(pBaseTx->GetFees());
+    auto fees        = std::get<1>(pBaseTx->GetFees());
+    assert(fees_symbol == SYMB::WICC ||
+           (fees_symbol == SYMB::WUSD && pBlock->vptx[0]->nTxType == UCOIN_BLOCK_REWARD_TX));
 
-            totalBlockSize += txSize;
-            totalRunStep += pBaseTx->nRunStep;
-            totalFuel += fuel;
-            totalFees += fees;
-            assert(fees >= fuel);
-            reward += (fees - fuel);
+    totalBlockSize += txSize;
+    totalRunStep += pBaseTx->nRunStep;
+    totalFuel += fuel;
+    totalFees += fees;
+    assert(fees >= fuel);
+    rewards[fees_symbol] += (fees - fuel);
 
-            ++index;
+    ++index;
 
-            pBlock->vptx.push_back(std::get<2>(item));
+    pBlock->vptx.push_back(std::get<2>(item));
 
-            LogPrint("fuel", "miner total fuel:%d, tx fuel:%d, runStep:%d, fuelRate:%d, txid:%s\n", totalFuel,
-                     pBaseTx->GetFuel(fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
-        }
+    LogPrint("fuel", "miner total fuel:%d, tx fuel:%d, runStep:%d, fuelRate:%d, txid:%s\n", totalFuel,
+             pBaseTx->GetFuel(fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
+
+    return true;
+}
+
+void CBlockTemplate::Update() {
+    assert(pBlock != nullptr);
+
+    if (pBlock->vptx[0]->nTxType == BLOCK_REWARD_TX) {
+        ((CBlockRewardTx *)pBlock->vptx[0].get())->reward_fees = rewards[SYMB::WICC];
+
+    } else if (pBlock->vptx[0]->nTxType == UCOIN_BLOCK_REWARD_TX) {
+        ((CUCoinBlockRewardTx *)pBlock->vptx[0].get())->reward_fees = rewards;
+
+        CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)pBlock->vptx[1].get();
+        map<CoinPricePair, uint64_t> mapMedianPricePoints;
+        uint64_t slideWindow;
+        cw.sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+        cw.ppCache.GetBlockMedianPricePoints(height, slideWindow, mapMedianPricePoints);
+        pPriceMedianTx->SetMedianPricePoints(mapMedianPricePoints);
+    }
+
+    pBlock->SetFuel(totalFuel);
+
+    nLastBlockTx                     = index + 1;
+    nLastBlockSize                   = totalBlockSize;
+    miningBlockInfo.txCount          = index + 1;
+    miningBlockInfo.totalBlockSize   = totalBlockSize;
+    miningBlockInfo.maxBlockSize     = blockMaxSize;
+    miningBlockInfo.candidateTxCount = setTriedTxs.size();
+    miningBlockInfo.buildTime        = buildTime;
+    miningBlockInfo.totalFees        = totalFees;
+}
+
+// Largest block you're willing to create
+static uint32_t GetBlockMaxSize() {
+    uint32_t nBlockMaxSize = SysCfg().GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
+    // Limit to between 1K and MAX_BLOCK_SIZE-1K for sanity:
+    return std::max((uint32_t)1000, std::min((uint32_t)(MAX_BLOCK_SIZE - 1000), nBlockMaxSize));
+}
+
+static void LogBlockTemplate(const char *name, const CBlockTemplate &blockTemplate) {
+    const CBlock *pBlock = blockTemplate.GetBlock();
+    LogPrint("INFO", "%s : height=%d, tx=%d, totalBlockSize=%llu, fill rate=%.2f%%, candidate tx=%llu, used %lld ms\n",
+             name, pBlock->GetHeight(), pBlock->vptx.size(), blockTemplate.GetBlockSize(),
+             100.0 * blockTemplate.GetBlockSize() / blockTemplate.GetBlockMaxSize(),
+             blockTemplate.GetCandidateTxCount(), blockTemplate.GetBuildTime());
+}
+
+std::unique_ptr<CBlock> CreateNewBlockPreStableCoinRelease(CBlockTemplate &blockTemplate) {
+    // Create new block
+    std::unique_ptr<CBlock> pBlock(new CBlock());
+    if (!pBlock.get())
+        return nullptr;
 
-        nLastBlockTx                   = index + 1;
-        nLastBlockSize                 = totalBlockSize;
-        miningBlockInfo.txCount        = index + 1;
-        miningBlockInfo.totalBlockSize = totalBlockSize;
-        miningBlockInfo.totalFees      = totalFees;
+    pBlock->vptx.push_back(std::make_shared<CBlockRewardTx>());
 
-        ((CBlockRewardTx *)pBlock->vptx[0].get())->reward_fees = reward;
+    // Collect memory pool transactions into the block
+    {
+        LOCK2(cs_main, mempool.cs);
+
+        CBlockIndex *pIndexPrev = chainActive.Tip();
 
         // Fill in header
         pBlock->SetPrevBlockHash(pIndexPrev->GetBlockHash());
         pBlock->SetNonce(0);
-        pBlock->SetHeight(height);
-        pBlock->SetFuel(totalFuel);
-        pBlock->SetFuelRate(fuelRate);
+        pBlock->SetHeight(pIndexPrev->height + 1);
+        pBlock->SetFuel(0);
+        pBlock->SetFuelRate(GetElementForBurn(pIndexPrev));
         UpdateTime(*pBlock, pIndexPrev);
 
-        LogPrint("INFO", "CreateNewBlockPreStableCoinRelease() : height=%d, tx=%d, totalBlockSize=%llu\n", height, index + 1,
-                 totalBlockSize);
+        blockTemplate.Start(pBlock.get(), GetBlockMaxSize());
+        blockTemplate.Fill(0);
+        blockTemplate.Update();
+
+        LogBlockTemplate("CreateNewBlockPreStableCoinRelease()", blockTemplate);
     }
 
     return pBlock;
@@ -441,7 +483,7 @@ std::unique_ptr<CBlock> CreateStableCoinGenesisBlock() {
 }
 
 
-std::unique_ptr<CBlock> CreateNewBlockStableCoinRelease(CCacheWrapper &cwIn) {
+std::unique_ptr<CBlock> CreateNewBlockStableCoinRelease(CBlockTemplate &blockTemplate) {
     // Create new block
     std::unique_ptr<CBlock> pBlock(new CBlock());
     if (!pBlock.get())
@@ -450,136 +492,31 @@ std::unique_ptr<CBlock> CreateNewBlockStableCoinRelease(CCacheWrapper &cwIn) {
     pBlock->vptx.push_back(std::make_shared<CUCoinBlockRewardTx>());
     pBlock->vptx.push_back(std::make_shared<CBlockPriceMedianTx>());
 
-    // Largest block you're willing to create:
-    uint32_t nBlockMaxSize = SysCfg().GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
-    // Limit to between 1K and MAX_BLOCK_SIZE-1K for sanity:
-    nBlockMaxSize = std::max((uint32_t)1000, std::min((uint32_t)(MAX_BLOCK_SIZE - 1000), nBlockMaxSize));
-
     // Collect memory pool transactions into the block
     {
         LOCK2(cs_main, mempool.cs);
 
-        CBlockIndex *pIndexPrev            = chainActive.Tip();
-        int32_t height                     = pIndexPrev->height + 1;
-        int32_t index                      = 1; // 0: block reward tx; 1: median price tx
-        uint32_t fuelRate                  = GetElementForBurn(pIndexPrev);
-        uint64_t totalBlockSize            = ::GetSerializeSize(*pBlock, SER_NETWORK, PROTOCOL_VERSION);
-        uint64_t totalRunStep              = 0;
-        uint64_t totalFees                 = 0;
-        uint64_t totalFuel                 = 0;
-        map<TokenSymbol, uint64_t> rewards = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
-
-        // Calculate && sort transactions from memory pool.
-        vector<TxPriority> txPriorities;
-        GetPriorityTx(txPriorities, fuelRate);
-        TxPriorityCompare comparer(false); // Priority by size first.
-        make_heap(txPriorities.begin(), txPriorities.end(), comparer);
-        LogPrint("MINER", "CreateNewBlockStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
-
-        auto startTime = std::chrono::steady_clock::now() ;
-        // Collect transactions into the block.
-        for (auto item : txPriorities) {
-            auto endTime    = std::chrono::steady_clock::now();
-            double costTime = std::chrono::duration<double>(endTime - startTime).count();
-            if (costTime >= GetBlockInterval(height) - 1) {
-                break;
-            }
-
-            CBaseTx *pBaseTx = std::get<2>(item).get();
-
-            uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
-            if (totalBlockSize + txSize >= nBlockMaxSize) {
-                LogPrint("MINER", "CreateNewBlockStableCoinRelease() : exceed max block size, txid: %s\n",
-                         pBaseTx->GetHash().GetHex());
-                continue;
-            }
-
-            auto spCW = std::make_shared<CCacheWrapper>(cwIn);
-
-            try {
-                CValidationState state;
-                pBaseTx->nFuelRate = fuelRate;
-                if (!pBaseTx->CheckTx(height, *spCW, state) || !pBaseTx->ExecuteTx(height, index + 1, *spCW, state)) {
-                    LogPrint("MINER", "CreateNewBlockStableCoinRelease() : failed to pack transaction, txid: %s\n",
-                             pBaseTx->GetHash().GetHex());
-
-                    if (SysCfg().IsLogFailures())
-                        pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                        state.GetRejectReason());
-                    continue;
-                }
-
-                // Run step limits
-                if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
-                    LogPrint("MINER", "CreateNewBlockStableCoinRelease() : exceed max block run steps, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-                    continue;
-                }
-            } catch (std::exception &e) {
-                LogPrint("ERROR", "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
-
-                continue;
-            }
-
-            // Need to re-sync all to cache layer except for transaction cache, as it depends on
-            // the global transaction cache to verify whether a transaction(txid) has been confirmed
-            // already in block.
-            spCW->Flush();
-
-            auto fuel        = pBaseTx->GetFuel(fuelRate);
-            auto fees_symbol = std::get<0>(pBaseTx->GetFees());
-            auto fees        = std::get<1>(pBaseTx->GetFees());
-            assert(fees_symbol == SYMB::WICC || fees_symbol == SYMB::WUSD);
-
-            totalBlockSize += txSize;
-            totalRunStep += pBaseTx->nRunStep;
-            totalFuel += fuel;
-            totalFees += fees;
-            assert(fees >= fuel);
-            rewards[fees_symbol] += (fees - fuel);
-
-            ++index;
-
-            pBlock->vptx.push_back(std::get<2>(item));
-
-            LogPrint("fuel", "miner total fuel:%d, tx fuel:%d, runStep:%d, fuelRate:%d, txid:%s\n", totalFuel,
-                     pBaseTx->GetFuel(fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
-
-        }
-
-        nLastBlockTx                   = index + 1;
-        nLastBlockSize                 = totalBlockSize;
-        miningBlockInfo.txCount        = index + 1;
-        miningBlockInfo.totalBlockSize = totalBlockSize;
-        miningBlockInfo.totalFees      = totalFees;
-
-        ((CUCoinBlockRewardTx *)pBlock->vptx[0].get())->reward_fees = rewards;
-
-        CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)pBlock->vptx[1].get();
-        map<CoinPricePair, uint64_t> mapMedianPricePoints;
-        uint64_t slideWindow;
-        cwIn.sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
-        cwIn.ppCache.GetBlockMedianPricePoints(height, slideWindow, mapMedianPricePoints);
-        pPriceMedianTx->SetMedianPricePoints(mapMedianPricePoints);
+        CBlockIndex *pIndexPrev = chainActive.Tip();
+        int32_t height          = pIndexPrev->height + 1;
 
         // Fill in header
         pBlock->SetPrevBlockHash(pIndexPrev->GetBlockHash());
         pBlock->SetNonce(0);
         pBlock->SetHeight(height);
-        pBlock->SetFuel(totalFuel);
-        pBlock->SetFuelRate(fuelRate);
+        pBlock->SetFuel(0);
+        pBlock->SetFuelRate(GetElementForBurn(pIndexPrev));
         UpdateTime(*pBlock, pIndexPrev);
 
-        LogPrint("INFO", "CreateNewBlockStableCoinRelease() : height=%d, tx=%d, totalBlockSize=%llu\n", height, index + 1,
-                 totalBlockSize);
+        blockTemplate.Start(pBlock.get(), GetBlockMaxSize());
+        blockTemplate.Fill(GetTimeMillis() + (GetBlockInterval(height) - 1) * 1000);
+        blockTemplate.Update();
+
+        LogBlockTemplate("CreateNewBlockStableCoinRelease()", blockTemplate);
     }
 
     return pBlock;
 }
 
-
-
 bool CheckWork(CBlock *pBlock, CWallet &wallet) {
     // Print block information
     pBlock->Print(*pCdMan->pAccountCache);
@@ -600,9 +537,26 @@ bool CheckWork(CBlock *pBlock, CWallet &wallet) {
 }
 
 bool static MineBlock(CBlock *pBlock, CWallet *pWallet, CBlockIndex *pIndexPrev, uint32_t txUpdated,
-                      CCacheWrapper &cw) {
+                      CCacheWrapper &cw, CBlockTemplate *pBlockTemplate) {
     int64_t nStart = GetTime();
 
+    // Keep the template warm by packing the transactions which arrived in mempool since the last fill.
+    auto TopUpTemplate = [&](const int64_t deadline) {
+        if (pBlockTemplate == nullptr || mempool.GetUpdatedTransactionNum() == txUpdated)
+            return;
+
+        LOCK2(cs_main, mempool.cs);
+        if (pIndexPrev != chainActive.Tip())
+            return;
+
+        txUpdated = mempool.GetUpdatedTransactionNum();
+        if (pBlockTemplate->Fill(deadline) > 0) {
+            pBlockTemplate->Update();
+            LogPrint("MINER", "MineBlock() : topped up block template, tx=%d, totalBlockSize=%llu, used %lld ms\n",
+                     pBlock->vptx.size(), pBlockTemplate->GetBlockSize(), pBlockTemplate->GetBuildTime());
+        }
+    };
+
     while (true) {
         boost::this_thread::interruption_point();
 
@@ -618,25 +572,38 @@ bool static MineBlock(CBlock *pBlock, CWallet *pWallet, CBlockIndex *pIndexPrev,
         [&]() {
             int64_t whenCanIStart = pIndexPrev->GetBlockTime() + GetBlockInterval(chainActive.Height() + 1);
             while (GetTime() < whenCanIStart) {
+                TopUpTemplate(whenCanIStart * 1000);
                 ::MilliSleep(100);
             }
         }();
 
+        // Attention: the miner account must be computed according to the received votes ranking list before
+        // this block, so read it from the global delegate cache instead of the template one.
         vector<CRegID> delegateList;
-        if (!cw.delegateCache.GetTopDelegateList(delegateList)) {
+        bool hasDelegates;
+        {
+            LOCK(cs_main);
+            hasDelegates = pCdMan->pDelegateCache->GetTopDelegateList(delegateList);
+        }
+        if (!hasDelegates) {
             LogPrint("MINER", "MineBlock() : failed to get top delegates\n");
             return false;
         }
 
-        uint16_t index = 0;
-        for (auto &delegate : delegateList)
-            LogPrint("shuffle", "before shuffle: index=%d, regId=%s\n", index++, delegate.ToString());
+        bool fLogShuffle = LOG_CATEGORY_ENABLED("shuffle");
+        uint16_t index   = 0;
+        if (fLogShuffle) {
+            for (auto &delegate : delegateList)
+                LogPrint("shuffle", "before shuffle: index=%d, regId=%s\n", index++, delegate.ToString());
+        }
 
         ShuffleDelegates(pBlock->GetHeight(), delegateList);
 
         index = 0;
-        for (auto &delegate : delegateList)
-            LogPrint("shuffle", "after shuffle: index=%d, regId=%s\n", index++, delegate.ToString());
+        if (fLogShuffle) {
+            for (auto &delegate : delegateList)
+                LogPrint("shuffle", "after shuffle: index=%d, regId=%s\n", index++, delegate.ToString());
+        }
 
         int64_t currentTime = GetTime();
         CRegID regId;
@@ -695,8 +662,15 @@ bool static MineBlock(CBlock *pBlock, CWallet *pWallet, CBlockIndex *pIndexPrev,
             return true;
         }
 
-        if (mempool.GetUpdatedTransactionNum() != txUpdated || GetTime() - nStart > 60)
+        if (GetTime() - nStart > 60)
             return false;
+
+        if (pBlockTemplate == nullptr) {
+            if (mempool.GetUpdatedTransactionNum() != txUpdated)
+                return false;
+        } else {
+            TopUpTemplate(GetTimeMillis() + 1000);
+        }
     }
 
     return false;
@@ -755,12 +729,14 @@ void static CoinMiner(CWallet *pWallet, int32_t targetHeight) {
             int32_t blockHeight     = chainActive.Height() + 1;
             CBlockIndex *pIndexPrev = chainActive.Tip();
 
-            auto spCW   = std::make_shared<CCacheWrapper>(pCdMan);
-            auto pBlock = (blockHeight == (int32_t)SysCfg().GetStableCoinGenesisHeight())
+            auto spCW           = std::make_shared<CCacheWrapper>(pCdMan);
+            auto spBlockTemplate = std::make_shared<CBlockTemplate>(*spCW);
+            bool isGenesisBlock  = (blockHeight == (int32_t)SysCfg().GetStableCoinGenesisHeight());
+            auto pBlock = isGenesisBlock
                               ? CreateStableCoinGenesisBlock()  // stable coin genesis
                               : (GetFeatureForkVersion(blockHeight) == MAJOR_VER_R1)
-                                    ? CreateNewBlockPreStableCoinRelease(*spCW) // pre-stable coin release
-                                    : CreateNewBlockStableCoinRelease(*spCW);   // stable coin release
+                                    ? CreateNewBlockPreStableCoinRelease(*spBlockTemplate) // pre-stable coin release
+                                    : CreateNewBlockStableCoinRelease(*spBlockTemplate);   // stable coin release
 
             if (!pBlock.get()) {
                 throw runtime_error("CoinMiner() : failed to create new block");
@@ -769,10 +745,8 @@ void static CoinMiner(CWallet *pWallet, int32_t targetHeight) {
                          pBlock->vptx.size(), GetTimeMillis() - lastTime);
             }
 
-            // Attention: need to reset delegate cache to compute the miner account according to received votes ranking
-            // list.
-            spCW->delegateCache.Clear();
-            MineBlock(pBlock.get(), pWallet, pIndexPrev, txUpdated, *spCW);
+            MineBlock(pBlock.get(), pWallet, pIndexPrev, txUpdated, *spCW,
+                      isGenesisBlock ? nullptr : spBlockTemplate.get());
 
             if (SysCfg().NetworkID() != MAIN_NET && targetHeight <= GetCurrHeight())
                 throw boost::thread_interrupted();
@@ -815,6 +789,9 @@ void MinedBlockInfo::SetNull() {
     totalFees      = 0;
     txCount        = 0;
     totalBlockSize = 0;
+    maxBlockSize   = 0;
+    candidateTxCount = 0;
+    buildTime      = 0;
     hash.SetNull();
     hashPrevBlock.SetNull();
 }
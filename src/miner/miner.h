@@ -16,6 +16,7 @@
 #include "entities/key.h"
 #include "commons/uint256.h"
 #include "tx/tx.h"
+#include "persistence/cachewrapper.h"
 
 class CBlock;
 class CBlockIndex;
@@ -31,7 +32,7 @@ class TxPriorityCompare {
 
 public:
     TxPriorityCompare(bool byFeeIn) : byFee(byFeeIn) {}
-    bool operator()(const TxPriority &a, const TxPriority &b) {
+    bool operator()(const TxPriority &a, const TxPriority &b) const {
         if (byFee) {
             return std::get<1>(a) == std::get<1>(b) ? std::get<0>(a) < std::get<0>(b) : std::get<1>(a) < std::get<1>(b);
         } else {
@@ -40,6 +41,56 @@ public:
     }
 };
 
+/**
+ * Block template which is filled incrementally. Every candidate transaction runs in one reusable child layer
+ * of the template cache: the layer is flushed into the template when the transaction gets packed and cleared
+ * when it fails, so there is no cache wrapper built per transaction. Transactions once tried are remembered,
+ * which lets the miner top the template up with newly arrived mempool transactions while waiting for its slot.
+ */
+class CBlockTemplate {
+public:
+    CBlockTemplate(CCacheWrapper &cwIn) : cw(cwIn), txCw(cwIn) {}
+
+    /** Start filling the block, whose reward txs and header have been set up. */
+    void Start(CBlock *pBlockIn, const uint32_t blockMaxSizeIn);
+    /**
+     * Pack the untried mempool transactions by priority until the block is full or the deadline (in ms,
+     * 0 for none) is reached. Return the count of transactions newly packed. cs_main and mempool.cs must be held.
+     */
+    uint32_t Fill(const int64_t deadline);
+    /** Write the collected fees, fuels and median price points into the block. */
+    void Update();
+
+    CBlock *GetBlock() const { return pBlock; }
+    CCacheWrapper &GetCache() { return cw; }
+
+    uint64_t GetTotalFees() const { return totalFees; }
+    uint64_t GetBlockSize() const { return totalBlockSize; }
+    uint32_t GetBlockMaxSize() const { return blockMaxSize; }
+    uint64_t GetCandidateTxCount() const { return setTriedTxs.size(); }
+    int64_t GetBuildTime() const { return buildTime; }
+
+private:
+    bool PackTx(const TxPriority &item);
+
+private:
+    CCacheWrapper &cw;      // template cache holding all the packed transactions
+    CCacheWrapper txCw;     // child layer of the template cache, to execute one candidate transaction
+    CBlock *pBlock = nullptr;
+
+    int32_t height          = 0;
+    int32_t index           = 0;  // index of the last packed transaction
+    uint32_t fuelRate       = 0;
+    uint32_t blockMaxSize   = 0;
+    uint64_t totalBlockSize = 0;
+    uint64_t totalRunStep   = 0;
+    uint64_t totalFees      = 0;
+    uint64_t totalFuel      = 0;
+    int64_t buildTime       = 0;  // total time (ms) spent on filling the template
+    map<TokenSymbol, uint64_t> rewards;
+    set<uint256> setTriedTxs;
+};
+
 // mined block info
 class MinedBlockInfo {
 public:
@@ -51,6 +102,9 @@ public:
     uint64_t totalFees;       // the total fees of all transactions in the block
     uint64_t txCount;         // transaction count in block, exclude coinbase
     uint64_t totalBlockSize;  // block size(bytes)
+    uint64_t maxBlockSize;    // max block size(bytes) allowed by -blockmaxsize
+    uint64_t candidateTxCount; // mempool transactions tried to pack into the block
+    int64_t buildTime;        // time(ms) spent on assembling the block
     uint256 hash;             // block hash
     uint256 hashPrevBlock;    // prev block has
 
@@ -66,11 +120,11 @@ vector<MinedBlockInfo> GetMinedBlocks(uint32_t count);
 void GenerateCoinBlock(bool fGenerate, CWallet *pWallet, int32_t nThreads);
 
 /** Generate a new block pre-stable coin release */
-std::unique_ptr<CBlock> CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn);
+std::unique_ptr<CBlock> CreateNewBlockPreStableCoinRelease(CBlockTemplate &blockTemplate);
 /** Generate fund coin's genesis block */
 std::unique_ptr<CBlock> CreateStableCoinGenesisBlock();
 /** Generate a new block after stable coin release */
-std::unique_ptr<CBlock> CreateNewBlockStableCoinRelease(CCacheWrapper &cwIn);
+std::unique_ptr<CBlock> CreateNewBlockStableCoinRelease(CBlockTemplate &blockTemplate);
 
 bool CreateBlockRewardTx(const int64_t currentTime, const CAccount &delegate, CAccountDBCache &accountCache,
                          CBlock *pBlock);
@@ -83,6 +137,6 @@ bool CheckWork(CBlock *pBlock, CWallet &wallet);
 /** Get burn element */
 uint32_t GetElementForBurn(CBlockIndex *pIndex);
 
-void GetPriorityTx(vector<TxPriority> &vecPriority, int32_t nFuelRate);
+void GetPriorityTx(vector<TxPriority> &vecPriority);
 
 #endif  // COIN_MINER_H
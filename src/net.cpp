@@ -10,6 +10,7 @@
 #include "addrman.h"
 #include "config/chainparams.h"
 #include "net.h"
+#include "netreactor.h"
 #include "nodeinfo.h"
 #include "tx/tx.h"
 
@@ -48,6 +49,12 @@ using namespace std;
 using namespace boost;
 
 static const int MAX_OUTBOUND_CONNECTIONS = 8;
+// the wait of the socket handler with nothing to do, and the period of the inactivity checking
+static const int64_t SOCKET_WAIT_MILLIS = 50;
+// the wait of the socket handler to retry a node locked by another thread
+static const int64_t SOCKET_RETRY_MILLIS = 5;
+// the wait of the message handler with nothing to do, for the trickled inventory and the pings
+static const int64_t MESSAGE_HANDLER_WAIT_MILLIS = 100;
 
 bool OpenNetworkConnection(const CAddress& addrConnect, CSemaphoreGrant* grantOutbound = nullptr,
                            const char* strDest = nullptr, bool fOneShot = false);
@@ -94,6 +101,32 @@ static CSemaphore* semOutbound = nullptr;
 static CNodeSignals g_signals;
 CNodeSignals& GetNodeSignals() { return g_signals; }
 
+static CNetReactor netReactor;
+
+// wakes the message handlers when a message is received, or a full send buffer has room again
+static boost::mutex mtxMessageHandler;
+static boost::condition_variable condMessageHandler;
+static bool fMessageHandlerWake = false;
+
+static void WakeMessageHandler() {
+    boost::lock_guard<boost::mutex> lock(mtxMessageHandler);
+    fMessageHandlerWake = true;
+    condMessageHandler.notify_all();
+}
+
+static void WaitMessageHandler(int64_t nTimeoutMillis) {
+    boost::unique_lock<boost::mutex> lock(mtxMessageHandler);
+    if (!fMessageHandlerWake)
+        condMessageHandler.timed_wait(lock, boost::posix_time::milliseconds(nTimeoutMillis));
+    fMessageHandlerWake = false;
+}
+
+// requires LOCK(cs_vRecvMsg), whether the socket handler receives more data of the node
+static bool CanReceiveMore(CNode* pNode) {
+    return pNode->vRecvMsg.empty() || !pNode->vRecvMsg.front().complete() ||
+           pNode->GetTotalRecvSize() <= ReceiveFloodSize();
+}
+
 void AddOneShot(string strDest) {
     LOCK(cs_vOneShots);
     vOneShots.push_back(strDest);
@@ -524,7 +557,10 @@ void CNode::CloseSocketDisconnect() {
 
     // in case this fails, we'll empty the recv buffer when the CNode is deleted
     TRY_LOCK(cs_vRecvMsg, lockRecv);
-    if (lockRecv) vRecvMsg.clear();
+    if (lockRecv) {
+        vRecvMsg.clear();
+        UpdateRecvQueueStats();
+    }
 
     // if this was the sync node, we'll need a new one
     if (this == pnodeSync)
@@ -619,6 +655,11 @@ void CNode::copyStats(CNodeStats& stats) {
 
     // Leave string empty if addrLocal invalid (not filled in yet)
     stats.addrLocal = addrLocal.IsValid() ? addrLocal.ToString() : "";
+
+    stats.nSendQueueMsgs  = nSendQueueMsgs;
+    stats.nSendQueueBytes = nSendSize;
+    stats.nRecvQueueMsgs  = nRecvQueueMsgs;
+    stats.nRecvQueueBytes = nRecvQueueBytes;
 }
 #undef X
 
@@ -728,101 +769,187 @@ void SocketSendData(CNode* pNode) {
         assert(pNode->nSendSize == 0);
     }
     pNode->vSendMsg.erase(pNode->vSendMsg.begin(), it);
+    pNode->nSendQueueMsgs = pNode->vSendMsg.size();
 }
 
 static list<CNode*> vNodesDisconnected;
 
-void ThreadSocketHandler() {
-    unsigned int nPrevNodeCount = 0;
-    while (true) {
-        //
-        // Disconnect nodes
-        //
-        {
-            LOCK(cs_vNodes);
-            // Disconnect unused nodes
-            vector<CNode*> vNodesCopy = vNodes;
-            for (auto pNode : vNodesCopy) {
-                if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
-                                           pNode->nSendSize == 0 && pNode->ssSend.empty())) {
-                    // remove from vNodes
-                    vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
-
-                    // release outbound grant (if any)
-                    pNode->grantOutbound.Release();
-
-                    // close socket and cleanup
-                    pNode->CloseSocketDisconnect();
-                    pNode->Cleanup();
-
-                    // hold in disconnected pool until all refs are released
-                    if (pNode->fNetworkNode || pNode->fInbound)
-                        pNode->Release();
-                    vNodesDisconnected.push_back(pNode);
-                }
+static void DisconnectNodes() {
+    {
+        LOCK(cs_vNodes);
+        // Disconnect unused nodes
+        vector<CNode*> vNodesCopy = vNodes;
+        for (auto pNode : vNodesCopy) {
+            if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
+                                       pNode->nSendSize == 0 && pNode->ssSend.empty())) {
+                // remove from vNodes
+                vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
+
+                // release outbound grant (if any)
+                pNode->grantOutbound.Release();
+
+                // close socket and cleanup
+                pNode->CloseSocketDisconnect();
+                pNode->Cleanup();
+
+                // hold in disconnected pool until all refs are released
+                if (pNode->fNetworkNode || pNode->fInbound)
+                    pNode->Release();
+                vNodesDisconnected.push_back(pNode);
             }
         }
-        {
-            // Delete disconnected nodes
-            list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
-            for (auto pNode : vNodesDisconnectedCopy) {
-                // wait until threads are done using it
-                if (pNode->GetRefCount() <= 0) {
-                    bool fDelete = false;
-                    {
-                        TRY_LOCK(pNode->cs_vSend, lockSend);
-                        if (lockSend) {
-                            TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                            if (lockRecv) {
-                                TRY_LOCK(pNode->cs_inventory, lockInv);
-                                if (lockInv)
-                                    fDelete = true;
-                            }
+    }
+    {
+        // Delete disconnected nodes
+        list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
+        for (auto pNode : vNodesDisconnectedCopy) {
+            // wait until threads are done using it
+            if (pNode->GetRefCount() <= 0) {
+                bool fDelete = false;
+                {
+                    TRY_LOCK(pNode->cs_vSend, lockSend);
+                    if (lockSend) {
+                        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+                        if (lockRecv) {
+                            TRY_LOCK(pNode->cs_inventory, lockInv);
+                            if (lockInv)
+                                fDelete = true;
                         }
                     }
-                    if (fDelete) {
-                        vNodesDisconnected.remove(pNode);
-                        delete pNode;
-                    }
+                }
+                if (fDelete) {
+                    vNodesDisconnected.remove(pNode);
+                    delete pNode;
                 }
             }
         }
+    }
+}
+
+// accept a pending connection, return false if none is pending
+static bool AcceptConnection(SOCKET hListenSocket) {
+    struct sockaddr_storage sockaddr;
+    socklen_t len  = sizeof(sockaddr);
+    SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
+    CAddress addr;
+    int nInbound = 0;
+
+    if (hSocket != INVALID_SOCKET)
+        if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
+            LogPrint("INFO", "Warning: Unknown socket family\n");
+
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodes)
+            if (pNode->fInbound)
+                nInbound++;
+    }
+
+    if (hSocket == INVALID_SOCKET) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK)
+            LogPrint("INFO", "socket error accept failed: %s\n", NetworkErrorString(nErr));
+        return false;
+    } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
+        closesocket(hSocket);
+    } else if (CNode::IsBanned(addr)) {
+        LogPrint("INFO", "connection from %s dropped (banned)\n", addr.ToString());
+        closesocket(hSocket);
+    } else {
+        LogPrint("net", "accepted connection %s\n", addr.ToString());
+        CNode* pNode = new CNode(hSocket, addr, "", true);
+        pNode->AddRef();
+        {
+            LOCK(cs_vNodes);
+            vNodes.push_back(pNode);
+        }
+    }
+    return true;
+}
+
+// requires LOCK(cs_vRecvMsg), receive once from the ready socket, return true if it may have more data
+static bool SocketRecvData(CNode* pNode) {
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    int nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    if (nBytes > 0) {
+        if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
+            pNode->CloseSocketDisconnect();
+        pNode->nLastRecv = GetTime();
+        pNode->nRecvBytes += nBytes;
+        pNode->RecordBytesRecv(nBytes);
+        pNode->UpdateRecvQueueStats();
+
+        if (!pNode->vRecvMsg.empty() && pNode->vRecvMsg.front().complete())
+            WakeMessageHandler();
+        return pNode->hSocket != INVALID_SOCKET;
+    } else if (nBytes == 0) {
+        // socket closed gracefully
+        if (!pNode->fDisconnect)
+            LogPrint("net", "socket closed\n");
+        pNode->CloseSocketDisconnect();
+    } else if (nBytes < 0) {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr == WSAEINTR)
+            return true;
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINPROGRESS) {
+            if (!pNode->fDisconnect)
+                LogPrint("INFO", "socket recv error %s\n", NetworkErrorString(nErr));
+            pNode->CloseSocketDisconnect();
+        }
+    }
+    return false;
+}
+
+static void CheckInactivity(CNode* pNode) {
+    if (pNode->nSendQueueMsgs == 0) pNode->nLastSendEmpty = GetTime();
+    if (GetTime() - pNode->nTimeConnected > 60) {
+        if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
+            LogPrint("net", "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
+                     pNode->nLastSend != 0);
+            pNode->fDisconnect = true;
+        } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
+            LogPrint("INFO", "socket not sending\n");
+            pNode->fDisconnect = true;
+        } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
+            LogPrint("INFO", "socket inactivity timeout\n");
+            pNode->fDisconnect = true;
+        }
+    }
+}
+
+void ThreadSocketHandler() {
+    unsigned int nPrevNodeCount  = 0;
+    int64_t nTimeout             = SOCKET_WAIT_MILLIS;
+    int64_t nLastInactivityCheck = 0;
+    vector<CNetReactor::Event> events;
+    while (true) {
+        //
+        // Disconnect nodes
+        //
+        DisconnectNodes();
         if (vNodes.size() != nPrevNodeCount) {
             LogPrint("INFO", "Connections number changed, %d -> %d\n", nPrevNodeCount, vNodes.size());
             nPrevNodeCount = vNodes.size();
         }
 
         //
-        // Find which sockets have data to receive
+        // Watch the sockets, the nodes are referenced until their events are handled
         //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000;  // frequency to poll pNode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds     = false;
-
-        for (auto hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket, &fdsetRecv);
-            hSocketMax = max(hSocketMax, hListenSocket);
-            have_fds   = true;
-        }
+        for (auto hListenSocket : vhListenSocket)
+            netReactor.Watch(hListenSocket, nullptr, true, false);
+
+        vector<CNode*> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            for (auto pNode : vNodes) {
+            vNodesCopy = vNodes;
+            for (auto pNode : vNodesCopy) {
+                pNode->AddRef();
                 if (pNode->hSocket == INVALID_SOCKET)
                     continue;
-                FD_SET(pNode->hSocket, &fdsetError);
-                hSocketMax = max(hSocketMax, pNode->hSocket);
-                have_fds   = true;
 
-                // Implement the following logic:
+                // The edge-triggered reactor reports any readiness once, which is kept until used. For select():
                 // * If there is data to send, select() for sending data. As this only
                 //   happens when optimistic write failed, we choose to first drain the
                 //   write buffer in this case before receiving more. This avoids
@@ -837,126 +964,78 @@ void ThreadSocketHandler() {
                 // * We send some data.
                 // * We wait for data to be received (and disconnect after timeout).
                 // * We process a message in the buffer (message handler thread).
-                {
-                    TRY_LOCK(pNode->cs_vSend, lockSend);
-                    if (lockSend && !pNode->vSendMsg.empty()) {
-                        FD_SET(pNode->hSocket, &fdsetSend);
-                        continue;
+                bool fRecv = true;
+                bool fSend = false;
+                if (!netReactor.IsEdgeTriggered()) {
+                    {
+                        TRY_LOCK(pNode->cs_vSend, lockSend);
+                        fSend = lockSend && !pNode->vSendMsg.empty();
+                    }
+                    if (!fSend) {
+                        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+                        fRecv = lockRecv && CanReceiveMore(pNode);
+                    } else {
+                        fRecv = false;
                     }
                 }
-                {
-                    TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                    if (lockRecv && (pNode->vRecvMsg.empty() || !pNode->vRecvMsg.front().complete() ||
-                                     pNode->GetTotalRecvSize() <= ReceiveFloodSize()))
-                        FD_SET(pNode->hSocket, &fdsetRecv);
-                }
+                netReactor.Watch(pNode->hSocket, pNode, fRecv, fSend);
             }
         }
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+        if (!netReactor.Wait(nTimeout, events))
+            MilliSleep(nTimeout);
         boost::this_thread::interruption_point();
 
-        if (nSelect == SOCKET_ERROR) {
-            if (have_fds) {
-                int nErr = WSAGetLastError();
-                LogPrint("INFO", "socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            MilliSleep(timeout.tv_usec / 1000);
-        }
-
-        //
-        // Accept new connections
-        //
-        for (auto hListenSocket : vhListenSocket)
-            if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv)) {
-                struct sockaddr_storage sockaddr;
-                socklen_t len  = sizeof(sockaddr);
-                SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
-                CAddress addr;
-                int nInbound = 0;
-
-                if (hSocket != INVALID_SOCKET)
-                    if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
-                        LogPrint("INFO", "Warning: Unknown socket family\n");
-
-                {
-                    LOCK(cs_vNodes);
-                    for (auto pNode : vNodes)
-                        if (pNode->fInbound)
-                            nInbound++;
-                }
-
-                if (hSocket == INVALID_SOCKET) {
-                    int nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK)
-                        LogPrint("INFO", "socket error accept failed: %s\n", NetworkErrorString(nErr));
-                } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
-                    closesocket(hSocket);
-                } else if (CNode::IsBanned(addr)) {
-                    LogPrint("INFO", "connection from %s dropped (banned)\n", addr.ToString());
-                    closesocket(hSocket);
-                } else {
-                    LogPrint("net", "accepted connection %s\n", addr.ToString());
-                    CNode* pNode = new CNode(hSocket, addr, "", true);
-                    pNode->AddRef();
-                    {
-                        LOCK(cs_vNodes);
-                        vNodes.push_back(pNode);
+        bool fBusy  = false;  // a ready socket may have more data
+        bool fRetry = false;  // a ready node was locked by another thread
+        for (const auto& event : events) {
+            //
+            // Accept new connections
+            //
+            if (event.pData == nullptr) {
+                if (event.flags & CNetReactor::EVENT_RECV) {
+                    while (AcceptConnection(event.hSocket)) {
+                        boost::this_thread::interruption_point();
                     }
                 }
+                continue;
             }
 
+            CNode* pNode = static_cast<CNode*>(event.pData);
+            if (event.flags & (CNetReactor::EVENT_RECV | CNetReactor::EVENT_ERROR))
+                pNode->fRecvReady = true;
+            if (event.flags & CNetReactor::EVENT_SEND)
+                pNode->fSendReady = true;
+        }
+
         //
-        // Service each socket
+        // Service each ready socket
         //
-        vector<CNode*> vNodesCopy;
-        {
-            LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (auto pNode : vNodesCopy)
-                pNode->AddRef();
-        }
+        int64_t nNow          = GetTimeMillis();
+        bool fCheckInactivity = nNow - nLastInactivityCheck >= SOCKET_WAIT_MILLIS;
+        if (fCheckInactivity)
+            nLastInactivityCheck = nNow;
+
         for (auto pNode : vNodesCopy) {
             boost::this_thread::interruption_point();
 
+            if (pNode->hSocket == INVALID_SOCKET) {
+                pNode->fRecvReady = false;
+                pNode->fSendReady = false;
+                continue;
+            }
+
             //
             // Receive
             //
-            if (pNode->hSocket == INVALID_SOCKET)
-                continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError)) {
+            if (pNode->fRecvReady) {
                 TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                if (lockRecv) {
-                    {
-                        // typical socket buffer is 8K-64K
-                        char pchBuf[0x10000];
-                        int nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                        if (nBytes > 0) {
-                            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
-                                pNode->CloseSocketDisconnect();
-                            pNode->nLastRecv = GetTime();
-                            pNode->nRecvBytes += nBytes;
-                            pNode->RecordBytesRecv(nBytes);
-                        } else if (nBytes == 0) {
-                            // socket closed gracefully
-                            if (!pNode->fDisconnect)
-                                LogPrint("net", "socket closed\n");
-                            pNode->CloseSocketDisconnect();
-                        } else if (nBytes < 0) {
-                            // error
-                            int nErr = WSAGetLastError();
-                            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR &&
-                                nErr != WSAEINPROGRESS) {
-                                if (!pNode->fDisconnect)
-                                    LogPrint("INFO", "socket recv error %s\n", NetworkErrorString(nErr));
-                                pNode->CloseSocketDisconnect();
-                            }
-                        }
-                    }
+                if (!lockRecv) {
+                    fRetry = true;
+                } else if (CanReceiveMore(pNode)) {
+                    // otherwise the message handler wakes us when the buffer has room
+                    pNode->fRecvReady = SocketRecvData(pNode);
+                    fBusy |= pNode->fRecvReady;
                 }
             }
 
@@ -965,34 +1044,34 @@ void ThreadSocketHandler() {
             //
             if (pNode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetSend)) {
+            if (pNode->fSendReady) {
                 TRY_LOCK(pNode->cs_vSend, lockSend);
-                if (lockSend) SocketSendData(pNode);
+                if (!lockSend) {
+                    fRetry = true;
+                } else {
+                    bool fSendBufferFull = pNode->nSendSize >= SendBufferSize();
+                    if (!pNode->vSendMsg.empty())
+                        SocketSendData(pNode);
+                    // a partial write leaves the socket unwritable, to be reported again once writable
+                    pNode->fSendReady = false;
+                    if (fSendBufferFull && pNode->nSendSize < SendBufferSize())
+                        WakeMessageHandler();
+                }
             }
 
             //
             // Inactivity checking
             //
-            if (pNode->vSendMsg.empty()) pNode->nLastSendEmpty = GetTime();
-            if (GetTime() - pNode->nTimeConnected > 60) {
-                if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
-                    LogPrint("net", "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
-                             pNode->nLastSend != 0);
-                    pNode->fDisconnect = true;
-                } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
-                    LogPrint("INFO", "socket not sending\n");
-                    pNode->fDisconnect = true;
-                } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
-                    LogPrint("INFO", "socket inactivity timeout\n");
-                    pNode->fDisconnect = true;
-                }
-            }
+            if (fCheckInactivity)
+                CheckInactivity(pNode);
         }
         {
             LOCK(cs_vNodes);
             for (auto pNode : vNodesCopy)
                 pNode->Release();
         }
+
+        nTimeout = fBusy ? 0 : (fRetry ? SOCKET_RETRY_MILLIS : SOCKET_WAIT_MILLIS);
     }
 }
 
@@ -1391,7 +1470,12 @@ void static StartSync(const vector<CNode*>& vNodes) {
     }
 }
 
-void ThreadMessageHandler() {
+/**
+ * One of the nWorkers message handler threads. A node is claimed by one thread at a time, which processes its
+ * received messages and sends its messages, so the messages of a node are handled in order, while a node served
+ * slowly, e.g. the blocks read from disk for a getdata, does not hold up the other nodes.
+ */
+void ThreadMessageHandler(uint32_t nWorker, uint32_t nWorkers) {
     SetThreadPriority(THREAD_PRIORITY_BELOW_NORMAL);
     while (true) {
         bool fHaveSyncNode = false;
@@ -1407,7 +1491,7 @@ void ThreadMessageHandler() {
             }
         }
 
-        if (!fHaveSyncNode)
+        if (nWorker == 0 && !fHaveSyncNode)
             StartSync(vNodesCopy);
 
         // Poll the connected nodes for messages
@@ -1417,16 +1501,29 @@ void ThreadMessageHandler() {
 
         bool fSleep = true;
 
-        for (auto pNode : vNodesCopy) {
+        // the threads start at different nodes and skip the nodes claimed by the others
+        size_t nStart = vNodesCopy.size() * nWorker / nWorkers;
+        for (size_t i = 0; i < vNodesCopy.size(); i++) {
+            CNode* pNode = vNodesCopy[(nStart + i) % vNodesCopy.size()];
             if (pNode->fDisconnect)
                 continue;
 
+            bool fClaimed = false;
+            if (!pNode->fMsgHandlerClaimed.compare_exchange_strong(fClaimed, true))
+                continue;
+
             // Receive messages
             {
                 TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
                 if (lockRecv) {
+                    bool fCouldReceive = CanReceiveMore(pNode);
                     if (!g_signals.ProcessMessages(pNode))
                         pNode->CloseSocketDisconnect();
+                    pNode->UpdateRecvQueueStats();
+
+                    // the socket handler stopped receiving from the flooding node
+                    if (!fCouldReceive && CanReceiveMore(pNode))
+                        netReactor.Wakeup();
 
                     if (pNode->nSendSize < SendBufferSize()) {
                         if (!pNode->vRecvGetData.empty() ||
@@ -1436,7 +1533,6 @@ void ThreadMessageHandler() {
                     }
                 }
             }
-            boost::this_thread::interruption_point();
 
             // Send messages
             {
@@ -1444,6 +1540,8 @@ void ThreadMessageHandler() {
                 if (lockSend)
                     g_signals.SendMessages(pNode, pNode == pnodeTrickle);
             }
+
+            pNode->fMsgHandlerClaimed = false;
             boost::this_thread::interruption_point();
         }
 
@@ -1453,8 +1551,9 @@ void ThreadMessageHandler() {
                 pNode->Release();
         }
 
+        // woken early by the socket handler
         if (fSleep)
-            MilliSleep(100);
+            WaitMessageHandler(MESSAGE_HANDLER_WAIT_MILLIS);
     }
 }
 
@@ -1627,6 +1726,8 @@ void StartNode(boost::thread_group& threadGroup) {
 #endif
 
     // Send and receive from sockets, accept connections
+    if (!netReactor.Open())
+        LogPrint("INFO", "Failed to open the socket reactor, wait for the sockets by select() without wakeup\n");
     threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "net", &ThreadSocketHandler));
 
     // Initiate outbound connections from -addnode
@@ -1636,7 +1737,12 @@ void StartNode(boost::thread_group& threadGroup) {
     threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "opencon", &ThreadOpenConnections));
 
     // Process messages
-    threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "msghand", &ThreadMessageHandler));
+    uint32_t nMsgHandlerThreads = max<int64_t>(min<int64_t>(SysCfg().GetArg("-msghandlerthreads", DEFAULT_MESSAGE_HANDLER_THREADS),
+                                                            MAX_MESSAGE_HANDLER_THREADS), 1);
+    LogPrint("INFO", "Using %u threads for message handling\n", nMsgHandlerThreads);
+    for (uint32_t i = 0; i < nMsgHandlerThreads; i++)
+        threadGroup.create_thread(boost::bind(&TraceThread<boost::function<void()> >, "msghand",
+                                              boost::function<void()>(boost::bind(&ThreadMessageHandler, i, nMsgHandlerThreads))));
 
     // Dump network addresses
     threadGroup.create_thread(boost::bind(&LoopForever<void (*)()>, "dumpaddr", &DumpAddresses, DUMP_ADDRESSES_INTERVAL * 1000));
@@ -19,6 +19,7 @@
 #include "sync.h"
 
 #include <stdint.h>
+#include <atomic>
 #include <deque>
 
 #ifndef WIN32
@@ -139,6 +140,10 @@ public:
     double dPingTime;
     double dPingWait;
     string addrLocal;
+    uint64_t nSendQueueMsgs;
+    uint64_t nSendQueueBytes;
+    uint64_t nRecvQueueMsgs;   // including the incomplete one
+    uint64_t nRecvQueueBytes;
 };
 
 class CNetMessage {
@@ -183,6 +188,7 @@ public:
     CDataStream ssSend;
     size_t nSendSize;    // total size of all vSendMsg entries
     size_t nSendOffset;  // offset inside the first vSendMsg already sent
+    size_t nSendQueueMsgs;  // vSendMsg.size(), readable without cs_vSend
     uint64_t nSendBytes;
     deque<CSerializeData> vSendMsg;
     CCriticalSection cs_vSend;
@@ -190,9 +196,20 @@ public:
     deque<CInv> vRecvGetData;  // strCommand == "getdata 保存的inv
     deque<CNetMessage> vRecvMsg;
     CCriticalSection cs_vRecvMsg;
+    size_t nRecvQueueMsgs;   // vRecvMsg.size(), readable without cs_vRecvMsg
+    size_t nRecvQueueBytes;  // GetTotalRecvSize(), readable without cs_vRecvMsg
     uint64_t nRecvBytes;
     int nRecvVersion;
 
+    // readiness reported by the socket reactor, only used by the socket handler thread: the recv readiness is kept
+    // until recv() would block, the send readiness until the send queue is written under cs_vSend
+    bool fRecvReady;
+    bool fSendReady;
+
+    // claimed by one message handler thread at a time, which keeps the messages of the node in order
+    std::atomic<bool> fMsgHandlerClaimed;
+    int64_t nLastMsgProcess;  // only used by the message handler thread claiming the node
+
     int64_t nLastSend;
     int64_t nLastRecv;
     int64_t nLastSendEmpty;
@@ -217,10 +234,12 @@ public:
     // b) the peer may tell us in their version message that we should not relay tx invs
     //    until they have initialized their bloom filter.
     bool fRelayTxes;
+    // the peer asked by sendcmpct for the new blocks pushed as compact blocks, read by the block relay
+    std::atomic<bool> fSendCompactBlocks;
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
     CBloomFilter* pfilter;
-    int nRefCount;
+    std::atomic<int> nRefCount;  // also taken by the tx admission queue from the message handler threads
     NodeId id;
 
 protected:
@@ -242,6 +261,7 @@ public:
     // flood relay
     vector<CAddress> vAddrToSend;
     mruset<CAddress> setAddrKnown;
+    CCriticalSection cs_addr;  // guards vAddrToSend and setAddrKnown, pushed by the handlers of the other nodes
     bool fGetAddr;
     set<uint256> setKnown;  // alertHash
 
@@ -281,6 +301,13 @@ public:
         nRefCount                = 0;
         nSendSize                = 0;
         nSendOffset              = 0;
+        nSendQueueMsgs           = 0;
+        nRecvQueueMsgs           = 0;
+        nRecvQueueBytes          = 0;
+        fRecvReady               = false;
+        fSendReady               = false;
+        fMsgHandlerClaimed       = false;
+        nLastMsgProcess          = 0;
         hashContinue             = uint256();
         pindexLastGetBlocksBegin = 0;
         hashLastGetBlocksEnd     = uint256();
@@ -288,6 +315,7 @@ public:
         fStartSync               = false;
         fGetAddr                 = false;
         fRelayTxes               = false;
+        fSendCompactBlocks       = false;
         setInventoryKnown.max_size(SendBufferSize() / 1000);
         pfilter        = new CBloomFilter();
         nPingNonceSent = 0;
@@ -346,6 +374,12 @@ public:
     // requires LOCK(cs_vRecvMsg)
     bool ReceiveMsgBytes(const char* pch, unsigned int nBytes);
 
+    // requires LOCK(cs_vRecvMsg)
+    void UpdateRecvQueueStats() {
+        nRecvQueueMsgs  = vRecvMsg.size();
+        nRecvQueueBytes = GetTotalRecvSize();
+    }
+
     // requires LOCK(cs_vRecvMsg)
     void SetRecvVersion(int nVersionIn) {
         nRecvVersion = nVersionIn;
@@ -360,12 +394,16 @@ public:
 
     void Release() { nRefCount--; }
 
-    void AddAddressKnown(const CAddress& addr) { setAddrKnown.insert(addr); }
+    void AddAddressKnown(const CAddress& addr) {
+        LOCK(cs_addr);
+        setAddrKnown.insert(addr);
+    }
 
     void PushAddress(const CAddress& addr) {
         // Known checking here is only to save space from duplicates.
         // SendMessages will filter it again for knowns that were added
         // after addresses were pushed.
+        LOCK(cs_addr);
         if (addr.IsValid() && !setAddrKnown.count(addr)) {
             if (vAddrToSend.size() >= MAX_ADDR_TO_SEND) {
                 vAddrToSend[insecure_rand() % vAddrToSend.size()] = addr;
@@ -375,11 +413,10 @@ public:
         }
     }
 
-    void AddInventoryKnown(const CInv& inv) {
-        {
-            LOCK(cs_inventory);
-            setInventoryKnown.insert(inv);
-        }
+    // return false if the peer knows the inventory already
+    bool AddInventoryKnown(const CInv& inv) {
+        LOCK(cs_inventory);
+        return setInventoryKnown.insert(inv).second;
     }
 
     void PushInventory(const CInv& inv) {
@@ -471,6 +508,7 @@ public:
         deque<CSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CSerializeData());
         ssSend.GetAndClear(*it);
         nSendSize += (*it).size();
+        nSendQueueMsgs = vSendMsg.size();
 
         // If write queue empty, attempt "optimistic write"
         if (it == vSendMsg.begin()) SocketSendData(this);
@@ -0,0 +1,236 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "netreactor.h"
+
+#include "commons/util.h"
+#include "netbase.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+
+// the epoll events fetched by a wait, the rest are fetched by the next wait
+static const int32_t MAX_EPOLL_EVENTS = 256;
+
+CNetReactor::CNetReactor() : hEpoll(-1), hWakeupRead(-1), hWakeupWrite(-1), nRound(0) {}
+
+CNetReactor::~CNetReactor() { Close(); }
+
+bool CNetReactor::Open() {
+    Close();
+
+#ifndef WIN32
+    int fds[2];
+    if (pipe(fds) != 0) {
+        LogPrint("INFO", "CNetReactor::Open, create wakeup pipe failed: %s\n", NetworkErrorString(errno));
+        return false;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    hWakeupRead  = fds[0];
+    hWakeupWrite = fds[1];
+#endif
+
+#ifdef HAVE_SYS_EPOLL_H
+    hEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (hEpoll == -1) {
+        LogPrint("INFO", "CNetReactor::Open, epoll_create1 failed, use select: %s\n", NetworkErrorString(errno));
+        return true;
+    }
+
+    // level-triggered, drained by the wait
+    struct epoll_event ev;
+    ev.events  = EPOLLIN;
+    ev.data.fd = hWakeupRead;
+    if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hWakeupRead, &ev) != 0) {
+        LogPrint("INFO", "CNetReactor::Open, add wakeup pipe failed: %s\n", NetworkErrorString(errno));
+        Close();
+        return false;
+    }
+#endif
+
+    LogPrint("INFO", "CNetReactor::Open, wait for the sockets with %s\n", IsEdgeTriggered() ? "epoll" : "select");
+    return true;
+}
+
+void CNetReactor::Close() {
+#ifdef HAVE_SYS_EPOLL_H
+    if (hEpoll != -1) {
+        close(hEpoll);
+        hEpoll = -1;
+    }
+#endif
+#ifndef WIN32
+    if (hWakeupRead != -1) {
+        close(hWakeupRead);
+        close(hWakeupWrite);
+        hWakeupRead  = -1;
+        hWakeupWrite = -1;
+    }
+#endif
+    mapWatch.clear();
+}
+
+void CNetReactor::Watch(SOCKET hSocket, void *pData, bool fRecv, bool fSend) {
+    auto ret     = mapWatch.emplace(hSocket, CWatch());
+    CWatch &item = ret.first->second;
+    // a new socket, or the fd reused by a new socket after the last one was closed
+    if (ret.second || item.pData != pData) {
+        item.pData       = pData;
+        item.fRegistered = false;
+    }
+    item.interest = (fRecv ? EVENT_RECV : 0) | (fSend ? EVENT_SEND : 0);
+    item.nRound   = nRound;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (IsEdgeTriggered() && !item.fRegistered) {
+        struct epoll_event ev;
+        ev.events  = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = hSocket;
+        if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hSocket, &ev) != 0 &&
+            (errno != EEXIST || epoll_ctl(hEpoll, EPOLL_CTL_MOD, hSocket, &ev) != 0)) {
+            LogPrint("INFO", "CNetReactor::Watch, add socket %d failed: %s\n", hSocket, NetworkErrorString(errno));
+            return;
+        }
+        item.fRegistered = true;
+    }
+#endif
+}
+
+bool CNetReactor::Wait(int64_t nTimeoutMillis, vector<Event> &events) {
+    events.clear();
+
+    // drop the sockets not watched in this round, a closed socket has left the epoll set already
+    for (auto it = mapWatch.begin(); it != mapWatch.end();) {
+        if (it->second.nRound != nRound) {
+#ifdef HAVE_SYS_EPOLL_H
+            if (IsEdgeTriggered() && it->second.fRegistered) {
+                struct epoll_event ev;
+                epoll_ctl(hEpoll, EPOLL_CTL_DEL, it->first, &ev);
+            }
+#endif
+            it = mapWatch.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    ++nRound;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (IsEdgeTriggered()) {
+        struct epoll_event evs[MAX_EPOLL_EVENTS];
+        int32_t nEvents = epoll_wait(hEpoll, evs, MAX_EPOLL_EVENTS, (int32_t)nTimeoutMillis);
+        if (nEvents < 0) {
+            if (errno == EINTR)
+                return true;
+
+            LogPrint("INFO", "CNetReactor::Wait, epoll_wait error %s\n", NetworkErrorString(errno));
+            return false;
+        }
+
+        for (int32_t i = 0; i < nEvents; i++) {
+            if (evs[i].data.fd == hWakeupRead) {
+                DrainWakeup();
+                continue;
+            }
+
+            auto it = mapWatch.find(evs[i].data.fd);
+            if (it == mapWatch.end())
+                continue;
+
+            uint32_t flags = 0;
+            if (evs[i].events & EPOLLIN)
+                flags |= EVENT_RECV;
+            if (evs[i].events & EPOLLOUT)
+                flags |= EVENT_SEND;
+            if (evs[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+                flags |= EVENT_ERROR;
+            events.push_back({it->first, it->second.pData, flags});
+        }
+        return true;
+    }
+#endif
+
+    struct timeval timeout;
+    timeout.tv_sec  = nTimeoutMillis / 1000;
+    timeout.tv_usec = (nTimeoutMillis % 1000) * 1000;
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds     = false;
+
+#ifndef WIN32
+    if (hWakeupRead != -1) {
+        FD_SET(hWakeupRead, &fdsetRecv);
+        hSocketMax = max(hSocketMax, (SOCKET)hWakeupRead);
+        have_fds   = true;
+    }
+#endif
+    for (const auto &item : mapWatch) {
+        if (item.second.interest & EVENT_RECV)
+            FD_SET(item.first, &fdsetRecv);
+        if (item.second.interest & EVENT_SEND)
+            FD_SET(item.first, &fdsetSend);
+        FD_SET(item.first, &fdsetError);
+        hSocketMax = max(hSocketMax, item.first);
+        have_fds   = true;
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0, &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (nSelect == SOCKET_ERROR) {
+        int nErr = WSAGetLastError();
+        if (!have_fds || nErr == WSAEINTR)
+            return true;
+
+        // let the caller find the bad socket by recv()
+        LogPrint("INFO", "socket select error %s\n", NetworkErrorString(nErr));
+        for (const auto &item : mapWatch)
+            events.push_back({item.first, item.second.pData, EVENT_RECV | EVENT_ERROR});
+        return false;
+    }
+
+#ifndef WIN32
+    if (hWakeupRead != -1 && FD_ISSET(hWakeupRead, &fdsetRecv))
+        DrainWakeup();
+#endif
+    for (const auto &item : mapWatch) {
+        uint32_t flags = 0;
+        if (FD_ISSET(item.first, &fdsetRecv))
+            flags |= EVENT_RECV;
+        if (FD_ISSET(item.first, &fdsetSend))
+            flags |= EVENT_SEND;
+        if (FD_ISSET(item.first, &fdsetError))
+            flags |= EVENT_ERROR;
+        if (flags != 0)
+            events.push_back({item.first, item.second.pData, flags});
+    }
+    return true;
+}
+
+void CNetReactor::Wakeup() {
+#ifndef WIN32
+    if (hWakeupWrite != -1) {
+        // a full pipe has a wakeup pending already
+        char c = 0;
+        if (write(hWakeupWrite, &c, 1) < 0) {}
+    }
+#endif
+}
+
+void CNetReactor::DrainWakeup() {
+#ifndef WIN32
+    char buf[64];
+    while (read(hWakeupRead, buf, sizeof(buf)) > 0) {}
+#endif
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_NETREACTOR_H
+#define COIN_NETREACTOR_H
+
+#if defined(HAVE_CONFIG_H)
+#include "config/coin-config.h"
+#endif
+
+#include "compat/compat.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Socket readiness for the socket handler thread.
+ *
+ * With epoll the sockets are registered once in edge-triggered mode: a wait costs nothing for the idle peers, and
+ * the readiness of a socket is reported once, so the caller must remember it until recv()/send() would block.
+ * Elsewhere select() is used on the interest given by Watch() in this round, and the readiness is reported as long
+ * as it lasts. A caller keeping the readiness until the socket would block works with both.
+ */
+class CNetReactor {
+public:
+    enum EventFlags : uint32_t {
+        EVENT_RECV  = 1,
+        EVENT_SEND  = 2,
+        EVENT_ERROR = 4,
+    };
+
+    struct Event {
+        SOCKET hSocket;
+        void *pData;  // as given to Watch()
+        uint32_t flags;
+    };
+
+public:
+    CNetReactor();
+    ~CNetReactor();
+
+    /** Create the epoll set if supported, otherwise fall back to select(). */
+    bool Open();
+    void Close();
+    bool IsEdgeTriggered() const { return hEpoll != -1; }
+
+    /**
+     * Watch the socket in this round. The interest is only used by select(), epoll always reports both directions.
+     * The sockets not watched in a round are dropped, so a closed socket is never reported for a reused fd.
+     */
+    void Watch(SOCKET hSocket, void *pData, bool fRecv, bool fSend);
+    /** Wait for the watched sockets or Wakeup(), return false on error. */
+    bool Wait(int64_t nTimeoutMillis, vector<Event> &events);
+    /** Interrupt the pending or next Wait() from another thread. */
+    void Wakeup();
+
+private:
+    struct CWatch {
+        void *pData;
+        uint32_t interest;
+        uint64_t nRound;
+        bool fRegistered;
+    };
+
+    void DrainWakeup();
+
+private:
+    int hEpoll;
+    int hWakeupRead;
+    int hWakeupWrite;
+    uint64_t nRound;
+    unordered_map<SOCKET, CWatch> mapWatch;
+};
+
+#endif  // COIN_NETREACTOR_H
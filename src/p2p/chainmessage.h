@@ -11,6 +11,9 @@
 #include "commons/util.h"
 #include "main.h"
 #include "net.h"
+#include "p2p/compactblock.h"
+#include "p2p/headerssync.h"
+#include "tx/txadmission.h"
 
 #include <string>
 #include <vector>
@@ -36,6 +39,7 @@ struct QueuedBlock {
     uint256 hash;
     int64_t nTime;      // Time of "getdata" request in microseconds.
     int32_t nQueuedBefore;  // Number of blocks in flight at the time of request.
+    bool fWindow;           // requested in the download window of the header chain
 };
 namespace {
     map<uint256, pair<NodeId, list<QueuedBlock>::iterator> > mapBlocksInFlight;
@@ -70,15 +74,32 @@ namespace {
         list<uint256> vBlocksToDownload;  //待下载的块
         int32_t nBlocksToDownload;            //待下载的块个数
         int64_t nLastBlockReceive;        //上一次收到块的时间
-        int64_t nLastBlockProcess;        //收到块，处理消息时的时间
+        // the compact block waiting for the blocktxn of the missing txs
+        std::shared_ptr<CPartialBlock> pPartialBlock;
+        // compact block relay counters of getpeerinfo
+        uint32_t nCmpctBlocks;
+        uint32_t nCmpctBlockRoundTrips;
+        uint32_t nCmpctBlockFailures;
+        uint64_t nCmpctTxsFound;
+        uint64_t nCmpctTxsMissing;
+        int64_t nCmpctReconstructMillis;
+        uint32_t nRelayedBlocks;
+        int64_t nRelayLatencyMillis;
 
         CNodeState() {
-            nMisbehavior      = 0;
-            fShouldBan        = false;
-            nBlocksToDownload = 0;
-            nBlocksInFlight   = 0;
-            nLastBlockReceive = 0;
-            nLastBlockProcess = 0;
+            nMisbehavior            = 0;
+            fShouldBan              = false;
+            nBlocksToDownload       = 0;
+            nBlocksInFlight         = 0;
+            nLastBlockReceive       = 0;
+            nCmpctBlocks            = 0;
+            nCmpctBlockRoundTrips   = 0;
+            nCmpctBlockFailures     = 0;
+            nCmpctTxsFound          = 0;
+            nCmpctTxsMissing        = 0;
+            nCmpctReconstructMillis = 0;
+            nRelayedBlocks          = 0;
+            nRelayLatencyMillis     = 0;
         }
     };
 
@@ -129,13 +150,12 @@ struct COrphanBlock {
 
 static CMedianFilter<int32_t> cPeerBlockCounts(8, 0);
 
+// Read-only, serves the blocks from disk without cs_main, so the other peers are not held up.
 inline void ProcessGetData(CNode *pFrom) {
     deque<CInv>::iterator it = pFrom->vRecvGetData.begin();
 
     vector<CInv> vNotFound;
 
-    LOCK(cs_main);
-
     while (it != pFrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway
         if (pFrom->nSendSize >= SendBufferSize())
@@ -147,15 +167,11 @@ inline void ProcessGetData(CNode *pFrom) {
             it++;
 
             if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
-                bool send                                = false;
-                map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(inv.hash);
-                if (mi != mapBlockIndex.end()) {
-                    send = true;
-                }
-                if (send) {
+                CBlockIndex *pIndex = LookupBlockIndex(inv.hash);
+                if (pIndex) {
                     // Send block from disk
                     CBlock block;
-                    ReadBlockFromDisk((*mi).second, block);
+                    ReadBlockFromDisk(pIndex, block);
                     if (inv.type == MSG_BLOCK)
                         pFrom->PushMessage("block", block);
                     else  // MSG_FILTERED_BLOCK)
@@ -184,7 +200,7 @@ inline void ProcessGetData(CNode *pFrom) {
                         // and we want it right after the last block so they don't
                         // wait for other stuff first.
                         vector<CInv> vInv;
-                        vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
+                        vInv.push_back(CInv(MSG_BLOCK, GetChainSnapshot().Tip()->GetBlockHash()));
                         pFrom->PushMessage("inv", vInv);
                         pFrom->hashContinue.SetNull();
                         LogPrint("net", "reset node hashcontinue\n");
@@ -513,63 +529,41 @@ inline bool ProcessTxMessage(CNode* pFrom, string strCommand , CDataStream& vRec
     CInv inv(MSG_TX, pBaseTx->GetHash());
     pFrom->AddInventoryKnown(inv);
 
-    LOCK(cs_main);
-    CValidationState state;
-    if (AcceptToMemoryPool(mempool, state, pBaseTx.get(), true)) {
-        RelayTransaction(pBaseTx.get(), inv.hash);
-        mapAlreadyAskedFor.erase(inv);
-
-        LogPrint("INFO", "AcceptToMemoryPool: %s %s : accepted %s (poolsz %u)\n",
-                 pFrom->addr.ToString(), pFrom->cleanSubVer,
-                 pBaseTx->GetHash().ToString(),
-                 mempool.memPoolTxs.size());
-    }
-
-    int32_t nDoS = 0;
-    if (state.IsInvalid(nDoS)) {
-        LogPrint("INFO", "%s from %s %s was not accepted into the memory pool: %s\n",
-                 pBaseTx->GetHash().ToString(),
-                 pFrom->addr.ToString(),
-                 pFrom->cleanSubVer,
-                 state.GetRejectReason());
-
-        pFrom->PushMessage("reject", strCommand, state.GetRejectCode(), state.GetRejectReason(), inv.hash);
-        // if (nDoS > 0) {
-        //     LogPrint("INFO", "Misebehaving, add to tx hash %s mempool error, Misbehavior add %d", pBaseTx->GetHash().GetHex(), nDoS);
-        //     Misbehaving(pFrom->GetId(), nDoS);
-        // }
-    }
+    // checked by the admission workers and accepted in the order received, or right here when the queue
+    // is disabled or full
+    if (!txAdmissionQueue.Push(pBaseTx, pFrom, strCommand))
+        txAdmissionQueue.Admit(pBaseTx, pFrom, strCommand);
 
     return true ;
 }
 
+// Read-only, runs without cs_main against the snapshot of the active chain.
 inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv){
 
     CBlockLocator locator;
     uint256 hashStop;
     vRecv >> locator >> hashStop;
 
-    LOCK(cs_main);
+    CChainSnapshot chain = GetChainSnapshot();
 
-    CBlockIndex *pIndex = nullptr;
+    const CBlockIndex *pIndex = nullptr;
     if (locator.IsNull()) {
         // If locator is null, return the hashStop block
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hashStop);
-        if (mi == mapBlockIndex.end())
+        pIndex = LookupBlockIndex(hashStop);
+        if (pIndex == nullptr)
             return true;
-        pIndex = (*mi).second;
     } else {
         // Find the last block the caller has in the main chain
-        pIndex = chainActive.FindFork(locator);
+        pIndex = chain.FindFork(locator);
         if (pIndex)
-            pIndex = chainActive.Next(pIndex);
+            pIndex = chain.Next(pIndex);
     }
 
     // We must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
     vector<CBlock> vHeaders;
-    int32_t nLimit = 2000;
+    int32_t nLimit = MAX_HEADERS_RESULTS;
     LogPrint("NET", "getheaders %d to %s\n", (pIndex ? pIndex->height : -1), hashStop.ToString());
-    for (; pIndex; pIndex = chainActive.Next(pIndex)) {
+    for (; pIndex; pIndex = chain.Next(pIndex)) {
         vHeaders.push_back(pIndex->GetBlockHeader());
         if (--nLimit <= 0 || pIndex->GetBlockHash() == hashStop)
             break;
@@ -579,23 +573,24 @@ inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv){
     return false;
 }
 
+// Read-only, runs without cs_main against the snapshot of the active chain.
 inline void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv){
 
     CBlockLocator locator;
     uint256 hashStop;
     vRecv >> locator >> hashStop;
 
-    LOCK(cs_main);
+    CChainSnapshot chain = GetChainSnapshot();
 
     // Find the last block the caller has in the main chain
-    CBlockIndex *pIndex = chainActive.FindFork(locator);
+    const CBlockIndex *pIndex = chain.FindFork(locator);
 
     // Send the rest of the chain
     if (pIndex)
-        pIndex = chainActive.Next(pIndex);
+        pIndex = chain.Next(pIndex);
     int32_t nLimit = 500;
     LogPrint("net", "getblocks %d to %s limit %d\n", (pIndex ? pIndex->height : -1), hashStop.ToString(), nLimit);
-    for (; pIndex; pIndex = chainActive.Next(pIndex)) {
+    for (; pIndex; pIndex = chain.Next(pIndex)) {
         if (pIndex->GetBlockHash() == hashStop) {
             LogPrint("net", "getblocks stopping at %d %s\n", pIndex->height, pIndex->GetBlockHash().ToString());
             break;
@@ -629,21 +624,23 @@ inline bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv){
         pFrom->AddInventoryKnown(inv);
         bool fAlreadyHave = AlreadyHave(inv);
 
-        int32_t nBlockHeight = 0;
-        if (inv.type == MSG_BLOCK && mapBlockIndex.count(inv.hash))
-            nBlockHeight = mapBlockIndex[inv.hash]->height;
+        if (LOG_CATEGORY_ENABLED("net")) {
+            int32_t nBlockHeight = 0;
+            if (inv.type == MSG_BLOCK && mapBlockIndex.count(inv.hash))
+                nBlockHeight = mapBlockIndex[inv.hash]->height;
 
-        LogPrint("net", "got inventory[%d]: %s %s %d from peer %s\n", nInv, inv.ToString(),
-                 fAlreadyHave ? "have" : "new", nBlockHeight, pFrom->addr.ToString());
+            LogPrint("net", "got inventory[%d]: %s %s %d from peer %s\n", nInv, inv.ToString(),
+                     fAlreadyHave ? "have" : "new", nBlockHeight, pFrom->addr.ToString());
+        }
 
         if (!fAlreadyHave) {
             if (!SysCfg().IsImporting() && !SysCfg().IsReindex()) {
-                if (inv.type == MSG_BLOCK)
-                    AddBlockToQueue(pFrom->GetId(), inv.hash);
-                else
+                if (inv.type != MSG_BLOCK)
                     pFrom->AskFor(inv);  // MSG_TX
+                else if (!headersSync.Contains(inv.hash))  // otherwise requested in the download window
+                    AddBlockToQueue(pFrom->GetId(), inv.hash);
             }
-        } else if (inv.type == MSG_BLOCK && mapOrphanBlocks.count(inv.hash)) {
+        } else if (inv.type == MSG_BLOCK && mapOrphanBlocks.count(inv.hash) && !headersSync.Contains(inv.hash)) {
             COrphanBlock *pOrphanBlock = mapOrphanBlocks[inv.hash];
             LogPrint("net", "receive orphan block inv height=%d hash=%s lead to getblocks, current height=%d\n",
                      pOrphanBlock->height, inv.hash.GetHex(), chainActive.Height());
@@ -677,6 +674,32 @@ inline bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv){
     return true ;
 }
 
+// Requires cs_main.
+inline void ProcessReceivedBlock(CNode *pFrom, CBlock &block) {
+    CInv inv(MSG_BLOCK, block.GetHash());
+    // Remember who we got this block from.
+    mapBlockSource[inv.hash] = pFrom->GetId();
+    MarkBlockAsReceived(inv.hash, pFrom->GetId());
+
+    // the relay latency of the new blocks at the tip, not of the blocks fetched by the block sync
+    CNodeState *nodeState = State(pFrom->GetId());
+    if (nodeState != nullptr && !IsInitialBlockDownload() &&
+        block.GetPrevBlockHash() == chainActive.Tip()->GetBlockHash()) {
+        nodeState->nRelayedBlocks++;
+        nodeState->nRelayLatencyMillis += max<int64_t>(GetTimeMillis() - block.GetBlockTime() * 1000, 0);
+    }
+
+    CValidationState state;
+    int32_t nDoS = 0;
+    if (!ProcessBlock(state, pFrom, &block) && state.IsInvalid(nDoS) && nDoS > 0 && headersSync.Contains(inv.hash)) {
+        // the block matches its header by hash, so the header chain of the sync peer leads to an invalid block
+        LogPrint("INFO", "Misbehaving: invalid block %s in the header chain of peer=%d, stop syncing headers\n",
+                 inv.hash.ToString(), headersSync.GetPeer());
+        Misbehaving(headersSync.GetPeer(), 100);
+        headersSync.Clear();
+    }
+}
+
 inline void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv){
     CBlock block;
     vRecv >> block;
@@ -684,16 +707,228 @@ inline void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv){
     LogPrint("net", "received block %s from %s\n", block.GetHash().ToString(), pFrom->addr.ToString());
     // block.Print();
 
-    CInv inv(MSG_BLOCK, block.GetHash());
-    pFrom->AddInventoryKnown(inv);
+    pFrom->AddInventoryKnown(CInv(MSG_BLOCK, block.GetHash()));
 
     LOCK(cs_main);
-    // Remember who we got this block from.
-    mapBlockSource[inv.hash] = pFrom->GetId();
-    MarkBlockAsReceived(inv.hash, pFrom->GetId());
+    ProcessReceivedBlock(pFrom, block);
+}
 
-    CValidationState state;
-    ProcessBlock(state, pFrom, &block);
+inline void ProcessSendCmpctMessage(CNode *pFrom, CDataStream &vRecv) {
+    bool fAnnounce         = false;
+    uint64_t nCmpctVersion = 0;
+    vRecv >> fAnnounce >> nCmpctVersion;
+
+    if (nCmpctVersion == COMPACT_BLOCKS_VERSION)
+        pFrom->fSendCompactBlocks = fAnnounce;
+}
+
+inline void RequestFullBlock(CNode *pFrom, const uint256 &blockHash) {
+    vector<CInv> vGetData(1, CInv(MSG_BLOCK, blockHash));
+    pFrom->PushMessage("getdata", vGetData);
+}
+
+// Requires cs_main. Find the txs in the mempool, and then in the recent blocks, where the txs of a block replaced
+// by a fork at the tip are, while they are still in the mempool of the peer.
+inline void FindCompactBlockTxs(CPartialBlock &partialBlock) {
+    {
+        LOCK(mempool.cs);
+        for (const auto &entry : mempool.memPoolTxs) {
+            if (partialBlock.IsWanted(entry.GetHash()))
+                partialBlock.AddTx(entry.GetHash(), entry.GetTransaction());
+        }
+    }
+    if (!partialBlock.HasMissing())
+        return;
+
+    set<uint256> blockHashes;
+    for (const auto &item : pCdMan->pTxCache->GetTxHashCache()) {
+        for (const auto &txid : item.second) {
+            if (partialBlock.IsWanted(txid)) {
+                blockHashes.insert(item.first);
+                break;
+            }
+        }
+    }
+
+    for (const auto &blockHash : blockHashes) {
+        CBlockIndex *pIndex = LookupBlockIndex(blockHash);
+        CBlock block;
+        if (pIndex == nullptr || !ReadBlockFromDisk(pIndex, block))
+            continue;
+
+        for (const auto &pTx : block.vptx) {
+            uint256 txid = pTx->GetHash();
+            if (partialBlock.IsWanted(txid))
+                partialBlock.AddTx(txid, pTx);
+        }
+    }
+}
+
+// Requires cs_main.
+inline void FinishCompactBlock(CNode *pFrom, CNodeState *nodeState, const CPartialBlock &partialBlock,
+                               const vector<std::shared_ptr<CBaseTx> > &missingTxs) {
+    CBlock block;
+    CPartialBlock::ReadStatus status = partialBlock.FillBlock(block, missingTxs);
+    if (status == CPartialBlock::READ_INVALID) {
+        LogPrint("INFO", "Misbehaving: blocktxn not matching the missing txs of block %s from peer %s, "
+                 "nMisbehavior add 100\n", partialBlock.GetHash().ToString(), pFrom->addr.ToString());
+        Misbehaving(pFrom->GetId(), 100);
+        return;
+    }
+    if (status == CPartialBlock::READ_FAILED) {
+        // a short id collision with a tx not in the block
+        LogPrint("net", "reconstructed block %s not matching the merkle root, download it in full from peer %s\n",
+                 partialBlock.GetHash().ToString(), pFrom->addr.ToString());
+        nodeState->nCmpctBlockFailures++;
+        RequestFullBlock(pFrom, partialBlock.GetHash());
+        return;
+    }
+
+    nodeState->nCmpctReconstructMillis += GetTimeMillis() - partialBlock.GetStartTime();
+    LogPrint("net", "reconstructed compact block %s from peer %s, prefilled=%u found=%u requested=%u\n",
+             partialBlock.GetHash().ToString(), pFrom->addr.ToString(), partialBlock.GetPrefilledCount(),
+             partialBlock.GetFoundCount(), missingTxs.size());
+    ProcessReceivedBlock(pFrom, block);
+}
+
+inline bool ProcessCompactBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CCompactBlock cmpctblock;
+    vRecv >> cmpctblock;
+    int64_t nStartTime = GetTimeMillis();
+
+    uint256 blockHash = cmpctblock.header.GetHash();
+    LogPrint("net", "received compact block %s from %s\n", blockHash.ToString(), pFrom->addr.ToString());
+    pFrom->AddInventoryKnown(CInv(MSG_BLOCK, blockHash));
+
+    LOCK(cs_main);
+    CNodeState *nodeState = State(pFrom->GetId());
+    if (nodeState == nullptr || mapBlockIndex.count(blockHash) || mapOrphanBlocks.count(blockHash))
+        return true;
+
+    nodeState->nCmpctBlocks++;
+    if (!mapBlockIndex.count(cmpctblock.header.GetPrevBlockHash())) {
+        // left to the orphan handling of the full block, or to the block sync
+        nodeState->nCmpctBlockFailures++;
+        if (!IsInitialBlockDownload())
+            RequestFullBlock(pFrom, blockHash);
+        return true;
+    }
+
+    auto pPartialBlock = std::make_shared<CPartialBlock>();
+    CPartialBlock::ReadStatus status = pPartialBlock->Init(cmpctblock);
+    if (status == CPartialBlock::READ_INVALID) {
+        LogPrint("INFO", "Misbehaving: invalid compact block %s from peer %s, nMisbehavior add 100\n",
+                 blockHash.ToString(), pFrom->addr.ToString());
+        Misbehaving(pFrom->GetId(), 100);
+        return false;
+    }
+    if (status == CPartialBlock::READ_FAILED) {
+        nodeState->nCmpctBlockFailures++;
+        RequestFullBlock(pFrom, blockHash);
+        return true;
+    }
+    pPartialBlock->SetStartTime(nStartTime);
+
+    FindCompactBlockTxs(*pPartialBlock);
+    nodeState->nCmpctTxsFound += pPartialBlock->GetFoundCount();
+    if (!pPartialBlock->HasMissing()) {
+        FinishCompactBlock(pFrom, nodeState, *pPartialBlock, {});
+        return true;
+    }
+
+    // one pending per peer, replaced by the next compact block of the peer
+    CBlockTxnRequest req;
+    req.blockHash = blockHash;
+    req.indexes   = pPartialBlock->GetMissingIndexes();
+    nodeState->nCmpctBlockRoundTrips++;
+    nodeState->nCmpctTxsMissing += req.indexes.size();
+    nodeState->pPartialBlock = pPartialBlock;
+    pFrom->PushMessage("getblocktxn", req);
+    return true;
+}
+
+// Read-only, serves the txs from the most recent compact block or from disk without cs_main.
+inline bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxnRequest req;
+    vRecv >> req;
+
+    std::shared_ptr<const CBlock> pBlock = GetMostRecentCompactBlock(req.blockHash);
+    if (!pBlock) {
+        CBlockIndex *pIndex = LookupBlockIndex(req.blockHash);
+        auto pDiskBlock     = std::make_shared<CBlock>();
+        if (pIndex == nullptr || !ReadBlockFromDisk(pIndex, *pDiskBlock)) {
+            LogPrint("net", "getblocktxn of unknown block %s from peer %s\n", req.blockHash.ToString(),
+                     pFrom->addr.ToString());
+            return true;
+        }
+        pBlock = pDiskBlock;
+    }
+
+    CBlockTxn resp;
+    resp.blockHash = req.blockHash;
+    resp.txs.reserve(req.indexes.size());
+    for (uint32_t index : req.indexes) {
+        if (index >= pBlock->vptx.size()) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("getblocktxn index %u out of block %s from peer %s", index, req.blockHash.ToString(),
+                            pFrom->addr.ToString());
+        }
+        resp.txs.push_back(pBlock->vptx[index]);
+    }
+    pFrom->PushMessage("blocktxn", resp);
+    return true;
+}
+
+inline void ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxn resp;
+    vRecv >> resp;
+
+    LOCK(cs_main);
+    CNodeState *nodeState = State(pFrom->GetId());
+    // not requested, or replaced by the next compact block of the peer
+    if (nodeState == nullptr || !nodeState->pPartialBlock || nodeState->pPartialBlock->GetHash() != resp.blockHash)
+        return;
+
+    std::shared_ptr<CPartialBlock> pPartialBlock = nodeState->pPartialBlock;
+    nodeState->pPartialBlock.reset();
+    // received from another peer meanwhile
+    if (mapBlockIndex.count(resp.blockHash) || mapOrphanBlocks.count(resp.blockHash))
+        return;
+
+    FinishCompactBlock(pFrom, nodeState, *pPartialBlock, resp.txs);
+}
+
+inline bool ProcessHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
+    vector<CBlock> vHeaders;
+    vRecv >> vHeaders;
+    if (vHeaders.size() > (size_t)MAX_HEADERS_RESULTS) {
+        Misbehaving(pFrom->GetId(), 20);
+        return ERRORMSG("message headers size() = %u", vHeaders.size());
+    }
+
+    LOCK(cs_main);
+    // only the headers requested from the sync peer are used
+    if (pFrom->GetId() != headersSync.GetPeer())
+        return true;
+
+    if (!headersSync.AddHeaders(vHeaders)) {
+        // the peer reorganized its chain below the tip, or the response is late, restart from the tip. A peer feeding
+        // a header chain of no blocks is banned when the download window stalls
+        LogPrint("net", "headers not linking to the header chain from peer %s, restart syncing headers\n",
+                 pFrom->addr.ToString());
+        headersSync.Clear();
+        pFrom->fStartSync = true;
+        return false;
+    }
+
+    LogPrint("net", "received %u headers from peer %s, header height=%d, current height=%d\n", vHeaders.size(),
+             pFrom->addr.ToString(), headersSync.GetHeight(), chainActive.Height());
+    if (headersSync.GetHeight() > nSyncTipHeight)
+        nSyncTipHeight = headersSync.GetHeight();
+
+    // done if the tip has reached the last header of the peer already
+    headersSync.UpdateTip(chainActive.Tip());
+    return true;
 }
 
 inline void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv){
@@ -727,12 +962,18 @@ inline void ProcessAlertMessage(CNode *pFrom, CDataStream &vRecv){
     vRecv >> alert;
 
     uint256 alertHash = alert.GetHash();
-    if (pFrom->setKnown.count(alertHash) == 0) {
+    bool fKnown;
+    {
+        // setKnown is inserted by the alert relays of the other peers
+        LOCK(cs_mapAlerts);
+        fKnown = pFrom->setKnown.count(alertHash) > 0;
+    }
+    if (!fKnown) {
         if (alert.ProcessAlert()) {
             // Relay
-            pFrom->setKnown.insert(alertHash);
             {
-                LOCK(cs_vNodes);
+                LOCK2(cs_vNodes, cs_mapAlerts);
+                pFrom->setKnown.insert(alertHash);
                 for (auto pNode : vNodes)
                     alert.RelayTo(pNode);
             }
@@ -787,7 +1028,8 @@ inline void ProcessFilterAddMessage(CNode *pFrom, CDataStream &vRecv){
 }
 
 inline void ProcessRejectMessage(CNode *pFrom, CDataStream &vRecv){
-    if (SysCfg().IsDebug()) {
+    // only decoded to be logged
+    if (LOG_CATEGORY_ENABLED("net")) {
         string strMsg;
         uint8_t ccode;
         string strReason;
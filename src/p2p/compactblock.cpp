@@ -0,0 +1,145 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compactblock.h"
+
+#include "config/const.h"
+#include "crypto/hash.h"
+#include "sync.h"
+#include "tx/tx.h"
+
+#include <unordered_set>
+
+bool fCompactBlocks = DEFAULT_COMPACT_BLOCKS;
+
+static CCriticalSection cs_mostRecentCompactBlock;
+static std::shared_ptr<const CBlock> pMostRecentCompactBlock;
+static uint256 mostRecentCompactBlockHash;
+
+CCompactBlock::CCompactBlock(const CBlock &block, uint64_t nonceIn) : header(block.GetBlockHeader()), nonce(nonceIn) {
+    uint256 salt = GetShortIdSalt();
+    for (uint32_t i = 0; i < block.vptx.size(); ++i) {
+        const auto &pTx = block.vptx[i];
+        if (pTx->IsBlockRewardTx() || pTx->IsMedianPriceTx())
+            prefilledTxs.push_back({i, pTx});
+        else
+            shortTxIds.push_back(GetShortTxId(salt, pTx->GetHash()));
+    }
+}
+
+uint256 CCompactBlock::GetShortIdSalt() const {
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << header.GetHash() << nonce;
+    return ss.GetHash();
+}
+
+CPartialBlock::ReadStatus CPartialBlock::Init(const CCompactBlock &cmpctblock) {
+    uint32_t txCount = cmpctblock.GetTxCount();
+    if (txCount == 0 || txCount > MAX_BLOCK_SIZE / MIN_COMPACT_BLOCK_TX_SIZE)
+        return READ_INVALID;
+
+    blockHash = cmpctblock.header.GetHash();
+    header    = cmpctblock.header;
+    salt      = cmpctblock.GetShortIdSalt();
+    vptx.assign(txCount, nullptr);
+    vTxids.assign(txCount, uint256());
+    vAmbiguous.assign(txCount, false);
+    mapShortIdIndex.clear();
+    nPrefilled = 0;
+    nFound     = 0;
+
+    for (const auto &prefilled : cmpctblock.prefilledTxs) {
+        if (prefilled.index >= txCount || !prefilled.pTx || vptx[prefilled.index])
+            return READ_INVALID;
+        vptx[prefilled.index] = prefilled.pTx;
+        ++nPrefilled;
+    }
+
+    auto itShortId = cmpctblock.shortTxIds.begin();
+    for (uint32_t i = 0; i < txCount; ++i) {
+        if (vptx[i])
+            continue;
+
+        // two txs of the block with the same short id, rare enough to download the block in full
+        if (!mapShortIdIndex.emplace(*itShortId++, i).second)
+            return READ_FAILED;
+    }
+    return READ_OK;
+}
+
+bool CPartialBlock::IsWanted(const uint256 &txid) const {
+    auto it = mapShortIdIndex.find(CCompactBlock::GetShortTxId(salt, txid));
+    return it != mapShortIdIndex.end() && !vAmbiguous[it->second] && vTxids[it->second] != txid;
+}
+
+void CPartialBlock::AddTx(const uint256 &txid, const std::shared_ptr<CBaseTx> &pTx) {
+    auto it = mapShortIdIndex.find(CCompactBlock::GetShortTxId(salt, txid));
+    if (it == mapShortIdIndex.end() || vAmbiguous[it->second] || vTxids[it->second] == txid)
+        return;
+
+    uint32_t index = it->second;
+    if (vptx[index]) {
+        // another tx has the short id, request the one of the block
+        vptx[index]       = nullptr;
+        vTxids[index]     = uint256();
+        vAmbiguous[index] = true;
+        --nFound;
+        return;
+    }
+    vptx[index]   = pTx;
+    vTxids[index] = txid;
+    ++nFound;
+}
+
+bool CPartialBlock::HasMissing() const { return nPrefilled + nFound < vptx.size(); }
+
+vector<uint32_t> CPartialBlock::GetMissingIndexes() const {
+    vector<uint32_t> indexes;
+    for (uint32_t i = 0; i < vptx.size(); ++i) {
+        if (!vptx[i])
+            indexes.push_back(i);
+    }
+    return indexes;
+}
+
+CPartialBlock::ReadStatus CPartialBlock::FillBlock(CBlock &block,
+                                                   const vector<std::shared_ptr<CBaseTx> > &missingTxs) const {
+    block = CBlock(header);
+    block.vptx.reserve(vptx.size());
+    auto itMissing = missingTxs.begin();
+    for (const auto &pTx : vptx) {
+        if (pTx) {
+            block.vptx.push_back(pTx);
+        } else {
+            if (itMissing == missingTxs.end() || !*itMissing)
+                return READ_INVALID;
+            block.vptx.push_back(*itMissing++);
+        }
+    }
+    if (itMissing != missingTxs.end())
+        return READ_INVALID;
+
+    // a duplicated tx keeps the merkle root of the block without it, and must not get the block marked invalid
+    if (block.BuildMerkleTree() != block.GetMerkleRootHash())
+        return READ_FAILED;
+    unordered_set<uint256, CUint256Hasher> txids;
+    for (uint32_t i = 0; i < block.vptx.size(); ++i) {
+        if (!txids.insert(block.GetTxid(i)).second)
+            return READ_FAILED;
+    }
+    return READ_OK;
+}
+
+void SetMostRecentCompactBlock(const std::shared_ptr<const CBlock> &pBlock) {
+    LOCK(cs_mostRecentCompactBlock);
+    pMostRecentCompactBlock    = pBlock;
+    mostRecentCompactBlockHash = pBlock ? pBlock->GetHash() : uint256();
+}
+
+std::shared_ptr<const CBlock> GetMostRecentCompactBlock(const uint256 &blockHash) {
+    LOCK(cs_mostRecentCompactBlock);
+    if (pMostRecentCompactBlock && mostRecentCompactBlockHash == blockHash)
+        return pMostRecentCompactBlock;
+    return nullptr;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_COMPACTBLOCK_H
+#define P2P_COMPACTBLOCK_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "persistence/block.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class CBaseTx;
+
+// whether to push the new blocks as compact blocks to the peers asking for them by sendcmpct
+extern bool fCompactBlocks;
+
+/** A tx of the compact block sent in full, the ones never relayed alone: the block reward and median price txs. */
+struct CPrefilledTx {
+    uint32_t index;  // in the block
+    std::shared_ptr<CBaseTx> pTx;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(index));
+        READWRITE(pTx);
+    )
+};
+
+/**
+ * The "cmpctblock" message: the header and the short ids of the txs, which the peer finds in its mempool. The short
+ * id of a tx is its txid hashed with a salt of the block hash and a random nonce, so the collisions can not be
+ * crafted ahead of the block.
+ */
+class CCompactBlock {
+public:
+    CBlockHeader header;
+    uint64_t nonce;
+    vector<uint64_t> shortTxIds;
+    vector<CPrefilledTx> prefilledTxs;  // in ascending order of index
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(header);
+        READWRITE(nonce);
+        READWRITE(shortTxIds);
+        READWRITE(prefilledTxs);
+    )
+
+public:
+    CCompactBlock() : nonce(0) {}
+    CCompactBlock(const CBlock &block, uint64_t nonceIn);
+
+    uint32_t GetTxCount() const { return shortTxIds.size() + prefilledTxs.size(); }
+    uint256 GetShortIdSalt() const;
+    static uint64_t GetShortTxId(const uint256 &salt, const uint256 &txid) { return txid.GetHash(salt); }
+};
+
+/** The "getblocktxn" message: the indexes of the txs missing from the reconstructed block. */
+struct CBlockTxnRequest {
+    uint256 blockHash;
+    vector<uint32_t> indexes;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(indexes);
+    )
+};
+
+/** The "blocktxn" message: the txs requested by getblocktxn, in the order of the indexes. */
+struct CBlockTxn {
+    uint256 blockHash;
+    vector<std::shared_ptr<CBaseTx> > txs;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(txs);
+    )
+};
+
+/**
+ * A block being reconstructed from a compact block, with the txs at hand offered by AddTx(). The txs of a short id
+ * matched by more than one tx are requested by getblocktxn like the missing ones. The filled block is checked
+ * against the merkle root of the header, so a collision with a tx not in the block never reaches validation.
+ */
+class CPartialBlock {
+public:
+    enum ReadStatus {
+        READ_OK,
+        READ_INVALID,  // the message is malformed, the peer misbehaves
+        READ_FAILED,   // the block can not be reconstructed, to be downloaded in full
+    };
+
+public:
+    CPartialBlock() : nPrefilled(0), nFound(0), nStartTime(0) {}
+
+    ReadStatus Init(const CCompactBlock &cmpctblock);
+
+    const uint256 &GetHash() const { return blockHash; }
+    const CBlockHeader &GetHeader() const { return header; }
+    /** Whether the tx matches the short id of a tx not filled yet. */
+    bool IsWanted(const uint256 &txid) const;
+    void AddTx(const uint256 &txid, const std::shared_ptr<CBaseTx> &pTx);
+    bool HasMissing() const;
+    vector<uint32_t> GetMissingIndexes() const;
+
+    /** Fill the missing txs in the order of GetMissingIndexes() and check the block against the header. */
+    ReadStatus FillBlock(CBlock &block, const vector<std::shared_ptr<CBaseTx> > &missingTxs) const;
+
+    uint32_t GetPrefilledCount() const { return nPrefilled; }
+    /** The txs found by AddTx(), excluding the ambiguous ones. */
+    uint32_t GetFoundCount() const { return nFound; }
+    int64_t GetStartTime() const { return nStartTime; }
+    void SetStartTime(int64_t nTime) { nStartTime = nTime; }
+
+private:
+    uint256 blockHash;
+    CBlockHeader header;
+    uint256 salt;
+    vector<std::shared_ptr<CBaseTx> > vptx;
+    vector<uint256> vTxids;                             // of the txs found by AddTx()
+    unordered_map<uint64_t, uint32_t> mapShortIdIndex;  // short id -> index of the tx not prefilled
+    vector<bool> vAmbiguous;                            // matched by more than one tx
+    uint32_t nPrefilled;
+    uint32_t nFound;
+    int64_t nStartTime;
+};
+
+/** Keep the last block relayed as a compact block, to serve the getblocktxn of the peers without reading the disk. */
+void SetMostRecentCompactBlock(const std::shared_ptr<const CBlock> &pBlock);
+std::shared_ptr<const CBlock> GetMostRecentCompactBlock(const uint256 &blockHash);
+
+#endif  // P2P_COMPACTBLOCK_H
@@ -0,0 +1,105 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "headerssync.h"
+
+#include "config/const.h"
+#include "persistence/block.h"
+
+CHeadersSync headersSync;
+
+void CHeadersSync::Start(int32_t peerIn, const CBlockIndex *pTip) {
+    Clear();
+    peer          = peerIn;
+    nBaseHeight   = pTip ? pTip->height : -1;
+    baseHash      = pTip ? pTip->GetBlockHash() : uint256();
+    fMoreHeaders  = true;
+    nProgressTime = GetTimeMicros();
+}
+
+void CHeadersSync::Clear() {
+    peer          = -1;
+    nBaseHeight   = -1;
+    baseHash      = uint256();
+    fMoreHeaders  = false;
+    nRequestTime  = 0;
+    nProgressTime = 0;
+    vHashes.clear();
+    mapHeights.clear();
+}
+
+uint256 CHeadersSync::GetHash(int32_t height) const {
+    if (height == nBaseHeight)
+        return baseHash;
+    if (height < nBaseHeight || height > GetHeight())
+        return uint256();
+    return vHashes[height - nBaseHeight - 1];
+}
+
+bool CHeadersSync::AddHeaders(const vector<CBlock> &headers) {
+    nRequestTime = 0;
+    // the tip has waited for no blocks
+    if (vHashes.empty())
+        nProgressTime = GetTimeMicros();
+
+    for (const auto &header : headers) {
+        uint256 hash = header.GetHash();
+        // the last headers of the peer are sent again after a reorg of its chain, or by a late response
+        if (hash == baseHash || mapHeights.count(hash))
+            continue;
+
+        // the peer reorganized its chain above the tip, drop the headers of the old branch
+        int32_t prevHeight = (int32_t)header.GetHeight() - 1;
+        if (prevHeight >= nBaseHeight && prevHeight < GetHeight() && header.GetPrevBlockHash() == GetHash(prevHeight)) {
+            while (GetHeight() > prevHeight) {
+                mapHeights.erase(vHashes.back());
+                vHashes.pop_back();
+            }
+        }
+
+        if (header.GetPrevBlockHash() != GetHash(GetHeight()) || (int32_t)header.GetHeight() != GetHeight() + 1)
+            return false;
+
+        vHashes.push_back(hash);
+        mapHeights.emplace(hash, GetHeight());
+    }
+    fMoreHeaders = headers.size() >= (size_t)MAX_HEADERS_RESULTS;
+    return true;
+}
+
+bool CHeadersSync::IsStalling(int64_t nNow) const {
+    return IsSyncing() && !vHashes.empty() && nProgressTime < nNow - 2 * BLOCK_DOWNLOAD_TIMEOUT * 1000000;
+}
+
+bool CHeadersSync::NeedMoreHeaders() const {
+    return IsSyncing() && fMoreHeaders && nRequestTime == 0 &&
+           (int32_t)vHashes.size() + MAX_HEADERS_RESULTS <= MAX_HEADERS_AHEAD;
+}
+
+void CHeadersSync::UpdateTip(const CBlockIndex *pTip) {
+    // disconnected below the header chain, which is expected to be connected again
+    if (!IsSyncing() || pTip == nullptr || pTip->height < nBaseHeight)
+        return;
+
+    if (GetHash(pTip->height) != pTip->GetBlockHash()) {
+        LogPrint("net", "CHeadersSync::UpdateTip, the tip %d %s left the header chain of peer=%d, stop syncing\n",
+                 pTip->height, pTip->GetBlockHash().ToString(), peer);
+        Clear();
+        return;
+    }
+
+    if (nBaseHeight < pTip->height)
+        nProgressTime = GetTimeMicros();
+    while (nBaseHeight < pTip->height) {
+        mapHeights.erase(vHashes.front());
+        vHashes.pop_front();
+        ++nBaseHeight;
+    }
+    baseHash = pTip->GetBlockHash();
+
+    if (vHashes.empty() && !fMoreHeaders && nRequestTime == 0) {
+        LogPrint("net", "CHeadersSync::UpdateTip, synced the headers of peer=%d to height %d\n", peer, nBaseHeight);
+        Clear();
+    }
+}
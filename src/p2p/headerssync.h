@@ -0,0 +1,86 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_HEADERSSYNC_H
+#define P2P_HEADERSSYNC_H
+
+#include "commons/uint256.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+class CBlock;
+class CBlockIndex;
+
+/**
+ * The header chain of the headers-first block sync, above the active chain tip. The headers are fetched by
+ * getheaders from the sync peer, up to MAX_HEADERS_AHEAD blocks ahead of the tip, and only checked to link up
+ * by hash and height. The blocks are fetched from all the peers by their hashes in the header chain within
+ * BLOCK_DOWNLOAD_WINDOW blocks above the tip, and fully validated as they connect to the tip in order.
+ *
+ * Requires cs_main.
+ */
+class CHeadersSync {
+public:
+    CHeadersSync() : fEnabled(false) { Clear(); }
+
+    void SetEnabled(bool fEnabledIn) { fEnabled = fEnabledIn; }
+    bool IsEnabled() const { return fEnabled; }
+
+    /** Start syncing the headers above the tip from the peer. */
+    void Start(int32_t peerIn, const CBlockIndex *pTip);
+    void Clear();
+
+    bool IsSyncing() const { return peer != -1; }
+    int32_t GetPeer() const { return peer; }
+    /** The height of the last header, the tip height if none. */
+    int32_t GetHeight() const { return nBaseHeight + (int32_t)vHashes.size(); }
+    bool Contains(const uint256 &hash) const { return mapHeights.count(hash) > 0; }
+    /** The hash of the header at the height, or the tip hash, null if out of the header chain. */
+    uint256 GetHash(int32_t height) const;
+
+    /**
+     * Append the headers of a headers message, the ones known already are skipped. A header linking below the last
+     * header replaces the headers after its parent, as the peer reorganized its chain. Return false if a header does
+     * not link to the header chain, the headers before it are kept.
+     */
+    bool AddHeaders(const vector<CBlock> &headers);
+    /** Whether to send the next getheaders: the peer has more headers and they are not too far ahead of the tip. */
+    bool NeedMoreHeaders() const;
+    /** The time in micros of the pending getheaders, 0 if none. */
+    int64_t GetRequestTime() const { return nRequestTime; }
+    void SetRequestTime(int64_t nTime) { nRequestTime = nTime; }
+
+    /**
+     * Drop the headers connected to the active chain, called on each tip update. The sync is done when the tip
+     * reaches the last header of the peer, and stopped if the tip left the header chain.
+     */
+    void UpdateTip(const CBlockIndex *pTip);
+
+    /**
+     * Whether the tip has not advanced in the header chain for 2 * BLOCK_DOWNLOAD_TIMEOUT while there are headers
+     * above it, long enough for the window requests to expire once and go to the other peers, so the peer has sent
+     * the headers of blocks no one serves.
+     */
+    bool IsStalling(int64_t nNow) const;
+
+private:
+    bool fEnabled;
+    int32_t peer;
+    int32_t nBaseHeight;     // the height of the tip below the first header
+    uint256 baseHash;
+    deque<uint256> vHashes;  // the header hashes from nBaseHeight + 1
+    map<uint256, int32_t> mapHeights;
+    bool fMoreHeaders;       // the last headers message was full
+    int64_t nRequestTime;
+    int64_t nProgressTime;   // the time in micros the tip last advanced in the header chain, or the chain grew from it
+};
+
+extern CHeadersSync headersSync;
+
+#endif  // P2P_HEADERSSYNC_H
@@ -226,6 +226,13 @@ bool CAccountDBCache::Flush() {
     return true;
 }
 
+void CAccountDBCache::Clear() {
+    blockHashCache.Clear();
+    accountCache.Clear();
+    regId2KeyIdCache.Clear();
+    nickId2KeyIdCache.Clear();
+}
+
 uint32_t CAccountDBCache::GetCacheSize() const {
     return blockHashCache.GetCacheSize() +
         accountCache.GetCacheSize() +
@@ -93,6 +93,7 @@ public:
     uint64_t GetAccountFreeAmount(const CKeyID &keyId, const TokenSymbol &tokenSymbol);
 
     bool Flush();
+    void Clear();
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         blockHashCache.SetDbOpLogMap(pDbOpLogMapIn);
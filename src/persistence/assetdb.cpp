@@ -54,4 +54,9 @@ bool CAssetDBCache::Flush() {
     assetCache.Flush();
     assetTradingPairCache.Flush();
     return true;
+}
+
+void CAssetDBCache::Clear() {
+    assetCache.Clear();
+    assetTradingPairCache.Clear();
 }
\ No newline at end of file
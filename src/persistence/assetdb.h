@@ -55,6 +55,8 @@ public:
     bool EraseAssetTradingPair(const CAssetTradingPair &assetTradingPair);
 
     bool Flush();
+    void Clear();
+    uint32_t GetCacheSize() const { return assetCache.GetCacheSize() + assetTradingPairCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CAssetDBCache *pBaseIn) {
         assetCache.SetBase(&pBaseIn->assetCache);
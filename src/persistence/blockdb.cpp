@@ -151,6 +151,7 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
     CBlockIndex *pIndexNew = new CBlockIndex();
     if (!pIndexNew)
         throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
+    LOCK(cs_mapBlockIndex);
     mi                    = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
     pIndexNew->pBlockHash = &((*mi).first);
 
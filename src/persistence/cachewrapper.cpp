@@ -32,17 +32,7 @@ CCacheWrapper::CCacheWrapper(CSysParamDBCache* pSysParamCacheIn,
 }
 
 CCacheWrapper::CCacheWrapper(CCacheWrapper& cwIn) {
-    sysParamCache.SetBaseViewPtr(&cwIn.sysParamCache);
-    accountCache.SetBaseViewPtr(&cwIn.accountCache);
-    assetCache.SetBaseViewPtr(&cwIn.assetCache);
-    contractCache.SetBaseViewPtr(&cwIn.contractCache);
-    delegateCache.SetBaseViewPtr(&cwIn.delegateCache);
-    cdpCache.SetBaseViewPtr(&cwIn.cdpCache);
-    dexCache.SetBaseViewPtr(&cwIn.dexCache);
-    txReceiptCache.SetBaseViewPtr(&cwIn.txReceiptCache);
-
-    txCache.SetBaseViewPtr(&cwIn.txCache);
-    ppCache.SetBaseViewPtr(&cwIn.ppCache);
+    SetBaseViewPtr(&cwIn);
 }
 
 CCacheWrapper::CCacheWrapper(CCacheDBManager* pCdMan) {
@@ -77,6 +67,33 @@ CCacheWrapper& CCacheWrapper::operator=(CCacheWrapper& other) {
     return *this;
 }
 
+void CCacheWrapper::SetBaseViewPtr(CCacheWrapper *pBaseIn) {
+    sysParamCache.SetBaseViewPtr(&pBaseIn->sysParamCache);
+    accountCache.SetBaseViewPtr(&pBaseIn->accountCache);
+    assetCache.SetBaseViewPtr(&pBaseIn->assetCache);
+    contractCache.SetBaseViewPtr(&pBaseIn->contractCache);
+    delegateCache.SetBaseViewPtr(&pBaseIn->delegateCache);
+    cdpCache.SetBaseViewPtr(&pBaseIn->cdpCache);
+    dexCache.SetBaseViewPtr(&pBaseIn->dexCache);
+    txReceiptCache.SetBaseViewPtr(&pBaseIn->txReceiptCache);
+
+    txCache.SetBaseViewPtr(&pBaseIn->txCache);
+    ppCache.SetBaseViewPtr(&pBaseIn->ppCache);
+}
+
+uint32_t CCacheWrapper::GetCacheSize() const {
+    return sysParamCache.GetCacheSize() +
+           accountCache.GetCacheSize() +
+           assetCache.GetCacheSize() +
+           contractCache.GetCacheSize() +
+           delegateCache.GetCacheSize() +
+           cdpCache.GetCacheSize() +
+           dexCache.GetCacheSize() +
+           txReceiptCache.GetCacheSize() +
+           txCache.GetCacheSize() +
+           ppCache.GetCacheSize();
+}
+
 void CCacheWrapper::EnableTxUndoLog(const uint256 &txid) {
     txUndo.Clear();
     SetDbOpMapLog(&txUndo.dbOpLogMap);
@@ -120,6 +137,44 @@ void CCacheWrapper::Flush() {
     ppCache.Flush();
 }
 
+void CCacheWrapper::Clear() {
+    sysParamCache.Clear();
+    accountCache.Clear();
+    assetCache.Clear();
+    contractCache.Clear();
+    delegateCache.Clear();
+    cdpCache.Clear();
+    dexCache.Clear();
+    txReceiptCache.Clear();
+
+    txCache.Clear();
+    ppCache.Clear();
+
+    txUndo.Clear();
+}
+
+std::unique_ptr<CCacheWrapper> CCacheWrapper::AcquireChild() {
+    if (freeChildren.empty())
+        return std::unique_ptr<CCacheWrapper>(new CCacheWrapper(*this));
+
+    std::unique_ptr<CCacheWrapper> spChild = std::move(freeChildren.back());
+    freeChildren.pop_back();
+    // resync the few values copied from base (e.g. the cdp globals), which may have changed since released
+    spChild->Clear();
+    return spChild;
+}
+
+void CCacheWrapper::ReleaseChild(std::unique_ptr<CCacheWrapper> &&spChild) {
+    static const uint32_t MAX_FREE_CHILDREN = 4;
+
+    if (freeChildren.size() >= MAX_FREE_CHILDREN)
+        return;
+
+    spChild->Clear();
+    spChild->DisableTxUndoLog();
+    freeChildren.push_back(std::move(spChild));
+}
+
 void CCacheWrapper::SetDbOpMapLog(CDBOpLogMap *pDbOpLogMap) {
     sysParamCache.SetDbOpLogMap(pDbOpLogMap);
     accountCache.SetDbOpLogMap(pDbOpLogMap);
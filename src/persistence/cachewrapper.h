@@ -17,6 +17,9 @@
 #include "txreceiptdb.h"
 #include "assetdb.h"
 
+#include <memory>
+#include <vector>
+
 class CCacheDBManager;
 class CBlockUndo;
 
@@ -54,6 +57,11 @@ public:
 
     CCacheWrapper& operator=(CCacheWrapper& other);
 
+    // Move this layer onto another base, keeping its data, see CCompositeKVCache::SetBase().
+    void SetBaseViewPtr(CCacheWrapper *pBaseIn);
+    // The memory of the data of the caches in this layer.
+    uint32_t GetCacheSize() const;
+
     void EnableTxUndoLog(const uint256 &txid);
     void DisableTxUndoLog();
 
@@ -62,8 +70,48 @@ public:
     bool UndoDatas(CBlockUndo &blockUndo);
 
     void Flush();
+    // Discard every change of this layer, leaving it as a fresh child of its base views. Together with
+    // Flush() it lets a single child layer act as a savepoint which is committed or rolled back per tx.
+    void Clear();
+
+    // Take a child layer of this wrapper from its pool, or construct one if the pool is empty.
+    std::unique_ptr<CCacheWrapper> AcquireChild();
+    // Discard the changes of a child layer taken by AcquireChild() and put it back to the pool.
+    void ReleaseChild(std::unique_ptr<CCacheWrapper> &&spChild);
 private:
     void SetDbOpMapLog(CDBOpLogMap *pDbOpLogMap);
+
+private:
+    std::vector<std::unique_ptr<CCacheWrapper>> freeChildren;
+};
+
+/**
+ * Copy-on-write snapshot of a cache wrapper for executing a tx speculatively. The snapshot is a child layer
+ * reused from the pool of the base wrapper, so taking one allocates nothing, and the tx only copies the data it
+ * touches into it. The changes are written to the base by Commit(), otherwise discarded when the snapshot goes
+ * out of scope.
+ */
+class CCacheSnapshot {
+public:
+    explicit CCacheSnapshot(CCacheWrapper &baseIn) : base(baseIn), spCw(baseIn.AcquireChild()) {}
+    ~CCacheSnapshot() { base.ReleaseChild(std::move(spCw)); }
+
+    CCacheSnapshot(const CCacheSnapshot &) = delete;
+    CCacheSnapshot &operator=(const CCacheSnapshot &) = delete;
+
+    CCacheWrapper &operator*() { return *spCw; }
+    CCacheWrapper *operator->() { return spCw.get(); }
+
+    void Commit() {
+        spCw->Flush();
+        spCw->Clear();
+    }
+
+    void Rollback() { spCw->Clear(); }
+
+private:
+    CCacheWrapper &base;
+    std::unique_ptr<CCacheWrapper> spCw;
 };
 
 #endif //PERSIST_CACHEWRAPPER_H
\ No newline at end of file
@@ -4,161 +4,44 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "cdpdb.h"
+#include "config/configuration.h"
 
-bool CCDPMemCache::LoadAllCDPFromDB() {
-    assert(pAccess != nullptr);
-    map<uint256, CUserCDP> rawCdps;
-    if (!pAccess->GetAllElements(dbk::CDP, rawCdps)) {
-        LogPrint("CDP", "CCDPMemCache::LoadAllCDPFromDB, GetAllElements failed\n");
-        return false;
-    }
-
-    for (const auto & item: rawCdps) {
-        cdps.emplace(item.second, CDPState::CDP_VALID);
-        global_staked_bcoins += item.second.total_staked_bcoins;
-        global_owed_scoins += item.second.total_owed_scoins;
-    }
-
-    LogPrint("CDP", "CCDPMemCache::LoadAllCDPFromDB, rawCdps: %llu, global_staked_bcoins: %llu, global_owed_scoins: %llu\n",
-             rawCdps.size(), global_staked_bcoins, global_owed_scoins);
-
-    return true;
-}
-
-void CCDPMemCache::SetBase(CCDPMemCache *pBaseIn) {
-    assert(pBaseIn != nullptr);
-    pBase = pBaseIn;
-
-    SetGlobalItem(pBaseIn->global_staked_bcoins, pBaseIn->global_owed_scoins);
-}
-
-void CCDPMemCache::Flush() {
-    if (pBase != nullptr) {
-        pBase->BatchWrite(cdps);
-        cdps.clear();
-
-        pBase->SetGlobalItem(global_staked_bcoins, global_owed_scoins);
-    }
-}
-
-bool CCDPMemCache::SaveCDP(const CUserCDP &userCdp) {
-    cdps.emplace(userCdp, CDPState::CDP_VALID);
-
-    global_staked_bcoins += userCdp.total_staked_bcoins;
-    global_owed_scoins += userCdp.total_owed_scoins;
-
-    return true;
-}
-
-bool CCDPMemCache::EraseCDP(const CUserCDP &userCdp) {
-    cdps[userCdp] = CDPState::CDP_EXPIRED;
-    global_staked_bcoins -= userCdp.total_staked_bcoins;
-    global_owed_scoins -= userCdp.total_owed_scoins;
-
-    return true;
-}
-
-bool CCDPMemCache::HaveCDP(const CUserCDP &userCdp) {
-    return cdps.count(userCdp) > 0;
-}
+#include <cstring>
 
-uint64_t CCDPMemCache::GetGlobalCollateralRatio(const uint64_t bcoinMedianPrice) const {
-    // If total owed scoins equal to zero, the global collateral ratio becomes infinite.
-    return (global_owed_scoins == 0) ? UINT64_MAX : uint64_t(double(global_staked_bcoins)
-        * bcoinMedianPrice / PRICE_BOOST / global_owed_scoins * RATIO_BOOST);
-}
-
-uint64_t CCDPMemCache::GetGlobalCollateral() const {
-    return global_staked_bcoins;
+// The bits of a non-negative double sort as the double does, written in hex to sort in db as well.
+static string GetRatioKey(const double ratio) {
+    uint64_t bits;
+    static_assert(sizeof(bits) == sizeof(ratio), "double must be 64 bits");
+    memcpy(&bits, &ratio, sizeof(bits));
+    return strprintf("%016x", bits);
 }
 
-void CCDPMemCache::GetGlobalItem(uint64_t &globalStakedBcoins, uint64_t &globalOwedScoins) {
-    globalStakedBcoins = global_staked_bcoins;
-    globalOwedScoins   = global_owed_scoins;
-}
+static const uint256 MAX_CDPID = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
 
-bool CCDPMemCache::GetCdpListByCollateralRatio(const uint64_t collateralRatio, const uint64_t bcoinMedianPrice,
-                                         set<CUserCDP> &userCdps) {
-    return GetCDPList((double(collateralRatio) / RATIO_BOOST) / (double(bcoinMedianPrice) / PRICE_BOOST), userCdps);
-}
-
-bool CCDPMemCache::GetCDPList(const double ratio, set<CUserCDP> &expiredCdps, set<CUserCDP> &userCdps) {
-    for (const auto item : cdps) {
-        LogPrint("CDP", "CCDPMemCache::GetCDPList, candidate cdp: %s, valid: %d, ratio: %f\n", item.first.ToString(),
-                 item.second, ratio);
-    }
-
-    static CRegID regId(std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint16_t>::max());
-    static CUserCDP cdp;
-    cdp.collateral_ratio_base = ratio;
-    cdp.owner_regid           = regId;
-
-    auto boundary = cdps.upper_bound(cdp);
-    for (auto iter = cdps.begin(); iter != boundary; ++ iter) {
-        if (db_util::IsEmpty(iter->second)) {
-            expiredCdps.insert(iter->first);
-        } else if (expiredCdps.count(iter->first) || userCdps.count(iter->first)) {
-            LogPrint("CDP", "CCDPMemCache::GetCDPList, found an expired item, ignore\n");
-            continue;
-        } else {
-            // Got a valid cdp
-            LogPrint("CDP", "CCDPMemCache::GetCDPList, found an valid item, %s\n", iter->first.ToString());
-            userCdps.insert(iter->first);
-        }
-    }
+// Need to delete the old cdp(before updating cdp), then save the new cdp if necessary.
+// Before the feature fork v3, a closed cdp was subtracted from the global amounts twice, and a cdp saved at a ratio
+// erased in the same cache layer stayed hidden by the erased entry, out of the liquidation scans. Both are kept there.
+bool CCDPDBCache::UpdateCDP(const int32_t blockHeight, const CUserCDP &oldCDP, const CUserCDP &newCDP) {
+    const bool fForkV3 = IsFeatureForkV3(blockHeight);
+    if (newCDP.IsFinished()) {
+        if (!fForkV3 && !UpdateGlobalData(oldCDP, false))
+            return false;
 
-    if (pBase != nullptr) {
-        return pBase->GetCDPList(ratio, expiredCdps, userCdps);
+        return EraseCDP(oldCDP, newCDP);
     }
 
-    return true;
-}
-
-bool CCDPMemCache::GetCDPList(const double ratio, set<CUserCDP> &userCdps) {
-    set<CUserCDP> expiredCdps;
-    if (!GetCDPList(ratio, expiredCdps, userCdps)) {
-        LogPrint("CDP", "CCDPMemCache::GetCDPList, GetCDPList failed\n");
+    if (!EraseCDPFromIndex(oldCDP) || !SaveCDPToDB(newCDP))
         return false;
-    }
-
-    return true;
-}
-
-void CCDPMemCache::BatchWrite(const map<CUserCDP, uint8_t> &cdpsIn) {
-    // If the value is empty, delete it from cache.
-    for (const auto &item : cdpsIn) {
-        if (db_util::IsEmpty(item.second)) {
-            cdps.erase(item.first);
-        } else {
-            cdps[item.first] = item.second;
-        }
-    }
-}
-
-///////////////////////////////////////////////////////////////////////////////
-// class CCDPDBCache
 
-void CCDPMemCache::SetGlobalItem(const uint64_t globalStakedBcoins, const uint64_t globalOwedScoins) {
-    global_staked_bcoins = globalStakedBcoins;
-    global_owed_scoins   = globalOwedScoins;
+    if (!fForkV3 && erasedRatioKeys.count(std::make_pair(GetRatioKey(newCDP.collateral_ratio_base), newCDP.cdpid)))
+        return UpdateGlobalData(newCDP, true);
 
-    LogPrint("CDP", "CCDPMemCache::SetGlobalItem, global_staked_bcoins: %llu, global_owed_scoins: %llu\n",
-             global_staked_bcoins, global_owed_scoins);
-}
-
-// Need to delete the old cdp(before updating cdp), then save the new cdp if necessary.
-bool CCDPDBCache::UpdateCDP(const CUserCDP &oldCDP, const CUserCDP &newCDP) {
-    cdpMemCache.EraseCDP(oldCDP);
-    if (newCDP.IsFinished()) {
-        return EraseCDP(oldCDP, newCDP);
-    } else {
-        return SaveCDPToDB(newCDP) && cdpMemCache.SaveCDP(newCDP);
-    }
+    return SaveCDPToIndex(newCDP);
 }
 
 bool CCDPDBCache::NewCDP(const int32_t blockHeight, CUserCDP &cdp) {
-    assert(!cdpMemCache.HaveCDP(cdp));
-    return SaveCDPToDB(cdp) && cdpMemCache.SaveCDP(cdp);
+    assert(!cdpCache.HaveData(cdp.cdpid));
+    return SaveCDPToDB(cdp) && SaveCDPToIndex(cdp);
 }
 
 bool CCDPDBCache::GetCDPList(const CRegID &regId, vector<CUserCDP> &cdpList) {
@@ -187,7 +70,7 @@ bool CCDPDBCache::GetCDP(const uint256 cdpid, CUserCDP &cdp) {
 }
 
 bool CCDPDBCache::EraseCDP(const CUserCDP &oldCDP, const CUserCDP &cdp) {
-    return EraseCDPFromDB(cdp) && cdpMemCache.EraseCDP(oldCDP);
+    return EraseCDPFromDB(cdp) && EraseCDPFromIndex(oldCDP);
 }
 
 // Attention: update cdpCache and regId2CDPCache synchronously.
@@ -208,28 +91,151 @@ bool CCDPDBCache::EraseCDPFromDB(const CUserCDP &cdp) {
     return cdpCache.EraseData(cdp.cdpid) && regId2CDPCache.SetData(cdp.owner_regid.ToRawString(), cdpTxids);
 }
 
+bool CCDPDBCache::SaveCDPToIndex(const CUserCDP &cdp) {
+    return ratioCDPIdCache.SetData(std::make_pair(GetRatioKey(cdp.collateral_ratio_base), cdp.cdpid), 1) &&
+           UpdateGlobalData(cdp, true);
+}
+
+bool CCDPDBCache::EraseCDPFromIndex(const CUserCDP &cdp) {
+    auto key = std::make_pair(GetRatioKey(cdp.collateral_ratio_base), cdp.cdpid);
+    erasedRatioKeys.insert(key);
+    return ratioCDPIdCache.EraseData(key) && UpdateGlobalData(cdp, false);
+}
+
+bool CCDPDBCache::UpdateGlobalData(const CUserCDP &cdp, bool fAdd) {
+    std::pair<uint64_t, uint64_t> globalData(0, 0);
+    globalDataCache.GetData(globalData);
+    if (fAdd) {
+        globalData.first += cdp.total_staked_bcoins;
+        globalData.second += cdp.total_owed_scoins;
+    } else {
+        // may wrap around below the feature fork v3, as the amounts subtracted twice did
+        globalData.first -= cdp.total_staked_bcoins;
+        globalData.second -= cdp.total_owed_scoins;
+    }
+
+    // the sums back to zero are erased, like any empty value
+    return globalDataCache.SetData(globalData);
+}
+
+bool CCDPDBCache::RebuildRatioIndex() {
+    map<uint256, CUserCDP> cdps;
+    map<std::pair<string, uint256>, uint8_t> staleKeys;
+    if (!cdpCache.GetAllElements(cdps) || !ratioCDPIdCache.GetAllElements(staleKeys)) {
+        LogPrint("ERROR", "CCDPDBCache::RebuildRatioIndex, GetAllElements failed\n");
+        return false;
+    }
+
+    // only the missing and the stale entries are written
+    uint32_t addedCount = 0;
+    std::pair<uint64_t, uint64_t> globalData(0, 0);
+    for (const auto &item : cdps) {
+        auto key = std::make_pair(GetRatioKey(item.second.collateral_ratio_base), item.first);
+        if (staleKeys.erase(key) == 0) {
+            if (!ratioCDPIdCache.SetData(key, 1))
+                return false;
+            ++addedCount;
+        }
+        globalData.first += item.second.total_staked_bcoins;
+        globalData.second += item.second.total_owed_scoins;
+    }
+
+    for (const auto &item : staleKeys) {
+        if (!ratioCDPIdCache.EraseData(item.first))
+            return false;
+    }
+    erasedRatioKeys.clear();
+
+    std::pair<uint64_t, uint64_t> oldGlobalData(0, 0);
+    globalDataCache.GetData(oldGlobalData);
+    if (globalData != oldGlobalData && !globalDataCache.SetData(globalData))
+        return false;
+
+    LogPrint("INFO", "CCDPDBCache::RebuildRatioIndex, cdps: %llu, added: %u, stale: %llu, global_staked_bcoins: "
+             "%llu, global_owed_scoins: %llu\n", cdps.size(), addedCount, staleKeys.size(), globalData.first,
+             globalData.second);
+    return true;
+}
+
+bool CCDPDBCache::GetCdpListByCollateralRatio(const uint64_t collateralRatio, const uint64_t bcoinMedianPrice,
+                                              set<CUserCDP> &userCdps) {
+    double ratio = (double(collateralRatio) / RATIO_BOOST) / (double(bcoinMedianPrice) / PRICE_BOOST);
+    map<std::pair<string, uint256>, uint8_t> elements;
+    if (!ratioCDPIdCache.GetElementsUpTo(std::make_pair(GetRatioKey(ratio), MAX_CDPID), elements)) {
+        LogPrint("CDP", "CCDPDBCache::GetCdpListByCollateralRatio, GetElementsUpTo failed\n");
+        return false;
+    }
+
+    CUserCDP cdp;
+    for (const auto &item : elements) {
+        if (!cdpCache.GetData(item.first.second, cdp)) {
+            LogPrint("ERROR", "CCDPDBCache::GetCdpListByCollateralRatio, cdp %s indexed but not found\n",
+                     item.first.second.GetHex());
+            return false;
+        }
+
+        userCdps.insert(cdp);
+    }
+
+    return true;
+}
+
+uint64_t CCDPDBCache::GetGlobalCollateralRatio(const uint64_t bcoinMedianPrice) const {
+    uint64_t globalStakedBcoins = 0, globalOwedScoins = 0;
+    GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+
+    // If total owed scoins equal to zero, the global collateral ratio becomes infinite.
+    return (globalOwedScoins == 0) ? UINT64_MAX : uint64_t(double(globalStakedBcoins)
+        * bcoinMedianPrice / PRICE_BOOST / globalOwedScoins * RATIO_BOOST);
+}
+
+uint64_t CCDPDBCache::GetGlobalCollateral() const {
+    uint64_t globalStakedBcoins = 0, globalOwedScoins = 0;
+    GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+    return globalStakedBcoins;
+}
+
+void CCDPDBCache::GetGlobalItem(uint64_t &globalStakedBcoins, uint64_t &globalOwedScoins) const {
+    std::pair<uint64_t, uint64_t> globalData(0, 0);
+    globalDataCache.GetData(globalData);
+    globalStakedBcoins = globalData.first;
+    globalOwedScoins   = globalData.second;
+}
+
 // global collateral ratio floor check
 bool CCDPDBCache::CheckGlobalCollateralRatioFloorReached(const uint64_t bcoinMedianPrice,
                                                          const uint64_t globalCollateralRatioLimit) {
-    return cdpMemCache.GetGlobalCollateralRatio(bcoinMedianPrice) < globalCollateralRatioLimit;
+    return GetGlobalCollateralRatio(bcoinMedianPrice) < globalCollateralRatioLimit;
 }
 
 // global collateral amount ceiling check
 bool CCDPDBCache::CheckGlobalCollateralCeilingReached(const uint64_t newBcoinsToStake,
                                                       const uint64_t globalCollateralCeiling) {
     LogPrint("CDP", "CCDPDBCache::CheckGlobalCollateralCeilingReached, newBcoinsToStake: %llu, "
-             "cdpMemCache.GetGlobalCollateral(): %llu, globalCollateralCeiling: %llu\n",
-             newBcoinsToStake, cdpMemCache.GetGlobalCollateral(), globalCollateralCeiling * COIN);
+             "GetGlobalCollateral(): %llu, globalCollateralCeiling: %llu\n",
+             newBcoinsToStake, GetGlobalCollateral(), globalCollateralCeiling * COIN);
 
-    return (newBcoinsToStake + cdpMemCache.GetGlobalCollateral()) > globalCollateralCeiling * COIN;
+    return (newBcoinsToStake + GetGlobalCollateral()) > globalCollateralCeiling * COIN;
 }
 
 bool CCDPDBCache::Flush() {
     cdpCache.Flush();
     regId2CDPCache.Flush();
-    cdpMemCache.Flush();
+    ratioCDPIdCache.Flush();
+    globalDataCache.Flush();
+    erasedRatioKeys.clear();
 
     return true;
 }
 
-uint32_t CCDPDBCache::GetCacheSize() const { return cdpCache.GetCacheSize() + regId2CDPCache.GetCacheSize(); }
+void CCDPDBCache::Clear() {
+    cdpCache.Clear();
+    regId2CDPCache.Clear();
+    ratioCDPIdCache.Clear();
+    globalDataCache.Clear();
+    erasedRatioKeys.clear();
+}
+
+uint32_t CCDPDBCache::GetCacheSize() const {
+    return cdpCache.GetCacheSize() + regId2CDPCache.GetCacheSize() + ratioCDPIdCache.GetCacheSize();
+}
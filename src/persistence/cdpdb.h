@@ -17,59 +17,28 @@
 
 using namespace std;
 
-class CCDPMemCache {
-public:
-    CCDPMemCache() {}
-    CCDPMemCache(CCDPMemCache *pBaseIn) : pBase(pBaseIn) {
-        SetGlobalItem(pBaseIn->global_staked_bcoins, pBaseIn->global_owed_scoins);
-    }
-    // Only apply to construct the global mem-cache.
-    CCDPMemCache(CDBAccess *pAccessIn) : pAccess(pAccessIn) { LoadAllCDPFromDB(); }
-
-    void SetBase(CCDPMemCache *pBaseIn);
-    void Flush();
-
-    // Usage: before modification, erase the old cdp; after modification, save the new cdp.
-    bool SaveCDP(const CUserCDP &userCdp);
-    bool EraseCDP(const CUserCDP &userCdp);
-    bool HaveCDP(const CUserCDP &userCdp);
-
-    bool GetCdpListByCollateralRatio(const uint64_t collateralRatio, const uint64_t bcoinMedianPrice,
-                                     set<CUserCDP> &userCdps);
-
-    uint64_t GetGlobalCollateralRatio(const uint64_t bcoinMedianPrice) const;
-    uint64_t GetGlobalCollateral() const;
-    void GetGlobalItem(uint64_t &globalStakedBcoins, uint64_t &globalOwedScoins);
-
-private:
-    bool GetCDPList(const double ratio, set<CUserCDP> &expiredCdps, set<CUserCDP> &userCdps);
-    bool GetCDPList(const double ratio, set<CUserCDP> &userCdps);
-
-    void BatchWrite(const map<CUserCDP, uint8_t> &cdpsIn);
-    void SetGlobalItem(const uint64_t globalStakedBcoins, const uint64_t globalOwedScoins);
-    bool LoadAllCDPFromDB();
-
-private:
-    enum CDPState { CDP_EXPIRED = 0, CDP_VALID = 1 };
-
-private:
-    map<CUserCDP, uint8_t /* CDPState */> cdps;
-    uint64_t global_staked_bcoins = 0;
-    uint64_t global_owed_scoins   = 0;
-    CCDPMemCache *pBase           = nullptr;
-    CDBAccess *pAccess            = nullptr;
-};
-
+/**
+ * The cdps are indexed by the collateral ratio base (staked bcoins / owed scoins) in db, which keeps the order of
+ * the cdps under any price. The cdps to force liquidate are a range scan of the index up to the ratio base of the
+ * liquidation ratio at the current price, merged with the overlays of the cache layers, instead of a walk over all
+ * the cdps kept in memory. The global staked and owed amounts are kept in db as well, and undone with the block.
+ */
 class CCDPDBCache {
 public:
     CCDPDBCache() {}
-    CCDPDBCache(CDBAccess *pDbAccess) : cdpCache(pDbAccess), regId2CDPCache(pDbAccess), cdpMemCache(pDbAccess) {}
+    CCDPDBCache(CDBAccess *pDbAccess)
+        : cdpCache(pDbAccess), regId2CDPCache(pDbAccess), ratioCDPIdCache(pDbAccess), globalDataCache(pDbAccess) {
+        // rebuilt at every start, as the cdps loaded into memory were, dropping the bookkeeping before the fork v3
+        RebuildRatioIndex();
+        Flush();
+    }
     CCDPDBCache(CCDPDBCache *pBaseIn)
-        : cdpCache(pBaseIn->cdpCache), regId2CDPCache(pBaseIn->regId2CDPCache), cdpMemCache(pBaseIn->cdpMemCache) {}
+        : cdpCache(pBaseIn->cdpCache), regId2CDPCache(pBaseIn->regId2CDPCache),
+          ratioCDPIdCache(pBaseIn->ratioCDPIdCache), globalDataCache(pBaseIn->globalDataCache) {}
 
 
     bool NewCDP(const int32_t blockHeight, CUserCDP &cdp);
-    bool UpdateCDP(const CUserCDP &oldCDP, const CUserCDP &newCDP);
+    bool UpdateCDP(const int32_t blockHeight, const CUserCDP &oldCDP, const CUserCDP &newCDP);
 
     bool GetCDPList(const CRegID &regId, vector<CUserCDP> &cdpList);
 
@@ -80,27 +49,52 @@ public:
                                                 const uint64_t globalCollateralRatioLimit);
     bool CheckGlobalCollateralCeilingReached(const uint64_t newBcoinsToStake,
                                              const uint64_t globalCollateralCeiling);
+
+    /** The cdps at or below the collateral ratio at the price, in the ascending order of the ratio. */
+    bool GetCdpListByCollateralRatio(const uint64_t collateralRatio, const uint64_t bcoinMedianPrice,
+                                     set<CUserCDP> &userCdps);
+
+    /**
+     * Rebuild the ratio index and the global amounts from all the cdps, and drop the entries the cdps do not have.
+     * Done when the db is opened and with the last block before the feature fork v3, so the bookkeeping before the
+     * fork never outlives a restart or reaches the fork.
+     */
+    bool RebuildRatioIndex();
+
+    uint64_t GetGlobalCollateralRatio(const uint64_t bcoinMedianPrice) const;
+    uint64_t GetGlobalCollateral() const;
+    void GetGlobalItem(uint64_t &globalStakedBcoins, uint64_t &globalOwedScoins) const;
+
     bool Flush();
+    void Clear();
     uint32_t GetCacheSize() const;
 
     void SetBaseViewPtr(CCDPDBCache *pBaseIn) {
         cdpCache.SetBase(&pBaseIn->cdpCache);
         regId2CDPCache.SetBase(&pBaseIn->regId2CDPCache);
-        cdpMemCache.SetBase(&pBaseIn->cdpMemCache);
+        ratioCDPIdCache.SetBase(&pBaseIn->ratioCDPIdCache);
+        globalDataCache.SetBase(&pBaseIn->globalDataCache);
     }
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         cdpCache.SetDbOpLogMap(pDbOpLogMapIn);
+        ratioCDPIdCache.SetDbOpLogMap(pDbOpLogMapIn);
+        globalDataCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
     bool UndoDatas() {
-        return cdpCache.UndoDatas();
+        return cdpCache.UndoDatas() && ratioCDPIdCache.UndoDatas() && globalDataCache.UndoDatas();
     }
 
 private:
     bool SaveCDPToDB(const CUserCDP &cdp);
     bool EraseCDPFromDB(const CUserCDP &cdp);
 
+    // Add the cdp to the ratio index and the global amounts, or remove it with a negative sign.
+    bool SaveCDPToIndex(const CUserCDP &cdp);
+    bool EraseCDPFromIndex(const CUserCDP &cdp);
+    bool UpdateGlobalData(const CUserCDP &cdp, bool fAdd);
+
 private:
 /*  CCompositeKVCache     prefixType     key              value             variable  */
 /*  ----------------   --------------   ------------   --------------    -------------*/
@@ -108,9 +102,14 @@ private:
     CCompositeKVCache< dbk::CDP,         uint256,       CUserCDP >       cdpCache;
     // rcdp${CRegID} -> set<CTxID>
     CCompositeKVCache< dbk::REGID_CDP,   string,        set<uint256>>    regId2CDPCache;
-
-public:
-    CCDPMemCache cdpMemCache;  // Memory only cache
+    // crat{$RatioKey}{$cdpid} -> 1
+    CCompositeKVCache< dbk::CDP_RATIO,   std::pair<string, uint256>, uint8_t> ratioCDPIdCache;
+    // cgld -> {global staked bcoins, global owed scoins}
+    CSimpleKVCache< dbk::CDP_GLOBAL_DATA, std::pair<uint64_t, uint64_t>>     globalDataCache;
+
+    // the ratio index keys erased in this cache layer since the last flush, memory only, for UpdateCDP() below
+    // the feature fork v3
+    set<std::pair<string, uint256>> erasedRatioKeys;
 };
 
 #endif  // PERSIST_CDPDB_H
@@ -79,15 +79,25 @@ bool CContractDBCache::Flush() {
     txDiskPosCache.Flush();
     contractDataCache.Flush();
     contractAccountCache.Flush();
+    addressTxCache.Flush();
 
     return true;
 }
 
+void CContractDBCache::Clear() {
+    contractCache.Clear();
+    txDiskPosCache.Clear();
+    contractDataCache.Clear();
+    contractAccountCache.Clear();
+    addressTxCache.Clear();
+}
+
 uint32_t CContractDBCache::GetCacheSize() const {
     return contractCache.GetCacheSize() +
         txDiskPosCache.GetCacheSize() +
         contractDataCache.GetCacheSize() +
-        contractAccountCache.GetCacheSize();
+        contractAccountCache.GetCacheSize() +
+        addressTxCache.GetCacheSize();
 }
 
 bool CContractDBCache::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
@@ -109,6 +119,12 @@ bool CContractDBCache::WriteTxIndexes(const vector<pair<uint256, CDiskTxPos> > &
     return true;
 }
 
+bool CContractDBCache::SetTxHashByAddress(const CKeyID &keyId, uint32_t height, uint32_t index,
+                                          const uint256 &txid) {
+    auto key = std::make_tuple(keyId, dbk::CFixedUInt32(height), dbk::CFixedUInt32(index));
+    return addressTxCache.SetData(key, txid);
+}
+
 shared_ptr<CDBContractDatasGetter> CContractDBCache::CreateContractDatasGetter(
     const CRegID &contractRegid, const string &contractKeyPrefix, uint32_t count,
     const string &lastKey) {
@@ -121,4 +137,13 @@ shared_ptr<CDBContractDatasGetter> CContractDBCache::CreateContractDatasGetter(
     }
     auto prefix = make_pair(contractRegid.ToRawString(), CDBContractKey(contractKeyPrefix));
     return make_shared<CDBContractDatasGetter>(contractDataCache, prefix);
-}
\ No newline at end of file
+}
+
+shared_ptr<CDBAddressTxsGetter> CContractDBCache::CreateAddressTxsGetter(const CKeyID &keyId, uint32_t count,
+                                                                         uint32_t lastHeight, uint32_t lastIndex) {
+    assert(addressTxCache.GetBasePtr() == nullptr && "only support top level cache");
+    DBAddressTxCache::KeyType lastKey;
+    if (lastHeight != 0 || lastIndex != 0)
+        lastKey = std::make_tuple(keyId, dbk::CFixedUInt32(lastHeight), dbk::CFixedUInt32(lastIndex));
+    return make_shared<CDBAddressTxsGetter>(addressTxCache, keyId, count, lastKey);
+}
@@ -34,6 +34,8 @@ typedef dbk::CDBTailKey<MAX_CONTRACT_KEY_SIZE> CDBContractKey;
 /*  -------------------- --------------------         ----------------------------  ---------   --------------------- */
     // pair<contractRegId, contractKey> -> contractData
 typedef CCompositeKVCache< dbk::CONTRACT_DATA,        pair<string, CDBContractKey>, string>     DBContractDataCache;
+    // tuple<keyId, height, index> -> txid
+typedef CCompositeKVCache< dbk::KEYID_TXID,           tuple<CKeyID, dbk::CFixedUInt32, dbk::CFixedUInt32>, uint256> DBAddressTxCache;
 
 // prefix: pair<contractRegId, contractKey>, support to match part of cotractKey
 class CDBContractDatasGetter: public CDBListGetter<DBContractDataCache, pair<string, CDBContractKey>> {
@@ -50,6 +52,25 @@ public:
     }
 };
 
+// prefix: keyId, the txs of the address in the order of height and index
+class CDBAddressTxsGetter: public CDBListGetter<DBAddressTxCache, CKeyID> {
+public:
+    typedef CDBListGetter<DBAddressTxCache, CKeyID> ListGetter;
+    using ListGetter::ListGetter;
+public:
+    uint32_t GetHeight(const ListGetter::DataListItem &item) const {
+        return std::get<1>(item.first).GetValue();
+    }
+
+    uint32_t GetIndex(const ListGetter::DataListItem &item) const {
+        return std::get<2>(item.first).GetValue();
+    }
+
+    const uint256& GetTxid(const ListGetter::DataListItem &item) const {
+        return item.second;
+    }
+};
+
 class CContractDBCache {
 public:
     CContractDBCache() {}
@@ -58,7 +79,8 @@ public:
         contractCache(pDbAccess),
         txDiskPosCache(pDbAccess),
         contractDataCache(pDbAccess),
-        contractAccountCache(pDbAccess) {
+        contractAccountCache(pDbAccess),
+        addressTxCache(pDbAccess) {
         assert(pDbAccess->GetDbNameType() == DBNameType::CONTRACT);
     };
 
@@ -66,7 +88,8 @@ public:
         contractCache(pBaseIn->contractCache),
         txDiskPosCache(pBaseIn->txDiskPosCache),
         contractDataCache(pBaseIn->contractDataCache),
-        contractAccountCache(pBaseIn->contractAccountCache) {};
+        contractAccountCache(pBaseIn->contractAccountCache),
+        addressTxCache(pBaseIn->addressTxCache) {};
 
     bool GetContractAccount(const CRegID &contractRegId, const string &accountKey, CAppUserAccount &appAccOut);
     bool SetContractAccount(const CRegID &contractRegId, const CAppUserAccount &appAccIn);
@@ -83,13 +106,13 @@ public:
     bool EraseContractData(const CRegID &contractRegId, const string &contractKey);
 
     bool Flush();
+    void Clear();
     uint32_t GetCacheSize() const;
 
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool SetTxIndex(const uint256 &txid, const CDiskTxPos &pos);
     bool WriteTxIndexes(const vector<pair<uint256, CDiskTxPos> > &list);
 
-    bool GetTxHashByAddress(const CKeyID &keyId, uint32_t height, map<string, string > &mapTxHash);
     bool SetTxHashByAddress(const CKeyID &keyId, uint32_t height, uint32_t index, const uint256 &txid);
 
     void SetBaseViewPtr(CContractDBCache *pBaseIn) {
@@ -97,6 +120,7 @@ public:
         txDiskPosCache.SetBase(&pBaseIn->txDiskPosCache);
         contractDataCache.SetBase(&pBaseIn->contractDataCache);
         contractAccountCache.SetBase(&pBaseIn->contractAccountCache);
+        addressTxCache.SetBase(&pBaseIn->addressTxCache);
     };
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
@@ -104,17 +128,22 @@ public:
         txDiskPosCache.SetDbOpLogMap(pDbOpLogMapIn);
         contractDataCache.SetDbOpLogMap(pDbOpLogMapIn);
         contractAccountCache.SetDbOpLogMap(pDbOpLogMapIn);
+        addressTxCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
     bool UndoDatas() {
         return contractCache.UndoDatas() &&
                txDiskPosCache.UndoDatas() &&
                contractDataCache.UndoDatas() &&
-               contractAccountCache.UndoDatas();
+               contractAccountCache.UndoDatas() &&
+               addressTxCache.UndoDatas();
     }
 
     shared_ptr<CDBContractDatasGetter> CreateContractDatasGetter(const CRegID &contractRegid,
         const string &contractKeyPrefix, uint32_t count, const string &lastKey);
+
+    shared_ptr<CDBAddressTxsGetter> CreateAddressTxsGetter(const CKeyID &keyId, uint32_t count,
+        uint32_t lastHeight, uint32_t lastIndex);
 private:
 /*       type               prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
@@ -127,6 +156,8 @@ private:
     DBContractDataCache contractDataCache;
     // pair<contractRegId, accountKey> -> appUserAccount
     CCompositeKVCache< dbk::CONTRACT_ACCOUNT,     pair<string, string>,     CAppUserAccount >      contractAccountCache;
+    // tuple<keyId, height, index> -> txid
+    DBAddressTxCache addressTxCache;
 };
 
 #endif  // PERSIST_CONTRACTDB_H
\ No newline at end of file
@@ -7,9 +7,14 @@
 #define PERSIST_DB_ACCESS_H
 
 #include "commons/uint256.h"
+#include "config/const.h"
 #include "dbconf.h"
 #include "leveldbwrapper.h"
 
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -151,8 +156,8 @@ public:
     int64_t GetDbCount() const { return db.GetDbCount(); }
     template<typename KeyType, typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
-        string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Read(keyStr, value);
+        dbk::CDBKeyBuffer keyBuf(prefixType, key);
+        return db.Read(keyBuf.GetSlice(), value);
     }
 
     template<typename ValueType>
@@ -336,15 +341,63 @@ public:
         return true;
     }
 
+    /** The elements with the key not greater than lastKey, the keys must sort in db as the KeyType does. */
+    template <typename KeyType, typename ValueType>
+    bool GetElementsUpTo(const dbk::PrefixType prefixType, const KeyType &lastKey, set<KeyType> &expiredKeys,
+                         map<KeyType, ValueType> &elements) {
+        KeyType key;
+        ValueType value;
+        shared_ptr<leveldb::Iterator> pCursor = NewIterator();
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        const string &prefix = dbk::GetKeyPrefix(prefixType);
+        ssKey.write(prefix.c_str(), prefix.size());
+        pCursor->Seek(ssKey.str());
+
+        for (; pCursor->Valid(); pCursor->Next()) {
+            leveldb::Slice slKey = pCursor->key();
+            if (!dbk::ParseDbKey(slKey, prefixType, key) || lastKey < key) {
+                break;
+            }
+
+            if (expiredKeys.count(key) || elements.count(key)) {
+                // skip it if the element existed in memory cache(upper level cache)
+                continue;
+            } else {
+                leveldb::Slice slValue = pCursor->value();
+                CDataStream ds(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+                ds >> value;
+                auto ret = elements.emplace(key, value);
+                if (!ret.second) throw runtime_error("alloc new cache item failed");
+            }
+        }
+
+        return true;
+    }
+
     template<typename KeyType, typename ValueType>
     bool HaveData(const dbk::PrefixType prefixType, const KeyType &key) const {
-        string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Exists(keyStr);
+        dbk::CDBKeyBuffer keyBuf(prefixType, key);
+        return db.Exists(keyBuf.GetSlice());
+    }
+
+    template<typename KeyType, typename ValueType>
+    void BatchWrite(const dbk::PrefixType prefixType, const map<KeyType, ValueType> &mapData) {
+        CLevelDBBatch batch;
+        AddToBatch(batch, prefixType, mapData);
+        db.WriteBatch(batch, true);
+    }
+
+    template<typename ValueType>
+    void BatchWrite(const dbk::PrefixType prefixType, ValueType &value) {
+        CLevelDBBatch batch;
+        AddValueToBatch(batch, prefixType, value);
+        db.WriteBatch(batch, true);
     }
 
     template<typename KeyType, typename ValueType>
-    void BatchWrite(const dbk::PrefixType prefixType, const map<KeyType, ValueType> &mapData) {        CLevelDBBatch batch;
-        for (auto item : mapData) {
+    static void AddToBatch(CLevelDBBatch &batch, const dbk::PrefixType prefixType,
+                           const map<KeyType, ValueType> &mapData) {
+        for (const auto &item : mapData) {
             string key = dbk::GenDbKey(prefixType, item.first);
             if (db_util::IsEmpty(item.second)) {
                 batch.Erase(key);
@@ -352,12 +405,10 @@ public:
                 batch.Write(key, item.second);
             }
         }
-        db.WriteBatch(batch, true);
     }
 
     template<typename ValueType>
-    void BatchWrite(const dbk::PrefixType prefixType, ValueType &value) {
-        CLevelDBBatch batch;
+    static void AddValueToBatch(CLevelDBBatch &batch, const dbk::PrefixType prefixType, const ValueType &value) {
         const string prefix = dbk::GetKeyPrefix(prefixType);
 
         if (db_util::IsEmpty(value)) {
@@ -365,9 +416,39 @@ public:
         } else {
             batch.Write(prefix, value);
         }
-        db.WriteBatch(batch, true);
     }
 
+    typedef std::function<void(CLevelDBBatch &batch)> BatchWriter;
+
+    /**
+     * While staging, the caches flushed into this db hand their data over as a writer instead of writing
+     * it, and keep it readable as a frozen layer. The staged writers are written by CDBFlusher.
+     */
+    bool IsStaging() const { return fStaging; }
+    void SetStaging(bool fStagingIn) { fStaging = fStagingIn; }
+    void StageWrite(BatchWriter writer) { stagedWriters.push_back(std::move(writer)); }
+    vector<BatchWriter> TakeStagedWrites() {
+        std::unique_lock<std::mutex> lock(writeMtx);
+        vector<BatchWriter> writers;
+        writers.swap(stagedWriters);
+        fWriting = !writers.empty();
+        return writers;
+    }
+    void EndStagedWrites() {
+        {
+            std::unique_lock<std::mutex> lock(writeMtx);
+            fWriting = false;
+        }
+        condWritten.notify_all();
+    }
+    /** The db iterators don't see the frozen layers, the list getters wait for the staged data to be written. */
+    void WaitForStagedWrites() {
+        std::unique_lock<std::mutex> lock(writeMtx);
+        condWritten.wait(lock, [this]() { return !fWriting; });
+    }
+
+    bool WriteBatch(CLevelDBBatch &batch, bool fSync) { return db.WriteBatch(batch, fSync); }
+
     DBNameType GetDbNameType() const { return dbNameType; }
 
     std::shared_ptr<leveldb::Iterator> NewIterator() {
@@ -376,6 +457,11 @@ public:
 private:
     DBNameType dbNameType;
     mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
+    bool fStaging = false;
+    vector<BatchWriter> stagedWriters;
+    std::mutex writeMtx;
+    std::condition_variable condWritten;
+    bool fWriting = false;  // the staged writers are being written
 };
 
 template<int PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType>
@@ -405,9 +491,12 @@ public:
         assert(pDbAccess->GetDbNameType() == GetDbNameEnumByPrefix(PREFIX_TYPE));
     };
 
+    /**
+     * The data of the layer is kept, so a layer holding data may only be moved to a base at the same state for the
+     * keys it read through, e.g. a layer inserted below it by undoing the changes made to the old base since.
+     */
     void SetBase(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBaseIn) {
         assert(pDbAccess == nullptr);
-        assert(mapData.empty());
         pBase = pBaseIn;
     };
 
@@ -415,8 +504,9 @@ public:
         pDbOpLogMap = pDbOpLogMapIn;
     }
 
+    // the serialized size of the data of this layer, with the node overhead of the map
     uint32_t GetCacheSize() const {
-        return ::GetSerializeSize(mapData, SER_DISK, CLIENT_VERSION);
+        return ::GetSerializeSize(mapData, SER_DISK, CLIENT_VERSION) + mapData.size() * CACHE_NODE_OVERHEAD;
     }
 
     bool GetTopNElements(const uint32_t maxNum, set<KeyType> &keys) {
@@ -472,6 +562,16 @@ public:
         return true;
     }
 
+    /**
+     * Get the elements with the key not greater than lastKey, for the keys ordered by a value, e.g. a ratio. Every
+     * layer is only walked up to the bound, so the cost follows the size of the range, not of the whole set.
+     * The keys must sort in db as the KeyType does.
+     */
+    bool GetElementsUpTo(const KeyType &lastKey, map<KeyType, ValueType> &elements) {
+        set<KeyType> expiredKeys;
+        return GetElementsUpTo(lastKey, expiredKeys, elements);
+    }
+
     bool GetData(const KeyType &key, ValueType &value) const {
         if (db_util::IsEmpty(key)) {
             return false;
@@ -584,7 +684,22 @@ public:
             }
         } else if (pDbAccess != nullptr) {
             assert(pBase == nullptr);
-            pDbAccess->BatchWrite<KeyType, ValueType>(PREFIX_TYPE, mapData);
+            if (!missingKeys.empty()) {
+                for (const auto &item : mapData)
+                    missingKeys.erase(item.first);
+            }
+            if (pDbAccess->IsStaging() && !mapData.empty()) {
+                // the staged data stays readable as the frozen layer until the next flush
+                auto pFrozen = std::make_shared<const Map>(std::move(mapData));
+                pFrozenData  = pFrozen;
+                pDbAccess->StageWrite([pFrozen](CLevelDBBatch &batch) {
+                    CDBAccess::AddToBatch(batch, PREFIX_TYPE, *pFrozen);
+                });
+            } else {
+                if (!pDbAccess->IsStaging())
+                    pDbAccess->BatchWrite<KeyType, ValueType>(PREFIX_TYPE, mapData);
+                pFrozenData = nullptr;
+            }
         }
 
         Clear();
@@ -631,152 +746,217 @@ public:
 
     map<KeyType, ValueType>& GetMapData() { return mapData; };
 private:
+    /**
+     * Find the key in this layer, then walk down the base layers. The found key-value is only added to this
+     * layer, and to the bottom layer if read from db, the layers in between are not touched. The keys missing
+     * in db are remembered by the bottom layer until written, so that the misses don't hit db repeatedly.
+     * The frozen data being written by the flusher is read after the bottom layer and before db.
+     */
     Iterator GetDataIt(const KeyType &key) const {
         Iterator it = mapData.find(key);
-        if (it != mapData.end()) {
+        if (it != mapData.end())
             return it;
-        } else if (pBase != nullptr){
-            // find key-value at base cache
-            auto baseIt = pBase->GetDataIt(key);
-            if (baseIt != pBase->mapData.end()) {
-                // the found key-value add to current mapData
-                auto newRet = mapData.emplace(key, baseIt->second);
-                if (!newRet.second) throw runtime_error("alloc new cache item failed");
-                return newRet.first;
-            }
-        } else if (pDbAccess != NULL) {
-            // TODO: need to save the empty value to mapData for search performance?
-            auto pDbValue = db_util::MakeEmptyValue<ValueType>();
-            if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
-                auto newRet = mapData.emplace(key, *pDbValue);
-                if (!newRet.second) throw runtime_error("alloc new cache item failed");
-                return newRet.first;
-            }
+
+        const CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pCache = this;
+        while (pCache->pBase != nullptr) {
+            pCache = pCache->pBase;
+            auto baseIt = pCache->mapData.find(key);
+            if (baseIt != pCache->mapData.end())
+                return AddData(key, baseIt->second);
         }
 
-        return mapData.end();
+        if (pCache->pFrozenData) {
+            auto frozenIt = pCache->pFrozenData->find(key);
+            if (frozenIt != pCache->pFrozenData->end())
+                return AddData(key, frozenIt->second);
+        }
+
+        if (pCache->pDbAccess == nullptr || pCache->missingKeys.count(key))
+            return mapData.end();
+
+        auto pDbValue = db_util::MakeEmptyValue<ValueType>();
+        if (!pCache->pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
+            if (pCache->missingKeys.size() >= MAX_MISSING_KEYS)
+                pCache->missingKeys.clear();
+            pCache->missingKeys.insert(key);
+            return mapData.end();
+        }
+
+        if (pCache != this)
+            pCache->AddData(key, *pDbValue);
+        return AddData(key, *pDbValue);
+    }
+
+    Iterator AddData(const KeyType &key, const ValueType &value) const {
+        auto newRet = mapData.emplace(key, value);
+        if (!newRet.second) throw runtime_error("alloc new cache item failed");
+        return newRet.first;
     }
 
     bool GetTopNElements(const uint32_t maxNum, set<KeyType> &expiredKeys, set<KeyType> &keys) {
-        if (!mapData.empty()) {
-            uint32_t count = 0;
-            auto iter      = mapData.begin();
-
-            for (; (count < maxNum) && iter != mapData.end(); ++iter) {
-                if (db_util::IsEmpty(iter->second)) {
-                    expiredKeys.insert(iter->first);
-                } else if (expiredKeys.count(iter->first) || keys.count(iter->first)) {
-                    // TODO: log
-                    continue;
-                } else {
-                    // Got a valid element.
-                    keys.insert(iter->first);
+        GetTopNElements(mapData, maxNum, expiredKeys, keys);
 
-                    ++count;
-                }
+        if (pBase != nullptr) {
+            return pBase->GetTopNElements(maxNum, expiredKeys, keys);
+        } else if (pDbAccess != nullptr) {
+            if (pFrozenData)
+                GetTopNElements(*pFrozenData, maxNum, expiredKeys, keys);
+            return pDbAccess->GetTopNElements(maxNum, PREFIX_TYPE, expiredKeys, keys);
+        }
+
+        return true;
+    }
+
+    static void GetTopNElements(const Map &data, const uint32_t maxNum, set<KeyType> &expiredKeys,
+                                set<KeyType> &keys) {
+        uint32_t count = 0;
+        auto iter      = data.begin();
+
+        for (; (count < maxNum) && iter != data.end(); ++iter) {
+            if (db_util::IsEmpty(iter->second)) {
+                expiredKeys.insert(iter->first);
+            } else if (expiredKeys.count(iter->first) || keys.count(iter->first)) {
+                // TODO: log
+                continue;
+            } else {
+                // Got a valid element.
+                keys.insert(iter->first);
+
+                ++count;
             }
         }
+    }
+
+    bool GetElementsUpTo(const KeyType &lastKey, set<KeyType> &expiredKeys, map<KeyType, ValueType> &elements) {
+        GetElementsUpTo(mapData, lastKey, expiredKeys, elements);
 
         if (pBase != nullptr) {
-            return pBase->GetTopNElements(maxNum, expiredKeys, keys);
+            return pBase->GetElementsUpTo(lastKey, expiredKeys, elements);
         } else if (pDbAccess != nullptr) {
-            return pDbAccess->GetTopNElements(maxNum, PREFIX_TYPE, expiredKeys, keys);
+            if (pFrozenData)
+                GetElementsUpTo(*pFrozenData, lastKey, expiredKeys, elements);
+            return pDbAccess->GetElementsUpTo(PREFIX_TYPE, lastKey, expiredKeys, elements);
         }
 
         return true;
     }
 
-    // map<string, ValueType>
-    bool GetAllElements(const string &prefix, set<string> &expiredKeys, map<string, ValueType> &elements) {
-        if (!mapData.empty()) {
-            auto boundary    = mapData.upper_bound(prefix);
-            size_t prefixLen = prefix.size();
-
-            if (boundary != mapData.end()) {
-                for (auto iter = boundary; iter != mapData.end(); ++ iter) {
-                    if (db_util::IsEmpty(iter->second)) {
-                        expiredKeys.insert(iter->first);
-                    } else if (expiredKeys.count(iter->first) || elements.count(iter->first)) {
-                        // TODO: log
-                        continue;
-                    } else if (iter->first.substr(0, prefixLen) != prefix) {
-                        // break the loop if prefix does not match.
-                        break;
-                    } else {
-                        // Got a valid element.
-                        elements.emplace(iter->first, iter->second);
-                    }
-                }
+    static void GetElementsUpTo(const Map &data, const KeyType &lastKey, set<KeyType> &expiredKeys,
+                                map<KeyType, ValueType> &elements) {
+        for (auto iter = data.begin(); iter != data.end() && !(lastKey < iter->first); ++iter) {
+            if (db_util::IsEmpty(iter->second)) {
+                expiredKeys.insert(iter->first);
+            } else if (expiredKeys.count(iter->first) || elements.count(iter->first)) {
+                continue;
+            } else {
+                // Got a valid element.
+                elements.emplace(iter->first, iter->second);
             }
         }
+    }
+
+    // map<string, ValueType>
+    bool GetAllElements(const string &prefix, set<string> &expiredKeys, map<string, ValueType> &elements) {
+        GetAllElements(mapData, prefix, expiredKeys, elements);
 
         if (pBase != nullptr) {
             return pBase->GetAllElements(prefix, expiredKeys, elements);
         } else if (pDbAccess != nullptr) {
+            if (pFrozenData)
+                GetAllElements(*pFrozenData, prefix, expiredKeys, elements);
             return pDbAccess->GetAllElements(PREFIX_TYPE, prefix, expiredKeys, elements);
         }
 
         return true;
     }
 
+    static void GetAllElements(const map<string, ValueType> &data, const string &prefix, set<string> &expiredKeys,
+                               map<string, ValueType> &elements) {
+        auto boundary    = data.upper_bound(prefix);
+        size_t prefixLen = prefix.size();
+
+        for (auto iter = boundary; iter != data.end(); ++ iter) {
+            if (db_util::IsEmpty(iter->second)) {
+                expiredKeys.insert(iter->first);
+            } else if (expiredKeys.count(iter->first) || elements.count(iter->first)) {
+                // TODO: log
+                continue;
+            } else if (iter->first.substr(0, prefixLen) != prefix) {
+                // break the loop if prefix does not match.
+                break;
+            } else {
+                // Got a valid element.
+                elements.emplace(iter->first, iter->second);
+            }
+        }
+    }
+
     // map<std::pair<string, string>, ValueType>
     bool GetAllElements(const string &prefix, set<std::pair<string, string>> &expiredKeys,
                         map<std::pair<string, string>, ValueType> &elements) {
-        if (!mapData.empty()) {
-            // Tips: the final prefix is consist of std::pair<prefix, string()>.
-            auto boundary = mapData.upper_bound(std::make_pair(prefix, string("")));
-
-            if (boundary != mapData.end()) {
-                for (auto iter = boundary; iter != mapData.end(); ++ iter) {
-                    if (db_util::IsEmpty(iter->second)) {
-                        expiredKeys.insert(iter->first);
-                    } else if (expiredKeys.count(iter->first) || elements.count(iter->first)) {
-                        // TODO: log
-                        continue;
-                    } else if (std::get<0>(iter->first) != prefix) {
-                        // break the loop if prefix does not match.
-                        break;
-                    } else {
-                        // Got a valid element.
-                        elements.emplace(iter->first, iter->second);
-                    }
-                }
-            }
-        }
+        GetAllElements(mapData, prefix, expiredKeys, elements);
 
         if (pBase != nullptr) {
             return pBase->GetAllElements(prefix, expiredKeys, elements);
         } else if (pDbAccess != nullptr) {
+            if (pFrozenData)
+                GetAllElements(*pFrozenData, prefix, expiredKeys, elements);
             return pDbAccess->GetAllElements(PREFIX_TYPE, prefix, expiredKeys, elements);
         }
 
         return true;
     }
 
-    bool GetAllElements(set<KeyType> &expiredKeys, map<KeyType, ValueType> &elements) {
-        if (!mapData.empty()) {
-            for (auto iter : mapData) {
-                if (db_util::IsEmpty(iter.second)) {
-                    expiredKeys.insert(iter.first);
-                } else if (expiredKeys.count(iter.first) || elements.count(iter.first)) {
-                    // TODO: log
-                    continue;
-                } else {
-                    // Got a valid element.
-                    elements.insert(iter);
-                }
+    static void GetAllElements(const map<std::pair<string, string>, ValueType> &data, const string &prefix,
+                               set<std::pair<string, string>> &expiredKeys,
+                               map<std::pair<string, string>, ValueType> &elements) {
+        // Tips: the final prefix is consist of std::pair<prefix, string()>.
+        auto boundary = data.upper_bound(std::make_pair(prefix, string("")));
+
+        for (auto iter = boundary; iter != data.end(); ++ iter) {
+            if (db_util::IsEmpty(iter->second)) {
+                expiredKeys.insert(iter->first);
+            } else if (expiredKeys.count(iter->first) || elements.count(iter->first)) {
+                // TODO: log
+                continue;
+            } else if (std::get<0>(iter->first) != prefix) {
+                // break the loop if prefix does not match.
+                break;
+            } else {
+                // Got a valid element.
+                elements.emplace(iter->first, iter->second);
             }
         }
+    }
+
+    bool GetAllElements(set<KeyType> &expiredKeys, map<KeyType, ValueType> &elements) {
+        GetAllElements(mapData, expiredKeys, elements);
 
         if (pBase != nullptr) {
             return pBase->GetAllElements(expiredKeys, elements);
         } else if (pDbAccess != nullptr) {
+            if (pFrozenData)
+                GetAllElements(*pFrozenData, expiredKeys, elements);
             return pDbAccess->GetAllElements(PREFIX_TYPE, expiredKeys, elements);
         }
 
         return true;
     }
 
+    static void GetAllElements(const Map &data, set<KeyType> &expiredKeys, map<KeyType, ValueType> &elements) {
+        for (const auto &item : data) {
+            if (db_util::IsEmpty(item.second)) {
+                expiredKeys.insert(item.first);
+            } else if (expiredKeys.count(item.first) || elements.count(item.first)) {
+                // TODO: log
+                continue;
+            } else {
+                // Got a valid element.
+                elements.insert(item);
+            }
+        }
+    }
+
     inline void AddOpLog(const KeyType &key, const ValueType &oldValue) {
         if (pDbOpLogMap != nullptr) {
             CDbOpLog dbOpLog;
@@ -789,7 +969,11 @@ private:
     mutable CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBase;
     CDBAccess *pDbAccess;
     mutable map<KeyType, ValueType> mapData;
+    mutable set<KeyType> missingKeys;  // keys missing in db, only kept by the bottom layer
+    std::shared_ptr<const Map> pFrozenData;  // data being written by the flusher, only kept by the bottom layer
     CDBOpLogMap *pDbOpLogMap = nullptr;
+
+    static const uint32_t MAX_MISSING_KEYS = 100000;
 };
 
 
@@ -813,9 +997,9 @@ public:
         assert(pDbAccessIn != nullptr);
     }
 
+    // the data of the layer is kept, see CCompositeKVCache::SetBase()
     void SetBase(CSimpleKVCache<PREFIX_TYPE, ValueType> *pBaseIn) {
         assert(pDbAccess == nullptr);
-        assert(!ptrData);
         pBase = pBaseIn;
     }
 
@@ -824,7 +1008,7 @@ public:
     }
 
     uint32_t GetCacheSize() const {
-        return ::GetSerializeSize(*ptrData, SER_DISK, CLIENT_VERSION);
+        return ptrData ? ::GetSerializeSize(*ptrData, SER_DISK, CLIENT_VERSION) : 0;
     }
 
     bool GetData(ValueType &value) const {
@@ -919,8 +1103,20 @@ public:
                 pBase->ptrData = ptrData;
             } else if (pDbAccess != nullptr) {
                 assert(pBase == nullptr);
-                pDbAccess->BatchWrite(PREFIX_TYPE, *ptrData);
+                if (pDbAccess->IsStaging()) {
+                    // the staged data stays readable as the frozen layer until the next flush
+                    std::shared_ptr<const ValueType> pFrozen = ptrData;
+                    pFrozenData = pFrozen;
+                    pDbAccess->StageWrite([pFrozen](CLevelDBBatch &batch) {
+                        CDBAccess::AddValueToBatch(batch, PREFIX_TYPE, *pFrozen);
+                    });
+                } else {
+                    pDbAccess->BatchWrite(PREFIX_TYPE, *ptrData);
+                    pFrozenData = nullptr;
+                }
             }
+        } else if (pDbAccess != nullptr && !pDbAccess->IsStaging()) {
+            pFrozenData = nullptr;
         }
 
         Clear();
@@ -958,11 +1154,20 @@ private:
         } else if (pBase != nullptr){
             auto ptr = pBase->GetDataPtr();
             if (ptr) {
-                assert(!db_util::IsEmpty(*ptr));
+                // erased in the base, e.g. a sum back to zero
+                if (db_util::IsEmpty(*ptr))
+                    return nullptr;
                 ptrData = std::make_shared<ValueType>(*ptr);
                 return ptrData;
             }
         } else if (pDbAccess != NULL) {
+            if (pFrozenData) {
+                if (db_util::IsEmpty(*pFrozenData))
+                    return nullptr;
+                ptrData = std::make_shared<ValueType>(*pFrozenData);
+                return ptrData;
+            }
+
             auto ptrDbData = std::make_shared<ValueType>();
 
             if (pDbAccess->GetData(PREFIX_TYPE, *ptrDbData)) {
@@ -986,6 +1191,7 @@ private:
     mutable CSimpleKVCache<PREFIX_TYPE, ValueType> *pBase;
     CDBAccess *pDbAccess;
     mutable std::shared_ptr<ValueType> ptrData;
+    std::shared_ptr<const ValueType> pFrozenData;  // data being written by the flusher, only kept by the bottom layer
     CDBOpLogMap *pDbOpLogMap = nullptr;
 };
 
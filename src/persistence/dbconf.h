@@ -7,6 +7,7 @@
 #define PERSIST_DBCONF_H
 
 #include <leveldb/slice.h>
+#include <cstring>
 #include <string>
 
 #include "config/version.h"
@@ -80,6 +81,7 @@ namespace dbk {
         DEFINE( CONTRACT_DATA,        "cdat",  CONTRACT )      /* cdat{$RegId}{$DataKey} --> $Data */ \
         DEFINE( CONTRACT_ITEM_NUM,    "citn",  CONTRACT )      /* citn{$ContractRegId} --> $total_num_of_contract_i */ \
         DEFINE( CONTRACT_ACCOUNT,     "cacc",  CONTRACT )      /* cacc{$ContractRegId}{$AccUserId} --> appUserAccount */ \
+        DEFINE( KEYID_TXID,           "ktxd",  CONTRACT )      /* ktxd{$KeyId}{$Height}{$Index} --> $txid */ \
         /**** delegate db                                                                     */ \
         DEFINE( VOTE,                 "vote",  DELEGATE )      /* "vote{(uint64t)MAX - $votedBcoins}{$RegId} --> 1 */ \
         DEFINE( REGID_VOTE,           "ridv",  DELEGATE )      /* "ridv --> $votes" */ \
@@ -90,9 +92,13 @@ namespace dbk {
         DEFINE( CDP_GLOBAL_HALT,      "cdph",  CDP )           /* cdph -> 0 | 1 */ \
         DEFINE( CDP_IR_PARAM_A,       "ira",   CDP )           /* [prefix] --> param_a */ \
         DEFINE( CDP_IR_PARAM_B,       "irb",   CDP )           /* [prefix] --> param_b */ \
+        DEFINE( CDP_RATIO,            "crat",  CDP )           /* crat{$RatioKey}{$cdpid} --> 1, RatioKey: bits of staked/owed */ \
+        DEFINE( CDP_GLOBAL_DATA,      "cgld",  CDP )           /* [prefix] --> {global staked bcoins, global owed scoins} */ \
         /**** dex db                                                                    */ \
         DEFINE( DEX_ACTIVE_ORDER,     "dato",  DEX )           /* [prefix]{txid} --> active order */ \
         DEFINE( DEX_BLOCK_ORDERS,      "dbos",  DEX )           /* [prefix]{height, generate_type, txid} --> active order */ \
+        DEFINE( DEX_ORDER_BOOK,       "dobk",  DEX )           /* [prefix]{book, order_key, txid} --> active order, book: coin/asset/side, order_key: price, height, index */ \
+        DEFINE( DEX_ORDER_BOOK_CHANGE,"dobc",  DEX )           /* [prefix]{height, txid} --> order book change */ \
         /**** log db                                                                   */ \
         DEFINE( TX_EXECUTE_FAIL,      "txef",  LOG )           /* [prefix]{height}{txid} --> {error code, error message} */ \
         /**** tx receipt db                                                                   */ \
@@ -150,6 +156,56 @@ namespace dbk {
         return std::string(ssKeyTemp.begin(), ssKeyTemp.end());
     }
 
+    /**
+     * The db key built in a stack buffer for lookups, without the CDataStream and string allocations of
+     * GenDbKey(). The key bytes are identical to GenDbKey(), keys longer than the buffer spill to the heap.
+     * Only the building of the keys changed: the prefixes and the encoding of the keys on disk are the same,
+     * so the dbs need no migration (see dbkey_bench for the size of a shorter prefix).
+     */
+    class CDBKeyBuffer {
+    public:
+        enum { STACK_SIZE = 128 };
+
+        template<typename KeyElement>
+        CDBKeyBuffer(PrefixType keyPrefixType, const KeyElement &keyElement) : size(0) {
+            assert(keyPrefixType != EMPTY);
+            const string &prefix = GetKeyPrefix(keyPrefixType);
+            write(prefix.data(), prefix.size());
+            ::Serialize(*this, keyElement, SER_DISK, CLIENT_VERSION);
+        }
+
+        CDBKeyBuffer(const CDBKeyBuffer &) = delete;
+        CDBKeyBuffer &operator=(const CDBKeyBuffer &) = delete;
+
+        CDBKeyBuffer &write(const char *pch, size_t len) {
+            if (heapKey.empty() && size + len <= STACK_SIZE) {
+                memcpy(stackKey + size, pch, len);
+            } else {
+                if (heapKey.empty())
+                    heapKey.assign(stackKey, size);
+                heapKey.append(pch, len);
+            }
+            size += len;
+            return *this;
+        }
+
+        template<typename T>
+        CDBKeyBuffer &operator<<(const T &obj) {
+            ::Serialize(*this, obj, SER_DISK, CLIENT_VERSION);
+            return *this;
+        }
+
+        int GetType() const { return SER_DISK; }
+        int GetVersion() const { return CLIENT_VERSION; }
+
+        Slice GetSlice() const { return heapKey.empty() ? Slice(stackKey, size) : Slice(heapKey); }
+
+    private:
+        char stackKey[STACK_SIZE];
+        size_t size;
+        string heapKey;
+    };
+
     template<typename KeyElement>
     bool ParseDbKey(const Slice& slice, PrefixType keyPrefixType, KeyElement &keyElement) {
         assert(slice.size() > 0);
@@ -193,7 +249,8 @@ namespace dbk {
             return key.size();
         }
 
-        void Serialize(CDataStream &s, int nType, int nVersion) const {
+        template<typename Stream>
+        void Serialize(Stream &s, int nType, int nVersion) const {
             s.write(key.data(), key.size());
         }
 
@@ -218,6 +275,51 @@ namespace dbk {
         void SetEmpty() { key.clear(); }
 
     };
+
+    // CFixedUInt32
+    // serialized as 4 big-endian bytes, so that the db keys are sorted by the value
+    class CFixedUInt32 {
+    private:
+        uint32_t value;
+    public:
+        CFixedUInt32(): value(0) {}
+        CFixedUInt32(uint32_t valueIn): value(valueIn) {}
+
+        uint32_t GetValue() const { return value; }
+
+        inline uint32_t GetSerializeSize(int32_t nType, int32_t nVersion) const {
+            return sizeof(value);
+        }
+
+        template<typename Stream>
+        void Serialize(Stream &s, int nType, int nVersion) const {
+            char buf[sizeof(value)];
+            buf[0] = (char)(value >> 24);
+            buf[1] = (char)(value >> 16);
+            buf[2] = (char)(value >> 8);
+            buf[3] = (char)value;
+            s.write(buf, sizeof(buf));
+        }
+
+        template<typename Stream>
+        void Unserialize(Stream &s, int nType, int nVersion) {
+            unsigned char buf[sizeof(value)];
+            s.read((char *)buf, sizeof(buf));
+            value = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+        }
+
+        bool operator==(const CFixedUInt32 &other) const {
+            return value == other.value;
+        }
+
+        bool operator<(const CFixedUInt32 &other) const {
+            return value < other.value;
+        }
+
+        bool IsEmpty() const { return value == 0; }
+
+        void SetEmpty() { value = 0; }
+    };
 }
 
 class SliceIterator {
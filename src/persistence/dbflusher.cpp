@@ -0,0 +1,243 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dbflusher.h"
+#include "commons/util.h"
+#include "config/configuration.h"
+#include "crypto/hash.h"
+
+#include <boost/filesystem.hpp>
+
+void CDBFlusher::Start() {
+    Stop();
+
+    fQuit  = false;
+    thread = std::thread([this]() {
+        RenameThread("coin-dbflush");
+        Worker();
+    });
+}
+
+void CDBFlusher::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condWorker.notify_all();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+void CDBFlusher::Worker() {
+    while (true) {
+        WriteJob job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condWorker.wait(lock, [this]() { return fQuit || !pendingJob.empty(); });
+            if (pendingJob.empty())
+                return;  // quit with nothing left to write
+
+            job.swap(pendingJob);
+        }
+
+        bool fResult = Write(job);
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            fLastResult = fLastResult && fResult;
+            fPending    = false;
+        }
+        condDone.notify_all();
+    }
+}
+
+bool CDBFlusher::WaitForWrite() {
+    int64_t nStart = GetTimeMillis();
+    std::unique_lock<std::mutex> lock(mtx);
+    condDone.wait(lock, [this]() { return !fPending; });
+    stats.waitTime += GetTimeMillis() - nStart;
+    return fLastResult;
+}
+
+bool CDBFlusher::BeginFlush() {
+    // the frozen layers of the last flush are dropped by the caches, so it must be on disk
+    if (!WaitForWrite())
+        return false;
+
+    for (auto pDb : dbs)
+        pDb->SetStaging(true);
+
+    return true;
+}
+
+bool CDBFlusher::EndFlush(bool fAsync) {
+    WriteJob job;
+    for (auto pDb : dbs) {
+        pDb->SetStaging(false);
+        vector<CDBAccess::BatchWriter> writers = pDb->TakeStagedWrites();
+        if (!writers.empty())
+            job.emplace_back(pDb, std::move(writers));
+    }
+
+    if (job.empty())
+        return true;
+
+    if (fAsync && IsRunning()) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            pendingJob.swap(job);
+            fPending = true;
+        }
+        condWorker.notify_one();
+        return true;
+    }
+
+    if (!Write(job)) {
+        std::unique_lock<std::mutex> lock(mtx);
+        fLastResult = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool CDBFlusher::Write(WriteJob &job) {
+    bool fResult = WriteBatches(job);
+    for (auto &item : job)
+        item.first->EndStagedWrites();
+
+    return fResult;
+}
+
+bool CDBFlusher::WriteBatches(WriteJob &job) {
+    int64_t nStart = GetTimeMillis();
+    // a single db batch is atomic by itself
+    bool fJournal  = job.size() > 1;
+    try {
+        vector<CLevelDBBatch> batches(job.size());
+        for (size_t i = 0; i < job.size(); ++i) {
+            for (auto &writer : job[i].second)
+                writer(batches[i]);
+        }
+
+        if (fJournal && !WriteJournal(job, batches))
+            return false;
+
+        for (size_t i = 0; i < job.size(); ++i)
+            job[i].first->WriteBatch(batches[i], true);
+
+        if (fJournal)
+            boost::filesystem::remove(pathJournal);
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Failed to write the state dbs - %s", __func__, e.what());
+    }
+
+    int64_t nTime = GetTimeMillis() - nStart;
+    LogPrint("BENCH", "%s : Wrote %u dbs (%dms)\n", __func__, job.size(), nTime);
+
+    std::unique_lock<std::mutex> lock(mtx);
+    ++stats.flushCount;
+    if (fJournal)
+        ++stats.journalCount;
+    stats.lastWriteTime = nTime;
+    stats.totalWriteTime += nTime;
+
+    return true;
+}
+
+bool CDBFlusher::WriteJournal(WriteJob &job, vector<CLevelDBBatch> &batches) {
+    CDataStream ssJournal(SER_DISK, CLIENT_VERSION);
+    ssJournal << FLATDATA(SysCfg().MessageStart());
+    WriteCompactSize(ssJournal, job.size());
+    for (size_t i = 0; i < job.size(); ++i) {
+        ssJournal << (uint8_t)job[i].first->GetDbNameType();
+        batches[i].WriteJournal(ssJournal);
+    }
+
+    uint256 hash = Hash(ssJournal.begin(), ssJournal.end());
+    ssJournal << hash;
+
+    boost::filesystem::path pathTmp = pathJournal;
+    pathTmp += ".new";
+    FILE *file        = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    fileout.write((const char *)&ssJournal[0], ssJournal.size());
+    FileCommit(fileout);
+    fileout.fclose();
+
+    // the journal is committed once renamed into place
+    if (!RenameOver(pathTmp, pathJournal))
+        return ERRORMSG("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+bool CDBFlusher::Recover() {
+    if (!boost::filesystem::exists(pathJournal))
+        return true;
+
+    FILE *file       = fopen(pathJournal.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathJournal.string());
+
+    int64_t dataSize = (int64_t)boost::filesystem::file_size(pathJournal) - (int64_t)sizeof(uint256);
+    if (dataSize <= 0)
+        return ERRORMSG("%s : Invalid file size", __func__);
+
+    vector<char> vchData(dataSize);
+    uint256 hashIn;
+    try {
+        filein.read(&vchData[0], dataSize);
+        filein >> hashIn;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssJournal(vchData, SER_DISK, CLIENT_VERSION);
+    if (hashIn != Hash(ssJournal.begin(), ssJournal.end()))
+        return ERRORMSG("%s : Checksum mismatch, data corrupted", __func__);
+
+    try {
+        unsigned char pchMsgTmp[4];
+        ssJournal >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("%s : Invalid network magic number", __func__);
+
+        uint64_t dbCount = ReadCompactSize(ssJournal);
+        for (uint64_t i = 0; i < dbCount; ++i) {
+            uint8_t dbNameType;
+            ssJournal >> dbNameType;
+            CLevelDBBatch batch;
+            batch.ReadJournal(ssJournal);
+
+            auto it = find_if(dbs.begin(), dbs.end(),
+                              [dbNameType](CDBAccess *pDb) { return (uint8_t)pDb->GetDbNameType() == dbNameType; });
+            if (it == dbs.end())
+                return ERRORMSG("%s : Unknown db %u in journal", __func__, dbNameType);
+
+            (*it)->WriteBatch(batch, true);
+        }
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Failed to replay the journal - %s", __func__, e.what());
+    }
+
+    boost::filesystem::remove(pathJournal);
+    LogPrint("INFO", "%s : Replayed the state db journal of an interrupted write\n", __func__);
+
+    return true;
+}
+
+void CDBFlusher::DiscardJournal() {
+    boost::filesystem::remove(pathJournal);
+}
+
+void CDBFlusher::GetStats(CDBFlushStats &statsOut) {
+    std::unique_lock<std::mutex> lock(mtx);
+    statsOut = stats;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_DBFLUSHER_H
+#define PERSIST_DBFLUSHER_H
+
+#include "dbaccess.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+using namespace std;
+
+struct CDBFlushStats {
+    uint64_t flushCount    = 0;
+    uint64_t journalCount  = 0;  // flushes written through the journal, touching more than one db
+    int64_t lastWriteTime  = 0;  // millis
+    int64_t totalWriteTime = 0;  // millis
+    int64_t waitTime       = 0;  // millis the flushes waited for the previous write
+};
+
+/**
+ * Writes the dirty sets of all state dbs as one unit. The caches stage their data into the dbs (see
+ * CDBAccess::IsStaging()) and keep it readable as a frozen layer, then the staged data is written in the
+ * flusher thread while the next blocks execute. When more than one db is touched, all batches are first
+ * written to a journal file, and the rename of the journal is the durable commit marker: an interrupted write
+ * is replayed from the journal on the next start, so the dbs never disagree.
+ */
+class CDBFlusher {
+public:
+    CDBFlusher(const vector<CDBAccess *> &dbsIn, const boost::filesystem::path &pathJournalIn)
+        : dbs(dbsIn), pathJournal(pathJournalIn) {}
+    ~CDBFlusher() { Stop(); }
+
+    void Start();
+    /** Stop the thread after the pending write. */
+    void Stop();
+    bool IsRunning() const { return thread.joinable(); }
+
+    /** Replay the journal of an interrupted write, must be called before the dbs are read. */
+    bool Recover();
+    /** Drop the journal of an interrupted write, when the dbs are rebuilt. */
+    void DiscardJournal();
+
+    /** Wait for the pending write and let the dbs stage the flushed caches, return false if the write failed. */
+    bool BeginFlush();
+    /** Write the staged data in the flusher thread, or in the calling thread if not fAsync or not running. */
+    bool EndFlush(bool fAsync);
+
+    void GetStats(CDBFlushStats &statsOut);
+
+private:
+    typedef vector<pair<CDBAccess *, vector<CDBAccess::BatchWriter>>> WriteJob;
+
+    void Worker();
+    bool WaitForWrite();
+    bool Write(WriteJob &job);
+    bool WriteBatches(WriteJob &job);
+    bool WriteJournal(WriteJob &job, vector<CLevelDBBatch> &batches);
+
+private:
+    vector<CDBAccess *> dbs;
+    boost::filesystem::path pathJournal;
+
+    std::thread thread;
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::condition_variable condDone;
+    WriteJob pendingJob;
+    bool fPending    = false;  // a job is queued or being written
+    bool fLastResult = true;
+    bool fQuit       = false;
+
+    CDBFlushStats stats;
+};
+
+#endif  // PERSIST_DBFLUSHER_H
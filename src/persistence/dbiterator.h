@@ -19,7 +19,7 @@ public:
     // 1/2: make 2 pair key object by 1 prefix
     template<typename T1, typename T2>
     static void MakeKeyByPrefix(const T1 &prefix, std::pair<T1, T2> &keyObj) {
-        keyObj = make_pair<T1, T2>(prefix, db_util::MakeEmpty<T2>());
+        keyObj = std::pair<T1, T2>(prefix, db_util::MakeEmpty<T2>());
     }
 
     // 2/2: make 2 pair key object by 2 prefix, the 2nd prefix must support partial match
@@ -31,13 +31,13 @@ public:
     // 1/3: make 3 tuple key object by 1 prefix
     template<typename T1, typename T2, typename T3>
     static void MakeKeyByPrefix(const T1 &prefix, std::tuple<T1, T2, T3> &keyObj) {
-        keyObj = make_tuple<T1, T2, T3>(prefix, db_util::MakeEmpty<T2>(), db_util::MakeEmpty<T3>());
+        keyObj = std::tuple<T1, T2, T3>(prefix, db_util::MakeEmpty<T2>(), db_util::MakeEmpty<T3>());
     }
 
     // 2/3: make 3 tuple key object by 2 pair prefix
     template<typename T1, typename T2, typename T3>
     static void MakeKeyByPrefix(const std::pair<T1, T2> &prefix, std::tuple<T1, T2, T3> &keyObj) {
-        keyObj = make_tuple<T1, T2, T3>(prefix.first, prefix.second, db_util::MakeEmpty<T3>());
+        keyObj = std::tuple<T1, T2, T3>(prefix.first, prefix.second, db_util::MakeEmpty<T3>());
     }
 
     // empty prefix, will match all keys
@@ -249,6 +249,7 @@ public:
           max_count(maxCount){}
 
     bool Execute() {
+        db_cache.GetDbAccessPtr()->WaitForStagedWrites();
         CMapPrefixIterator<CacheType, PrefixElement, PrefixMatcher> mapIt(db_cache, prefix_element);
         CDBPrefixIterator<CacheType, PrefixElement, PrefixMatcher> dbIt(db_cache, prefix_element);
         mapIt.First(last_key);
@@ -7,6 +7,8 @@
 
 #include "config/configuration.h"
 
+#include <limits>
+
 bool CDelegateDBCache::LoadTopDelegateList() {
     delegateRegIds.clear();
 
@@ -47,6 +49,18 @@ bool CDelegateDBCache::GetTopDelegateList(vector<CRegID> &delegatesList) {
     return true;
 }
 
+// The votes in descending order, the same as strprintf("%016x", MAX - votes) without the formatting cost.
+static string GetVotesKey(const uint64_t votes) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    uint64_t number = std::numeric_limits<uint64_t>::max() - votes;
+    string strVotes(16, '0');
+    for (int32_t i = 15; i >= 0; --i, number >>= 4)
+        strVotes[i] = hexDigits[number & 0xF];
+
+    return strVotes;
+}
+
 bool CDelegateDBCache::SetDelegateVotes(const CRegID &regId, const uint64_t votes) {
     // If CRegID is empty, ignore received votes for forward compatibility.
     if (regId.IsEmpty()) {
@@ -55,9 +69,7 @@ bool CDelegateDBCache::SetDelegateVotes(const CRegID &regId, const uint64_t vote
 
     delegateRegIds.clear();
 
-    static uint64_t maxNumber = 0xFFFFFFFFFFFFFFFF;
-    string strVotes           = strprintf("%016x", maxNumber - votes);
-    auto key                  = std::make_pair(strVotes, regId.ToRawString());
+    auto key                  = std::make_pair(GetVotesKey(votes), regId.ToRawString());
     static uint8_t value      = 1;
 
     return voteRegIdCache.SetData(key, value);
@@ -71,9 +83,7 @@ bool CDelegateDBCache::EraseDelegateVotes(const CRegID &regId, const uint64_t vo
 
     delegateRegIds.clear();
 
-    static uint64_t maxNumber = 0xFFFFFFFFFFFFFFFF;
-    string strVotes           = strprintf("%016x", maxNumber - votes);
-    auto oldKey               = std::make_pair(strVotes, regId.ToRawString());
+    auto oldKey               = std::make_pair(GetVotesKey(votes), regId.ToRawString());
 
     return voteRegIdCache.EraseData(oldKey);
 }
@@ -8,6 +8,7 @@
 #include "entities/asset.h"
 #include "main.h"
 #include <functional>
+#include <limits>
 
 ///////////////////////////////////////////////////////////////////////////////
 // class DEX_DB
@@ -28,6 +29,35 @@ void DEX_DB::BlockOrdersToJson(const BlockOrders &orders, Object &obj) {
     obj.push_back(Pair("orders", array));
 }
 
+string DEX_DB::MakeOrderBookName(const TokenSymbol &coinSymbol, const TokenSymbol &assetSymbol, OrderSide orderSide) {
+    return strprintf("%s/%s/%s", coinSymbol, assetSymbol, GetOrderSideName(orderSide));
+}
+
+DEXOrderBookCache::KeyType DEX_DB::MakeOrderBookKey(const uint256 &orderId, const CDEXOrderDetail &order) {
+    uint64_t priceKey = 0;  // market orders
+    if (order.order_type == ORDER_LIMIT_PRICE)
+        priceKey = (order.order_side == ORDER_BUY) ? std::numeric_limits<uint64_t>::max() - order.price : order.price;
+
+    string orderKey = strprintf("%016x%08x%08x", priceKey, order.tx_cord.GetHeight(), order.tx_cord.GetIndex());
+    return make_tuple(MakeOrderBookName(order.coin_symbol, order.asset_symbol, order.order_side), orderKey, orderId);
+}
+
+DEXOrderBookChangeCache::KeyType DEX_DB::MakeOrderBookChangeKey(uint32_t height, const uint256 &orderId) {
+    return make_pair(strprintf("%08x", height), orderId.GetHex());
+}
+
+uint32_t DEX_DB::GetHeight(const DEXOrderBookChangeCache::KeyType &key) {
+    return (uint32_t)strtoul(key.first.c_str(), nullptr, 16);
+}
+
+uint64_t DEX_DB::GetResidualAssetAmount(const CDEXOrderDetail &order) {
+    return order.asset_amount > order.total_deal_asset_amount ? order.asset_amount - order.total_deal_asset_amount : 0;
+}
+
+uint64_t DEX_DB::GetResidualCoinAmount(const CDEXOrderDetail &order) {
+    return order.coin_amount > order.total_deal_coin_amount ? order.coin_amount - order.total_deal_coin_amount : 0;
+}
+
 shared_ptr<string> DEX_DB::ParseLastPos(const string &lastPosInfo, DEXBlockOrdersCache::KeyType &lastKey) {
 
     CDataStream ds(lastPosInfo, SER_DISK, CLIENT_VERSION);
@@ -173,6 +203,7 @@ private:
 bool CDEXOrdersGetter::Execute(uint32_t beginHeight, uint32_t endHeight, uint32_t maxCount, const DEXBlockOrdersCache::KeyType &lastKey) {
 
     assert(orders.size() == 0 && "Can only execute 1 times");
+    db_access.WaitForStagedWrites();
     CMapDexOrderIt mapIt(db_cache, beginHeight, endHeight);
     CDBDexOrderIt dbIt(db_cache, beginHeight, endHeight);
 
@@ -327,6 +358,7 @@ private:
 
 bool CDEXSysOrdersGetter::Execute(uint32_t height) {
 
+    db_access.WaitForStagedWrites();
     CMapDexSysOrderIt mapIt(db_cache, height);
     CDBDexSysOrderIt dbIt(db_access, height);
     mapIt.First();
@@ -370,6 +402,210 @@ void CDEXSysOrdersGetter::ToJson(Object &obj) {
     DEX_DB::BlockOrdersToJson(orders, obj);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// class CDexRangeIt
+
+/**
+ * Walk the elements of a top level cache in the range [firstKey, lastKey], the map data merged over the db in the key
+ * order. The keys in the range must sort in db as the KeyType does, and be contiguous in db, e.g. a leading string of
+ * the key fixed by the range. The keys of db out of the range end the walk of db.
+ */
+template<typename CacheType>
+class CDexRangeIt {
+public:
+    typedef typename CacheType::KeyType KeyType;
+    typedef typename CacheType::ValueType ValueType;
+
+    KeyType key;
+    ValueType value;
+private:
+    CacheType &db_cache;
+    typename CacheType::Iterator map_it;
+    shared_ptr<leveldb::Iterator> p_db_it;
+    string prefix;
+    KeyType first_key;
+    KeyType last_key;
+    KeyType db_key;
+    bool is_db_valid;
+    bool is_map_data;
+    bool is_valid;
+public:
+    CDexRangeIt(CacheType &dbCache)
+        : key(), value(), db_cache(dbCache), map_it(dbCache.GetMapData().end()), first_key(), last_key(), db_key(),
+          is_db_valid(false), is_map_data(false), is_valid(false) {}
+
+    bool First(const KeyType &firstKey, const KeyType &lastKey) {
+        first_key = firstKey;
+        last_key  = lastKey;
+        map_it    = db_cache.GetMapData().lower_bound(firstKey);
+        p_db_it   = db_cache.GetDbAccessPtr()->NewIterator();
+        prefix    = dbk::GetKeyPrefix(CacheType::PREFIX_TYPE);
+        p_db_it->Seek(dbk::GenDbKey(CacheType::PREFIX_TYPE, firstKey));
+        ParseDbKey();
+        return Merge();
+    }
+
+    bool Next() {
+        if (is_map_data) {
+            map_it++;
+        } else {
+            p_db_it->Next();
+            ParseDbKey();
+        }
+        return Merge();
+    }
+
+    bool IsValid() { return is_valid; }
+private:
+    inline void ParseDbKey() {
+        is_db_valid = p_db_it->Valid() && p_db_it->key().starts_with(prefix);
+        if (is_db_valid && !dbk::ParseDbKey(p_db_it->key(), CacheType::PREFIX_TYPE, db_key)) {
+            throw runtime_error(strprintf("CDexRangeIt::ParseDbKey db key error! key=%s",
+                                          HexStr(p_db_it->key().ToString())));
+        }
+        // the db sorts the strings by length first, so the keys out of the range may follow either bound
+        if (is_db_valid && (db_key < first_key || last_key < db_key))
+            is_db_valid = false;
+    }
+
+    inline bool IsMapValid() {
+        return map_it != db_cache.GetMapData().end() && !(last_key < map_it->first);
+    }
+
+    // the next valid element of both, the map data wins over the db and its erased elements are skipped
+    inline bool Merge() {
+        is_valid = false;
+        while (IsMapValid() || is_db_valid) {
+            if (IsMapValid() && (!is_db_valid || !(db_key < map_it->first))) {
+                if (is_db_valid && !(map_it->first < db_key)) {  // same key, the db element is overridden
+                    p_db_it->Next();
+                    ParseDbKey();
+                }
+                if (db_util::IsEmpty(map_it->second)) {
+                    map_it++;
+                    continue;
+                }
+                key         = map_it->first;
+                value       = map_it->second;
+                is_map_data = true;
+            } else {
+                const leveldb::Slice &slValue = p_db_it->value();
+                try {
+                    CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+                    ssValue >> value;
+                } catch(std::exception &e) {
+                    throw runtime_error(strprintf("CDexRangeIt::Merge db value error! %s", HexStr(slValue.ToString())));
+                }
+                key         = db_key;
+                is_map_data = false;
+            }
+            is_valid = true;
+            break;
+        }
+        return is_valid;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CDEXOrderBookGetter
+
+void CDEXOrderBookLevel::ToJson(Object &obj) const {
+    obj.push_back(Pair("order_type",            GetOrderTypeName(order_type)));
+    obj.push_back(Pair("price",                 price));
+    obj.push_back(Pair("order_count",           (int64_t)order_count));
+    obj.push_back(Pair("residual_asset_amount", residual_asset_amount));
+    obj.push_back(Pair("residual_coin_amount",  residual_coin_amount));
+    if (!orders.empty()) {
+        Array array;
+        for (const auto &item : orders) {
+            Object objItem;
+            DEX_DB::OrderToJson(item.first, item.second, objItem);
+            array.push_back(objItem);
+        }
+        obj.push_back(Pair("orders", array));
+    }
+}
+
+bool CDEXOrderBookGetter::Execute(const TokenSymbol &coinSymbol, const TokenSymbol &assetSymbol, OrderSide orderSide,
+                                  uint32_t maxLevels, bool withOrders) {
+    assert(levels.size() == 0 && "Can only execute 1 times");
+    db_access.WaitForStagedWrites();
+
+    const string bookName = DEX_DB::MakeOrderBookName(coinSymbol, assetSymbol, orderSide);
+    CDexRangeIt<DEXOrderBookCache> it(db_cache);
+    // all the order keys of the book are lower hex digits, in between
+    for (it.First(make_tuple(bookName, string(), uint256()), make_tuple(bookName, string("~"), uint256()));
+         it.IsValid(); it.Next()) {
+        const CDEXOrderDetail &order = it.value;
+        uint64_t price = (order.order_type == ORDER_LIMIT_PRICE) ? order.price : 0;
+        if (levels.empty() || levels.back().order_type != order.order_type || levels.back().price != price) {
+            if (maxLevels != 0 && levels.size() >= maxLevels)
+                break;
+
+            levels.emplace_back();
+            levels.back().order_type = order.order_type;
+            levels.back().price      = price;
+        }
+
+        CDEXOrderBookLevel &level = levels.back();
+        level.order_count += 1;
+        level.residual_asset_amount += DEX_DB::GetResidualAssetAmount(order);
+        level.residual_coin_amount += DEX_DB::GetResidualCoinAmount(order);
+        if (withOrders)
+            level.orders.emplace_back(DEX_DB::GetOrderId(it.key), order);
+    }
+    return true;
+}
+
+void CDEXOrderBookGetter::ToJson(Array &arr) {
+    for (const auto &level : levels) {
+        Object obj;
+        level.ToJson(obj);
+        arr.push_back(obj);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class CDEXOrderBookChangesGetter
+
+bool CDEXOrderBookChangesGetter::Execute(uint32_t sinceHeight, uint32_t toHeight, uint32_t maxCount) {
+    assert(changes.size() == 0 && "Can only execute 1 times");
+    db_access.WaitForStagedWrites();
+
+    end_height = sinceHeight;
+    CDexRangeIt<DEXOrderBookChangeCache> it(db_cache);
+    for (it.First(DEX_DB::MakeOrderBookChangeKey(sinceHeight + 1, uint256()),
+                  make_pair(strprintf("%08x", toHeight), string(64, 'f')));
+         it.IsValid(); it.Next()) {
+        uint32_t height = DEX_DB::GetHeight(it.key);
+        if (height != end_height) {
+            if (maxCount != 0 && changes.size() >= maxCount) {
+                has_more = true;
+                break;
+            }
+            end_height = height;
+        }
+        changes.emplace_back(it.key, it.value);
+    }
+    if (!has_more)
+        end_height = toHeight;
+
+    return true;
+}
+
+void CDEXOrderBookChangesGetter::ToJson(Object &obj) {
+    obj.push_back(Pair("count", (int64_t)changes.size()));
+    Array array;
+    for (const auto &item : changes) {
+        Object objItem;
+        objItem.push_back(Pair("height", (int64_t)DEX_DB::GetHeight(item.first)));
+        objItem.push_back(Pair("action", GetOrderBookActionName(item.second.action)));
+        DEX_DB::OrderToJson(DEX_DB::GetOrderId(item.first), item.second.order, objItem);
+        array.push_back(objItem);
+    }
+    obj.push_back(Pair("changes", array));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // class CDexDBCache
 
@@ -384,15 +620,62 @@ bool CDexDBCache::HaveActiveOrder(const uint256 &orderId) {
 bool CDexDBCache::CreateActiveOrder(const uint256 &orderId, const CDEXOrderDetail &activeOrder) {
     assert(!activeOrderCache.HaveData(orderId));
     return activeOrderCache.SetData(orderId, activeOrder)
-        && blockOrdersCache.SetData(MakeBlockOrderKey(orderId, activeOrder), activeOrder);
+        && blockOrdersCache.SetData(MakeBlockOrderKey(orderId, activeOrder), activeOrder)
+        && orderBookCache.SetData(DEX_DB::MakeOrderBookKey(orderId, activeOrder), activeOrder)
+        && SetOrderBookChange(activeOrder.tx_cord.GetHeight(), orderId, ORDER_BOOK_PUT, activeOrder);
 }
 
-bool CDexDBCache::UpdateActiveOrder(const uint256 &orderId, const CDEXOrderDetail &activeOrder) {
+bool CDexDBCache::UpdateActiveOrder(const uint256 &orderId, const CDEXOrderDetail &activeOrder, uint32_t height) {
     return activeOrderCache.SetData(orderId, activeOrder)
-        && blockOrdersCache.SetData(MakeBlockOrderKey(orderId, activeOrder), activeOrder);
+        && blockOrdersCache.SetData(MakeBlockOrderKey(orderId, activeOrder), activeOrder)
+        && orderBookCache.SetData(DEX_DB::MakeOrderBookKey(orderId, activeOrder), activeOrder)
+        && SetOrderBookChange(height, orderId, ORDER_BOOK_PUT, activeOrder);
 };
 
-bool CDexDBCache::EraseActiveOrder(const uint256 &orderId, const CDEXOrderDetail &activeOrder) {
+bool CDexDBCache::EraseActiveOrder(const uint256 &orderId, const CDEXOrderDetail &activeOrder, uint32_t height) {
     return activeOrderCache.EraseData(orderId)
-        && blockOrdersCache.EraseData(MakeBlockOrderKey(orderId, activeOrder));
+        && blockOrdersCache.EraseData(MakeBlockOrderKey(orderId, activeOrder))
+        && orderBookCache.EraseData(DEX_DB::MakeOrderBookKey(orderId, activeOrder))
+        && SetOrderBookChange(height, orderId, ORDER_BOOK_ERASE, activeOrder);
 };
+
+bool CDexDBCache::PruneOrderBookChanges(uint32_t height) {
+    if (height <= DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT)
+        return true;
+
+    // normally the changes of a single height, the older ones are pruned already
+    auto lastKey = make_pair(strprintf("%08x", height - DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT), string(64, 'f'));
+    map<DEXOrderBookChangeCache::KeyType, CDEXOrderBookChange> elements;
+    if (!orderBookChangeCache.GetElementsUpTo(lastKey, elements))
+        return false;
+
+    for (const auto &item : elements) {
+        if (!orderBookChangeCache.EraseData(item.first))
+            return false;
+    }
+    return true;
+}
+
+bool CDexDBCache::SetOrderBookChange(uint32_t height, const uint256 &orderId, OrderBookAction action,
+                                     const CDEXOrderDetail &activeOrder) {
+    // the last change of the order at the height wins
+    return orderBookChangeCache.SetData(DEX_DB::MakeOrderBookChangeKey(height, orderId),
+                                        CDEXOrderBookChange(action, activeOrder));
+}
+
+void CDexDBCache::BuildOrderBook(CDBAccess *pDbAccess) {
+    set<DEXOrderBookCache::KeyType> bookKeys;
+    if (orderBookCache.GetTopNElements(1, bookKeys))
+        return;
+
+    map<uint256, CDEXOrderDetail> activeOrders;
+    if (!pDbAccess->GetAllElements(dbk::DEX_ACTIVE_ORDER, activeOrders) || activeOrders.empty())
+        return;
+
+    for (const auto &item : activeOrders) {
+        orderBookCache.SetData(DEX_DB::MakeOrderBookKey(item.first, item.second), item.second);
+    }
+    orderBookCache.Flush();
+
+    LogPrint("INFO", "CDexDBCache::BuildOrderBook, active orders: %llu\n", activeOrders.size());
+}
@@ -22,6 +22,13 @@ using namespace std;
     /////////// DexDB
     // block orders: height generate_type txid -> active order
 typedef CCompositeKVCache<dbk::DEX_BLOCK_ORDERS,  tuple<uint32_t, uint8_t, uint256>, CDEXOrderDetail>     DEXBlockOrdersCache;
+    // order book: book order_key txid -> active order
+typedef CCompositeKVCache<dbk::DEX_ORDER_BOOK,    tuple<string, string, uint256>,    CDEXOrderDetail>     DEXOrderBookCache;
+    // order book changes: height txid -> the last change of the order at the height
+typedef CCompositeKVCache<dbk::DEX_ORDER_BOOK_CHANGE, pair<string, string>,          CDEXOrderBookChange> DEXOrderBookChangeCache;
+
+// the blocks of order book changes kept for the matchers following the book, about one day
+static const uint32_t DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT = 28800;
 
 // DEX_DB
 namespace DEX_DB {
@@ -49,6 +56,34 @@ namespace DEX_DB {
     void OrderToJson(const uint256 &orderId, const CDEXOrderDetail &order, Object &obj);
 
     void BlockOrdersToJson(const BlockOrders &orderList, Object &obj);
+
+    // order book key: book(coin/asset/side) order_key(price key, height, index) txid
+    // the order key is fixed width hex, so that the keys of a book sort in db in the price-time priority: the
+    // market orders first, then the sell prices ascending and the buy prices descending, then the tx cord
+    string MakeOrderBookName(const TokenSymbol &coinSymbol, const TokenSymbol &assetSymbol, OrderSide orderSide);
+
+    DEXOrderBookCache::KeyType MakeOrderBookKey(const uint256 &orderId, const CDEXOrderDetail &order);
+
+    inline const string &GetOrderBookName(const DEXOrderBookCache::KeyType &key) {
+        return std::get<0>(key);
+    }
+
+    inline const uint256 &GetOrderId(const DEXOrderBookCache::KeyType &key) {
+        return std::get<2>(key);
+    }
+
+    // order book change key: height(fixed width hex) txid(hex)
+    DEXOrderBookChangeCache::KeyType MakeOrderBookChangeKey(uint32_t height, const uint256 &orderId);
+
+    uint32_t GetHeight(const DEXOrderBookChangeCache::KeyType &key);
+
+    inline uint256 GetOrderId(const DEXOrderBookChangeCache::KeyType &key) {
+        return uint256S(key.second);
+    }
+
+    // the residual amounts of the order not dealt yet
+    uint64_t GetResidualAssetAmount(const CDEXOrderDetail &order);
+    uint64_t GetResidualCoinAmount(const CDEXOrderDetail &order);
 };
 
 class CDEXOrdersGetter {
@@ -86,36 +121,116 @@ public:
     void ToJson(Object &obj);
 };
 
+// the orders of a book aggregated by price, a market order level holds all the market orders of the side
+struct CDEXOrderBookLevel {
+    OrderType order_type            = ORDER_LIMIT_PRICE;
+    uint64_t price                  = 0;
+    uint32_t order_count            = 0;
+    uint64_t residual_asset_amount  = 0;
+    uint64_t residual_coin_amount   = 0;
+    vector<pair<uint256, CDEXOrderDetail>> orders;  // the orders in the price-time priority, when verbose
+
+    void ToJson(Object &obj) const;
+};
+
+class CDEXOrderBookGetter {
+public:
+    vector<CDEXOrderBookLevel> levels;  // exec result, the best level first
+private:
+    DEXOrderBookCache &db_cache;
+    CDBAccess &db_access;
+public:
+    CDEXOrderBookGetter(DEXOrderBookCache &dbCache)
+        : db_cache(dbCache), db_access(*dbCache.GetDbAccessPtr()) {
+    }
+
+    // the best levels of a book, only the orders of the levels returned are read
+    bool Execute(const TokenSymbol &coinSymbol, const TokenSymbol &assetSymbol, OrderSide orderSide,
+                 uint32_t maxLevels, bool withOrders);
+
+    void ToJson(Array &arr);
+};
+
+class CDEXOrderBookChangesGetter {
+public:
+    uint32_t    end_height      = 0;        // the last height returned, the changes of a height are never split
+    bool        has_more        = false;    // has more changes after end_height
+    vector<pair<DEXOrderBookChangeCache::KeyType, CDEXOrderBookChange>> changes;  // exec result
+private:
+    DEXOrderBookChangeCache &db_cache;
+    CDBAccess &db_access;
+public:
+    CDEXOrderBookChangesGetter(DEXOrderBookChangeCache &dbCache)
+        : db_cache(dbCache), db_access(*dbCache.GetDbAccessPtr()) {
+    }
+
+    // the changes after sinceHeight up to toHeight, at least maxCount changes unless no more
+    bool Execute(uint32_t sinceHeight, uint32_t toHeight, uint32_t maxCount);
+
+    void ToJson(Object &obj);
+};
+
+/**
+ * The active orders are indexed by book and price in db, so that the best levels of a book are a range scan of the
+ * book, and every change of the book is logged at its block height for the matchers following it, until it is
+ * older than DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT. Both are written with the active orders and undone with the block.
+ */
 class CDexDBCache {
 public:
     CDexDBCache() {}
-    CDexDBCache(CDBAccess *pDbAccess) : activeOrderCache(pDbAccess), blockOrdersCache(pDbAccess) {};
+    CDexDBCache(CDBAccess *pDbAccess)
+        : activeOrderCache(pDbAccess), blockOrdersCache(pDbAccess), orderBookCache(pDbAccess),
+          orderBookChangeCache(pDbAccess) {
+        BuildOrderBook(pDbAccess);
+    };
 
 public:
     bool GetActiveOrder(const uint256 &orderTxId, CDEXOrderDetail& activeOrder);
     bool HaveActiveOrder(const uint256 &orderTxId);
+    // the order is created at the height of its tx cord, updated or erased at the height of the block given
     bool CreateActiveOrder(const uint256 &orderTxId, const CDEXOrderDetail& activeOrder);
-    bool UpdateActiveOrder(const uint256 &orderTxId, const CDEXOrderDetail& activeOrder);
-    bool EraseActiveOrder(const uint256 &orderTxId, const CDEXOrderDetail &activeOrder);
+    bool UpdateActiveOrder(const uint256 &orderTxId, const CDEXOrderDetail& activeOrder, uint32_t height);
+    bool EraseActiveOrder(const uint256 &orderTxId, const CDEXOrderDetail &activeOrder, uint32_t height);
+
+    // erase the order book changes too old to keep at the block height
+    bool PruneOrderBookChanges(uint32_t height);
 
     bool Flush() {
         activeOrderCache.Flush();
         blockOrdersCache.Flush();
+        orderBookCache.Flush();
+        orderBookChangeCache.Flush();
         return true;
     }
+    void Clear() {
+        activeOrderCache.Clear();
+        blockOrdersCache.Clear();
+        orderBookCache.Clear();
+        orderBookChangeCache.Clear();
+    }
+    uint32_t GetCacheSize() const {
+        return activeOrderCache.GetCacheSize() + blockOrdersCache.GetCacheSize() + orderBookCache.GetCacheSize() +
+               orderBookChangeCache.GetCacheSize();
+    }
     void SetBaseViewPtr(CDexDBCache *pBaseIn) {
         activeOrderCache.SetBase(&pBaseIn->activeOrderCache);
         blockOrdersCache.SetBase(&pBaseIn->blockOrdersCache);
+        orderBookCache.SetBase(&pBaseIn->orderBookCache);
+        orderBookChangeCache.SetBase(&pBaseIn->orderBookChangeCache);
     };
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         activeOrderCache.SetDbOpLogMap(pDbOpLogMapIn);
         blockOrdersCache.SetDbOpLogMap(pDbOpLogMapIn);
+        orderBookCache.SetDbOpLogMap(pDbOpLogMapIn);
+        orderBookChangeCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
     bool UndoDatas() {
         return activeOrderCache.UndoDatas() &&
-               blockOrdersCache.UndoDatas();
+               blockOrdersCache.UndoDatas() &&
+               orderBookCache.UndoDatas() &&
+               orderBookChangeCache.UndoDatas();
     }
 
     shared_ptr<CDEXOrdersGetter> CreateOrdersGetter() {
@@ -127,7 +242,23 @@ public:
         assert(blockOrdersCache.GetBasePtr() == nullptr && "only support top level cache");
         return make_shared<CDEXSysOrdersGetter>(blockOrdersCache);
     }
+
+    shared_ptr<CDEXOrderBookGetter> CreateOrderBookGetter() {
+        assert(orderBookCache.GetBasePtr() == nullptr && "only support top level cache");
+        return make_shared<CDEXOrderBookGetter>(orderBookCache);
+    }
+
+    shared_ptr<CDEXOrderBookChangesGetter> CreateOrderBookChangesGetter() {
+        assert(orderBookChangeCache.GetBasePtr() == nullptr && "only support top level cache");
+        return make_shared<CDEXOrderBookChangesGetter>(orderBookChangeCache);
+    }
 private:
+    bool SetOrderBookChange(uint32_t height, const uint256 &orderId, OrderBookAction action,
+                            const CDEXOrderDetail &activeOrder);
+
+    // Build the order book of a db written before it existed, from all the active orders, once.
+    void BuildOrderBook(CDBAccess *pDbAccess);
+
     DEXBlockOrdersCache::KeyType MakeBlockOrderKey(const uint256 &orderid, const CDEXOrderDetail &activeOrder) {
         return make_tuple(activeOrder.tx_cord.GetHeight(), (uint8_t)activeOrder.generate_type, orderid);
     }
@@ -138,6 +269,8 @@ private:
     // order tx id -> active order
     CCompositeKVCache< dbk::DEX_ACTIVE_ORDER,          uint256,                     CDEXOrderDetail >     activeOrderCache;
     DEXBlockOrdersCache    blockOrdersCache;
+    DEXOrderBookCache      orderBookCache;
+    DEXOrderBookChangeCache orderBookChangeCache;
 };
 
 #endif //PERSIST_DEX_H
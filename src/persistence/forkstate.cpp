@@ -0,0 +1,156 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "forkstate.h"
+#include "main.h"
+
+CForkStateTree forkStates;
+
+void CForkStateTree::SetRoot(CCacheDBManager *pCdManIn, const uint256 &hash, int32_t height) {
+    Clear();
+    pCdMan     = pCdManIn;
+    rootHash   = hash;
+    rootHeight = height;
+}
+
+CCacheWrapper *CForkStateTree::Get(const uint256 &hash) {
+    auto it = mapNodes.find(hash);
+    if (it == mapNodes.end())
+        return nullptr;
+
+    Touch(hash);
+    return it->second.sp_cw.get();
+}
+
+std::unique_ptr<CCacheWrapper> CForkStateTree::CreateLayer(const uint256 &baseHash) {
+    if (baseHash == rootHash) {
+        assert(pCdMan != nullptr);
+        return std::unique_ptr<CCacheWrapper>(new CCacheWrapper(pCdMan));
+    }
+
+    auto it = mapNodes.find(baseHash);
+    assert(it != mapNodes.end());
+    return std::unique_ptr<CCacheWrapper>(new CCacheWrapper(*it->second.sp_cw));
+}
+
+void CForkStateTree::Add(const uint256 &hash, int32_t height, const uint256 &baseHash,
+                         std::unique_ptr<CCacheWrapper> spCw) {
+    assert(!Contains(hash) && hash != rootHash);
+    assert(baseHash == rootHash || Contains(baseHash));
+
+    // the undo log set by an undo of the blocks is not of the state
+    spCw->DisableTxUndoLog();
+
+    int32_t baseHeight   = baseHash == rootHash ? rootHeight : mapNodes.at(baseHash).height;
+    CForkStateNode &node = mapNodes[hash];
+    node.base_hash       = baseHash;
+    node.height          = height;
+    node.cache_size      = spCw->GetCacheSize() + sizeof(CCacheWrapper);
+    node.forked          = height > baseHeight;
+    node.sp_cw           = std::move(spCw);
+    GetLayers(baseHash).insert(hash);
+    cacheSize += node.cache_size;
+    if (node.forked)
+        ++forkedCount;
+
+    Touch(hash);
+    Evict(hash);
+
+    LogPrint("INFO", "CForkStateTree::Add, add [%d]: %s on %s, %u states, %llu bytes\n", height, hash.GetHex(),
+             baseHash.GetHex(), mapNodes.size(), cacheSize);
+}
+
+void CForkStateTree::MoveRoot(const uint256 &hash, int32_t height, std::unique_ptr<CCacheWrapper> spOldRootCw) {
+    assert(!Contains(hash) && !Contains(rootHash));
+
+    spOldRootCw->DisableTxUndoLog();
+
+    uint256 oldRootHash = rootHash;
+    set<uint256> oldRootLayers;
+    oldRootLayers.swap(rootLayers);
+
+    CForkStateNode &node = mapNodes[oldRootHash];
+    node.base_hash       = hash;
+    node.height          = rootHeight;
+    node.cache_size      = spOldRootCw->GetCacheSize() + sizeof(CCacheWrapper);
+    node.sp_cw           = std::move(spOldRootCw);
+    node.last_access     = ++accessCount;
+    node.layers          = oldRootLayers;
+    cacheSize += node.cache_size;
+
+    for (const auto &layerHash : oldRootLayers) {
+        CForkStateNode &layer = mapNodes.at(layerHash);
+        layer.base_hash       = oldRootHash;
+        layer.sp_cw->SetBaseViewPtr(node.sp_cw.get());
+    }
+
+    rootHash   = hash;
+    rootHeight = height;
+    rootLayers.insert(oldRootHash);
+
+    // the states forked too deep below the tip are unlikely to be built on any more
+    vector<uint256> deepHashes;
+    for (const auto &item : mapNodes) {
+        if (item.second.height < rootHeight - MAX_FORK_STATE_DEPTH)
+            deepHashes.push_back(item.first);
+    }
+    for (const auto &deepHash : deepHashes)
+        Erase(deepHash);
+
+    Evict(uint256());
+}
+
+void CForkStateTree::Clear() {
+    mapNodes.clear();
+    rootLayers.clear();
+    cacheSize   = 0;
+    forkedCount = 0;
+    pCdMan     = nullptr;
+    rootHash   = uint256();
+    rootHeight = 0;
+}
+
+set<uint256> &CForkStateTree::GetLayers(const uint256 &baseHash) {
+    return baseHash == rootHash ? rootLayers : mapNodes.at(baseHash).layers;
+}
+
+void CForkStateTree::Touch(const uint256 &hash) {
+    uint64_t access = ++accessCount;
+    for (auto it = mapNodes.find(hash); it != mapNodes.end(); it = mapNodes.find(it->second.base_hash))
+        it->second.last_access = access;
+}
+
+void CForkStateTree::Erase(const uint256 &hash) {
+    auto it = mapNodes.find(hash);
+    if (it == mapNodes.end())
+        return;  // erased with its base already
+
+    set<uint256> layers = it->second.layers;
+    for (const auto &layerHash : layers)
+        Erase(layerHash);
+
+    GetLayers(it->second.base_hash).erase(hash);
+    cacheSize -= it->second.cache_size;
+    if (it->second.forked)
+        --forkedCount;
+    mapNodes.erase(it);
+}
+
+void CForkStateTree::Evict(const uint256 &keepHash) {
+    while (cacheSize > maxCacheSize) {
+        // only the leaves are evicted, the others are the bases of the states on them
+        auto lruIt = mapNodes.end();
+        for (auto it = mapNodes.begin(); it != mapNodes.end(); ++it) {
+            if (it->second.layers.empty() && it->first != keepHash &&
+                (lruIt == mapNodes.end() || it->second.last_access < lruIt->second.last_access))
+                lruIt = it;
+        }
+        if (lruIt == mapNodes.end())
+            break;
+
+        LogPrint("INFO", "CForkStateTree::Evict, evict [%d]: %s, %llu bytes above the max cache size\n",
+                 lruIt->second.height, lruIt->first.GetHex(), cacheSize - maxCacheSize);
+        Erase(lruIt->first);
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_FORKSTATE_H
+#define PERSIST_FORKSTATE_H
+
+#include "cachewrapper.h"
+#include "commons/uint256.h"
+#include "config/const.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+
+using namespace std;
+
+class CCacheDBManager;
+
+/**
+ * The states of the blocks off the active chain tip, kept for validating the forked chains. The root is the state at
+ * the tip, i.e. the top level caches of the manager. Every other state is a cache wrapper layer keyed by the hash of
+ * its block, on the layer of its base block:
+ *   - the blocks of the active chain below the tip, each layered on the block above it with the block above
+ *     disconnected, from the undo data;
+ *   - the blocks of the forked chains, each layered on its previous block with the block connected.
+ * So a forked chain is validated on the states of the blocks it shares with the others, and the active chain is
+ * only disconnected once down to a forked point.
+ *
+ * When a block is connected on the tip while there are states of forked chains, the state at the old tip is built by
+ * disconnecting it on the new root, and the layers on the old root are moved onto it: they hold the same state as
+ * before, whatever they read through. Without them, and on any other tip update, all the states are dropped, and the
+ * states of the active chain are only built again for a forked chain.
+ *
+ * The memory of the states is accounted by their cache sizes, and the least recently used leaves are evicted above
+ * the max cache size. The states deeper than MAX_FORK_STATE_DEPTH below the tip are dropped on the tip updates.
+ *
+ * Requires cs_main.
+ */
+class CForkStateTree {
+public:
+    CForkStateTree()
+        : pCdMan(nullptr), rootHeight(0), maxCacheSize(DEFAULT_FORK_STATE_CACHE_SIZE << 20), cacheSize(0),
+          accessCount(0), forkedCount(0) {}
+
+    void SetMaxCacheSize(uint64_t maxCacheSizeIn) { maxCacheSize = maxCacheSizeIn; }
+    /** The accounted memory of all the states in bytes. */
+    uint64_t GetCacheSize() const { return cacheSize; }
+    size_t GetSize() const { return mapNodes.size(); }
+    bool IsEmpty() const { return mapNodes.empty(); }
+
+    /** Drop all the states and take the top level caches of the manager as the state at the block. */
+    void SetRoot(CCacheDBManager *pCdManIn, const uint256 &hash, int32_t height);
+    const uint256 &GetRootHash() const { return rootHash; }
+
+    bool Contains(const uint256 &hash) const { return mapNodes.count(hash) > 0; }
+    /** Whether there are states of the blocks connected off the active chain, besides the ones disconnected in it. */
+    bool HasForkedStates() const { return forkedCount > 0; }
+    /** The state at the block, nullptr if not in the tree. The state and its bases are marked as used. */
+    CCacheWrapper *Get(const uint256 &hash);
+
+    /**
+     * A new layer on the state at the base block, the root or one in the tree, to connect or disconnect a block in.
+     * It is added to the tree by Add(), or discarded if the block fails.
+     */
+    std::unique_ptr<CCacheWrapper> CreateLayer(const uint256 &baseHash);
+    /**
+     * Add the state at the block, a layer created on the state at the base block, then evict the least recently
+     * used leaves other than it until under the max cache size.
+     */
+    void Add(const uint256 &hash, int32_t height, const uint256 &baseHash, std::unique_ptr<CCacheWrapper> spCw);
+
+    /**
+     * Move the root to the block connected on it. The state at the old root is the layer created on the root after
+     * the block was connected, with the block disconnected in it.
+     */
+    void MoveRoot(const uint256 &hash, int32_t height, std::unique_ptr<CCacheWrapper> spOldRootCw);
+
+    /** Drop all the states and the root, e.g. before the manager is deleted. */
+    void Clear();
+
+private:
+    struct CForkStateNode {
+        uint256 base_hash;
+        int32_t height          = 0;
+        std::unique_ptr<CCacheWrapper> sp_cw;
+        uint64_t cache_size     = 0;
+        uint64_t last_access    = 0;
+        bool forked             = false;  // connected on its base, otherwise disconnected in the active chain
+        set<uint256> layers;    // the states on this one
+    };
+
+    // the layers on the base, the root or a state in the tree
+    set<uint256> &GetLayers(const uint256 &baseHash);
+    void Touch(const uint256 &hash);
+    // erase the state with the ones on it
+    void Erase(const uint256 &hash);
+    void Evict(const uint256 &keepHash);
+
+private:
+    CCacheDBManager *pCdMan;
+    uint256 rootHash;
+    int32_t rootHeight;
+    set<uint256> rootLayers;
+    map<uint256, CForkStateNode> mapNodes;
+    uint64_t maxCacheSize;
+    uint64_t cacheSize;
+    uint64_t accessCount;
+    uint32_t forkedCount;
+};
+
+extern CForkStateTree forkStates;
+
+#endif  // PERSIST_FORKSTATE_H
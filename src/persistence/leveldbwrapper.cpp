@@ -27,6 +27,49 @@ void ThrowError(const leveldb::Status &status) {
     throw leveldb_error("Unknown database error");
 }
 
+// Serializes the operations of a batch as (put flag, key[, value]) records
+class CBatchJournalWriter : public leveldb::WriteBatch::Handler {
+public:
+    CDataStream ssRecords;
+    uint64_t count;
+
+    CBatchJournalWriter() : ssRecords(SER_DISK, CLIENT_VERSION), count(0) {}
+
+    void Put(const leveldb::Slice &key, const leveldb::Slice &value) {
+        ssRecords << true << key.ToString() << value.ToString();
+        ++count;
+    }
+
+    void Delete(const leveldb::Slice &key) {
+        ssRecords << false << key.ToString();
+        ++count;
+    }
+};
+
+void CLevelDBBatch::WriteJournal(CDataStream &ssJournal) const {
+    CBatchJournalWriter writer;
+    ThrowError(batch.Iterate(&writer));
+    WriteCompactSize(ssJournal, writer.count);
+    if (writer.count > 0)
+        ssJournal.write(&writer.ssRecords[0], writer.ssRecords.size());
+}
+
+void CLevelDBBatch::ReadJournal(CDataStream &ssJournal) {
+    uint64_t count = ReadCompactSize(ssJournal);
+    for (uint64_t i = 0; i < count; ++i) {
+        bool fPut;
+        string key;
+        ssJournal >> fPut >> key;
+        if (fPut) {
+            string value;
+            ssJournal >> value;
+            batch.Put(key, value);
+        } else {
+            batch.Delete(key);
+        }
+    }
+}
+
 std::string CDBOpLogMap::ToString() const {
     std::string str = "";
     for (auto itemOpLogs : mapDbOpLogs) {
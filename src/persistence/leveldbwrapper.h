@@ -142,6 +142,9 @@ public:
         batch.Delete(key);
     }
 
+    // Append the operations of the batch to a journal stream, ReadJournal() restores them
+    void WriteJournal(CDataStream &ssJournal) const;
+    void ReadJournal(CDataStream &ssJournal);
  };
 
 class CLevelDBWrapper {
@@ -172,9 +175,12 @@ public:
     ~CLevelDBWrapper();
 
     template<typename V>
-    bool Read(std::string key, V &value) {
-    	leveldb::Slice slKey(key);
+    bool Read(const std::string &key, V &value) {
+        return Read(leveldb::Slice(key), value);
+    }
 
+    template<typename V>
+    bool Read(const leveldb::Slice &slKey, V &value) {
         string strValue;
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
         if (!status.ok()) {
@@ -200,7 +206,10 @@ public:
     }
 
     bool Exists(const std::string &key) {
-    	leveldb::Slice slKey(key);
+        return Exists(leveldb::Slice(key));
+    }
+
+    bool Exists(const leveldb::Slice &slKey) {
         string strValue;
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
         if (!status.ok()) {
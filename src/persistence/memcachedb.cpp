@@ -0,0 +1,134 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "memcachedb.h"
+#include "commons/random.h"
+#include "commons/util.h"
+#include "config/configuration.h"
+#include "crypto/hash.h"
+#include "pricefeeddb.h"
+#include "txdb.h"
+
+#include <boost/filesystem.hpp>
+
+static const int32_t MEMCACHE_VERSION = 1;
+
+CMemCacheDB::CMemCacheDB() { pathCache = GetDataDir() / "memcache.dat"; }
+
+bool CMemCacheDB::Write(const uint256 &tipHash, int32_t txCacheHeight, int32_t ppCacheHeight,
+                        CTxMemCache &txCache, CPricePointMemCache &ppCache) {
+    string tmpfn = strprintf("memcache.dat.%04x", GetRand(0x10000));
+
+    // serialize the caches, checksum data up to that point, then append csum
+    CDataStream ssCache(SER_DISK, CLIENT_VERSION);
+    ssCache << FLATDATA(SysCfg().MessageStart());
+    ssCache << MEMCACHE_VERSION << tipHash << txCacheHeight << ppCacheHeight;
+
+    const auto &txHashCache = txCache.GetTxHashCache();
+    WriteCompactSize(ssCache, txHashCache.size());
+    for (const auto &item : txHashCache) {
+        ssCache << item.first;
+        WriteCompactSize(ssCache, item.second.size());
+        for (const auto &txid : item.second)
+            ssCache << txid;
+    }
+
+    ssCache << ppCache.GetPricePointCache() << ppCache.GetLatestBlockMedianPricePoints();
+
+    uint256 hash = Hash(ssCache.begin(), ssCache.end());
+    ssCache << hash;
+
+    boost::filesystem::path pathTmp = GetDataDir() / tmpfn;
+    FILE *file                      = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout               = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout.write((const char *)&ssCache[0], ssCache.size());
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, pathCache))
+        return ERRORMSG("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+bool CMemCacheDB::Read(const uint256 &tipHash, int32_t txCacheHeight, int32_t ppCacheHeight,
+                       CTxMemCache &txCache, CPricePointMemCache &ppCache) {
+    if (!boost::filesystem::exists(pathCache))
+        return false;
+
+    FILE *file       = fopen(pathCache.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathCache.string());
+
+    int64_t dataSize = (int64_t)boost::filesystem::file_size(pathCache) - (int64_t)sizeof(uint256);
+    if (dataSize <= 0)
+        return ERRORMSG("%s : Invalid file size", __func__);
+
+    vector<char> vchData(dataSize);
+    uint256 hashIn;
+    try {
+        filein.read(&vchData[0], dataSize);
+        filein >> hashIn;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssCache(vchData, SER_DISK, CLIENT_VERSION);
+    if (hashIn != Hash(ssCache.begin(), ssCache.end()))
+        return ERRORMSG("%s : Checksum mismatch, data corrupted", __func__);
+
+    map<uint256, UnorderedHashSet> txHashCache;
+    CoinPricePointMap pricePointCache;
+    map<CoinPricePair, uint64_t> latestMedianPricePoints;
+    try {
+        unsigned char pchMsgTmp[4];
+        int32_t version;
+        uint256 tipHashIn;
+        int32_t txCacheHeightIn;
+        int32_t ppCacheHeightIn;
+        ssCache >> FLATDATA(pchMsgTmp) >> version >> tipHashIn >> txCacheHeightIn >> ppCacheHeightIn;
+
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)) || version != MEMCACHE_VERSION)
+            return ERRORMSG("%s : Invalid network magic number or version", __func__);
+
+        // the chain moved on since written, e.g. after an unclean shutdown
+        if (tipHashIn != tipHash || txCacheHeightIn != txCacheHeight || ppCacheHeightIn != ppCacheHeight) {
+            LogPrint("INFO", "%s : Outdated snapshot of tip %s\n", __func__, tipHashIn.GetHex());
+            return false;
+        }
+
+        uint64_t blockCount = ReadCompactSize(ssCache);
+        for (uint64_t i = 0; i < blockCount; ++i) {
+            uint256 blockHash;
+            ssCache >> blockHash;
+            auto &txids = txHashCache[blockHash];
+            uint64_t txCount = ReadCompactSize(ssCache);
+            txids.reserve(txCount);
+            for (uint64_t j = 0; j < txCount; ++j) {
+                uint256 txid;
+                ssCache >> txid;
+                txids.insert(txid);
+            }
+        }
+
+        ssCache >> pricePointCache >> latestMedianPricePoints;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    txCache.SetTxHashCache(txHashCache);
+    ppCache.SetPricePointCache(pricePointCache);
+    ppCache.SetLatestBlockMedianPricePoints(latestMedianPricePoints);
+
+    return true;
+}
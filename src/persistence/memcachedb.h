@@ -0,0 +1,32 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_MEMCACHEDB_H
+#define PERSIST_MEMCACHEDB_H
+
+#include "commons/uint256.h"
+
+#include <boost/filesystem/path.hpp>
+
+class CTxMemCache;
+class CPricePointMemCache;
+
+/**
+ * Snapshot of the tx and price point memory caches (memcache.dat), written on clean shutdown and loaded on the
+ * next start instead of replaying the latest blocks. The snapshot is tagged with the tip hash and the cached
+ * heights, and is only loaded if they still match.
+ */
+class CMemCacheDB {
+private:
+    boost::filesystem::path pathCache;
+
+public:
+    CMemCacheDB();
+    bool Write(const uint256 &tipHash, int32_t txCacheHeight, int32_t ppCacheHeight, CTxMemCache &txCache,
+               CPricePointMemCache &ppCache);
+    bool Read(const uint256 &tipHash, int32_t txCacheHeight, int32_t ppCacheHeight, CTxMemCache &txCache,
+              CPricePointMemCache &ppCache);
+};
+
+#endif  // PERSIST_MEMCACHEDB_H
@@ -25,9 +25,65 @@ bool CConsecutiveBlockPrice::ExistBlockUserPrice(const int32_t blockHeight, cons
     return mapBlockUserPrices[blockHeight].count(regId);
 }
 
+void CMedianPriceWindow::AddPrice(const uint64_t price) {
+    if (lower.empty() || price <= *lower.rbegin())
+        lower.insert(price);
+    else
+        upper.insert(price);
+
+    Rebalance();
+}
+
+void CMedianPriceWindow::RemovePrice(const uint64_t price) {
+    auto iter = lower.find(price);
+    if (iter != lower.end()) {
+        lower.erase(iter);
+    } else {
+        iter = upper.find(price);
+        assert(iter != upper.end());
+        upper.erase(iter);
+    }
+
+    Rebalance();
+}
+
+void CMedianPriceWindow::Rebalance() {
+    if (lower.size() > upper.size() + 1) {
+        auto iter = std::prev(lower.end());
+        upper.insert(*iter);
+        lower.erase(iter);
+    } else if (upper.size() > lower.size()) {
+        auto iter = upper.begin();
+        lower.insert(*iter);
+        upper.erase(iter);
+    }
+}
+
+uint64_t CMedianPriceWindow::GetMedian() const {
+    if (lower.empty())
+        return 0;
+
+    return lower.size() > upper.size() ? *lower.rbegin() : (*lower.rbegin() + *upper.begin()) / 2;
+}
+
+void CMedianPriceWindow::SetHeights(const int32_t beginHeightIn, const int32_t endHeightIn) {
+    beginHeight = beginHeightIn;
+    endHeight   = endHeightIn;
+    fBuilt      = true;
+}
+
+void CMedianPriceWindow::Clear() {
+    lower.clear();
+    upper.clear();
+    beginHeight = 0;
+    endHeight   = 0;
+    fBuilt      = false;
+}
+
 void CPricePointMemCache::SetLatestBlockMedianPricePoints(
     const map<CoinPricePair, uint64_t> &latestBlockMedianPricePointsIn) {
-    latestBlockMedianPricePoints = latestBlockMedianPricePointsIn;
+    latestBlockMedianPricePoints    = latestBlockMedianPricePointsIn;
+    hasLatestBlockMedianPricePoints = true;
     string prices;
     for (const auto &item: latestBlockMedianPricePointsIn) {
         prices += strprintf("{%s/%s -> %llu}", std::get<0>(item.first), std::get<1>(item.first), item.second);
@@ -45,8 +101,10 @@ bool CPricePointMemCache::AddBlockPricePointInBatch(const int32_t blockHeight, c
             return false;
         }
 
+        RemoveWindowPrices(pp.GetCoinPricePair(), blockHeight);
         CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[pp.GetCoinPricePair()];
         cbp.AddUserPrice(blockHeight, regId, pp.GetPrice());
+        AddWindowPrices(pp.GetCoinPricePair(), blockHeight);
     }
 
     return true;
@@ -87,13 +145,26 @@ bool CPricePointMemCache::AddBlockToCache(const CBlock &block) {
 }
 
 bool CPricePointMemCache::DeleteBlockPricePoint(const int32_t blockHeight) {
-    for (auto &item : mapCoinPricePointCache) {
-        item.second.DeleteUserPrice(blockHeight);
+    // the pairs of the base layers as well, a new layer holds none of them yet
+    set<CoinPricePair> coinPricePairs;
+    GetCoinPricePairs(coinPricePairs);
+    for (const auto &coinPricePair : coinPricePairs) {
+        RemoveWindowPrices(coinPricePair, blockHeight);
+        mapCoinPricePointCache[coinPricePair].DeleteUserPrice(blockHeight);
+        AddWindowPrices(coinPricePair, blockHeight);
     }
 
     return true;
 }
 
+void CPricePointMemCache::GetCoinPricePairs(set<CoinPricePair> &coinPricePairs) const {
+    for (const auto &item : mapCoinPricePointCache)
+        coinPricePairs.insert(item.first);
+
+    if (pBase != nullptr)
+        pBase->GetCoinPricePairs(coinPricePairs);
+}
+
 bool CPricePointMemCache::DeleteBlockFromCache(const CBlock &block) {
     return DeleteBlockPricePoint(block.GetHeight());
 }
@@ -102,6 +173,7 @@ void CPricePointMemCache::BatchWrite(const CoinPricePointMap &mapCoinPricePointC
     for (const auto &item : mapCoinPricePointCacheIn) {
         const auto &mapBlockUserPrices = item.second.mapBlockUserPrices;
         for (const auto &userPrice : mapBlockUserPrices) {
+            RemoveWindowPrices(item.first, userPrice.first);
             if (userPrice.second.empty()) {
                 mapCoinPricePointCache[item.first /* CoinPricePair */].mapBlockUserPrices.erase(
                     userPrice.first /* height */);
@@ -113,13 +185,42 @@ void CPricePointMemCache::BatchWrite(const CoinPricePointMap &mapCoinPricePointC
                         .emplace(priceItem.first /* CRegID */, priceItem.second /* price */);
                 }
             }
+            AddWindowPrices(item.first, userPrice.first);
         }
     }
 }
 
+const map<CoinPricePair, uint64_t> &CPricePointMemCache::GetLatestBlockMedianPricePoints() const {
+    static const map<CoinPricePair, uint64_t> emptyPricePoints;
+
+    if (hasLatestBlockMedianPricePoints)
+        return latestBlockMedianPricePoints;
+
+    return pBase != nullptr ? pBase->GetLatestBlockMedianPricePoints() : emptyPricePoints;
+}
+
 void CPricePointMemCache::SetBaseViewPtr(CPricePointMemCache *pBaseIn) {
-    pBase                        = pBaseIn;
-    latestBlockMedianPricePoints = pBaseIn->latestBlockMedianPricePoints;
+    // the windows are of the prices read through the old base, the latest median price points are of this layer
+    pBase = pBaseIn;
+    mapMedianPriceWindows.clear();
+}
+
+uint32_t CPricePointMemCache::GetCacheSize() const {
+    static const uint32_t USER_PRICE_SIZE = sizeof(CRegID) + sizeof(uint64_t) + CACHE_NODE_OVERHEAD;
+    static const uint32_t BLOCK_SIZE      = sizeof(int32_t) + sizeof(map<CRegID, uint64_t>) + CACHE_NODE_OVERHEAD;
+    static const uint32_t PAIR_SIZE       = sizeof(CoinPricePair) + CACHE_NODE_OVERHEAD;
+
+    uint32_t size = 0;
+    for (const auto &pairItem : mapCoinPricePointCache) {
+        size += PAIR_SIZE + sizeof(CConsecutiveBlockPrice);
+        for (const auto &blockItem : pairItem.second.mapBlockUserPrices)
+            size += BLOCK_SIZE + blockItem.second.size() * USER_PRICE_SIZE;
+    }
+    for (const auto &windowItem : mapMedianPriceWindows)
+        size += PAIR_SIZE + sizeof(CMedianPriceWindow) +
+                windowItem.second.GetSize() * (sizeof(uint64_t) + CACHE_NODE_OVERHEAD);
+    size += latestBlockMedianPricePoints.size() * (sizeof(CoinPricePair) + sizeof(uint64_t) + CACHE_NODE_OVERHEAD);
+    return size;
 }
 
 void CPricePointMemCache::Flush() {
@@ -127,112 +228,142 @@ void CPricePointMemCache::Flush() {
 
     pBase->BatchWrite(mapCoinPricePointCache);
     mapCoinPricePointCache.clear();
+    mapMedianPriceWindows.clear();
 
-    pBase->latestBlockMedianPricePoints = latestBlockMedianPricePoints;
+    if (hasLatestBlockMedianPricePoints) {
+        pBase->latestBlockMedianPricePoints    = latestBlockMedianPricePoints;
+        pBase->hasLatestBlockMedianPricePoints = true;
+        latestBlockMedianPricePoints.clear();
+        hasLatestBlockMedianPricePoints = false;
+    }
+}
+
+void CPricePointMemCache::Clear() {
+    mapCoinPricePointCache.clear();
+    mapMedianPriceWindows.clear();
     latestBlockMedianPricePoints.clear();
+    hasLatestBlockMedianPricePoints = false;
 }
 
 void CPricePointMemCache::Reset() {
     pBase = nullptr;
+    mapMedianPriceWindows.clear();
     latestBlockMedianPricePoints.clear();
+    hasLatestBlockMedianPricePoints = false;
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair, set<int32_t> &expired,
-                                             BlockUserPriceMap &blockUserPrices) {
+const map<CRegID, uint64_t> *CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair,
+                                                                     const int32_t blockHeight) const {
     const auto &iter = mapCoinPricePointCache.find(coinPricePair);
     if (iter != mapCoinPricePointCache.end()) {
         const auto &mapBlockUserPrices = iter->second.mapBlockUserPrices;
-        for (const auto &item : mapBlockUserPrices) {
-            if (item.second.empty()) {
-                expired.insert(item.first);
-            } else if (expired.count(item.first) || blockUserPrices.count(item.first)) {
-                // TODO: log
-                continue;
-            } else {
-                // Got a valid item.
-                blockUserPrices[item.first] = item.second;
-            }
+        const auto &heightIter         = mapBlockUserPrices.find(blockHeight);
+        if (heightIter != mapBlockUserPrices.end()) {
+            // empty if erased in this layer
+            return heightIter->second.empty() ? nullptr : &heightIter->second;
         }
     }
 
-    if (pBase != nullptr) {
-        return pBase->GetBlockUserPrices(coinPricePair, expired, blockUserPrices);
-    }
-
-    return true;
+    return pBase != nullptr ? pBase->GetBlockUserPrices(coinPricePair, blockHeight) : nullptr;
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair, BlockUserPriceMap &blockUserPrices) {
-    set<int32_t /* block height */> expired;
-    if (!GetBlockUserPrices(coinPricePair, expired, blockUserPrices)) {
-        // TODO: log
+bool CPricePointMemCache::HaveBlockUserPrices(const CoinPricePair &coinPricePair, const int32_t beginHeight,
+                                              const int32_t endHeight) const {
+    const auto &iter = mapCoinPricePointCache.find(coinPricePair);
+    if (iter == mapCoinPricePointCache.end())
         return false;
+
+    const auto &heightIter = iter->second.mapBlockUserPrices.upper_bound(beginHeight);
+    return heightIter != iter->second.mapBlockUserPrices.end() && heightIter->first <= endHeight;
+}
+
+void CPricePointMemCache::RemoveWindowPrices(const CoinPricePair &coinPricePair, const int32_t blockHeight) {
+    auto iter = mapMedianPriceWindows.find(coinPricePair);
+    if (iter != mapMedianPriceWindows.end() && iter->second.Covers(blockHeight))
+        RemoveBlockPrices(coinPricePair, iter->second, blockHeight);
+}
+
+void CPricePointMemCache::AddWindowPrices(const CoinPricePair &coinPricePair, const int32_t blockHeight) {
+    auto iter = mapMedianPriceWindows.find(coinPricePair);
+    if (iter != mapMedianPriceWindows.end() && iter->second.Covers(blockHeight))
+        AddBlockPrices(coinPricePair, iter->second, blockHeight);
+}
+
+void CPricePointMemCache::AddBlockPrices(const CoinPricePair &coinPricePair, CMedianPriceWindow &window,
+                                         const int32_t blockHeight) {
+    const map<CRegID, uint64_t> *pUserPrices = GetBlockUserPrices(coinPricePair, blockHeight);
+    if (pUserPrices != nullptr) {
+        for (const auto &userPrice : *pUserPrices)
+            window.AddPrice(userPrice.second);
     }
+}
 
-    return true;
+void CPricePointMemCache::RemoveBlockPrices(const CoinPricePair &coinPricePair, CMedianPriceWindow &window,
+                                            const int32_t blockHeight) {
+    const map<CRegID, uint64_t> *pUserPrices = GetBlockUserPrices(coinPricePair, blockHeight);
+    if (pUserPrices != nullptr) {
+        for (const auto &userPrice : *pUserPrices)
+            window.RemovePrice(userPrice.second);
+    }
 }
 
-uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                                      const CoinPricePair &coinPricePair) {
-    // 1. merge block user prices with base cache.
-    BlockUserPriceMap blockUserPrices;
-    if (!GetBlockUserPrices(coinPricePair, blockUserPrices) || blockUserPrices.empty()) {
-        return 0;
+const CMedianPriceWindow *CPricePointMemCache::GetMedianPriceWindow(const CoinPricePair &coinPricePair,
+                                                                    const int32_t beginHeight,
+                                                                    const int32_t endHeight) {
+    // A layer changing no price in the window reads the one of its base, only the layers with the prices of the
+    // blocks being connected keep their own.
+    if (pBase != nullptr && !HaveBlockUserPrices(coinPricePair, beginHeight, endHeight)) {
+        mapMedianPriceWindows.erase(coinPricePair);
+        return pBase->GetMedianPriceWindow(coinPricePair, beginHeight, endHeight);
     }
 
-    // 2. compute block median price.
-    return ComputeBlockMedianPrice(blockHeight, slideWindow, blockUserPrices);
+    CMedianPriceWindow &window = mapMedianPriceWindows[coinPricePair];
+    if (!window.IsAt(beginHeight, endHeight))
+        SlideMedianPriceWindow(coinPricePair, window, beginHeight, endHeight);
+
+    return &window;
 }
 
-uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                                      const BlockUserPriceMap &blockUserPrices) {
-    // for (const auto &item : blockUserPrices) {
-    //     string price;
-    //     for (const auto &userPrice : item.second) {
-    //         price += strprintf("{user:%s, price:%lld}", userPrice.first.ToString(), userPrice.second);
-    //     }
-
-    //     LogPrint("PRICEFEED", "CPricePointMemCache::ComputeBlockMedianPrice, height: %d, userPrice: %s\n",
-    //              item.first, price);
-    // }
-
-    vector<uint64_t> prices;
-    int32_t beginBlockHeight = std::max((blockHeight - slideWindow), uint64_t(0));
-    for (int32_t height = blockHeight; height > beginBlockHeight; --height) {
-        const auto &iter = blockUserPrices.find(height);
-        if (iter != blockUserPrices.end()) {
-            for (const auto &userPrice : iter->second) {
-                prices.push_back(userPrice.second);
-            }
-        }
+void CPricePointMemCache::SlideMedianPriceWindow(const CoinPricePair &coinPricePair, CMedianPriceWindow &window,
+                                                 const int32_t beginHeight, const int32_t endHeight) {
+    if (!window.fBuilt || beginHeight >= window.endHeight || window.beginHeight >= endHeight) {
+        // nothing in common, build it over
+        window.Clear();
+        for (int32_t height = beginHeight + 1; height <= endHeight; ++height)
+            AddBlockPrices(coinPricePair, window, height);
+    } else {
+        // the blocks out of the new window are taken out, the ones not in the old window put in
+        for (int32_t height = window.beginHeight + 1; height <= beginHeight; ++height)
+            RemoveBlockPrices(coinPricePair, window, height);
+        for (int32_t height = endHeight + 1; height <= window.endHeight; ++height)
+            RemoveBlockPrices(coinPricePair, window, height);
+        for (int32_t height = beginHeight + 1; height <= window.beginHeight; ++height)
+            AddBlockPrices(coinPricePair, window, height);
+        for (int32_t height = window.endHeight + 1; height <= endHeight; ++height)
+            AddBlockPrices(coinPricePair, window, height);
     }
 
-    // for (const auto &item : prices) {
-    //     LogPrint("PRICEFEED", "CPricePointMemCache::ComputeBlockMedianPrice, found a candidate price: %llu\n", item);
-    // }
+    window.SetHeights(beginHeight, endHeight);
+}
 
-    uint64_t medianPrice = ComputeMedianNumber(prices);
+uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
+                                                      const CoinPricePair &coinPricePair) {
+    const CMedianPriceWindow *pWindow =
+        GetMedianPriceWindow(coinPricePair, blockHeight - (int32_t)slideWindow, blockHeight);
+    uint64_t medianPrice = pWindow->GetMedian();
     LogPrint("PRICEFEED", "CPricePointMemCache::ComputeBlockMedianPrice, computed median number: %llu\n", medianPrice);
 
     return medianPrice;
 }
 
-uint64_t CPricePointMemCache::ComputeMedianNumber(vector<uint64_t> &numbers) {
-    int32_t size = numbers.size();
-    if (size < 2) {
-        return size == 0 ? 0 : numbers[0];
-    }
-    sort(numbers.begin(), numbers.end());
-    return (size % 2 == 0) ? (numbers[size / 2 - 1] + numbers[size / 2]) / 2 : numbers[size / 2];
-}
-
 uint64_t CPricePointMemCache::GetMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
                                              const CoinPricePair &coinPricePair) {
     uint64_t medianPrice = ComputeBlockMedianPrice(blockHeight, slideWindow, coinPricePair);
 
     if (medianPrice == 0) {
-        medianPrice = latestBlockMedianPricePoints.count(coinPricePair) ?
-                    latestBlockMedianPricePoints[coinPricePair] : 0;
+        const auto &latestPricePoints = GetLatestBlockMedianPricePoints();
+        auto iter   = latestPricePoints.find(coinPricePair);
+        medianPrice = iter != latestPricePoints.end() ? iter->second : 0;
 
         LogPrint("PRICEFEED", "CPricePointMemCache::GetMedianPrice, use previous block median price: %s/%s -> %llu\n",
                  std::get<0>(coinPricePair), std::get<1>(coinPricePair), medianPrice);
@@ -13,6 +13,7 @@
 #include "tx/tx.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -23,7 +24,7 @@ class CConsecutiveBlockPrice;
 typedef map<int32_t /* block height */, map<CRegID, uint64_t /* price */>> BlockUserPriceMap;
 typedef map<CoinPricePair, CConsecutiveBlockPrice> CoinPricePointMap;
 
-// Price Points in 11 consecutive blocks
+// Price Points in the consecutive blocks of the median price slide window
 class CConsecutiveBlockPrice {
 public:
     void AddUserPrice(const int32_t blockHeight, const CRegID &regId, const uint64_t price);
@@ -33,19 +34,60 @@ public:
 
 public:
     BlockUserPriceMap mapBlockUserPrices;
+
+    IMPLEMENT_SERIALIZE(READWRITE(mapBlockUserPrices);)
 };
 
-class CPricePointMemCache {
+/**
+ * The prices of the blocks in a slide window (beginHeight, endHeight] of a coin pair, split in a lower and an upper
+ * half, so the median is read in O(1) and a price is added or removed in O(log n) as the window slides.
+ */
+class CMedianPriceWindow {
 public:
-    map<CoinPricePair, uint64_t> latestBlockMedianPricePoints;
+    CMedianPriceWindow() : beginHeight(0), endHeight(0), fBuilt(false) {}
+
+    void AddPrice(const uint64_t price);
+    // the price must be in the window
+    void RemovePrice(const uint64_t price);
+    // 0 for an empty window, the mean of the two middle prices for an even count
+    uint64_t GetMedian() const;
+    size_t GetSize() const { return lower.size() + upper.size(); }
+
+    bool IsAt(const int32_t beginHeightIn, const int32_t endHeightIn) const {
+        return fBuilt && beginHeight == beginHeightIn && endHeight == endHeightIn;
+    }
+    bool Covers(const int32_t height) const { return fBuilt && height > beginHeight && height <= endHeight; }
+    void SetHeights(const int32_t beginHeightIn, const int32_t endHeightIn);
+    void Clear();
+
+public:
+    int32_t beginHeight;  // exclusive
+    int32_t endHeight;    // inclusive
+    bool fBuilt;
+
+private:
+    void Rebalance();
 
+private:
+    multiset<uint64_t> lower;  // the smaller half, one more than the upper half for an odd count
+    multiset<uint64_t> upper;
+};
+
+class CPricePointMemCache {
 public:
     CPricePointMemCache() : pBase(nullptr) {}
-    CPricePointMemCache(CPricePointMemCache *pBaseIn)
-        : latestBlockMedianPricePoints(pBase->latestBlockMedianPricePoints), pBase(pBaseIn) {}
+    CPricePointMemCache(CPricePointMemCache *pBaseIn) : pBase(pBaseIn) {}
 
 public:
     void SetLatestBlockMedianPricePoints(const map<CoinPricePair, uint64_t> &latestBlockMedianPricePoints);
+    // The latest median price points are only held by the layer they were set in, the others read them from base.
+    const map<CoinPricePair, uint64_t> &GetLatestBlockMedianPricePoints() const;
+
+    const CoinPricePointMap &GetPricePointCache() const { return mapCoinPricePointCache; }
+    void SetPricePointCache(const CoinPricePointMap &mapCache) {
+        mapCoinPricePointCache = mapCache;
+        mapMedianPriceWindows.clear();
+    }
     bool AddBlockPricePointInBatch(const int32_t blockHeight, const CRegID &regId, const vector<CPricePoint> &pps);
     bool AddBlockToCache(const CBlock &block);
     // delete block price point by specific block height.
@@ -58,24 +100,44 @@ public:
 
     void SetBaseViewPtr(CPricePointMemCache *pBaseIn);
     void Flush();
+    // The memory of the price points and the median windows of this layer.
+    uint32_t GetCacheSize() const;
+    // Discard the price points and the latest median price points of this layer.
+    void Clear();
     void Reset();
 
 private:
     bool ExistBlockUserPrice(const int32_t blockHeight, const CRegID &regId, const CoinPricePair &coinPricePair);
 
     void BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn);
-
-    bool GetBlockUserPrices(const CoinPricePair &coinPricePair, set<int32_t> &expired, BlockUserPriceMap &blockUserPrices);
-    bool GetBlockUserPrices(const CoinPricePair &coinPricePair, BlockUserPriceMap &blockUserPrices);
+    void GetCoinPricePairs(set<CoinPricePair> &coinPricePairs) const;
+
+    // The prices of the block, from the top layer holding the block, nullptr if none or erased.
+    const map<CRegID, uint64_t> *GetBlockUserPrices(const CoinPricePair &coinPricePair, const int32_t blockHeight) const;
+    bool HaveBlockUserPrices(const CoinPricePair &coinPricePair, const int32_t beginHeight,
+                             const int32_t endHeight) const;
+
+    // Keep the median window of the pair, if any, in step with a change of the prices of the block: the prices are
+    // taken out of the window before the change and put back after it.
+    void RemoveWindowPrices(const CoinPricePair &coinPricePair, const int32_t blockHeight);
+    void AddWindowPrices(const CoinPricePair &coinPricePair, const int32_t blockHeight);
+
+    // The window of the layer changing prices in it, or else of the base, slid to (beginHeight, endHeight].
+    const CMedianPriceWindow *GetMedianPriceWindow(const CoinPricePair &coinPricePair, const int32_t beginHeight,
+                                                   const int32_t endHeight);
+    void SlideMedianPriceWindow(const CoinPricePair &coinPricePair, CMedianPriceWindow &window,
+                                const int32_t beginHeight, const int32_t endHeight);
+    void AddBlockPrices(const CoinPricePair &coinPricePair, CMedianPriceWindow &window, const int32_t blockHeight);
+    void RemoveBlockPrices(const CoinPricePair &coinPricePair, CMedianPriceWindow &window, const int32_t blockHeight);
 
     uint64_t ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
                                      const CoinPricePair &coinPricePair);
-    uint64_t ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                     const BlockUserPriceMap &blockUserPrices);
-    static uint64_t ComputeMedianNumber(vector<uint64_t> &numbers);
 
 private:
     CoinPricePointMap mapCoinPricePointCache;  // coinPriceType -> consecutiveBlockPrice
+    map<CoinPricePair, CMedianPriceWindow> mapMedianPriceWindows;  // of the pairs read from this layer, see above
+    map<CoinPricePair, uint64_t> latestBlockMedianPricePoints;
+    bool hasLatestBlockMedianPricePoints = false;
     CPricePointMemCache *pBase;
 };
 
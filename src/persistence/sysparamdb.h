@@ -37,6 +37,7 @@ public:
         sysParamCache.Flush();
         return true;
     }
+    void Clear() { sysParamCache.Clear(); }
     uint32_t GetCacheSize() const { return sysParamCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CSysParamDBCache *pBaseIn) {
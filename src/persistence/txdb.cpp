@@ -14,8 +14,10 @@
 
 #include <algorithm>
 
-bool CTxMemCache::IsContainBlock(const CBlock &block) {
-    return mapBlockTxHashSet.count(block.GetHash()) || (pBase ? pBase->IsContainBlock(block) : false);
+bool CTxMemCache::IsContainBlock(const CBlock &block) { return IsContainBlock(block.GetHash()); }
+
+bool CTxMemCache::IsContainBlock(const uint256 &blockHash) {
+    return mapBlockTxHashSet.count(blockHash) || (pBase ? pBase->IsContainBlock(blockHash) : false);
 }
 
 bool CTxMemCache::AddBlockToCache(const CBlock &block) {
@@ -23,15 +25,17 @@ bool CTxMemCache::AddBlockToCache(const CBlock &block) {
     for (auto &ptx : block.vptx) {
         txids.insert(ptx->GetHash());
     }
-    mapBlockTxHashSet[block.GetHash()] = txids;
+    SetBlockTxHashSet(block.GetHash(), txids);
 
     return true;
 }
 
-bool CTxMemCache::DeleteBlockFromCache(const CBlock &block) {
-    if (IsContainBlock(block)) {
+bool CTxMemCache::DeleteBlockFromCache(const CBlock &block) { return DeleteBlockFromCache(block.GetHash()); }
+
+bool CTxMemCache::DeleteBlockFromCache(const uint256 &blockHash) {
+    if (IsContainBlock(blockHash)) {
         UnorderedHashSet txids;
-		mapBlockTxHashSet[block.GetHash()] = txids;
+        SetBlockTxHashSet(blockHash, txids);
     }
 
     // On starting node, the memory cache is empty, thus, can not find the
@@ -52,10 +56,9 @@ bool CTxMemCache::HaveBlock(const uint256 &blockHash) const {
 }
 
 uint256 CTxMemCache::HaveTx(const uint256 &txid) {
-    for (auto &item : mapBlockTxHashSet) {
-        if (item.second.find(txid) != item.second.end()) {
-            return item.first;
-        }
+    auto it = mapTxHashIndex.find(txid);
+    if (it != mapTxHashIndex.end()) {
+        return setDupTxHash.count(txid) ? FindTxInBlocks(txid) : it->second;
     }
 
     if (pBase == nullptr) {
@@ -70,13 +73,81 @@ uint256 CTxMemCache::HaveTx(const uint256 &txid) {
     return uint256();
 }
 
+uint256 CTxMemCache::FindTxInBlocks(const uint256 &txid) const {
+    for (auto &item : mapBlockTxHashSet) {
+        if (item.second.find(txid) != item.second.end()) {
+            return item.first;
+        }
+    }
+
+    return uint256();
+}
+
+void CTxMemCache::SetBlockTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids) {
+    auto it = mapBlockTxHashSet.find(blockHash);
+    if (it != mapBlockTxHashSet.end()) {
+        UnindexTxHashSet(blockHash, it->second);
+        it->second = txids;
+    } else {
+        mapBlockTxHashSet.emplace(blockHash, txids);
+    }
+
+    IndexTxHashSet(blockHash, txids);
+}
+
+void CTxMemCache::IndexTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids) {
+    for (const auto &txid : txids) {
+        auto ret = mapTxHashIndex.emplace(txid, blockHash);
+        if (!ret.second && ret.first->second != blockHash) {
+            setDupTxHash.insert(txid);
+        }
+    }
+}
+
+void CTxMemCache::UnindexTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids) {
+    for (const auto &txid : txids) {
+        auto it = mapTxHashIndex.find(txid);
+        if (it == mapTxHashIndex.end() || it->second != blockHash)
+            continue;
+
+        if (setDupTxHash.count(txid)) {
+            // point to another block still containing it, mapBlockTxHashSet[blockHash] is about to be replaced
+            uint256 otherBlockHash;
+            for (auto &item : mapBlockTxHashSet) {
+                if (item.first != blockHash && item.second.count(txid)) {
+                    otherBlockHash = item.first;
+                    break;
+                }
+            }
+            if (!otherBlockHash.IsNull()) {
+                it->second = otherBlockHash;
+                continue;
+            }
+            setDupTxHash.erase(txid);
+        }
+        mapTxHashIndex.erase(it);
+    }
+}
+
+void CTxMemCache::RebuildTxHashIndex() {
+    mapTxHashIndex.clear();
+    setDupTxHash.clear();
+    for (const auto &item : mapBlockTxHashSet) {
+        IndexTxHashSet(item.first, item.second);
+    }
+}
+
 void CTxMemCache::BatchWrite(const map<uint256, UnorderedHashSet> &mapBlockTxHashSetIn) {
     // If the value is empty, delete it from cache.
     for (const auto &item : mapBlockTxHashSetIn) {
         if (item.second.empty()) {
-            mapBlockTxHashSet.erase(item.first);
+            auto it = mapBlockTxHashSet.find(item.first);
+            if (it != mapBlockTxHashSet.end()) {
+                UnindexTxHashSet(it->first, it->second);
+                mapBlockTxHashSet.erase(it);
+            }
         } else {
-            mapBlockTxHashSet[item.first] = item.second;
+            SetBlockTxHashSet(item.first, item.second);
         }
     }
 }
@@ -85,13 +156,29 @@ void CTxMemCache::Flush() {
     assert(pBase);
 
     pBase->BatchWrite(mapBlockTxHashSet);
-    mapBlockTxHashSet.clear();
+    Clear();
 }
 
-void CTxMemCache::Clear() { mapBlockTxHashSet.clear(); }
+void CTxMemCache::Clear() {
+    mapBlockTxHashSet.clear();
+    mapTxHashIndex.clear();
+    setDupTxHash.clear();
+}
 
 uint64_t CTxMemCache::GetSize() { return mapBlockTxHashSet.size(); }
 
+uint32_t CTxMemCache::GetCacheSize() const {
+    // a tx hash is in the set of its block and in the index, each a node of a hash table with a bucket
+    static const uint32_t TX_HASH_SET_SIZE   = sizeof(uint256) + sizeof(void *) + CACHE_NODE_OVERHEAD;
+    static const uint32_t TX_HASH_INDEX_SIZE = 2 * sizeof(uint256) + sizeof(void *) + CACHE_NODE_OVERHEAD;
+
+    uint32_t size = 0;
+    for (const auto &item : mapBlockTxHashSet)
+        size += sizeof(uint256) + sizeof(UnorderedHashSet) + CACHE_NODE_OVERHEAD + item.second.size() * TX_HASH_SET_SIZE;
+    size += mapTxHashIndex.size() * TX_HASH_INDEX_SIZE + setDupTxHash.size() * TX_HASH_SET_SIZE;
+    return size;
+}
+
 Object CTxMemCache::ToJsonObj() const {
     Array txArray;
     for (auto &item : mapBlockTxHashSet) {
@@ -117,6 +204,7 @@ const map<uint256, UnorderedHashSet> &CTxMemCache::GetTxHashCache() { return map
 
 void CTxMemCache::SetTxHashCache(const map<uint256, UnorderedHashSet> &mapCache) {
     mapBlockTxHashSet = mapCache;
+    RebuildTxHashIndex();
 }
 
 string CTxUndo::ToString() const {
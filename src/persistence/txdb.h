@@ -14,6 +14,7 @@
 #include "json/json_spirit_value.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
@@ -30,9 +31,11 @@ public:
 public:
     uint256 HaveTx(const uint256 &txid);
     bool IsContainBlock(const CBlock &block);
+    bool IsContainBlock(const uint256 &blockHash);
 
     bool AddBlockToCache(const CBlock &block);
     bool DeleteBlockFromCache(const CBlock &block);
+    bool DeleteBlockFromCache(const uint256 &blockHash);
 
     void Clear();
     void SetBaseViewPtr(CTxMemCache *pBaseIn) { pBase = pBaseIn; }
@@ -40,6 +43,8 @@ public:
 
     Object ToJsonObj() const;
     uint64_t GetSize();
+    // the memory of the tx hashes of this layer, with their index
+    uint32_t GetCacheSize() const;
 
     const map<uint256, UnorderedHashSet> &GetTxHashCache();
     void SetTxHashCache(const map<uint256, UnorderedHashSet> &mapCache);
@@ -47,9 +52,19 @@ public:
 private:
     bool HaveBlock(const uint256 &blockHash) const;
     void BatchWrite(const map<uint256, UnorderedHashSet> &mapBlockTxHashSetIn);
+    void SetBlockTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids);
+
+    uint256 FindTxInBlocks(const uint256 &txid) const;
+    void IndexTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids);
+    void UnindexTxHashSet(const uint256 &blockHash, const UnorderedHashSet &txids);
+    void RebuildTxHashIndex();
 
 private:
-    map<uint256, UnorderedHashSet> mapBlockTxHashSet;  // map: BlockHash -> TxHashSet
+    map<uint256, UnorderedHashSet> mapBlockTxHashSet;  // map: BlockHash -> TxHashSet, empty set as deleted
+    // index of the tx hashes in mapBlockTxHashSet of this layer, map: TxHash -> BlockHash
+    unordered_map<uint256, uint256, CUint256Hasher> mapTxHashIndex;
+    // tx hashes which appear in more than one block of this layer, looked up by scanning the blocks
+    UnorderedHashSet setDupTxHash;
     CTxMemCache *pBase;
 };
 
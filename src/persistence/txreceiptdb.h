@@ -30,6 +30,8 @@ public:
     bool GetTxReceipts(const TxID &txid, vector<CReceipt> &receipts);
 
     void Flush();
+    void Clear() { txReceiptCache.Clear(); }
+    uint32_t GetCacheSize() const { return txReceiptCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CTxReceiptDBCache *pBaseIn) { txReceiptCache.SetBase(&pBaseIn->txReceiptCache); }
 
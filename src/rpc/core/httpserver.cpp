@@ -599,6 +599,21 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply) {
     req       = nullptr;  // transferred back to main thread
 }
 
+/** Written from the worker thread into the output buffer, which WriteReply() sends along. */
+void HTTPRequest::WriteReplyData(const char* data, size_t size) {
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, data, size);
+}
+
+void HTTPRequest::ClearReplyData() {
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_drain(evb, evbuffer_get_length(evb));
+}
+
 CService HTTPRequest::GetPeer() const {
     evhttp_connection* con = evhttp_request_get_connection(req);
     CService peer;
@@ -114,6 +114,15 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Append to the body of the reply, sent by the WriteReply() to come.
+     * This lets a large reply be written in chunks rather than built as one string.
+     */
+    void WriteReplyData(const char* data, size_t size);
+
+    /** Drop the body written by WriteReplyData(), e.g. to reply an error instead. */
+    void ClearReplyData();
 };
 
 /** Event handler closure.
@@ -0,0 +1,147 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "jsonwriter.h"
+
+#include "json/json_spirit_writer_template.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+CJsonWriter::CJsonWriter(const Sink &sinkIn, size_t nBufferSizeIn)
+    : sink(sinkIn), nBufferSize(nBufferSizeIn), fAfterKey(false), nWritten(0) {
+    buffer.reserve(nBufferSize);
+}
+
+CJsonWriter &CJsonWriter::BeginObject() {
+    BeginValue();
+    Append('{');
+    vFirstInScope.push_back(true);
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::EndObject() {
+    assert(!vFirstInScope.empty() && !fAfterKey);
+    vFirstInScope.pop_back();
+    Append('}');
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::BeginArray() {
+    BeginValue();
+    Append('[');
+    vFirstInScope.push_back(true);
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::EndArray() {
+    assert(!vFirstInScope.empty() && !fAfterKey);
+    vFirstInScope.pop_back();
+    Append(']');
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Key(const std::string &key) {
+    String(key);
+    Append(':');
+    fAfterKey = true;
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::String(const std::string &str) {
+    BeginValue();
+    Append('"');
+    Append(json_spirit::add_esc_chars(str));
+    Append('"');
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Int(int64_t value) {
+    BeginValue();
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%" PRId64, value);
+    Append(buf, len);
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::UInt(uint64_t value) {
+    BeginValue();
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    Append(buf, len);
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Real(double value) {
+    // the fixed notation with 8 decimals of the json_spirit writer
+    BeginValue();
+    char buf[352];
+    int len = snprintf(buf, sizeof(buf), "%.8f", value);
+    Append(buf, std::min((size_t)len, sizeof(buf) - 1));
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Bool(bool value) {
+    BeginValue();
+    Append(value ? "true" : "false");
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Null() {
+    BeginValue();
+    Append("null");
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Write(const json_spirit::Value &value) {
+    BeginValue();
+    Append(json_spirit::write_string(value, false));
+    return *this;
+}
+
+CJsonWriter &CJsonWriter::Raw(const std::string &text) {
+    Append(text);
+    return *this;
+}
+
+void CJsonWriter::Flush() {
+    if (!buffer.empty()) {
+        sink(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+void CJsonWriter::BeginValue() {
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vFirstInScope.empty()) {
+        if (!vFirstInScope.back())
+            Append(',');
+        vFirstInScope.back() = false;
+    }
+}
+
+void CJsonWriter::Append(const char *data, size_t size) {
+    nWritten += size;
+    if (buffer.size() + size > nBufferSize) {
+        Flush();
+        // too large for the buffer, pass it through
+        if (size > nBufferSize) {
+            sink(data, size);
+            return;
+        }
+    }
+    buffer.append(data, size);
+}
+
+void CJsonWriter::Append(char c) {
+    nWritten += 1;
+    if (buffer.size() + 1 > nBufferSize)
+        Flush();
+    buffer.push_back(c);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_RPC_JSONWRITER_H
+#define COIN_RPC_JSONWRITER_H
+
+#include "json/json_spirit_value.h"
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// the bytes collected before handing them to the sink
+static const size_t DEFAULT_JSON_WRITER_BUFFER_SIZE = 64 * 1024;
+
+/**
+ * Write JSON text on the fly, for the rpc results too large to be built as a json_spirit::Value first. The output is
+ * the same as write_string(value, false) of the equivalent value, and is handed to the sink in chunks of the buffer
+ * size. The commas are inserted by the writer, the caller only opens, fills and closes the containers in order.
+ *
+ * The buffered bytes not flushed are dropped with the writer, so a result failing halfway never reaches the sink
+ * beyond the chunks flushed already.
+ */
+class CJsonWriter {
+public:
+    typedef std::function<void(const char *data, size_t size)> Sink;
+
+public:
+    explicit CJsonWriter(const Sink &sinkIn, size_t nBufferSizeIn = DEFAULT_JSON_WRITER_BUFFER_SIZE);
+
+    CJsonWriter &BeginObject();
+    CJsonWriter &EndObject();
+    CJsonWriter &BeginArray();
+    CJsonWriter &EndArray();
+    /** The key of the next value, inside an object. */
+    CJsonWriter &Key(const std::string &key);
+
+    CJsonWriter &String(const std::string &str);
+    CJsonWriter &Int(int64_t value);
+    CJsonWriter &UInt(uint64_t value);
+    CJsonWriter &Real(double value);
+    CJsonWriter &Bool(bool value);
+    CJsonWriter &Null();
+    /** A value built as a tree, for the small parts of a streamed result. */
+    CJsonWriter &Write(const json_spirit::Value &value);
+
+    /** Text written as is, out of the containers, e.g. the trailing newline of a reply. */
+    CJsonWriter &Raw(const std::string &text);
+    void Flush();
+
+    /** The bytes written so far, flushed or not. */
+    uint64_t GetWrittenSize() const { return nWritten; }
+
+private:
+    void BeginValue();
+    void Append(const char *data, size_t size);
+    void Append(const std::string &str) { Append(str.data(), str.size()); }
+    void Append(char c);
+
+private:
+    Sink sink;
+    size_t nBufferSize;
+    std::string buffer;
+    std::vector<bool> vFirstInScope;  // whether nothing is written yet in the open containers
+    bool fAfterKey;
+    uint64_t nWritten;
+};
+
+#endif  // COIN_RPC_JSONWRITER_H
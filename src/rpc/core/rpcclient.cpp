@@ -155,6 +155,7 @@ Array RPCConvertValues(const string &strMethod, const vector<string> &strParams)
     if (strMethod == "submitcontractcalltx"         && n > 5) ConvertTo<int32_t>(params[5]);
 
     if (strMethod == "submituniversalcontractdeploytx"  && n > 3) ConvertTo<int32_t>(params[3]);
+    if (strMethod == "submituniversalcontractdeploytx"  && n > 5) ConvertTo<int32_t>(params[5]);
 
     if (strMethod == "submituniversalcontractcalltx"    && n > 5) ConvertTo<int32_t>(params[5]);
 
@@ -171,10 +172,12 @@ Array RPCConvertValues(const string &strMethod, const vector<string> &strParams)
 
     /********************************************************************************************************************/
     if (strMethod == "getcontractdata"        && n > 2) ConvertTo<bool>(params[2]);
+    if (strMethod == "getaddresstxs"          && n > 1) ConvertTo<int64_t>(params[1]);
 
     if (strMethod == "listtx"                 && n > 0) ConvertTo<int32_t>(params[0]);
     if (strMethod == "listtx"                 && n > 1) ConvertTo<int32_t>(params[1]);
     if (strMethod == "listdelegates"          && n > 0) ConvertTo<int32_t>(params[0]);
+    if (strMethod == "listcdpstoliquidate"    && n > 0) ConvertTo<int64_t>(params[0]);
 
     if (strMethod == "invalidateblock"        && n > 0) { if (params[0].get_str().size() < 32) ConvertTo<int32_t>(params[0]); }
 
@@ -200,6 +203,12 @@ Array RPCConvertValues(const string &strMethod, const vector<string> &strParams)
     if (strMethod == "getdexorders"              && n > 1) ConvertTo<int64_t>(params[1]);
     if (strMethod == "getdexorders"              && n > 2) ConvertTo<int64_t>(params[2]);
 
+    if (strMethod == "getdexbookdepth"           && n > 2) ConvertTo<int64_t>(params[2]);
+    if (strMethod == "getdexbookdepth"           && n > 3) ConvertTo<bool>(params[3]);
+
+    if (strMethod == "getdexbookchanges"         && n > 0) ConvertTo<int64_t>(params[0]);
+    if (strMethod == "getdexbookchanges"         && n > 2) ConvertTo<int64_t>(params[2]);
+
     if (strMethod == "startcommontpstest"       && n > 0)    ConvertTo<int64_t>(params[0]);
     if (strMethod == "startcommontpstest"       && n > 1)    ConvertTo<int64_t>(params[1]);
     if (strMethod == "startcontracttpstest"     && n > 1)    ConvertTo<int64_t>(params[1]);
@@ -155,6 +155,7 @@ vector<unsigned char> ParseHexO(const Object& o, string strKey) {
 string CRPCTable::help(string strCommand) const {
     string strRet;
     set<rpcfn_type> setDone;
+    set<rpcstreamfn_type> setStreamDone;
     for (map<string, const CRPCCommand*>::const_iterator mi = mapCommands.begin();
          mi != mapCommands.end(); ++mi) {
         const CRPCCommand* pcmd = mi->second;
@@ -169,9 +170,16 @@ string CRPCTable::help(string strCommand) const {
             continue;
         try {
             Array params;
-            rpcfn_type pfn = pcmd->actor;
-            if (setDone.insert(pfn).second)
-                (*pfn)(params, true);
+            if (pcmd->actor) {
+                rpcfn_type pfn = pcmd->actor;
+                if (setDone.insert(pfn).second)
+                    (*pfn)(params, true);
+            } else {
+                rpcstreamfn_type pfn = pcmd->streamActor;
+                CJsonWriter writer([](const char*, size_t) {});
+                if (setStreamDone.insert(pfn).second)
+                    (*pfn)(params, true, writer);
+            }
         } catch (std::exception& e) {
             // Help text is returned in an exception
             string strHelp = string(e.what());
@@ -221,8 +229,8 @@ Value stop(const Array& params, bool fHelp) {
 //
 
 static const CRPCCommand vRPCCommands[] =
-{ //  name                      actor (function)         okSafeMode threadSafe reqWallet
-  //  ------------------------  -----------------------  ---------- ---------- ---------
+{ //  name                      actor (function)         okSafeMode threadSafe reqWallet streamActor
+  //  ------------------------  -----------------------  ---------- ---------- --------- -----------
     /* Overall control/query calls */
     { "help",                   &help,                   true,      true,       false },
     { "getinfo",                &getinfo,                true,      false,      false }, /* uses wallet if enabled */
@@ -242,8 +250,10 @@ static const CRPCCommand vRPCCommands[] =
 
     /* Block chain and UTXO */
     { "getblockcount",          &getblockcount,          true,      true,       false },
-    { "getblock",               &getblock,               false,     false,      false },
-    { "getrawmempool",          &getrawmempool,          true,      false,      false },
+    { "getblock",               nullptr,                 false,     false,      false,    &getblock },
+    { "getrawmempool",          nullptr,                 true,      false,      false,    &getrawmempool },
+    { "getmempoolinfo",         &getmempoolinfo,         true,      false,      false },
+    { "gettxadmissioninfo",     &gettxadmissioninfo,     true,      false,      false },
     { "verifychain",            &verifychain,            true,      false,      false },
 
     { "gettotalcoins",          &gettotalcoins,          false,     false,      false },
@@ -283,7 +293,8 @@ static const CRPCCommand vRPCCommands[] =
     { "listcontracts",          &listcontracts,          true,      false,      true },
     { "getcontractinfo",        &getcontractinfo,        true,      false,      true },
     { "listtxcache",            &listtxcache,            true,      false,      true },
-    { "getcontractdata",        &getcontractdata,        true,      false,      true },
+    { "getcontractdata",        nullptr,                 true,      false,      true,     &getcontractdata },
+    { "getaddresstxs",          &getaddresstxs,          true,      false,      false },
     { "signmessage",            &signmessage,            false,     false,      true },
     { "verifymessage",          &verifymessage,          false,     false,      false },
     { "getcoinunitinfo",        &getcoinunitinfo,        false,     false,      false},
@@ -293,7 +304,7 @@ static const CRPCCommand vRPCCommands[] =
     { "signtxraw",              &signtxraw,              true,      false,      true },
     { "getcontractaccountinfo", &getcontractaccountinfo, true,      false,      true },
     { "getsignature",           &getsignature,           true,      false,      true },
-    { "listdelegates",          &listdelegates,          true,      false,      true },
+    { "listdelegates",          nullptr,                 true,      false,      true,     &listdelegates },
     { "decodetxraw",            &decodetxraw,            false,     false,      false},
     { "decodemulsigscript",     &decodemulsigscript,     false,     false,      false },
 
@@ -319,6 +330,7 @@ static const CRPCCommand vRPCCommands[] =
     { "getscoininfo",           &getscoininfo,          false,     false,      false },
     { "getcdp",                 &getcdp,                false,     false,      false },
     { "getusercdp",             &getusercdp,            false,     false,      false },
+    { "listcdpstoliquidate",    nullptr,                false,     false,      false,    &listcdpstoliquidate },
 
     /* for dex */
     { "submitdexbuylimitordertx",   &submitdexbuylimitordertx,   true,     false,      false },
@@ -331,6 +343,9 @@ static const CRPCCommand vRPCCommands[] =
     { "getdexorder",                &getdexorder,                true,     false,      false },
     { "getdexsysorders",            &getdexsysorders,            true,     false,      false },
     { "getdexorders",               &getdexorders,               true,     false,      false },
+    { "getdexbooktop",              &getdexbooktop,              true,     false,      false },
+    { "getdexbookdepth",            &getdexbookdepth,            true,     false,      false },
+    { "getdexbookchanges",          &getdexbookchanges,          true,     false,      false },
 
     /* for asset */
     { "submitassetissuetx",         &submitassetissuetx,         true,     false,      false },
@@ -396,6 +411,8 @@ static void ErrorReply(HTTPRequest* req, const json_spirit::Object& objError,
             nStatus = HTTP_NOT_FOUND;
     }
     std::string strReply = JSONRPCReply(Value::null, objError, id);
+    // drop the partial result of a streamed command
+    req->ClearReplyData();
     req->WriteHeader("Content-Type", "application/json");
     req->WriteReply(nStatus, strReply);
 }
@@ -555,8 +572,18 @@ string JSONRPCExecBatch(const Array& vReq) {
     return write_string(Value(ret), false) + "\n";
 }
 
-json_spirit::Value CRPCTable::execute(const string& strMethod,
-                                      const json_spirit::Array& params) const {
+void JSONRPCStreamReply(const string& method, const Array& params, const Value& id, CJsonWriter& writer) {
+    writer.BeginObject();
+    writer.Key("result");
+    tableRPC.executeStream(method, params, writer);
+    writer.Key("error").Null();
+    writer.Key("id").Write(id);
+    writer.EndObject();
+    writer.Raw("\n");
+    writer.Flush();
+}
+
+const CRPCCommand* CRPCTable::getCommand(const string& strMethod) const {
     // Find method
     const CRPCCommand* pcmd = tableRPC[strMethod];
     if (!pcmd) throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
@@ -569,27 +596,62 @@ json_spirit::Value CRPCTable::execute(const string& strMethod,
     if (strWarning != "" && !SysCfg().GetBoolArg("-disablesafemode", false) && !pcmd->okSafeMode)
         throw JSONRPCError(RPC_FORBIDDEN_BY_SAFE_MODE, string("Safe mode: ") + strWarning);
 
+    return pcmd;
+}
+
+template <typename Func>
+static void RunCommand(const CRPCCommand* pcmd, Func func) {
     try {
-        // Execute
-        Value result;
-        {
-            if (pcmd->threadSafe)
-                result = pcmd->actor(params, false);
-            else if (!pWalletMain) {
-                LOCK(cs_main);
-                result = pcmd->actor(params, false);
-            } else {
-                LOCK2(cs_main, pWalletMain->cs_wallet);
-                result = pcmd->actor(params, false);
-            }
+        if (pcmd->threadSafe)
+            func();
+        else if (!pWalletMain) {
+            LOCK(cs_main);
+            func();
+        } else {
+            LOCK2(cs_main, pWalletMain->cs_wallet);
+            func();
         }
-
-        return result;
     } catch (std::exception& e) {
         throw JSONRPCError(RPC_MISC_ERROR, e.what());
     }
 }
 
+json_spirit::Value CRPCTable::execute(const string& strMethod,
+                                      const json_spirit::Array& params) const {
+    const CRPCCommand* pcmd = getCommand(strMethod);
+
+    // Execute
+    Value result;
+    RunCommand(pcmd, [&]() {
+        if (pcmd->actor) {
+            result = pcmd->actor(params, false);
+            return;
+        }
+
+        // a streamed command in a batch request, read the result back to a tree
+        string strResult;
+        CJsonWriter writer([&strResult](const char* data, size_t size) { strResult.append(data, size); });
+        pcmd->streamActor(params, false, writer);
+        writer.Flush();
+        if (!read_string(strResult, result))
+            throw runtime_error("invalid result of " + strMethod);
+    });
+
+    return result;
+}
+
+void CRPCTable::executeStream(const string& strMethod, const json_spirit::Array& params,
+                              CJsonWriter& writer) const {
+    const CRPCCommand* pcmd = getCommand(strMethod);
+
+    RunCommand(pcmd, [&]() {
+        if (pcmd->streamActor)
+            pcmd->streamActor(params, false, writer);
+        else
+            writer.Write(pcmd->actor(params, false));
+    });
+}
+
 string HelpExampleCli(string methodname, string args) {
     return "> ./coind " + methodname + " " + args + "\n";
 }
@@ -648,10 +710,9 @@ static bool JsonRPCHandler(HTTPRequest* req, const std::string&) {
         if (valRequest.type() == obj_type) {
             jreq.parse(valRequest);
 
-            Value result = tableRPC.execute(jreq.strMethod, jreq.params);
-
-            // Send reply
-            strReply = JSONRPCReply(result, Value::null, jreq.id);
+            // Write the reply into the output buffer of the request as the result goes
+            CJsonWriter writer([req](const char* data, size_t size) { req->WriteReplyData(data, size); });
+            JSONRPCStreamReply(jreq.strMethod, jreq.params, jreq.id, writer);
 
             // array of requests
         } else if (valRequest.type() == array_type)
@@ -7,6 +7,7 @@
 #define _COINRPC_SERVER_H_
 
 #include "rpcprotocol.h"
+#include "jsonwriter.h"
 #include "commons/uint256.h"
 
 #include <stdint.h>
@@ -52,14 +53,17 @@ void RPCTypeCheck(const json_spirit::Object& o,
 void RPCRunLater(const std::string& name, std::function<void()> func, int64_t nSeconds);
 
 typedef json_spirit::Value (*rpcfn_type)(const json_spirit::Array& params, bool fHelp);
+/** A command writing its result to the writer as it goes, instead of returning it as a tree. */
+typedef void (*rpcstreamfn_type)(const json_spirit::Array& params, bool fHelp, CJsonWriter& writer);
 
 class CRPCCommand {
 public:
     string name;
-    rpcfn_type actor;
+    rpcfn_type actor;  // nullptr for a streamed command
     bool okSafeMode;
     bool threadSafe;
     bool reqWallet;
+    rpcstreamfn_type streamActor;
 };
 
 /**
@@ -82,6 +86,15 @@ public:
      * @throws an exception (json_spirit::Value) when an error happens.
      */
     json_spirit::Value execute(const string& method, const json_spirit::Array& params) const;
+
+    /**
+     * Execute a method, writing the result to the writer. A streamed command never builds the result as a tree.
+     * @throws an exception (json_spirit::Value) when an error happens, the writer is left with a partial result.
+     */
+    void executeStream(const string& method, const json_spirit::Array& params, CJsonWriter& writer) const;
+
+private:
+    const CRPCCommand* getCommand(const string& method) const;
 };
 
 extern const CRPCTable tableRPC;
@@ -157,8 +170,10 @@ extern json_spirit::Value decodemulsigscript(const json_spirit::Array& params, b
 
 extern json_spirit::Value getblockcount(const json_spirit::Array& params, bool fHelp); // in rpcblockchain.cpp
 extern json_spirit::Value getdifficulty(const json_spirit::Array& params, bool fHelp);
-extern json_spirit::Value getrawmempool(const json_spirit::Array& params, bool fHelp);
-extern json_spirit::Value getblock(const json_spirit::Array& params, bool fHelp);
+extern void getrawmempool(const json_spirit::Array& params, bool fHelp, CJsonWriter& writer);
+extern json_spirit::Value getmempoolinfo(const json_spirit::Array& params, bool fHelp);
+extern json_spirit::Value gettxadmissioninfo(const json_spirit::Array& params, bool fHelp);
+extern void getblock(const json_spirit::Array& params, bool fHelp, CJsonWriter& writer);
 extern json_spirit::Value verifychain(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getcontractregid(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value invalidateblock(const json_spirit::Array& params, bool fHelp);
@@ -179,6 +194,9 @@ extern json_spirit::Value submitdexsettletx(const json_spirit::Array& params, bo
 extern json_spirit::Value getdexorder(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getdexsysorders(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getdexorders(const json_spirit::Array& params, bool fHelp);
+extern json_spirit::Value getdexbooktop(const json_spirit::Array& params, bool fHelp);
+extern json_spirit::Value getdexbookdepth(const json_spirit::Array& params, bool fHelp);
+extern json_spirit::Value getdexbookchanges(const json_spirit::Array& params, bool fHelp);
 
 extern json_spirit::Value submitcdpstaketx(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value submitcdpredeemtx(const json_spirit::Array& params, bool fHelp);
@@ -186,6 +204,7 @@ extern json_spirit::Value submitcdpliquidatetx(const json_spirit::Array& params,
 extern json_spirit::Value getscoininfo(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getcdp(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value getusercdp(const json_spirit::Array& params, bool fHelp);
+extern void listcdpstoliquidate(const json_spirit::Array& params, bool fHelp, CJsonWriter& writer);
 
 extern json_spirit::Value submitassetissuetx(const json_spirit::Array& params, bool fHelp);
 extern json_spirit::Value submitassetupdatetx(const json_spirit::Array& params, bool fHelp);
@@ -197,6 +216,10 @@ json_spirit::Object JSONRPCExecOne(const json_spirit::Value& req);
 
 std::string JSONRPCExecBatch(const json_spirit::Array& vReq);
 
+/** Write the reply of a single request as JSONRPCReply() does, with the result streamed by the command. */
+void JSONRPCStreamReply(const string& method, const json_spirit::Array& params, const json_spirit::Value& id,
+                        CJsonWriter& writer);
+
 /** Opaque base class for timers returned by NewTimerFunc.
  * This provides no methods at the moment, but makes sure that delete
  * cleans up the whole state.
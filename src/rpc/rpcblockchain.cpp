@@ -17,6 +17,7 @@
 #include "sync.h"
 #include "tx/merkletx.h"
 #include "tx/tx.h"
+#include "tx/txadmission.h"
 #include "wallet/wallet.h"
 
 using namespace json_spirit;
@@ -24,41 +25,41 @@ using namespace std;
 
 class CBaseCoinTransferTx;
 
-Object BlockToJSON(const CBlock& block, const CBlockIndex* pBlockIndex) {
-    Object result;
-    result.push_back(Pair("block_hash",     block.GetHash().GetHex()));
+static void WriteBlockJSON(const CBlock& block, const CBlockIndex* pBlockIndex, CJsonWriter& writer) {
+    writer.BeginObject();
+    writer.Key("block_hash")    .String(block.GetHash().GetHex());
     CMerkleTx txGen(block.vptx[0]);
     txGen.SetMerkleBranch(&block);
-    result.push_back(Pair("confirmations",  (int32_t)txGen.GetDepthInMainChain()));
-    result.push_back(Pair("size",           (int32_t)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
-    result.push_back(Pair("height",         (int32_t)block.GetHeight()));
-    result.push_back(Pair("version",        block.GetVersion()));
-    result.push_back(Pair("merkle_root",    block.GetMerkleRootHash().GetHex()));
-    result.push_back(Pair("tx_count",       (int32_t)block.vptx.size()));
-    Array txs;
+    writer.Key("confirmations") .Int((int32_t)txGen.GetDepthInMainChain());
+    writer.Key("size")          .Int((int32_t)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    writer.Key("height")        .Int((int32_t)block.GetHeight());
+    writer.Key("version")       .Int(block.GetVersion());
+    writer.Key("merkle_root")   .String(block.GetMerkleRootHash().GetHex());
+    writer.Key("tx_count")      .Int((int32_t)block.vptx.size());
+    writer.Key("tx").BeginArray();
     for (const auto& ptx : block.vptx)
-        txs.push_back(ptx->GetHash().GetHex());
-    result.push_back(Pair("tx",             txs));
-    result.push_back(Pair("time",           block.GetBlockTime()));
-    result.push_back(Pair("nonce",          (uint64_t)block.GetNonce()));
+        writer.String(ptx->GetHash().GetHex());
+    writer.EndArray();
+    writer.Key("time")          .Int(block.GetBlockTime());
+    writer.Key("nonce")         .UInt(block.GetNonce());
 
     if (pBlockIndex->pprev)
-        result.push_back(Pair("previous_block_hash", pBlockIndex->pprev->GetBlockHash().GetHex()));
+        writer.Key("previous_block_hash").String(pBlockIndex->pprev->GetBlockHash().GetHex());
     CBlockIndex* pNext = chainActive.Next(pBlockIndex);
     if (pNext)
-        result.push_back(Pair("next_block_hash", pNext->GetBlockHash().GetHex()));
+        writer.Key("next_block_hash").String(pNext->GetBlockHash().GetHex());
 
-    Array prices;
+    writer.Key("median_price").BeginArray();
     for (auto &item : block.GetBlockMedianPrice()) {
-        Object price;
-        price.push_back(Pair("coin_symbol",   item.first.first));
-        price.push_back(Pair("price_symbol",  item.first.second));
-        price.push_back(Pair("price",         (double) item.second / PRICE_BOOST));
-        prices.push_back(price);
+        writer.BeginObject();
+        writer.Key("coin_symbol")   .String(item.first.first);
+        writer.Key("price_symbol")  .String(item.first.second);
+        writer.Key("price")         .Real((double) item.second / PRICE_BOOST);
+        writer.EndObject();
     }
-    result.push_back(Pair("median_price", prices));
+    writer.EndArray();
 
-    return result;
+    writer.EndObject();
 }
 
 Value getblockcount(const Array& params, bool fHelp) {
@@ -74,7 +75,7 @@ Value getblockcount(const Array& params, bool fHelp) {
     return chainActive.Height();
 }
 
-Value getrawmempool(const Array& params, bool fHelp)
+void getrawmempool(const Array& params, bool fHelp, CJsonWriter& writer)
 {
     if (fHelp || params.size() > 1)
         throw runtime_error(
@@ -94,6 +95,7 @@ Value getrawmempool(const Array& params, bool fHelp)
             "    \"fee\" : n,              (numeric) transaction fee in WICC coins\n"
             "    \"size\" : n,             (numeric) transaction size in bytes\n"
             "    \"priority\" : n,         (numeric) priority\n"
+            "    \"fee_per_kb\" : n,       (numeric) fees deducted fuel per KB, normalized by the median price\n"
             "    \"time\" : n,             (numeric) local time transaction entered pool in seconds since 1 Jan 1970 "
             "GMT\n"
             "    \"height\" : n,           (numeric) block height when transaction entered pool\n"
@@ -106,37 +108,99 @@ Value getrawmempool(const Array& params, bool fHelp)
     if (params.size() > 0)
         fVerbose = params[0].get_bool();
 
+    // written as the mempool is walked, a large mempool is never held as a tree
     if (fVerbose) {
         LOCK(mempool.cs);
-        Object obj;
-        for (const auto& entry : mempool.memPoolTxs) {
-            const uint256& hash      = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
-            Object info;
-            info.push_back(Pair("size",         (int)e.GetTxSize()));
-            info.push_back(Pair("fees_type",    std::get<0>(e.GetFees())));
-            info.push_back(Pair("fees",         ValueFromAmount(std::get<1>(e.GetFees()))));
-            info.push_back(Pair("time",         e.GetTime()));
-            info.push_back(Pair("height",       (int)e.GetHeight()));
-            info.push_back(Pair("priority",     e.GetPriority()));
-
-            obj.push_back(Pair(hash.ToString(), info));
+        writer.BeginObject();
+        for (const auto& e : mempool.memPoolTxs) {
+            writer.Key(e.GetHash().ToString()).BeginObject();
+            writer.Key("size")      .Int(e.GetTxSize());
+            writer.Key("fees_type") .String(std::get<0>(e.GetFees()));
+            writer.Key("fees")      .Real(ValueFromAmount(std::get<1>(e.GetFees())).get_real());
+            writer.Key("time")      .Int(e.GetTime());
+            writer.Key("height")    .Int(e.GetHeight());
+            writer.Key("priority")  .Real(e.GetPriority());
+            writer.Key("fee_per_kb").Real(e.GetFeePerKb());
+            writer.EndObject();
         }
-        return obj;
+        writer.EndObject();
     } else {
         vector<uint256> txids;
         mempool.QueryHash(txids);
 
-        Array arr;
+        writer.BeginArray();
         for (const auto& hash : txids) {
-            arr.push_back(hash.ToString());
+            writer.String(hash.ToString());
         }
-
-        return arr;
+        writer.EndArray();
     }
 }
 
-Value getblock(const Array& params, bool fHelp) {
+Value getmempoolinfo(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getmempoolinfo\n"
+            "\nReturns details on the active state of the memory pool.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": n,          (numeric) count of transactions in memory pool\n"
+            "  \"bytes\": n,         (numeric) total size of transactions in memory pool in bytes\n"
+            "  \"max_bytes\": n,     (numeric) size limit of memory pool in bytes, set by -maxmempool\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getmempoolinfo", "") + "\nAs json rpc\n" + HelpExampleRpc("getmempoolinfo", ""));
+
+    Object obj;
+    obj.push_back(Pair("size",      mempool.Size()));
+    obj.push_back(Pair("bytes",     mempool.GetTotalTxSize()));
+    obj.push_back(Pair("max_bytes", mempool.GetMaxSize()));
+    return obj;
+}
+
+Value gettxadmissioninfo(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "gettxadmissioninfo\n"
+            "\nReturns the statistics of the admission of transactions received from network into the memory pool.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"running\": true|false,       (bool) whether the admission runs in the background threads\n"
+            "  \"queue_size\": n,             (numeric) count of transactions waiting for admission\n"
+            "  \"accepted\": n,               (numeric) count of accepted transactions\n"
+            "  \"rejected\": n,               (numeric) count of rejected transactions\n"
+            "  \"bad_signatures\": n,         (numeric) count of signatures failed in precheck\n"
+            "  \"avg_queue_time\": n,         (numeric) average waiting time in queue in microseconds\n"
+            "  \"avg_precheck_time\": n,      (numeric) average time of the checks without cs_main in microseconds\n"
+            "  \"avg_accept_time\": n,        (numeric) average time of the admission under cs_main in microseconds\n"
+            "  \"reject_reasons\": {          (json object) count of rejected transactions by reason\n"
+            "    \"reason\": n\n"
+            "    ,...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("gettxadmissioninfo", "") + "\nAs json rpc\n" + HelpExampleRpc("gettxadmissioninfo", ""));
+
+    CTxAdmissionStats stats;
+    txAdmissionQueue.GetStats(stats);
+
+    Object reasons;
+    for (const auto &item : stats.rejectReasons)
+        reasons.push_back(Pair(item.first, item.second));
+
+    Object obj;
+    obj.push_back(Pair("running",           txAdmissionQueue.IsRunning()));
+    obj.push_back(Pair("queue_size",        stats.queueSize));
+    obj.push_back(Pair("accepted",          stats.acceptedCount));
+    obj.push_back(Pair("rejected",          stats.rejectedCount));
+    obj.push_back(Pair("bad_signatures",    stats.badSigCount));
+    obj.push_back(Pair("avg_queue_time",    stats.queuedCount ? stats.queueTime / (int64_t)stats.queuedCount : 0));
+    obj.push_back(Pair("avg_precheck_time", stats.preCheckCount ? stats.preCheckTime / (int64_t)stats.preCheckCount : 0));
+    obj.push_back(Pair("avg_accept_time",   stats.acceptCount ? stats.acceptTime / (int64_t)stats.acceptCount : 0));
+    obj.push_back(Pair("reject_reasons",    reasons));
+    return obj;
+}
+
+void getblock(const Array& params, bool fHelp, CJsonWriter& writer) {
     if (fHelp || params.size() < 1 || params.size() > 2) {
         throw runtime_error(
             "getblock \"hash or height\" [\"verbose\"]\n"
@@ -206,11 +270,11 @@ Value getblock(const Array& params, bool fHelp) {
     if (!fVerbose) {
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        writer.String(HexStr(ssBlock.begin(), ssBlock.end()));
+        return;
     }
 
-    return BlockToJSON(block, pBlockIndex);
+    WriteBlockJSON(block, pBlockIndex, writer);
 }
 
 Value verifychain(const Array& params, bool fHelp) {
@@ -199,6 +199,9 @@ Value getminedblocks(const Array& params, bool fHelp) {
             "    \"reward\": n             (numeric) block reward for miner\n"
             "    \"txcount\": n            (numeric) transaction count in block, exclude coinbase\n"
             "    \"blocksize\": n          (numeric) block size (bytes)\n"
+            "    \"fill_rate\": n          (numeric) block size in percent of the max block size\n"
+            "    \"candidate_tx_count\": n (numeric) mempool transactions tried to pack into the block\n"
+            "    \"build_time\": n         (numeric) time (ms) spent on assembling the block\n"
             "    \"hash\": xxx             (string) block hash\n"
             "    \"preblockhash\": xxx     (string) pre block hash\n"
             "  }\n"
@@ -227,6 +230,10 @@ Value getminedblocks(const Array& params, bool fHelp) {
         obj.push_back(Pair("total_fees",    blockInfo.totalFees));
         obj.push_back(Pair("tx_count",      blockInfo.txCount));
         obj.push_back(Pair("block_size",    blockInfo.totalBlockSize));
+        obj.push_back(Pair("fill_rate",     blockInfo.maxBlockSize == 0 ? 0.0 :
+                                            100.0 * blockInfo.totalBlockSize / blockInfo.maxBlockSize));
+        obj.push_back(Pair("candidate_tx_count", blockInfo.candidateTxCount));
+        obj.push_back(Pair("build_time",    blockInfo.buildTime));
         obj.push_back(Pair("txid",          blockInfo.hash.ToString()));
         obj.push_back(Pair("preblockhash",  blockInfo.hashPrevBlock.ToString()));
         ret.push_back(obj);
@@ -97,7 +97,17 @@ Value getpeerinfo(const Array& params, bool fHelp)
             "    \"inbound\": true|false,     (boolean) Inbound (true) or Outbound (false)\n"
             "    \"startingheight\": n,       (numeric) The starting height (block) of the peer\n"
             "    \"banscore\": n,              (numeric) The ban score (stats.nMisbehavior)\n"
-            "    \"syncnode\" : true|false     (booleamn) if sync node\n"
+            "    \"cmpctblocks\": n,           (numeric) The compact blocks received\n"
+            "    \"cmpctblockroundtrips\": n,  (numeric) The compact blocks completed by requesting the missing txs\n"
+            "    \"cmpctblockfailures\": n,    (numeric) The compact blocks downloaded in full\n"
+            "    \"cmpctblockhitrate\": n,     (numeric) The ratio of the txs of the compact blocks found locally\n"
+            "    \"cmpctblockreconstructms\": n, (numeric) The average milliseconds from a compact block to the full block\n"
+            "    \"blockrelaylatencyms\": n,   (numeric) The average milliseconds from the block time to the new blocks received\n"
+            "    \"syncnode\" : true|false,    (booleamn) if sync node\n"
+            "    \"sendqueue\": n,            (numeric) The messages waiting to be sent\n"
+            "    \"sendqueuebytes\": n,       (numeric) The bytes waiting to be sent\n"
+            "    \"recvqueue\": n,            (numeric) The received messages waiting to be processed\n"
+            "    \"recvqueuebytes\": n,       (numeric) The bytes of the received messages waiting to be processed\n"
             "  }\n"
             "  ,...\n"
             "}\n"
@@ -137,8 +147,23 @@ Value getpeerinfo(const Array& params, bool fHelp)
         obj.push_back(Pair("startingheight", stats.nStartingHeight));
         if (fStateStats) {
             obj.push_back(Pair("banscore", statestats.nMisbehavior));
+            obj.push_back(Pair("cmpctblocks", (uint64_t)statestats.nCmpctBlocks));
+            obj.push_back(Pair("cmpctblockroundtrips", (uint64_t)statestats.nCmpctBlockRoundTrips));
+            obj.push_back(Pair("cmpctblockfailures", (uint64_t)statestats.nCmpctBlockFailures));
+            uint64_t txCount = statestats.nCmpctTxsFound + statestats.nCmpctTxsMissing;
+            if (txCount > 0)
+                obj.push_back(Pair("cmpctblockhitrate", (double)statestats.nCmpctTxsFound / txCount));
+            uint32_t nReconstructed = statestats.nCmpctBlocks - statestats.nCmpctBlockFailures;
+            if (nReconstructed > 0)
+                obj.push_back(Pair("cmpctblockreconstructms", statestats.nCmpctReconstructMillis / nReconstructed));
+            if (statestats.nRelayedBlocks > 0)
+                obj.push_back(Pair("blockrelaylatencyms", statestats.nRelayLatencyMillis / statestats.nRelayedBlocks));
         }
         obj.push_back(Pair("syncnode", stats.fSyncNode));
+        obj.push_back(Pair("sendqueue", stats.nSendQueueMsgs));
+        obj.push_back(Pair("sendqueuebytes", stats.nSendQueueBytes));
+        obj.push_back(Pair("recvqueue", stats.nRecvQueueMsgs));
+        obj.push_back(Pair("recvqueuebytes", stats.nRecvQueueBytes));
 
         ret.push_back(obj);
     }
@@ -313,13 +313,13 @@ Value getscoininfo(const Array& params, bool fHelp){
     // TODO: multi stable coin
     uint64_t bcoinMedianPrice =
         pCdMan->pPpCache->GetMedianPrice(height, slideWindow, CoinPricePair(SYMB::WICC, SYMB::USD));
-    uint64_t globalCollateralRatio = pCdMan->pCdpCache->cdpMemCache.GetGlobalCollateralRatio(bcoinMedianPrice);
+    uint64_t globalCollateralRatio = pCdMan->pCdpCache->GetGlobalCollateralRatio(bcoinMedianPrice);
     bool globalCollateralRatioFloorReached =
         pCdMan->pCdpCache->CheckGlobalCollateralRatioFloorReached(bcoinMedianPrice, globalCollateralRatioFloor);
 
     uint64_t globalStakedBcoins = 0;
     uint64_t globalOwedScoins   = 0;
-    pCdMan->pCdpCache->cdpMemCache.GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+    pCdMan->pCdpCache->GetGlobalItem(globalStakedBcoins, globalOwedScoins);
 
     bool global_collateral_ceiling_reached = globalStakedBcoins > globalCollateralCeiling * COIN;
 
@@ -329,7 +329,7 @@ Value getscoininfo(const Array& params, bool fHelp){
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Acquire cdp force liquidate ratio error");
     }
 
-    pCdMan->pCdpCache->cdpMemCache.GetCdpListByCollateralRatio(forceLiquidateRatio, bcoinMedianPrice,
+    pCdMan->pCdpCache->GetCdpListByCollateralRatio(forceLiquidateRatio, bcoinMedianPrice,
                                                                forceLiquidateCdps);
 
     Object obj;
@@ -362,7 +362,6 @@ Value getscoininfo(const Array& params, bool fHelp){
 }
 
 Value listcdps(const Array& params, bool fHelp);
-Value listcdpstoliquidate(const Array& params, bool fHelp);
 
 Value getusercdp(const Array& params, bool fHelp){
     if (fHelp || params.size() < 1 || params.size() > 2) {
@@ -440,6 +439,61 @@ Value getcdp(const Array& params, bool fHelp){
     return obj;
 }
 
+void listcdpstoliquidate(const Array& params, bool fHelp, CJsonWriter& writer) {
+    if (fHelp || params.size() > 1) {
+        throw runtime_error(
+            "listcdpstoliquidate ( max_count )\n"
+            "\nlist the cdps to force liquidate at the current median price, in the ascending order of the collateral ratio\n"
+            "\nArguments:\n"
+            "1.\"max_count\": (numeric, optional) the cdps to return at most, default is all\n"
+            "\nResult:\n"
+            "\nExamples:\n"
+            + HelpExampleCli("listcdpstoliquidate", "100\n")
+            + "\nAs json rpc call\n"
+            + HelpExampleRpc("listcdpstoliquidate", "100\n")
+        );
+    }
+
+    int64_t maxCount = params.size() > 0 ? params[0].get_int64() : 0;
+    if (maxCount < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "max_count must not be negative");
+
+    int32_t height = chainActive.Height();
+    uint64_t slideWindow = 0;
+    if (!pCdMan->pSysParamCache->GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Acquire median price slide window blockcount error");
+    }
+
+    uint64_t forceLiquidateRatio = 0;
+    if (!pCdMan->pSysParamCache->GetParam(SysParamType::CDP_FORCE_LIQUIDATE_RATIO, forceLiquidateRatio)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Acquire cdp force liquidate ratio error");
+    }
+
+    // TODO: multi stable coin
+    uint64_t bcoinMedianPrice = pCdMan->pPpCache->GetMedianPrice(height, slideWindow, CoinPricePair(SYMB::WICC, SYMB::USD));
+
+    // a range scan of the ratio index, the cdps above the liquidation ratio are never read
+    set<CUserCDP> forceLiquidateCdps;
+    if (!pCdMan->pCdpCache->GetCdpListByCollateralRatio(forceLiquidateRatio, bcoinMedianPrice, forceLiquidateCdps)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Acquire cdps to force liquidate error");
+    }
+
+    uint64_t count = maxCount > 0 ? min<uint64_t>(maxCount, forceLiquidateCdps.size()) : forceLiquidateCdps.size();
+
+    writer.BeginObject();
+    writer.Key("height")                .Int(height);
+    writer.Key("force_liquidate_ratio") .String(strprintf("%.4f%%", (double)forceLiquidateRatio / RATIO_BOOST * 100));
+    writer.Key("bcoin_median_price")    .Real((double)bcoinMedianPrice / PRICE_BOOST);
+    writer.Key("count")                 .UInt(count);
+    writer.Key("cdps").BeginArray();
+    auto iter = forceLiquidateCdps.begin();
+    for (uint64_t i = 0; i < count; ++i, ++iter) {
+        writer.Write(iter->ToJson(bcoinMedianPrice));
+    }
+    writer.EndArray();
+    writer.EndObject();
+}
+
 /*************************************************<< DEX >>**************************************************/
 Value submitdexbuylimitordertx(const Array& params, bool fHelp) {
     if (fHelp || params.size() < 5 || params.size() > 6) {
@@ -858,6 +912,159 @@ extern Value getdexorders(const Array& params, bool fHelp) {
     return obj;
 }
 
+static Value GetDexBookLevels(const TokenSymbol &coinSymbol, const TokenSymbol &assetSymbol, OrderSide orderSide,
+                              uint32_t maxLevels, bool withOrders) {
+    auto pGetter = pCdMan->pDexCache->CreateOrderBookGetter();
+    if (!pGetter->Execute(coinSymbol, assetSymbol, orderSide, maxLevels, withOrders)) {
+        throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("get order book error! coin_symbol=%s, asset_symbol=%s, "
+            "order_side=%s", coinSymbol, assetSymbol, GetOrderSideName(orderSide)));
+    }
+    Array arr;
+    pGetter->ToJson(arr);
+    return arr;
+}
+
+Value getdexbooktop(const Array& params, bool fHelp) {
+     if (fHelp || params.size() != 2) {
+        throw runtime_error(
+            "getdexbooktop \"coin_symbol\" \"asset_symbol\"\n"
+            "\nget the best buy and sell levels of the dex order book of a trading pair.\n"
+            "\nArguments:\n"
+            "1.\"coin_symbol\":    (string, required) coin type to pay\n"
+            "2.\"asset_symbol\":   (string, required) asset type to buy or sell\n"
+            "\nResult:\n"
+            "\"height\"           (numeric) the tip block height of the book.\n"
+            "\"bid\"              (object) the best buy level, null if no buy order.\n"
+            "\"ask\"              (object) the best sell level, null if no sell order.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdexbooktop", "\"WUSD\" \"WICC\"")
+            + "\nAs json rpc call\n"
+            + HelpExampleRpc("getdexbooktop", "\"WUSD\", \"WICC\"")
+        );
+    }
+
+    const TokenSymbol &coinSymbol  = RPC_PARAM::GetOrderCoinSymbol(params[0]);
+    const TokenSymbol &assetSymbol = RPC_PARAM::GetOrderAssetSymbol(params[1]);
+    RPC_PARAM::CheckOrderSymbols(__FUNCTION__, coinSymbol, assetSymbol);
+
+    Array bids = GetDexBookLevels(coinSymbol, assetSymbol, ORDER_BUY, 1, false).get_array();
+    Array asks = GetDexBookLevels(coinSymbol, assetSymbol, ORDER_SELL, 1, false).get_array();
+
+    Object obj;
+    obj.push_back(Pair("height",        chainActive.Height()));
+    obj.push_back(Pair("coin_symbol",   coinSymbol));
+    obj.push_back(Pair("asset_symbol",  assetSymbol));
+    obj.push_back(Pair("bid",           bids.empty() ? Value::null : bids.front()));
+    obj.push_back(Pair("ask",           asks.empty() ? Value::null : asks.front()));
+    return obj;
+}
+
+Value getdexbookdepth(const Array& params, bool fHelp) {
+     if (fHelp || params.size() < 2 || params.size() > 4) {
+        throw runtime_error(
+            "getdexbookdepth \"coin_symbol\" \"asset_symbol\" [max_levels] [verbose]\n"
+            "\nget the depth of the dex order book of a trading pair, the orders aggregated by price.\n"
+            "\nArguments:\n"
+            "1.\"coin_symbol\":    (string, required) coin type to pay\n"
+            "2.\"asset_symbol\":   (string, required) asset type to buy or sell\n"
+            "3.\"max_levels\":     (numeric, optional) the max price levels of each side, 0 for all, default is 20\n"
+            "4.\"verbose\":        (bool, optional) include the orders of each level, default is false\n"
+            "\nResult:\n"
+            "\"height\"           (numeric) the tip block height of the book, the changes after it follow in "
+            "getdexbookchanges.\n"
+            "\"bids\"             (array) the buy levels, the market orders first, then the prices descending.\n"
+            "\"asks\"             (array) the sell levels, the market orders first, then the prices ascending.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdexbookdepth", "\"WUSD\" \"WICC\" 20 true")
+            + "\nAs json rpc call\n"
+            + HelpExampleRpc("getdexbookdepth", "\"WUSD\", \"WICC\", 20, true")
+        );
+    }
+
+    const TokenSymbol &coinSymbol  = RPC_PARAM::GetOrderCoinSymbol(params[0]);
+    const TokenSymbol &assetSymbol = RPC_PARAM::GetOrderAssetSymbol(params[1]);
+    RPC_PARAM::CheckOrderSymbols(__FUNCTION__, coinSymbol, assetSymbol);
+
+    int64_t maxLevels = 20;
+    if (params.size() > 2) {
+        maxLevels = params[2].get_int64();
+        if (maxLevels < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("max_levels=%d must >= 0", maxLevels));
+    }
+    bool verbose = params.size() > 3 ? params[3].get_bool() : false;
+
+    Object obj;
+    obj.push_back(Pair("height",        chainActive.Height()));
+    obj.push_back(Pair("coin_symbol",   coinSymbol));
+    obj.push_back(Pair("asset_symbol",  assetSymbol));
+    obj.push_back(Pair("bids",          GetDexBookLevels(coinSymbol, assetSymbol, ORDER_BUY, maxLevels, verbose)));
+    obj.push_back(Pair("asks",          GetDexBookLevels(coinSymbol, assetSymbol, ORDER_SELL, maxLevels, verbose)));
+    return obj;
+}
+
+Value getdexbookchanges(const Array& params, bool fHelp) {
+     if (fHelp || params.size() < 1 || params.size() > 3) {
+        throw runtime_error(
+            "getdexbookchanges since_height [\"since_block_hash\"] [max_count]\n"
+            "\nget the changes of all the dex order books after a block height, in the block order.\n"
+            "\nArguments:\n"
+            "1.\"since_height\":       (numeric, required) the changes after the height, e.g. the height of a depth "
+            "snapshot or the end_height returned before\n"
+            "2.\"since_block_hash\":   (string, optional) the block hash of since_height known by the caller, an error "
+            "is returned if it is no longer in the active chain, default is empty to skip the check\n"
+            "3.\"max_count\":          (numeric, optional) the changes to get at least, unless no more, default is "
+            "1000, the changes of a height are never split\n"
+            "\nResult:\n"
+            "\"end_height\"           (numeric) the last height of the changes returned, to get more since it.\n"
+            "\"end_block_hash\"       (string) the block hash of end_height.\n"
+            "\"has_more\"             (bool) has more changes after end_height.\n"
+            "\"count\"                (numeric) the count of returned changes.\n"
+            "\"changes\"              (array) the last change of every order at each height, PUT with the new "
+            "state of the order or ERASE with its last state.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdexbookchanges", "100 \"\" 1000")
+            + "\nAs json rpc call\n"
+            + HelpExampleRpc("getdexbookchanges", "100, \"\", 1000")
+        );
+    }
+
+    int64_t tipHeight   = chainActive.Height();
+    int64_t sinceHeight = params[0].get_int64();
+    int64_t keptHeight  = max<int64_t>(tipHeight - DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT, 0);
+    if (sinceHeight < keptHeight || sinceHeight > tipHeight) {
+        throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("since_height=%d must >= %d and <= tip_height=%d, "
+            "get a new snapshot by getdexbookdepth", sinceHeight, keptHeight, tipHeight));
+    }
+
+    if (params.size() > 1 && !params[1].get_str().empty()) {
+        const uint256 &sinceBlockHash = RPC_PARAM::GetTxid(params[1], "since_block_hash");
+        if (chainActive[sinceHeight]->GetBlockHash() != sinceBlockHash) {
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("The block of since_height is not in the active chain, "
+                "get a new snapshot by getdexbookdepth, since_height=%d, since_block_hash=%s", sinceHeight,
+                sinceBlockHash.ToString()));
+        }
+    }
+
+    int64_t maxCount = 1000;
+    if (params.size() > 2) {
+        maxCount = params[2].get_int64();
+        if (maxCount < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("max_count=%d must >= 0", maxCount));
+    }
+
+    auto pGetter = pCdMan->pDexCache->CreateOrderBookChangesGetter();
+    if (!pGetter->Execute(sinceHeight, tipHeight, maxCount)) {
+        throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("get order book changes error! since_height=%d", sinceHeight));
+    }
+
+    Object obj;
+    obj.push_back(Pair("end_height",        (int64_t)pGetter->end_height));
+    obj.push_back(Pair("end_block_hash",    chainActive[pGetter->end_height]->GetBlockHash().GetHex()));
+    obj.push_back(Pair("has_more",          pGetter->has_more));
+    pGetter->ToJson(obj);
+    return obj;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // asset tx rpc
 
@@ -10,6 +10,7 @@
 
 #include "json/json_spirit_utils.h"
 #include "json/json_spirit_value.h"
+#include "rpc/core/jsonwriter.h"
 
 using namespace std;
 using namespace json_spirit;
@@ -26,6 +27,9 @@ extern Value submitdexsettletx(const Array& params, bool fHelp);
 extern Value getdexorder(const Array& params, bool fHelp);
 extern Value getdexorders(const Array& params, bool fHelp);
 extern Value getdexsysorders(const Array& params, bool fHelp);
+extern Value getdexbooktop(const Array& params, bool fHelp);
+extern Value getdexbookdepth(const Array& params, bool fHelp);
+extern Value getdexbookchanges(const Array& params, bool fHelp);
 
 extern Value submitcdpstaketx(const Array& params, bool fHelp);
 extern Value submitcdpredeemtx(const Array& params, bool fHelp);
@@ -36,7 +40,7 @@ extern Value getcdp(const Array& params, bool fHelp);
 extern Value getusercdp(const Array& params, bool fHelp);
 
 extern Value listcdps(const Array& params, bool fHelp);
-extern Value listcdpstoliquidate(const Array& params, bool fHelp);
+extern void listcdpstoliquidate(const Array& params, bool fHelp, CJsonWriter& writer);
 
 
 extern Value submitassetissuetx(const Array& params, bool fHelp);
@@ -290,8 +290,8 @@ Value submitdelegatevotetx(const Array& params, bool fHelp) {
 }
 
 Value submituniversalcontractdeploytx(const Array& params, bool fHelp) {
-    if (fHelp || params.size() < 3 || params.size() > 5) {
-        throw runtime_error("submituniversalcontractdeploytx \"addr\" \"filepath\" \"fee\" [\"height\"] [\"contract_memo\"]\n"
+    if (fHelp || params.size() < 3 || params.size() > 6) {
+        throw runtime_error("submituniversalcontractdeploytx \"addr\" \"filepath\" \"fee\" [\"height\"] [\"contract_memo\"] [vm_type]\n"
             "\ncreate a transaction of registering a universal contract\n"
             "\nArguments:\n"
             "1.\"addr\":            (string, required) contract owner address from this wallet\n"
@@ -299,6 +299,8 @@ Value submituniversalcontractdeploytx(const Array& params, bool fHelp) {
             "3.\"symbol:fee:unit\": (symbol:amount:unit, required) fee paid to miner, default is WICC:100000000:sawi\n"
             "4.\"height\":          (numeric, optional) valid height, when not specified, the tip block height in chainActive will be used\n"
             "5.\"contract_memo\":   (string, optional) contract memo\n"
+            "6.\"vm_type\":         (numeric, optional) 1: lua vm (default), 4: lua vm passing the contract arguments"
+            " as one string, since the feature fork v3\n"
             "\nResult:\n"
             "\"txid\":              (string)\n"
             "\nExamples:\n"
@@ -309,7 +311,7 @@ Value submituniversalcontractdeploytx(const Array& params, bool fHelp) {
                 "WiZx6rrsBn9sHjwpvdwtMNNX2o31s3DEHH, \"/tmp/lua/myapp.lua\", \"WICC:100000000:sawi\", 10000, \"Hello, WaykiChain!\""));
     }
 
-    RPCTypeCheck(params, list_of(str_type)(str_type)(str_type)(int_type)(str_type));
+    RPCTypeCheck(params, list_of(str_type)(str_type)(str_type)(int_type)(str_type)(int_type));
 
     EnsureWalletIsUnlocked();
 
@@ -318,6 +320,13 @@ Value submituniversalcontractdeploytx(const Array& params, bool fHelp) {
     ComboMoney cmFee      = RPC_PARAM::GetFee(params, 2, UCONTRACT_DEPLOY_TX);
     int32_t validHegiht   = params.size() > 3 ? params[3].get_int() : chainActive.Height();
     string memo           = params.size() > 4 ? params[4].get_str() : "";
+    int32_t vmType        = params.size() > 5 ? params[5].get_int() : (int32_t)VMType::LUA_VM;
+
+    if (vmType != VMType::LUA_VM && vmType != VMType::LUA_VM_STR)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unsupported vm type");
+
+    if (vmType == VMType::LUA_VM_STR && !IsFeatureForkV3(chainActive.Height() + 1))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unsupported vm type before the feature fork v3");
 
     if (!txUid.is<CRegID>())
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Regid not exist or immature");
@@ -330,7 +339,7 @@ Value submituniversalcontractdeploytx(const Array& params, bool fHelp) {
 
     CUniversalContractDeployTx tx;
     tx.txUid        = txUid;
-    tx.contract     = CUniversalContract(contractScript, memo);
+    tx.contract     = CUniversalContract((VMType)vmType, true, contractScript, memo, "");
     tx.fee_symbol   = cmFee.symbol;
     tx.llFees       = cmFee.GetSawiAmount();
     tx.nRunStep     = tx.contract.GetContractSize();
@@ -640,7 +649,10 @@ static Value TestDisconnectBlock(int32_t number) {
                 return false;
             if (!pCdMan->pBlockTreeDb->EraseBlockIndex(pTipIndex->GetBlockHash()))
                 return false;
-            mapBlockIndex.erase(pTipIndex->GetBlockHash());
+            {
+                LOCK(cs_mapBlockIndex);
+                mapBlockIndex.erase(pTipIndex->GetBlockHash());
+            }
         } while (--number);
     }
 
@@ -805,7 +817,7 @@ Value reloadtxcache(const Array& params, bool fHelp) {
     return obj;
 }
 
-Value getcontractdata(const Array& params, bool fHelp) {
+void getcontractdata(const Array& params, bool fHelp, CJsonWriter& writer) {
     if (fHelp || (params.size() != 2 && params.size() != 3)) {
         throw runtime_error(
             "getcontractdata \"contract regid\" \"key\" [hexadecimal]\n"
@@ -839,11 +851,85 @@ Value getcontractdata(const Array& params, bool fHelp) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Failed to acquire contract data");
     }
 
-    Object obj;
-    obj.push_back(Pair("contract_regid",    regId.ToString()));
-    obj.push_back(Pair("key",               hexadecimal ? HexStr(key) : key));
-    obj.push_back(Pair("value",             hexadecimal ? HexStr(value) : value));
+    writer.BeginObject();
+    writer.Key("contract_regid")    .String(regId.ToString());
+    writer.Key("key")               .String(hexadecimal ? HexStr(key) : key);
+    writer.Key("value")             .String(hexadecimal ? HexStr(value) : value);
+    writer.EndObject();
+}
+
+Value getaddresstxs(const Array& params, bool fHelp) {
+    if (fHelp || params.size() < 1 || params.size() > 3) {
+        throw runtime_error(
+            "getaddresstxs \"address\" [\"max_count\"] [\"last_pos_info\"]\n"
+            "\nget the transactions involving the address in the order of block height, requires -addressindex\n"
+            "\nArguments:\n"
+            "1.\"address\":         (string, required) the address\n"
+            "2.\"max_count\":       (numeric, optional) the max tx count to get, default is 500\n"
+            "3.\"last_pos_info\":   (string, optional) the last position info to get more txs, default is empty\n"
+            "\nResult:\n"
+            "\"has_more\"           (bool) has more txs in db.\n"
+            "\"last_pos_info\"      (string) the last position info to get more txs.\n"
+            "\"count\"              (numeric) the count of returned txs.\n"
+            "\"txs\"                (array) the txs with the block height, index and txid.\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getaddresstxs", "\"wNw1Rr8cHPerXXGt6yxEkAPHDXmzMiQBn4\" 100") + "\nAs json rpc call\n" +
+            HelpExampleRpc("getaddresstxs", "\"wNw1Rr8cHPerXXGt6yxEkAPHDXmzMiQBn4\", 100"));
+    }
+
+    if (!SysCfg().IsAddressIndex())
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is disabled, restart with -addressindex -reindex");
+
+    CKeyID keyId;
+    if (!GetKeyId(params[0].get_str(), keyId))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    int64_t maxCount = 500;
+    if (params.size() > 1) {
+        maxCount = params[1].get_int64();
+        if (maxCount <= 0)
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("max_count=%d must > 0", maxCount));
+    }
+
+    // last_pos_info: the big-endian height and index of the last returned tx
+    dbk::CFixedUInt32 lastHeight, lastIndex;
+    if (params.size() > 2) {
+        string lastPosInfo = RPC_PARAM::GetBinStrFromHex(params[2], "last_pos_info");
+        try {
+            CDataStream ss(lastPosInfo.data(), lastPosInfo.data() + lastPosInfo.size(), SER_DISK, CLIENT_VERSION);
+            ss >> lastHeight >> lastIndex;
+        } catch (std::exception &e) {
+            throw JSONRPCError(RPC_INVALID_PARAMS, "Invalid last_pos_info!");
+        }
+    }
+
+    auto pGetter = pCdMan->pContractCache->CreateAddressTxsGetter(keyId, maxCount, lastHeight.GetValue(),
+                                                                  lastIndex.GetValue());
+    if (!pGetter->Execute())
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to get the txs of address");
+
+    Array txArray;
+    for (const auto &item : pGetter->data_list) {
+        Object txObj;
+        txObj.push_back(Pair("height",  (int64_t)pGetter->GetHeight(item)));
+        txObj.push_back(Pair("index",   (int64_t)pGetter->GetIndex(item)));
+        txObj.push_back(Pair("txid",    pGetter->GetTxid(item).GetHex()));
+        txArray.push_back(txObj);
+    }
+
+    string newLastPosInfo;
+    if (pGetter->have_next && !pGetter->data_list.empty()) {
+        const auto &lastItem = pGetter->data_list.back();
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << std::get<1>(lastItem.first) << std::get<2>(lastItem.first);
+        newLastPosInfo.assign(ss.begin(), ss.end());
+    }
 
+    Object obj;
+    obj.push_back(Pair("has_more",      pGetter->have_next));
+    obj.push_back(Pair("last_pos_info", HexStr(newLastPosInfo)));
+    obj.push_back(Pair("count",         (int64_t)txArray.size()));
+    obj.push_back(Pair("txs",           txArray));
     return obj;
 }
 
@@ -1287,7 +1373,7 @@ Value gettotalcoins(const Array& params, bool fHelp) {
     return obj;
 }
 
-Value listdelegates(const Array& params, bool fHelp) {
+void listdelegates(const Array& params, bool fHelp, CJsonWriter& writer) {
     if (fHelp || params.size() > 1) {
         throw runtime_error(
             "listdelegates \n"
@@ -1312,18 +1398,17 @@ Value listdelegates(const Array& params, bool fHelp) {
 
     delegatesList.resize(std::min(delegateNum, (int32_t)delegatesList.size()));
 
-    Object obj;
-    Array delegateArray;
+    writer.BeginObject();
+    writer.Key("delegates").BeginArray();
 
     CAccount account;
     for (const auto& delegate : delegatesList) {
         if (!pCdMan->pAccountCache->GetAccount(delegate, account)) {
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to get account info");
         }
-        delegateArray.push_back(account.ToJsonObj());
+        writer.Write(account.ToJsonObj());
     }
 
-    obj.push_back(Pair("delegates", delegateArray));
-
-    return obj;
+    writer.EndArray();
+    writer.EndObject();
 }
@@ -9,6 +9,7 @@
 #include <boost/assign/list_of.hpp>
 #include "json/json_spirit_utils.h"
 #include "json/json_spirit_value.h"
+#include "rpc/core/jsonwriter.h"
 
 using namespace std;
 using namespace json_spirit;
@@ -29,7 +30,8 @@ extern Value disconnectblock(const Array& params, bool fHelp);
 extern Value reloadtxcache(const Array& params, bool fHelp);
 
 extern Value getcontractinfo(const Array& params, bool fHelp);
-extern Value getcontractdata(const Array& params, bool fHelp);
+extern void getcontractdata(const Array& params, bool fHelp, CJsonWriter& writer);
+extern Value getaddresstxs(const Array& params, bool fHelp);
 extern Value getcontractaccountinfo(const Array& params, bool fHelp);
 
 extern Value saveblocktofile(const Array& params, bool fHelp);
@@ -45,6 +47,6 @@ extern Value listtx(const Array& params, bool fHelp);
 extern Value listcontractassets(const Array& params, bool fHelp);
 extern Value listcontracts(const Array& params, bool fHelp);
 extern Value listtxcache(const Array& params, bool fHelp);
-extern Value listdelegates(const Array& params, bool fHelp);
+extern void listdelegates(const Array& params, bool fHelp, CJsonWriter& writer);
 
 #endif  // RPC_RPCTX_H
@@ -48,3 +48,102 @@ void CSignatureCache::Set(const uint256& sigHash, const std::vector<unsigned cha
 
     setValid.insert(entry);
 }
+
+bool CSignatureCheck::operator()(CSignatureCache& sigCache) const {
+    if (!pubKey.Verify(sigHash, vchSig))
+        return false;
+
+    sigCache.Set(sigHash, vchSig, pubKey);
+    return true;
+}
+
+void CSignatureCheckQueue::Start(uint32_t nThreads) {
+    Stop();
+
+    fQuit = false;
+    for (uint32_t i = 0; i < nThreads; ++i) {
+        workers.emplace_back([this, i]() {
+            RenameThread(strprintf("coin-sigcheck-%u", i).c_str());
+            Worker();
+        });
+    }
+}
+
+void CSignatureCheckQueue::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condWorker.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+}
+
+void CSignatureCheckQueue::Process() {
+    const size_t count = pChecks->size();
+    // stop as soon as any check failed, the whole batch is rejected anyway
+    while (fAllOk) {
+        size_t index = nextIndex.fetch_add(1);
+        if (index >= count)
+            break;
+
+        if (!(*pChecks)[index](*pSigCache))
+            fAllOk = false;
+    }
+}
+
+void CSignatureCheckQueue::Worker() {
+    uint64_t lastBatchId = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        condWorker.wait(lock, [&]() { return fQuit || batchId != lastBatchId; });
+        if (fQuit)
+            return;
+
+        lastBatchId = batchId;
+        lock.unlock();
+        Process();
+        lock.lock();
+
+        if (++finishedWorkers == workers.size())
+            condMaster.notify_one();
+    }
+}
+
+bool CSignatureCheckQueue::Verify(const std::vector<CSignatureCheck>& checks, CSignatureCache& sigCache) {
+    if (checks.empty())
+        return true;
+
+    if (workers.empty() || checks.size() == 1) {
+        for (const auto& check : checks) {
+            if (!check(sigCache))
+                return false;
+        }
+        return true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        pChecks         = &checks;
+        pSigCache       = &sigCache;
+        nextIndex       = 0;
+        fAllOk          = true;
+        finishedWorkers = 0;
+        ++batchId;
+    }
+    condWorker.notify_all();
+
+    Process();
+
+    // wait for all workers to leave the batch before the checks go out of scope
+    std::unique_lock<std::mutex> lock(mtx);
+    condMaster.wait(lock, [&]() { return finishedWorkers == workers.size(); });
+    pChecks   = nullptr;
+    pSigCache = nullptr;
+
+    return fAllOk;
+}
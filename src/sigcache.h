@@ -7,7 +7,10 @@
 #ifndef COIN_SIGCACHE_H
 #define COIN_SIGCACHE_H
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "config/chainparams.h"
@@ -41,4 +44,61 @@ private:
                       const std::vector<unsigned char>& vchSig, const CPubKey& pubKey);
 };
 
+/**
+ * A deferred signature check, collected while checking the txs of a block and
+ * verified later in a batch by CSignatureCheckQueue.
+ */
+struct CSignatureCheck {
+    uint256 sigHash;
+    std::vector<unsigned char> vchSig;
+    CPubKey pubKey;
+
+    CSignatureCheck() {}
+    CSignatureCheck(const uint256& sigHashIn, const std::vector<unsigned char>& vchSigIn, const CPubKey& pubKeyIn)
+        : sigHash(sigHashIn), vchSig(vchSigIn), pubKey(pubKeyIn) {}
+
+    // verify signature and put the valid one into signature cache
+    bool operator()(CSignatureCache& sigCache) const;
+};
+
+/**
+ * Pool of worker threads verifying a batch of signatures in parallel, the
+ * calling thread joins the work as well. Verify() is expected to be called
+ * by one thread at a time (under cs_main).
+ */
+class CSignatureCheckQueue {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::condition_variable condMaster;
+
+    // current batch, protected by mtx
+    const std::vector<CSignatureCheck>* pChecks;
+    CSignatureCache* pSigCache;
+    uint64_t batchId;
+    uint32_t finishedWorkers;
+    bool fQuit;
+
+    std::atomic<size_t> nextIndex;
+    std::atomic<bool> fAllOk;
+
+    void Worker();
+    void Process();
+
+public:
+    CSignatureCheckQueue()
+        : pChecks(nullptr), pSigCache(nullptr), batchId(0), finishedWorkers(0), fQuit(false), nextIndex(0), fAllOk(true) {}
+    ~CSignatureCheckQueue() { Stop(); }
+
+    // start nThreads worker threads besides the calling thread
+    void Start(uint32_t nThreads);
+    void Stop();
+    bool IsRunning() const { return !workers.empty(); }
+    uint32_t GetThreadCount() const { return workers.size() + 1; }
+
+    // verify all checks, return false if any of them failed
+    bool Verify(const std::vector<CSignatureCheck>& checks, CSignatureCache& sigCache);
+};
+
 #endif  // COIN_SIGCACHE_H
\ No newline at end of file
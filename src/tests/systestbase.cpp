@@ -637,11 +637,7 @@ bool SysTestBase::GetKeyId(string const &addr, CKeyID &KeyId) {
 };
 
 bool SysTestBase::IsTxInMemorypool(const uint256 &txid) {
-    for (const auto &entry : mempool.memPoolTxs) {
-        if (entry.first == txid) return true;
-    }
-
-    return false;
+    return mempool.Exists(txid);
 }
 
 bool SysTestBase::IsTxUnConfirmdInWallet(const uint256 &txid) {
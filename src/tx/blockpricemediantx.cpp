@@ -96,7 +96,7 @@ bool CBlockPriceMedianTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper
             return state.DoS(100, ERRORMSG("CBlockPriceMedianTx::ExecuteTx, read force liquidate ratio error"),
                             READ_SYS_PARAM_FAIL, "read-force-liquidate-ratio-error");
         }
-        cw.cdpCache.cdpMemCache.GetCdpListByCollateralRatio(forceLiquidateRatio, bcoinMedianPrice, forceLiquidateCDPList);
+        cw.cdpCache.GetCdpListByCollateralRatio(forceLiquidateRatio, bcoinMedianPrice, forceLiquidateCDPList);
 
         LogPrint("CDP", "CBlockPriceMedianTx::ExecuteTx, globalCollateralRatioFloor: %llu, bcoinMedianPrice: %llu, "
                 "forceLiquidateRatio: %llu, forceLiquidateCDPList: %llu\n",
@@ -109,8 +109,10 @@ bool CBlockPriceMedianTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper
             // TODO: remove me.
             LogPrint("CDP", "CBlockPriceMedianTx::ExecuteTx, have %llu cdps to force settle, in detail:\n",
                      forceLiquidateCDPList.size());
-            for (const auto &cdp : forceLiquidateCDPList) {
-                LogPrint("CDP", "%s\n", cdp.ToString());
+            if (LOG_CATEGORY_ENABLED("CDP")) {
+                for (const auto &cdp : forceLiquidateCDPList) {
+                    LogPrint("CDP", "%s\n", cdp.ToString());
+                }
             }
         }
 
@@ -249,7 +249,7 @@ bool CCDPStakeTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &cw, CV
 
         // settle cdp state & persist
         cdp.AddStake(height, assetAmount, scoins_to_mint);
-        if (!cw.cdpCache.UpdateCDP(oldCDP, cdp)) {
+        if (!cw.cdpCache.UpdateCDP(height, oldCDP, cdp)) {
             return state.DoS(100, ERRORMSG("CCDPStakeTx::ExecuteTx, save changed cdp to db failed"),
                             READ_SYS_PARAM_FAIL, "save-changed-cdp-failed");
         }
@@ -493,7 +493,7 @@ bool CCDPRedeemTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &cw, C
             }
         }
 
-        if (!cw.cdpCache.UpdateCDP(oldCDP, cdp)) {
+        if (!cw.cdpCache.UpdateCDP(height, oldCDP, cdp)) {
             return state.DoS(100, ERRORMSG("CCDPRedeemTx::ExecuteTx, update CDP %s failed", cdp.cdpid.ToString()),
                             UPDATE_CDP_FAIL, "bad-save-cdp");
         }
@@ -826,7 +826,7 @@ bool CCDPLiquidateTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &cw
         if (!ProcessPenaltyFees(CTxCord(height, index), cdp, scoinsToReturnSysFund, cw, state, receipts))
             return false;
 
-        if (!cw.cdpCache.UpdateCDP(oldCDP, cdp)) {
+        if (!cw.cdpCache.UpdateCDP(height, oldCDP, cdp)) {
             return state.DoS(100, ERRORMSG("CCDPLiquidateTx::ExecuteTx, update CDP failed! cdpid=%s",
                         cdp.cdpid.ToString()), UPDATE_CDP_FAIL, "bad-save-cdp");
         }
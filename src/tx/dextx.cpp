@@ -516,7 +516,7 @@ bool CDEXCancelOrderTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &
         return state.DoS(100, ERRORMSG("CDEXCancelOrderTx::ExecuteTx, set account info error"),
                          WRITE_ACCOUNT_FAIL, "bad-write-accountdb");
 
-    if (!cw.dexCache.EraseActiveOrder(orderId, activeOrder)) {
+    if (!cw.dexCache.EraseActiveOrder(orderId, activeOrder, height)) {
         return state.DoS(100, ERRORMSG("CDEXCancelOrderTx::ExecuteTx, erase active order failed! order_id=%s", orderId.ToString()),
                         REJECT_INVALID, "order-erase-failed");
     }
@@ -881,12 +881,12 @@ bool CDEXSettleTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &cw, C
                 }
             }
             // erase active order
-            if (!cw.dexCache.EraseActiveOrder(dealItem.buyOrderId, buyOrder)) {
+            if (!cw.dexCache.EraseActiveOrder(dealItem.buyOrderId, buyOrder, height)) {
                 return state.DoS(100, ERRORMSG("CDEXSettleTx::ExecuteTx, erase active buy order failed"),
                                     REJECT_INVALID, "write-dexdb-failed");
             }
         } else {
-            if (!cw.dexCache.UpdateActiveOrder(dealItem.buyOrderId, buyOrder)) {
+            if (!cw.dexCache.UpdateActiveOrder(dealItem.buyOrderId, buyOrder, height)) {
                 return state.DoS(100, ERRORMSG("CDEXSettleTx::ExecuteTx, erase active buy order failed"),
                                     REJECT_INVALID, "write-dexdb-failed");
             }
@@ -894,12 +894,12 @@ bool CDEXSettleTx::ExecuteTx(int32_t height, int32_t index, CCacheWrapper &cw, C
 
         if (sellResidualAmount == 0) { // sell order fulfilled
             // erase active order
-            if (!cw.dexCache.EraseActiveOrder(dealItem.sellOrderId, sellOrder)) {
+            if (!cw.dexCache.EraseActiveOrder(dealItem.sellOrderId, sellOrder, height)) {
                 return state.DoS(100, ERRORMSG("CDEXSettleTx::ExecuteTx, erase active sell order failed"),
                                     REJECT_INVALID, "write-dexdb-failed");
             }
         } else {
-            if (!cw.dexCache.UpdateActiveOrder(dealItem.sellOrderId, sellOrder)) {
+            if (!cw.dexCache.UpdateActiveOrder(dealItem.sellOrderId, sellOrder, height)) {
                 return state.DoS(100, ERRORMSG("CDEXSettleTx::ExecuteTx, erase active sell order failed"),
                                     REJECT_INVALID, "write-dexdb-failed");
             }
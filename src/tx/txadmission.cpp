@@ -0,0 +1,231 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txadmission.h"
+#include "config/const.h"
+#include "main.h"
+#include "net.h"
+#include "persistence/txdb.h"
+#include "tx/txmempool.h"
+
+CTxAdmissionQueue txAdmissionQueue;
+
+void CTxAdmissionQueue::Start(uint32_t nThreads) {
+    Stop();
+
+    fQuit = false;
+    for (uint32_t i = 0; i < nThreads; ++i) {
+        workers.emplace_back([this, i]() {
+            RenameThread(strprintf("coin-txcheck-%u", i).c_str());
+            PreCheckWorker();
+        });
+    }
+    workers.emplace_back([this]() {
+        RenameThread("coin-txadmit");
+        AdmissionWorker();
+    });
+}
+
+void CTxAdmissionQueue::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condPreCheck.notify_all();
+    condAdmission.notify_all();
+
+    for (auto &worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+
+    // drop the txs left in the queue
+    for (auto &item : pendingTxs) {
+        if (item.pFrom)
+            item.pFrom->Release();
+    }
+    for (auto &item : doneTxs) {
+        if (item.second.pFrom)
+            item.second.pFrom->Release();
+    }
+    pendingTxs.clear();
+    doneTxs.clear();
+    nextAdmitSeq = nextSeq;
+}
+
+bool CTxAdmissionQueue::Push(const std::shared_ptr<CBaseTx> &pTx, CNode *pFrom, const string &strCommand) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (workers.empty() || fQuit || pendingTxs.size() + doneTxs.size() >= MAX_TX_ADMISSION_QUEUE_SIZE)
+            return false;
+
+        if (pFrom)
+            pFrom->AddRef();
+
+        pendingTxs.push_back({pTx, pFrom, strCommand, nextSeq++, GetTimeMicros(), false,
+                              std::make_shared<CValidationState>()});
+    }
+    condPreCheck.notify_one();
+
+    return true;
+}
+
+bool CTxAdmissionQueue::Admit(const std::shared_ptr<CBaseTx> &pTx, CNode *pFrom, const string &strCommand) {
+    if (pFrom)
+        pFrom->AddRef();
+
+    CTxAdmission item = {pTx, pFrom, strCommand, 0, GetTimeMicros(), true, std::make_shared<CValidationState>()};
+    return Process(item);
+}
+
+bool CTxAdmissionQueue::PreCheck(CBaseTx *pBaseTx, CValidationState &state) {
+    int64_t nStart = GetTimeMicros();
+
+    uint256 txid = pBaseTx->GetHash();
+    if (pBaseTx->IsBlockRewardTx() || pBaseTx->IsMedianPriceTx())
+        return state.Invalid(ERRORMSG("PreCheck() : txid: %s is a miner reward transaction, can't put into mempool",
+                             txid.GetHex()), REJECT_INVALID, "tx-coinbase-to-mempool");
+
+    string reason;
+    if (SysCfg().NetworkID() == MAIN_NET && !IsStandardTx(pBaseTx, reason))
+        return state.DoS(0, ERRORMSG("PreCheck() : txid: %s is nonstandard transaction due to %s",
+                         txid.GetHex(), reason), REJECT_NONSTANDARD, reason);
+
+    if (mempool.Exists(txid)) {
+        // expected for the txs relayed by several peers, not an error
+        LogPrint("mempool", "PreCheck() : txid: %s already in mempool\n", txid.GetHex());
+        return state.Invalid(false, REJECT_INVALID, "tx-already-in-mempool");
+    }
+
+    CPubKey pubKey;
+    {
+        LOCK(cs_main);
+        if (pCdMan->pTxCache->HaveTx(txid) != uint256())
+            return state.Invalid(ERRORMSG("PreCheck() : txid: %s has been confirmed", txid.GetHex()),
+                                 REJECT_INVALID, "tx-duplicate-confirmed");
+
+        CAccount account;
+        if (pBaseTx->txUid.type() == typeid(CPubKey))
+            pubKey = pBaseTx->txUid.get<CPubKey>();
+        else if (mempool.cw->accountCache.GetAccount(pBaseTx->txUid, account))
+            pubKey = account.owner_pubkey;
+    }
+
+    // Verify the signature into the signature cache without cs_main. A failure is not rejected here, since
+    // some txs are signed by other keys than the sender (e.g. multisig), CheckTx remains authoritative.
+    bool fBadSig = false;
+    const auto &signature = pBaseTx->signature;
+    if (pubKey.IsFullyValid() && signature.size() > 0 && signature.size() < MAX_SIGNATURE_SIZE)
+        fBadSig = !VerifySignature(pBaseTx->ComputeSignatureHash(), signature, pubKey);
+
+    std::unique_lock<std::mutex> lock(statsMtx);
+    stats.preCheckCount++;
+    stats.preCheckTime += GetTimeMicros() - nStart;
+    if (fBadSig)
+        stats.badSigCount++;
+
+    return true;
+}
+
+void CTxAdmissionQueue::GetStats(CTxAdmissionStats &statsOut) {
+    {
+        std::unique_lock<std::mutex> lock(statsMtx);
+        statsOut = stats;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    statsOut.queueSize = pendingTxs.size() + doneTxs.size();
+}
+
+void CTxAdmissionQueue::PreCheckWorker() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        condPreCheck.wait(lock, [&]() { return fQuit || !pendingTxs.empty(); });
+        if (fQuit)
+            return;
+
+        CTxAdmission item = std::move(pendingTxs.front());
+        pendingTxs.pop_front();
+        lock.unlock();
+
+        {
+            std::unique_lock<std::mutex> statsLock(statsMtx);
+            stats.queuedCount++;
+            stats.queueTime += GetTimeMicros() - item.queuedTime;
+        }
+        item.fPreChecked = PreCheck(item.pTx.get(), *item.pState);
+
+        lock.lock();
+        bool fNext = item.seq == nextAdmitSeq;
+        uint64_t seq = item.seq;
+        doneTxs.emplace(seq, std::move(item));
+        if (fNext)
+            condAdmission.notify_one();
+    }
+}
+
+void CTxAdmissionQueue::AdmissionWorker() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        // admit in the order received, whichever precheck worker finished first
+        condAdmission.wait(lock, [&]() { return fQuit || doneTxs.count(nextAdmitSeq); });
+        if (fQuit)
+            return;
+
+        auto iter = doneTxs.find(nextAdmitSeq);
+        CTxAdmission item = std::move(iter->second);
+        doneTxs.erase(iter);
+        nextAdmitSeq++;
+        lock.unlock();
+
+        Process(item);
+
+        lock.lock();
+    }
+}
+
+bool CTxAdmissionQueue::Process(CTxAdmission &item) {
+    int64_t nStart      = GetTimeMicros();
+    CBaseTx *pBaseTx    = item.pTx.get();
+    CNode *pFrom        = item.pFrom;
+    CValidationState &state = *item.pState;
+    CInv inv(MSG_TX, pBaseTx->GetHash());
+
+    bool fAccepted = false;
+    {
+        LOCK(cs_main);
+        if (item.fPreChecked && AcceptToMemoryPool(mempool, state, item.pTx, true)) {
+            fAccepted = true;
+            RelayTransaction(pBaseTx, inv.hash);
+            mapAlreadyAskedFor.erase(inv);
+
+            if (pFrom)
+                LogPrint("INFO", "AcceptToMemoryPool: %s %s : accepted %s (poolsz %u)\n", pFrom->addr.ToString(),
+                         pFrom->cleanSubVer, inv.hash.ToString(), mempool.memPoolTxs.size());
+        }
+
+        int32_t nDoS = 0;
+        if (pFrom && state.IsInvalid(nDoS)) {
+            LogPrint("INFO", "%s from %s %s was not accepted into the memory pool: %s\n", inv.hash.ToString(),
+                     pFrom->addr.ToString(), pFrom->cleanSubVer, state.GetRejectReason());
+
+            pFrom->PushMessage("reject", item.strCommand, state.GetRejectCode(), state.GetRejectReason(), inv.hash);
+        }
+    }
+
+    if (pFrom)
+        pFrom->Release();
+
+    std::unique_lock<std::mutex> lock(statsMtx);
+    stats.acceptCount++;
+    stats.acceptTime += GetTimeMicros() - nStart;
+    if (fAccepted) {
+        stats.acceptedCount++;
+    } else {
+        stats.rejectedCount++;
+        stats.rejectReasons[state.GetRejectReason().empty() ? "unknown" : state.GetRejectReason()]++;
+    }
+
+    return fAccepted;
+}
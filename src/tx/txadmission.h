@@ -0,0 +1,101 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_TXADMISSION_H
+#define COIN_TXADMISSION_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class CBaseTx;
+class CNode;
+class CValidationState;
+
+/** A transaction waiting for admission into the mempool. */
+struct CTxAdmission {
+    std::shared_ptr<CBaseTx> pTx;
+    CNode *pFrom;           // referenced while queued, nullptr if not received from network
+    string strCommand;
+    uint64_t seq;           // admission order
+    int64_t queuedTime;     // micros
+    bool fPreChecked;       // passed the stateless checks
+    std::shared_ptr<CValidationState> pState;
+};
+
+struct CTxAdmissionStats {
+    uint64_t queueSize     = 0;
+    uint64_t acceptedCount = 0;
+    uint64_t rejectedCount = 0;
+    map<string, uint64_t> rejectReasons;
+    uint64_t badSigCount   = 0;  // signatures failed in precheck, left to CheckTx
+
+    // accumulated latencies of every stage in micros
+    uint64_t queuedCount   = 0;
+    int64_t queueTime      = 0;
+    uint64_t preCheckCount = 0;
+    int64_t preCheckTime   = 0;
+    uint64_t acceptCount   = 0;
+    int64_t acceptTime     = 0;
+};
+
+/**
+ * Admission pipeline of the transactions received from network. The stateless checks (type, size,
+ * IsStandardTx, duplicates in mempool and confirmed tx cache, signature) run in parallel worker threads
+ * without cs_main, only the final AcceptToMemoryPool, which executes the tx against the mempool cache,
+ * runs serialized in the admission thread under cs_main. Transactions are admitted in the order received.
+ */
+class CTxAdmissionQueue {
+public:
+    CTxAdmissionQueue() {}
+    ~CTxAdmissionQueue() { Stop(); }
+
+    void Start(uint32_t nThreads);
+    void Stop();
+    bool IsRunning() const { return !workers.empty(); }
+
+    /** Queue a tx received from pFrom, return false if the queue is not running or full. */
+    bool Push(const std::shared_ptr<CBaseTx> &pTx, CNode *pFrom, const string &strCommand);
+    /** Admit a tx received from pFrom in the calling thread, bypassing the queue. */
+    bool Admit(const std::shared_ptr<CBaseTx> &pTx, CNode *pFrom, const string &strCommand);
+
+    /**
+     * The stateless checks. The state is only looked up briefly under cs_main and the signature is
+     * verified into the signature cache without it, so that CheckTx under cs_main hits the cache.
+     */
+    bool PreCheck(CBaseTx *pBaseTx, CValidationState &state);
+
+    void GetStats(CTxAdmissionStats &statsOut);
+
+private:
+    void PreCheckWorker();
+    void AdmissionWorker();
+    bool Process(CTxAdmission &item);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable condPreCheck;
+    std::condition_variable condAdmission;
+    std::deque<CTxAdmission> pendingTxs;      // waiting for the stateless checks
+    std::map<uint64_t, CTxAdmission> doneTxs; // prechecked, waiting for admission in order
+    uint64_t nextSeq      = 0;
+    uint64_t nextAdmitSeq = 0;
+    bool fQuit            = false;
+
+    std::mutex statsMtx;
+    CTxAdmissionStats stats;
+};
+
+extern CTxAdmissionQueue txAdmissionQueue;
+
+#endif  // COIN_TXADMISSION_H
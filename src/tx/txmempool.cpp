@@ -6,34 +6,20 @@
 #include "txmempool.h"
 #include "commons/uint256.h"
 #include "main.h"
+#include "miner/miner.h"
 #include "persistence/txdb.h"
 #include "tx/tx.h"
 
 using namespace std;
 
-CTxMemPoolEntry::CTxMemPoolEntry() {
-    nTxSize   = 0;
-    dPriority = 0.0;
-
-    nTime   = 0;
-    height = 0;
-}
-
-CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height) : nTime(time), height(height) {
-    pTx       = pBaseTx->GetNewInstance();
+CTxMemPoolEntry::CTxMemPoolEntry(const std::shared_ptr<CBaseTx> &pTxIn, int64_t time, uint32_t height)
+    : pTx(pTxIn), nTime(time), height(height) {
+    txid      = pTx->GetHash();
+    sender    = pTx->txUid.ToString();
     nFees     = pTx->GetFees();
     nTxSize   = ::GetSerializeSize(*pTx, SER_NETWORK, PROTOCOL_VERSION);
     dPriority = pTx->GetPriority();
-}
-
-CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
-    this->pTx       = other.pTx->GetNewInstance();
-    this->nFees     = other.nFees;
-    this->nTxSize   = other.nTxSize;
-    this->dPriority = other.dPriority;
-
-    this->nTime     = other.nTime;
-    this->height   = other.height;
+    dFeePerKb = 0.0;
 }
 
 CTxMemPool::CTxMemPool() {
@@ -42,6 +28,14 @@ CTxMemPool::CTxMemPool() {
     // of transactions in the pool
     fSanityCheck         = false;
     nTransactionsUpdated = 0;
+    nTotalTxSize         = 0;
+    nMaxSize             = DEFAULT_MAX_MEMPOOL_SIZE * 1000000;
+    nFuelRate            = INIT_FUEL_RATES;
+}
+
+void CTxMemPool::SetMaxSize(uint64_t nMaxSizeIn) {
+    LOCK(cs);
+    nMaxSize = nMaxSizeIn;
 }
 
 uint32_t CTxMemPool::GetUpdatedTransactionNum() const {
@@ -57,42 +51,103 @@ void CTxMemPool::AddUpdatedTransactionNum(uint32_t n) {
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
     // Remove transaction from memory pool
     LOCK(cs);
-    uint256 txid = pBaseTx->GetHash();
-    if (memPoolTxs.count(txid)) {
-        removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
-        memPoolTxs.erase(txid);
-        EraseTransaction(txid);
+    auto iter = memPoolTxs.find(pBaseTx->GetHash());
+    if (iter != memPoolTxs.end()) {
+        removed.push_front(iter->GetTransaction());
+        EraseTransaction(iter->GetHash());
+        EraseEntry(iter);
         nTransactionsUpdated++;
     }
 }
 
-bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state) {
+void CTxMemPool::RemoveConfirmed(const vector<std::shared_ptr<CBaseTx> > &vptx) {
+    LOCK(cs);
+    for (const auto &pBaseTx : vptx) {
+        auto iter = memPoolTxs.find(pBaseTx->GetHash());
+        if (iter != memPoolTxs.end())
+            EraseEntry(iter);
+    }
+}
+
+void CTxMemPool::EraseEntry(CTxMemPoolEntrySet::iterator iter) {
+    nTotalTxSize -= iter->GetTxSize();
+    memPoolTxs.erase(iter);
+}
+
+bool CTxMemPool::AddUnchecked(const uint256 &txid, CTxMemPoolEntry &&entry, CValidationState &state) {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES
     // all the appropriate checks.
     LOCK(cs);
     {
-        if (!CheckTxInMemPool(txid, entry, state))
+        if (!CheckTxInMemPool(txid, entry, state, true, true))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        // the fuel is known after the tx has been executed
+        entry.SetFeePerKb(ComputeFeePerKb(entry));
+        nTotalTxSize += entry.GetTxSize();
+        memPoolTxs.insert(std::move(entry));
         ++nTransactionsUpdated;
+
+        if (!TrimToSize(txid))
+            return state.DoS(0, ERRORMSG("AddUnchecked() : txid: %s evicted, mempool full", txid.GetHex()),
+                             REJECT_INSUFFICIENTFEE, "mempool-full");
     }
     return true;
 }
 
+// Evict the transactions of the lowest fee rate once the mempool exceeds the size limit. As the evicted
+// ones have been executed into the mempool cache, the cache is rebuilt from the remaining transactions,
+// so the mempool is trimmed down to the low-water mark at once and the rebuilding is not repeated for
+// each of the following transactions. Return false if the transaction of txid itself has been evicted.
+bool CTxMemPool::TrimToSize(const uint256 &txid) {
+    if (nTotalTxSize <= nMaxSize)
+        return true;
+
+    bool fKept         = true;
+    uint32_t nEvicted  = 0;
+    uint64_t nLowWater = nMaxSize / 100 * MEMPOOL_TRIM_LOW_WATER_PERCENT;
+    auto &feeRateIndex = memPoolTxs.get<fee_rate_tag>();
+    while (nTotalTxSize > nLowWater && !feeRateIndex.empty()) {
+        auto iter = memPoolTxs.project<txid_tag>(feeRateIndex.begin());
+        if (iter->GetHash() == txid)
+            fKept = false;
+
+        EraseTransaction(iter->GetHash());
+        EraseEntry(iter);
+        ++nEvicted;
+    }
+
+    LogPrint("mempool", "CTxMemPool::TrimToSize() : evicted %u transaction(s), size: %llu bytes, limit: %llu bytes\n",
+             nEvicted, nTotalTxSize, nMaxSize);
+
+    ReScanMemPoolTx(pCdMan);
+
+    return fKept && memPoolTxs.count(txid);
+}
+
 void CTxMemPool::QueryHash(vector<uint256> &txids) {
     LOCK(cs);
 
     txids.clear();
     txids.reserve(memPoolTxs.size());
-    for (typename map<uint256, CTxMemPoolEntry>::iterator mi = memPoolTxs.begin(); mi != memPoolTxs.end(); ++mi) {
-        txids.push_back((*mi).first);
+    for (const auto &entry : memPoolTxs) {
+        txids.push_back(entry.GetHash());
+    }
+}
+
+void CTxMemPool::QuerySenderHash(const CUserID &txUid, vector<uint256> &txids) {
+    LOCK(cs);
+
+    txids.clear();
+    auto range = memPoolTxs.get<sender_tag>().equal_range(txUid.ToString());
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        txids.push_back(iter->GetHash());
     }
 }
 
 bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &memPoolEntry, CValidationState &state,
-                                  bool bExecute) {
+                                  bool bExecute, bool fCheckFeeRate) {
     // is it already confirmed in block
     if (cw->txCache.HaveTx(txid) != uint256())
         return state.Invalid(ERRORMSG("CheckTxInMemPool() : txid: %s has been confirmed", txid.GetHex()), REJECT_INVALID,
@@ -105,10 +160,10 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
                              REJECT_INVALID, "tx-invalid-height");
     }
 
-    auto spCW = std::make_shared<CCacheWrapper>(*cw);
+    CCacheSnapshot snapshot(*cw);
 
     if (bExecute) {
-        if (!memPoolEntry.GetTransaction()->ExecuteTx(chainActive.Height(), 0, *spCW, state)) {
+        if (!memPoolEntry.GetTransaction()->ExecuteTx(chainActive.Height(), 0, *snapshot, state)) {
             if (SysCfg().IsLogFailures()) {
                 pCdMan->pLogCache->SetExecuteFail(chainActive.Height(), memPoolEntry.GetTransaction()->GetHash(),
                                                   state.GetRejectCode(), state.GetRejectReason());
@@ -117,38 +172,75 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         }
     }
 
+    // A transaction that would be the first one evicted from the full mempool is rejected before its effects
+    // reach the mempool cache, which then needs no rebuilding.
+    if (fCheckFeeRate && nTotalTxSize + memPoolEntry.GetTxSize() > nMaxSize && !memPoolTxs.empty() &&
+        ComputeFeePerKb(memPoolEntry) <= memPoolTxs.get<fee_rate_tag>().begin()->GetFeePerKb())
+        return state.DoS(0, ERRORMSG("CheckTxInMemPool() : txid: %s fee rate too low, mempool full", txid.GetHex()),
+                         REJECT_INSUFFICIENTFEE, "mempool-full");
+
     // Need to re-sync all to cache layer except for transaction cache, as it's depend on
     // the global transaction cache to verify whether a transaction(txid) has been confirmed
     // already in block.
-    spCW->Flush();
+    snapshot.Commit();
 
     return true;
 }
 
 void CTxMemPool::SetMemPoolCache(CCacheDBManager *pCdManIn) {
     cw.reset(new CCacheWrapper(pCdManIn));
+
+    LOCK(cs);
+    UpdateFeeRateParams();
 }
 
 void CTxMemPool::ReScanMemPoolTx(CCacheDBManager *pCdManIn) {
     cw.reset(new CCacheWrapper(pCdManIn));
 
     LOCK(cs);
+    UpdateFeeRateParams();
+
+    // Re-execute in the order of entering the mempool, as later txs may depend on earlier ones of the same sender.
     CValidationState state;
-    for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end();) {
-        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, true)) {
-            uint256 txid = iterTx->first;
-            iterTx       = memPoolTxs.erase(iterTx++);
-            EraseTransaction(txid);
+    auto &entryTimeIndex = memPoolTxs.get<entry_time_tag>();
+    for (auto iterTx = entryTimeIndex.begin(); iterTx != entryTimeIndex.end();) {
+        auto iter = memPoolTxs.project<txid_tag>(iterTx++);
+        if (!CheckTxInMemPool(iter->GetHash(), *iter, state, true)) {
+            EraseTransaction(iter->GetHash());
+            EraseEntry(iter);
             continue;
         }
-        ++iterTx;
+        memPoolTxs.modify(iter, [&](CTxMemPoolEntry &e) { e.SetFeePerKb(ComputeFeePerKb(e)); });
     }
 }
 
+void CTxMemPool::UpdateFeeRateParams() {
+    CBlockIndex *pTip = chainActive.Tip();
+    nFuelRate         = GetElementForBurn(pTip);
+
+    uint64_t slideWindow = 0;
+    cw->sysParamCache.GetParam(SysParamType::MEDIAN_PRICE_SLIDE_WINDOW_BLOCKCOUNT, slideWindow);
+    int32_t height = pTip ? pTip->height : 0;
+    // fee symbol should be WICC or WUSD only.
+    feeMedianPrices[SYMB::WICC] = cw->ppCache.GetMedianPrice(height, slideWindow, CoinPricePair(SYMB::WICC, SYMB::USD));
+    feeMedianPrices[SYMB::WUSD] = 1 * PRICE_BOOST;
+}
+
+double CTxMemPool::ComputeFeePerKb(const CTxMemPoolEntry &entry) {
+    auto iter       = feeMedianPrices.find(std::get<0>(entry.GetFees()));
+    uint64_t price  = iter == feeMedianPrices.end() ? 0 : iter->second;
+    uint64_t fees   = std::get<1>(entry.GetFees());
+    uint64_t fuel   = entry.GetTransaction()->GetFuel(nFuelRate);
+    uint64_t txSize = std::max<uint32_t>(entry.GetTxSize(), 1);
+
+    return (double(price) / PRICE_BOOST) * (fees > fuel ? fees - fuel : 0) / (txSize / 1000.0);
+}
+
 void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    nTotalTxSize = 0;
     cw.reset(new CCacheWrapper(pCdMan));
 
     ++nTransactionsUpdated;
@@ -159,6 +251,11 @@ uint64_t CTxMemPool::Size() {
     return memPoolTxs.size();
 }
 
+uint64_t CTxMemPool::GetTotalTxSize() {
+    LOCK(cs);
+    return nTotalTxSize;
+}
+
 bool CTxMemPool::Exists(const uint256 txid) {
     LOCK(cs);
     return ((memPoolTxs.count(txid) != 0));
@@ -166,8 +263,8 @@ bool CTxMemPool::Exists(const uint256 txid) {
 
 std::shared_ptr<CBaseTx> CTxMemPool::Lookup(const uint256 txid) const {
     LOCK(cs);
-    typename map<uint256, CTxMemPoolEntry>::const_iterator i = memPoolTxs.find(txid);
-    if (i == memPoolTxs.end())
+    auto iter = memPoolTxs.find(txid);
+    if (iter == memPoolTxs.end())
         return std::shared_ptr<CBaseTx>();
-    return i->second.GetTransaction();
+    return iter->GetTransaction();
 }
\ No newline at end of file
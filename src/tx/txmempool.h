@@ -15,6 +15,12 @@
 #include <map>
 #include <memory>
 
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
 using namespace std;
 
 class CValidationState;
@@ -22,33 +28,82 @@ class CBaseTx;
 class uint256;
 
 /*
- * CTxMemPool stores these:
+ * CTxMemPool stores these. The tx is shared with the relay, block assembly and lookups instead of being
+ * cloned, and the entries are move-only so that the mempool never copies them.
  */
 class CTxMemPoolEntry {
 private:
     std::shared_ptr<CBaseTx> pTx;
+    uint256 txid;                         // Cached to avoid rehashing the tx in the mempool indexes
+    string sender;                        // Cached tx uid of the sender
     std::pair<TokenSymbol, uint64_t> nFees;  // Cached to avoid expensive parent-transaction lookups
     uint32_t nTxSize;                     // Cached to avoid recomputing tx size
     double dPriority;                     // Cached to avoid recomputing priority
+    double dFeePerKb;                     // Fees deducted fuel per KB, normalized by the median price
 
     int64_t nTime;     // Local time when entering the mempool
     uint32_t height;  // Chain height when entering the mempool
 
 public:
-    CTxMemPoolEntry(CBaseTx *ptx, int64_t time, uint32_t height);
-    CTxMemPoolEntry();
-    CTxMemPoolEntry(const CTxMemPoolEntry &other);
+    CTxMemPoolEntry(const std::shared_ptr<CBaseTx> &pTxIn, int64_t time, uint32_t height);
+    CTxMemPoolEntry(CTxMemPoolEntry &&other) = default;
+    CTxMemPoolEntry &operator=(CTxMemPoolEntry &&other) = default;
+
+    CTxMemPoolEntry(const CTxMemPoolEntry &other) = delete;
+    CTxMemPoolEntry &operator=(const CTxMemPoolEntry &other) = delete;
 
-    std::shared_ptr<CBaseTx> GetTransaction() const { return pTx; }
+    const std::shared_ptr<CBaseTx> &GetTransaction() const { return pTx; }
 
+    inline const uint256 &GetHash() const { return txid; }
+    inline const string &GetSender() const { return sender; }
     inline std::pair<TokenSymbol, uint64_t> GetFees() const { return nFees; }
     inline uint32_t GetTxSize() const { return nTxSize; }
     inline double GetPriority() const { return dPriority; }
+    inline double GetFeePerKb() const { return dFeePerKb; }
 
     inline int64_t GetTime() const { return nTime; }
     inline uint32_t GetHeight() const { return height; }
+
+    void SetFeePerKb(const double feePerKbIn) { dFeePerKb = feePerKbIn; }
 };
 
+// tags of the mempool indexes
+struct txid_tag {};
+struct fee_rate_tag {};
+struct entry_time_tag {};
+struct sender_tag {};
+struct priority_tag {};
+
+typedef boost::multi_index_container<
+    CTxMemPoolEntry,
+    boost::multi_index::indexed_by<
+        // txid -> entry
+        boost::multi_index::hashed_unique<
+            boost::multi_index::tag<txid_tag>,
+            boost::multi_index::const_mem_fun<CTxMemPoolEntry, const uint256 &, &CTxMemPoolEntry::GetHash>,
+            CUint256Hasher>,
+        // ascending fee rate, the lowest gets evicted first
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<fee_rate_tag>,
+            boost::multi_index::const_mem_fun<CTxMemPoolEntry, double, &CTxMemPoolEntry::GetFeePerKb>>,
+        // ascending entry time
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<entry_time_tag>,
+            boost::multi_index::const_mem_fun<CTxMemPoolEntry, int64_t, &CTxMemPoolEntry::GetTime>>,
+        // sender -> entries
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<sender_tag>,
+            boost::multi_index::const_mem_fun<CTxMemPoolEntry, const string &, &CTxMemPoolEntry::GetSender>>,
+        // descending priority and then fee rate, the order for the miner to pack transactions
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<priority_tag>,
+            boost::multi_index::composite_key<
+                CTxMemPoolEntry,
+                boost::multi_index::const_mem_fun<CTxMemPoolEntry, double, &CTxMemPoolEntry::GetPriority>,
+                boost::multi_index::const_mem_fun<CTxMemPoolEntry, double, &CTxMemPoolEntry::GetFeePerKb>>,
+            boost::multi_index::composite_key_compare<std::greater<double>, std::greater<double>>>>>
+    CTxMemPoolEntrySet;
+
 /*
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -58,11 +113,14 @@ public:
  * are added to the pool: if a new transaction double-spends
  * an input of a transaction in the pool, it is dropped,
  * as are non-standard transactions.
+ *
+ * The entries are indexed by txid, fee rate, entry time, sender and the miner's priority order. When
+ * the total size of transactions exceeds the limit, the ones of the lowest fee rate get evicted.
  */
 class CTxMemPool {
 public:
     mutable CCriticalSection cs;
-    map<uint256, CTxMemPoolEntry > memPoolTxs;
+    CTxMemPoolEntrySet memPoolTxs;
     std::shared_ptr<CCacheWrapper> cw;
 
 public:
@@ -70,25 +128,40 @@ public:
 
 public:
     void SetSanityCheck(bool fSanityCheckIn) { fSanityCheck = fSanityCheckIn; }
-    bool AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state);
+    void SetMaxSize(uint64_t nMaxSizeIn);
+    bool AddUnchecked(const uint256 &txid, CTxMemPoolEntry &&entry, CValidationState &state);
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
+    void RemoveConfirmed(const vector<std::shared_ptr<CBaseTx> > &vptx);
     void QueryHash(vector<uint256> &txids);
+    void QuerySenderHash(const CUserID &txUid, vector<uint256> &txids);
     uint32_t GetUpdatedTransactionNum() const;
     void AddUpdatedTransactionNum(uint32_t n);
 
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state,
-                          bool bExecute = true);
+                          bool bExecute = true, bool fCheckFeeRate = false);
     void SetMemPoolCache(CCacheDBManager *pCdManIn);
     void ReScanMemPoolTx(CCacheDBManager *pCdManIn);
     void Clear();
 
     uint64_t Size();
+    uint64_t GetTotalTxSize();
+    uint64_t GetMaxSize() const { return nMaxSize; }
     bool Exists(const uint256 txid);
     std::shared_ptr<CBaseTx> Lookup(const uint256 txid) const;
 
+private:
+    void EraseEntry(CTxMemPoolEntrySet::iterator iter);
+    bool TrimToSize(const uint256 &txid);
+    void UpdateFeeRateParams();
+    double ComputeFeePerKb(const CTxMemPoolEntry &entry);
+
 private:
     bool fSanityCheck; // Normally false, true if -checkmempool or -regtest
     uint32_t nTransactionsUpdated;
+    uint64_t nTotalTxSize;  // total serialized size of the transactions in bytes
+    uint64_t nMaxSize;      // limit of nTotalTxSize
+    uint32_t nFuelRate;     // fuel rate of the next block, to compute the fee rates
+    map<TokenSymbol, uint64_t> feeMedianPrices;  // median prices of the fee symbols, to normalize the fee rates
 };
 
 
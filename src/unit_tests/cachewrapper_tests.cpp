@@ -0,0 +1,123 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "persistence/cachewrapper.h"
+#include "unit_tests/testutil.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t BENCH_ACCOUNT_COUNT = 1000;
+static const uint32_t BENCH_TX_COUNT      = 50000;
+
+static CKeyID MakeKeyId(uint32_t i) {
+    uint160 id;
+    *(uint32_t *)id.begin() = i + 1;
+    return CKeyID(id);
+}
+
+// a tx touching a single account
+static void ExecuteTx(CCacheWrapper &cw, uint32_t i) {
+    CKeyID keyId = MakeKeyId(i % BENCH_ACCOUNT_COUNT);
+    CAccount account;
+    BOOST_CHECK(cw.accountCache.GetAccount(keyId, account));
+    account.last_vote_height = i;
+    cw.accountCache.SetAccount(keyId, account);
+}
+
+struct CacheWrapperTestingSetup {
+    CCacheDBManager cdMan;
+    CCacheWrapper cw;
+
+    CacheWrapperTestingSetup() : cdMan(true, false, 1 << 20, 1 << 20, 1 << 20, 1 << 20), cw(&cdMan) {
+        for (uint32_t i = 0; i < BENCH_ACCOUNT_COUNT; ++i) {
+            CKeyID keyId = MakeKeyId(i);
+            cw.accountCache.SetAccount(keyId, CAccount(keyId));
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(cachewrapper_tests, CacheWrapperTestingSetup)
+
+BOOST_AUTO_TEST_CASE(cachewrapper_snapshot_test)
+{
+    CKeyID keyId = MakeKeyId(0);
+    CAccount account;
+    {
+        CCacheSnapshot snapshot(cw);
+        ExecuteTx(*snapshot, 7);
+        BOOST_CHECK(snapshot->accountCache.GetAccount(keyId, account) && account.last_vote_height == 7);
+        BOOST_CHECK(cw.accountCache.GetAccount(keyId, account) && account.last_vote_height == 0);
+    }
+    // rolled back when out of scope
+    BOOST_CHECK(cw.accountCache.GetAccount(keyId, account) && account.last_vote_height == 0);
+
+    {
+        CCacheSnapshot snapshot(cw);
+        ExecuteTx(*snapshot, 8);
+        snapshot.Commit();
+        BOOST_CHECK(cw.accountCache.GetAccount(keyId, account) && account.last_vote_height == 8);
+
+        // nested snapshots take different children, the committed snapshot is empty again
+        CCacheSnapshot nested(cw);
+        BOOST_CHECK(&*nested != &*snapshot);
+        BOOST_CHECK(snapshot->accountCache.GetCacheSize() == 0);
+    }
+
+    // the released child is reused
+    CCacheWrapper *pChild = nullptr;
+    {
+        CCacheSnapshot snapshot(cw);
+        pChild = &*snapshot;
+    }
+    CCacheSnapshot snapshot(cw);
+    BOOST_CHECK(&*snapshot == pChild);
+    BOOST_CHECK(snapshot->accountCache.GetAccount(keyId, account) && account.last_vote_height == 8);
+}
+
+BOOST_AUTO_TEST_CASE(cachewrapper_snapshot_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    // create only
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_TX_COUNT; ++i) {
+        auto spCW = std::make_shared<CCacheWrapper>(cw);
+    }
+    int64_t nCopyCreateTime = GetTimeMicros() - nStart;
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_TX_COUNT; ++i) {
+        CCacheSnapshot snapshot(cw);
+    }
+    int64_t nSnapshotCreateTime = GetTimeMicros() - nStart;
+
+    // create, execute and flush
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_TX_COUNT; ++i) {
+        auto spCW = std::make_shared<CCacheWrapper>(cw);
+        ExecuteTx(*spCW, i);
+        spCW->Flush();
+    }
+    int64_t nCopyFlushTime = GetTimeMicros() - nStart;
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_TX_COUNT; ++i) {
+        CCacheSnapshot snapshot(cw);
+        ExecuteTx(*snapshot, i);
+        snapshot.Commit();
+    }
+    int64_t nSnapshotFlushTime = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("cachewrapper_snapshot_bench: %u txs, create: copy %.3fus/tx, snapshot %.3fus/tx; "
+                                 "create+execute+flush: copy %.3fus/tx, snapshot %.3fus/tx", BENCH_TX_COUNT,
+                                 (double)nCopyCreateTime / BENCH_TX_COUNT, (double)nSnapshotCreateTime / BENCH_TX_COUNT,
+                                 (double)nCopyFlushTime / BENCH_TX_COUNT, (double)nSnapshotFlushTime / BENCH_TX_COUNT));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,272 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/util.h"
+#include "config/chainparams.h"
+#include "config/configuration.h"
+#include "config/const.h"
+#include "persistence/cdpdb.h"
+#include "unit_tests/testutil.h"
+
+#include <limits>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t INDEX_TEST_CDP_COUNT        = 2000;
+static const uint32_t BENCH_FLUSH_BATCH_COUNT     = 100000;
+static const uint64_t FORCE_LIQUIDATE_RATIO       = 10400;      // 104%
+static const uint64_t BENCH_BCOIN_PRICE           = 95000000;   // 0.95, about 1% of the bench cdps to liquidate
+static const uint64_t ALL_CDPS_BCOIN_PRICE        = 10000000;   // 0.1, all the test cdps to liquidate
+
+static uint256 MakeCdpId(uint32_t i) {
+    uint256 id;
+    *(uint32_t *)id.begin() = i + 1;
+    return id;
+}
+
+// the collateral ratio base is spread over [1.0, 10.0)
+static CUserCDP MakeCdp(uint32_t i, uint32_t seed = 0) {
+    uint64_t owedScoins   = 100 * COIN;
+    uint64_t stakedBcoins = owedScoins * (1000 + ((i + seed) * 7919ULL) % 9000) / 1000;
+    return CUserCDP(CRegID(i / 1000 + 1, i % 1000), MakeCdpId(i), 1, SYMB::WICC, SYMB::WUSD, stakedBcoins,
+                    owedScoins);
+}
+
+// the ids in the order of the set, CUserCDP has no equality
+static vector<uint256> GetCdpIds(const set<CUserCDP> &cdps) {
+    vector<uint256> cdpIds;
+    for (const auto &cdp : cdps)
+        cdpIds.push_back(cdp.cdpid);
+    return cdpIds;
+}
+
+// the cdps to liquidate picked from all the cdps, the expected result of the index
+static set<CUserCDP> GetCdpsToLiquidate(const map<uint256, CUserCDP> &cdps, uint64_t collateralRatio,
+                                        uint64_t bcoinMedianPrice) {
+    double ratio = (double(collateralRatio) / RATIO_BOOST) / (double(bcoinMedianPrice) / PRICE_BOOST);
+    set<CUserCDP> result;
+    for (const auto &item : cdps) {
+        if (item.second.collateral_ratio_base <= ratio)
+            result.insert(item.second);
+    }
+    return result;
+}
+
+static void CheckCdpCache(CCDPDBCache &cache, const map<uint256, CUserCDP> &cdps) {
+    for (uint64_t price : {20000000ULL, 50000000ULL, 95000000ULL, 100000000ULL, 1000000000ULL}) {
+        set<CUserCDP> userCdps;
+        BOOST_CHECK(cache.GetCdpListByCollateralRatio(FORCE_LIQUIDATE_RATIO, price, userCdps));
+        BOOST_CHECK(GetCdpIds(userCdps) == GetCdpIds(GetCdpsToLiquidate(cdps, FORCE_LIQUIDATE_RATIO, price)));
+    }
+
+    uint64_t stakedBcoins = 0, owedScoins = 0;
+    for (const auto &item : cdps) {
+        stakedBcoins += item.second.total_staked_bcoins;
+        owedScoins += item.second.total_owed_scoins;
+    }
+    uint64_t globalStakedBcoins = 0, globalOwedScoins = 0;
+    cache.GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+    BOOST_CHECK_EQUAL(globalStakedBcoins, stakedBcoins);
+    BOOST_CHECK_EQUAL(globalOwedScoins, owedScoins);
+}
+
+// the cdps of a block: every 7th cdp updated, a third of them closed, and new cdps opened
+static map<uint256, CUserCDP> ApplyBlock(CCDPDBCache &cache, const map<uint256, CUserCDP> &cdps) {
+    const int32_t height = SysCfg().GetFeatureForkV3Height();
+    map<uint256, CUserCDP> blockCdps = cdps;
+    for (uint32_t i = 0; i < INDEX_TEST_CDP_COUNT; i += 7) {
+        const CUserCDP &oldCdp = cdps.at(MakeCdpId(i));
+        CUserCDP newCdp        = MakeCdp(i, 1234);
+        if (i % 3 == 0) {
+            newCdp.Redeem(2, newCdp.total_staked_bcoins, newCdp.total_owed_scoins);
+            blockCdps.erase(newCdp.cdpid);
+        } else {
+            blockCdps[newCdp.cdpid] = newCdp;
+        }
+        BOOST_CHECK(cache.UpdateCDP(height, oldCdp, newCdp));
+    }
+    for (uint32_t i = INDEX_TEST_CDP_COUNT; i < INDEX_TEST_CDP_COUNT + 100; ++i) {
+        CUserCDP cdp = MakeCdp(i);
+        BOOST_CHECK(cache.NewCDP(2, cdp));
+        blockCdps.emplace(cdp.cdpid, cdp);
+    }
+    return blockCdps;
+}
+
+BOOST_AUTO_TEST_SUITE(cdpdb_tests)
+
+BOOST_AUTO_TEST_CASE(cdp_ratio_index_test)
+{
+    shared_ptr<CDBAccess> pDbAccess = make_shared<CDBAccess>(DBNameType::CDP, 1 << 20, false, true);
+
+    // the cdps written before the index existed are indexed when the db is opened
+    map<uint256, CUserCDP> cdps;
+    for (uint32_t i = 0; i < INDEX_TEST_CDP_COUNT / 2; ++i) {
+        CUserCDP cdp = MakeCdp(i);
+        cdps.emplace(cdp.cdpid, cdp);
+    }
+    pDbAccess->BatchWrite<uint256, CUserCDP>(dbk::CDP, cdps);
+
+    CCDPDBCache dbCache(pDbAccess.get());
+    CheckCdpCache(dbCache, cdps);
+
+    for (uint32_t i = INDEX_TEST_CDP_COUNT / 2; i < INDEX_TEST_CDP_COUNT; ++i) {
+        CUserCDP cdp = MakeCdp(i);
+        BOOST_CHECK(dbCache.NewCDP(1, cdp));
+        cdps.emplace(cdp.cdpid, cdp);
+    }
+    CheckCdpCache(dbCache, cdps);
+    dbCache.Flush();
+    CheckCdpCache(dbCache, cdps);
+
+    // the changes of a block in an overlay, merged with the index in db by the range scan
+    CCDPDBCache blockCache;
+    blockCache.SetBaseViewPtr(&dbCache);
+    CDBOpLogMap dbOpLogMap;
+    blockCache.SetDbOpLogMap(&dbOpLogMap);
+
+    map<uint256, CUserCDP> blockCdps = ApplyBlock(blockCache, cdps);
+    CheckCdpCache(blockCache, blockCdps);
+    CheckCdpCache(dbCache, cdps);
+
+    // undoing the block restores the index and the global amounts
+    BOOST_CHECK(blockCache.UndoDatas());
+    CheckCdpCache(blockCache, cdps);
+
+    // or the block is flushed down to the db
+    CCDPDBCache blockCache2;
+    blockCache2.SetBaseViewPtr(&dbCache);
+    ApplyBlock(blockCache2, cdps);
+    blockCache2.Flush();
+    dbCache.Flush();
+    CheckCdpCache(dbCache, blockCdps);
+}
+
+BOOST_AUTO_TEST_CASE(cdp_update_fork_v3_test)
+{
+    shared_ptr<CDBAccess> pDbAccess = make_shared<CDBAccess>(DBNameType::CDP, 1 << 20, false, true);
+    CCDPDBCache dbCache(pDbAccess.get());
+    CUserCDP cdp0 = MakeCdp(0), cdp1 = MakeCdp(1);
+    BOOST_CHECK(dbCache.NewCDP(1, cdp0) && dbCache.NewCDP(1, cdp1));
+    dbCache.Flush();
+
+    CUserCDP movedCdp0 = MakeCdp(0, 1234), closedCdp1 = cdp1;
+    closedCdp1.Redeem(2, cdp1.total_staked_bcoins, cdp1.total_owed_scoins);
+
+    // the cdps at their ratios and in the global amounts, as a rebuilt index has them
+    auto CheckExact = [&](CCDPDBCache &cache) {
+        set<CUserCDP> userCdps;
+        BOOST_CHECK(cache.GetCdpListByCollateralRatio(FORCE_LIQUIDATE_RATIO, ALL_CDPS_BCOIN_PRICE, userCdps));
+        BOOST_CHECK(GetCdpIds(userCdps) == vector<uint256>{cdp0.cdpid});
+        uint64_t globalStakedBcoins = 0, globalOwedScoins = 0;
+        cache.GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+        BOOST_CHECK_EQUAL(globalStakedBcoins, cdp0.total_staked_bcoins);
+        BOOST_CHECK_EQUAL(globalOwedScoins, cdp0.total_owed_scoins);
+    };
+
+    for (int32_t height : {1, (int32_t)SysCfg().GetFeatureForkV3Height()}) {
+        CCDPDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dbCache);
+
+        // cdp0 moved and back at the ratio erased in the same layer, cdp1 closed
+        BOOST_CHECK(blockCache.UpdateCDP(height, cdp0, movedCdp0));
+        BOOST_CHECK(blockCache.UpdateCDP(height, movedCdp0, cdp0));
+        BOOST_CHECK(blockCache.UpdateCDP(height, cdp1, closedCdp1));
+
+        if (!IsFeatureForkV3(height)) {
+            // cdp0 hidden by its erased entry, cdp1 subtracted twice
+            set<CUserCDP> userCdps;
+            BOOST_CHECK(blockCache.GetCdpListByCollateralRatio(FORCE_LIQUIDATE_RATIO, ALL_CDPS_BCOIN_PRICE, userCdps));
+            BOOST_CHECK(userCdps.empty());
+            uint64_t globalStakedBcoins = 0, globalOwedScoins = 0;
+            blockCache.GetGlobalItem(globalStakedBcoins, globalOwedScoins);
+            BOOST_CHECK_EQUAL(globalStakedBcoins, cdp0.total_staked_bcoins - cdp1.total_staked_bcoins);
+            BOOST_CHECK_EQUAL(globalOwedScoins, cdp0.total_owed_scoins - cdp1.total_owed_scoins);
+
+            // dropped with the last block before the fork, and undone with it
+            CDBOpLogMap dbOpLogMap;
+            blockCache.SetDbOpLogMap(&dbOpLogMap);
+            BOOST_CHECK(blockCache.RebuildRatioIndex());
+            CheckExact(blockCache);
+            BOOST_CHECK(blockCache.UndoDatas());
+            userCdps.clear();
+            BOOST_CHECK(blockCache.GetCdpListByCollateralRatio(FORCE_LIQUIDATE_RATIO, ALL_CDPS_BCOIN_PRICE, userCdps));
+            BOOST_CHECK(userCdps.empty());
+        } else {
+            CheckExact(blockCache);
+        }
+    }
+
+    // the bookkeeping before the fork written to db does not outlive a restart
+    CCDPDBCache blockCache;
+    blockCache.SetBaseViewPtr(&dbCache);
+    BOOST_CHECK(blockCache.UpdateCDP(1, cdp0, movedCdp0));
+    BOOST_CHECK(blockCache.UpdateCDP(1, movedCdp0, cdp0));
+    BOOST_CHECK(blockCache.UpdateCDP(1, cdp1, closedCdp1));
+    blockCache.Flush();
+    dbCache.Flush();
+
+    CCDPDBCache restartedCache(pDbAccess.get());
+    CheckExact(restartedCache);
+}
+
+BOOST_AUTO_TEST_CASE(cdp_liquidate_scan_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    for (uint32_t cdpCount : {100000U, 1000000U}) {
+        shared_ptr<CDBAccess> pDbAccess = make_shared<CDBAccess>(DBNameType::CDP, 8 << 20, false, true);
+        {
+            CCDPDBCache dbCache(pDbAccess.get());
+            for (uint32_t i = 0; i < cdpCount; ++i) {
+                CUserCDP cdp = MakeCdp(i);
+                dbCache.NewCDP(1, cdp);
+                if ((i + 1) % BENCH_FLUSH_BATCH_COUNT == 0)
+                    dbCache.Flush();
+            }
+            dbCache.Flush();
+        }
+
+        // all the cdps loaded into a set ordered by the ratio and walked up to the bound, as before the index
+        uint64_t nStartMemory = GetResidentSize();
+        int64_t nStart        = GetTimeMicros();
+        set<CUserCDP> allCdps;
+        {
+            map<uint256, CUserCDP> rawCdps;
+            BOOST_CHECK(pDbAccess->GetAllElements(dbk::CDP, rawCdps));
+            for (const auto &item : rawCdps)
+                allCdps.insert(item.second);
+        }
+        int64_t nLoadTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+        int64_t nLoadMemory = GetResidentSize() - nStartMemory;
+
+        nStart = GetTimeMicros();
+        CUserCDP boundary;
+        boundary.collateral_ratio_base =
+            (double(FORCE_LIQUIDATE_RATIO) / RATIO_BOOST) / (double(BENCH_BCOIN_PRICE) / PRICE_BOOST);
+        boundary.owner_regid = CRegID(std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint16_t>::max());
+        set<CUserCDP> walkedCdps(allCdps.begin(), allCdps.upper_bound(boundary));
+        int64_t nWalkTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+        allCdps.clear();
+
+        // the range scan of the ratio index on a fresh cache, nothing held in memory beforehand
+        CCDPDBCache dbCache(pDbAccess.get());
+        nStart = GetTimeMicros();
+        set<CUserCDP> scannedCdps;
+        BOOST_CHECK(dbCache.GetCdpListByCollateralRatio(FORCE_LIQUIDATE_RATIO, BENCH_BCOIN_PRICE, scannedCdps));
+        int64_t nScanTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+
+        BOOST_CHECK(!scannedCdps.empty());
+        BOOST_CHECK(GetCdpIds(scannedCdps) == GetCdpIds(walkedCdps));
+
+        BOOST_TEST_MESSAGE(strprintf("cdp_liquidate_scan_bench: %u cdps, %u to liquidate, load all: %lld us, "
+                                     "+%lld KB RSS, walk: %lld us, index range scan: %lld us",
+                                     cdpCount, scannedCdps.size(), nLoadTime, nLoadMemory / 1024, nWalkTime,
+                                     nScanTime));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <deque>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+// the block index entries of a test chain, kept in mapBlockIndex until destroyed
+struct CTestBlockIndexes {
+    deque<CBlockIndex> indexes;
+    vector<uint256> hashes;
+
+    ~CTestBlockIndexes() {
+        LOCK(cs_mapBlockIndex);
+        for (const auto &hash : hashes)
+            mapBlockIndex.erase(hash);
+    }
+
+    CBlockIndex *Add(CBlockIndex *pPrev, uint32_t nSalt) {
+        indexes.emplace_back();
+        CBlockIndex *pIndex = &indexes.back();
+        pIndex->pprev       = pPrev;
+        pIndex->height      = pPrev ? pPrev->height + 1 : 0;
+        pIndex->BuildSkip();
+
+        uint256 hash = ArithToUint256(arith_uint256(nSalt) << 32 | arith_uint256(pIndex->height + 1));
+        LOCK(cs_mapBlockIndex);
+        pIndex->pBlockHash = &mapBlockIndex.emplace(hash, pIndex).first->first;
+        hashes.push_back(hash);
+        return pIndex;
+    }
+
+    CBlockIndex *AddChain(CBlockIndex *pPrev, int32_t count, uint32_t nSalt) {
+        for (int32_t i = 0; i < count; ++i)
+            pPrev = Add(pPrev, nSalt);
+        return pPrev;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(chainsnapshot_tests)
+
+BOOST_AUTO_TEST_CASE(chainsnapshot_test)
+{
+    CTestBlockIndexes test;
+    CBlockIndex *pTip  = test.AddChain(nullptr, 1000, 1);
+    CBlockIndex *pFork = pTip->GetAncestor(900);
+    CBlockIndex *pForkTip = test.AddChain(pFork, 50, 2);
+
+    CChain chain;
+    chain.SetTip(pTip);
+    CChainSnapshot snapshot(pTip);
+    BOOST_CHECK(snapshot.Height() == 999 && snapshot.Tip() == pTip);
+    for (int32_t height = -1; height <= 1000; ++height) {
+        BOOST_CHECK(snapshot[height] == chain[height]);
+        if (chain[height]) {
+            BOOST_CHECK(snapshot.Contains(chain[height]));
+            BOOST_CHECK(snapshot.Next(chain[height]) == chain.Next(chain[height]));
+        }
+    }
+    BOOST_CHECK(!snapshot.Contains(pForkTip) && !snapshot.Contains(pForkTip->GetAncestor(901)));
+    BOOST_CHECK(snapshot.Next(pForkTip->GetAncestor(901)) == nullptr);
+
+    // the locator of the fork finds the fork point, the unknown hashes are skipped
+    CChain forkChain;
+    forkChain.SetTip(pForkTip);
+    CBlockLocator locator = forkChain.GetLocator();
+    locator.vHave.insert(locator.vHave.begin(), uint256S("1234"));
+    BOOST_CHECK(snapshot.FindFork(locator) == chain.FindFork(locator));
+    BOOST_CHECK(snapshot.FindFork(locator) == pFork);
+    BOOST_CHECK(snapshot.FindFork(CBlockLocator()) == snapshot[0]);
+
+    // the snapshot stays on its chain after the active chain moves to the fork
+    chain.SetTip(pForkTip);
+    BOOST_CHECK(snapshot[950] == pTip->GetAncestor(950) && chain[950] == pForkTip);
+    BOOST_CHECK(LookupBlockIndex(pForkTip->GetBlockHash()) == pForkTip);
+    BOOST_CHECK(LookupBlockIndex(uint256S("1234")) == nullptr);
+
+    BOOST_CHECK(CChainSnapshot().Tip() == nullptr && CChainSnapshot()[0] == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
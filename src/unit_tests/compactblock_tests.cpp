@@ -0,0 +1,105 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "p2p/compactblock.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TXS_PER_BLOCK = 100;
+
+static std::shared_ptr<CBaseTx> MakeTx(uint32_t height, uint32_t i) {
+    return std::make_shared<CBaseCoinTransferTx>(CRegID(height, i), CRegID(1, 1), height, i + 1, 10000, "");
+}
+
+static void MakeBlock(uint32_t height, CBlock &block) {
+    block.SetNull();
+    block.SetHeight(height);
+    block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+    for (uint32_t i = 0; i < TXS_PER_BLOCK; ++i)
+        block.vptx.push_back(MakeTx(height, i));
+    block.SetMerkleRootHash(block.BuildMerkleTree());
+}
+
+BOOST_AUTO_TEST_SUITE(compactblock_tests)
+
+BOOST_AUTO_TEST_CASE(compactblock_test)
+{
+    CBlock block;
+    MakeBlock(10, block);
+
+    // the block reward tx is sent in full, the others by short ids
+    CCompactBlock sentBlock(block, 42);
+    BOOST_CHECK(sentBlock.prefilledTxs.size() == 1 && sentBlock.prefilledTxs[0].index == 0);
+    BOOST_CHECK(sentBlock.shortTxIds.size() == TXS_PER_BLOCK);
+
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << sentBlock;
+    uint32_t cmpctSize = ds.size();
+    CCompactBlock cmpctblock;
+    ds >> cmpctblock;
+    BOOST_CHECK(cmpctblock.header.GetHash() == block.GetHash() && cmpctblock.GetTxCount() == block.vptx.size());
+    BOOST_CHECK(cmpctSize * 2 < ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+
+    // the txs at hand, with the unrelated ones skipped
+    CPartialBlock partialBlock;
+    BOOST_REQUIRE(partialBlock.Init(cmpctblock) == CPartialBlock::READ_OK);
+    for (uint32_t i = 0; i < TXS_PER_BLOCK; ++i) {
+        auto pTx = MakeTx(11, i);
+        BOOST_CHECK(!partialBlock.IsWanted(pTx->GetHash()));
+        partialBlock.AddTx(pTx->GetHash(), pTx);
+    }
+    for (uint32_t i = 1; i < block.vptx.size(); i += 2) {
+        BOOST_CHECK(partialBlock.IsWanted(block.vptx[i]->GetHash()));
+        partialBlock.AddTx(block.vptx[i]->GetHash(), block.vptx[i]);
+        BOOST_CHECK(!partialBlock.IsWanted(block.vptx[i]->GetHash()));
+    }
+    BOOST_CHECK(partialBlock.GetPrefilledCount() == 1 && partialBlock.GetFoundCount() == TXS_PER_BLOCK / 2);
+    BOOST_CHECK(partialBlock.HasMissing());
+
+    vector<uint32_t> indexes = partialBlock.GetMissingIndexes();
+    BOOST_REQUIRE(indexes.size() == TXS_PER_BLOCK / 2);
+    vector<std::shared_ptr<CBaseTx> > missingTxs;
+    for (uint32_t index : indexes) {
+        BOOST_CHECK(index % 2 == 0 && index > 0);
+        missingTxs.push_back(block.vptx[index]);
+    }
+
+    CBlock filledBlock;
+    BOOST_CHECK(partialBlock.FillBlock(filledBlock, missingTxs) == CPartialBlock::READ_OK);
+    BOOST_CHECK(filledBlock.GetHash() == block.GetHash() && filledBlock.vptx.size() == block.vptx.size());
+    for (uint32_t i = 0; i < block.vptx.size(); ++i)
+        BOOST_CHECK(filledBlock.vptx[i]->GetHash() == block.vptx[i]->GetHash());
+
+    // too few txs is the fault of the peer, a wrong tx is a collision to download the block in full
+    vector<std::shared_ptr<CBaseTx> > fewerTxs(missingTxs.begin() + 1, missingTxs.end());
+    BOOST_CHECK(partialBlock.FillBlock(filledBlock, fewerTxs) == CPartialBlock::READ_INVALID);
+    missingTxs[0] = MakeTx(12, 0);
+    BOOST_CHECK(partialBlock.FillBlock(filledBlock, missingTxs) == CPartialBlock::READ_FAILED);
+
+    // two txs of the block with the same short id
+    CBlock mutatedBlock;
+    MakeBlock(10, mutatedBlock);
+    mutatedBlock.vptx.resize(4);
+    mutatedBlock.SetMerkleRootHash(mutatedBlock.BuildMerkleTree());
+    CCompactBlock mutatedCmpctBlock(mutatedBlock, 7);
+    mutatedCmpctBlock.shortTxIds.push_back(mutatedCmpctBlock.shortTxIds.back());
+    BOOST_CHECK(partialBlock.Init(mutatedCmpctBlock) == CPartialBlock::READ_FAILED);
+
+    // malformed prefilled txs
+    CCompactBlock badBlock = cmpctblock;
+    badBlock.prefilledTxs.push_back(badBlock.prefilledTxs[0]);
+    badBlock.shortTxIds.pop_back();
+    BOOST_CHECK(partialBlock.Init(badBlock) == CPartialBlock::READ_INVALID);
+    badBlock = cmpctblock;
+    badBlock.prefilledTxs[0].index = cmpctblock.GetTxCount();
+    BOOST_CHECK(partialBlock.Init(badBlock) == CPartialBlock::READ_INVALID);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,9 +9,77 @@
 #include <map>
 #include <boost/test/unit_test.hpp>
 #include "persistence/dbaccess.h"
+#include "entities/account.h"
+#include "persistence/contractdb.h"
+#include "persistence/dbflusher.h"
+#include "unit_tests/testutil.h"
 
 using namespace std;
 
+typedef CCompositeKVCache<dbk::KEYID_ACCOUNT, CKeyID, CAccount> AccountCache;
+
+static const uint32_t BENCH_ACCOUNT_COUNT = 10000;
+static const uint32_t BENCH_OP_COUNT      = 100000;
+
+static CKeyID MakeKeyId(uint32_t i) {
+    uint160 id;
+    *(uint32_t *)id.begin() = i + 1;
+    return CKeyID(id);
+}
+
+// The on-disk size of the accounts keyed by the prefix and the key id, once written to a table file by reopening the
+// db, which replays its log.
+static uint64_t GetAccountDbSize(const map<CKeyID, CAccount> &accounts, const string &prefix) {
+    boost::filesystem::path path = GetDataDir() / "blocks" / strprintf("dbkey_size_%u", prefix.size());
+    {
+        CLevelDBWrapper db(path, 1 << 20, false, true);
+        CLevelDBBatch batch;
+        for (const auto &item : accounts) {
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            ssKey.write(prefix.data(), prefix.size());
+            ssKey << item.first;
+            batch.Write(string(ssKey.begin(), ssKey.end()), item.second);
+        }
+        db.WriteBatch(batch, true);
+    }
+    { CLevelDBWrapper db(path, 1 << 20); }
+
+    uint64_t size = 0;
+    for (boost::filesystem::directory_iterator it(path), end; it != end; ++it) {
+        string ext = it->path().extension().string();
+        if (ext == ".ldb" || ext == ".sst")
+            size += boost::filesystem::file_size(it->path());
+    }
+    boost::filesystem::remove_all(path);
+    return size;
+}
+
+// reads of existing accounts : reads of missing accounts : writes = 7 : 1 : 2
+static int64_t BenchAccountCache(CDBAccess &dbAccess, uint32_t layers) {
+    vector<shared_ptr<AccountCache>> caches;
+    caches.push_back(make_shared<AccountCache>(&dbAccess));
+    for (uint32_t i = 1; i < layers; ++i)
+        caches.push_back(make_shared<AccountCache>(caches.back().get()));
+    AccountCache &cache = *caches.back();
+
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_OP_COUNT; ++i) {
+        CAccount account;
+        uint32_t op = i % 10;
+        if (op < 7) {
+            BOOST_CHECK(cache.GetData(MakeKeyId((i * 7919) % BENCH_ACCOUNT_COUNT), account));
+        } else if (op < 8) {
+            BOOST_CHECK(!cache.GetData(MakeKeyId(BENCH_ACCOUNT_COUNT + i % 1000), account));
+        } else {
+            CKeyID keyId = MakeKeyId((i * 104729) % BENCH_ACCOUNT_COUNT);
+            BOOST_CHECK(cache.GetData(keyId, account));
+            account.last_vote_height = i;
+            cache.SetData(keyId, account);
+        }
+    }
+    return max<int64_t>(GetTimeMicros() - nStart, 1);
+}
+
 BOOST_AUTO_TEST_SUITE(dbaccess_tests)
 
 
@@ -35,6 +103,155 @@ BOOST_AUTO_TEST_CASE(dbaccess_test)
 
 }
 
+template<typename KeyElement>
+static bool IsSameDbKey(dbk::PrefixType prefixType, const KeyElement &key) {
+    dbk::CDBKeyBuffer keyBuf(prefixType, key);
+    return keyBuf.GetSlice() == Slice(dbk::GenDbKey(prefixType, key));
+}
+
+BOOST_AUTO_TEST_CASE(dbkey_buffer_test)
+{
+    BOOST_CHECK(IsSameDbKey(dbk::KEYID_ACCOUNT, MakeKeyId(1)));
+    BOOST_CHECK(IsSameDbKey(dbk::TXID_DISKINDEX, GetRandHash()));
+    BOOST_CHECK(IsSameDbKey(dbk::REGID_KEYID, CRegID(100, 2).ToRawString()));
+    BOOST_CHECK(IsSameDbKey(dbk::CONTRACT_DATA, std::make_pair(CRegID(100, 2).ToRawString(), CDBContractKey("key"))));
+    // spilled to heap
+    BOOST_CHECK(IsSameDbKey(dbk::CONTRACT_DATA, std::make_pair(string(100, 'r'), CDBContractKey(string(200, 'k')))));
+}
+
+BOOST_AUTO_TEST_CASE(dbkey_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    const bool isWipe = true;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, 100000, false, isWipe);
+
+    map<CKeyID, CAccount> accounts;
+    vector<CKeyID> keyIds;
+    for (uint32_t i = 0; i < BENCH_ACCOUNT_COUNT; ++i) {
+        keyIds.push_back(MakeKeyId(i));
+        accounts.emplace(keyIds.back(), CAccount(keyIds.back()));
+    }
+    pDBAccess->BatchWrite<CKeyID, CAccount>(dbk::KEYID_ACCOUNT, accounts);
+
+    size_t nKeySize = 0;
+    int64_t nStart  = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_OP_COUNT; ++i)
+        nKeySize += dbk::GenDbKey(dbk::KEYID_ACCOUNT, keyIds[i % keyIds.size()]).size();
+    int64_t nStreamTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_OP_COUNT; ++i) {
+        dbk::CDBKeyBuffer keyBuf(dbk::KEYID_ACCOUNT, keyIds[i % keyIds.size()]);
+        nKeySize -= keyBuf.GetSlice().size();
+    }
+    int64_t nBufferTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+    BOOST_CHECK(nKeySize == 0);
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_OP_COUNT; ++i) {
+        CAccount account;
+        BOOST_CHECK(pDBAccess->GetData(dbk::KEYID_ACCOUNT, keyIds[i % keyIds.size()], account));
+    }
+    int64_t nGetDataTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+
+    BOOST_TEST_MESSAGE(strprintf("dbkey_bench: %u keys, build key: stream %.3fus/key, buffer %.3fus/key; "
+                                 "GetData: %.3fus/lookup", BENCH_OP_COUNT, (double)nStreamTime / BENCH_OP_COUNT,
+                                 (double)nBufferTime / BENCH_OP_COUNT, (double)nGetDataTime / BENCH_OP_COUNT));
+
+    // the db size of the idac prefix against a 1 byte prefix, which leveldb mostly prefix-compresses away
+    const string &prefix = dbk::GetKeyPrefix(dbk::KEYID_ACCOUNT);
+    uint64_t nPrefixSize = GetAccountDbSize(accounts, prefix);
+    uint64_t nShortSize  = GetAccountDbSize(accounts, prefix.substr(0, 1));
+    BOOST_CHECK(nPrefixSize > 0 && nShortSize > 0);
+    BOOST_TEST_MESSAGE(strprintf("dbkey_bench: %u accounts, db size: %s prefix %llu bytes, 1 byte prefix %llu bytes",
+                                 accounts.size(), prefix, nPrefixSize, nShortSize));
+}
+
+BOOST_AUTO_TEST_CASE(dbflusher_test)
+{
+    const bool isWipe = true;
+    shared_ptr<CDBAccess> pAccountDb = make_shared<CDBAccess>(DBNameType::ACCOUNT, 100000, false, isWipe);
+    shared_ptr<CDBAccess> pContractDb = make_shared<CDBAccess>(DBNameType::CONTRACT, 100000, false, isWipe);
+    boost::filesystem::path pathJournal = GetDataDir() / "blocks" / "dbjournal.dat";
+
+    CDBFlusher flusher({pAccountDb.get(), pContractDb.get()}, pathJournal);
+    flusher.Start();
+    BOOST_CHECK(flusher.Recover());
+
+    CCompositeKVCache<dbk::REGID_KEYID, string, string> accountCache(pAccountDb.get());
+    CCompositeKVCache<dbk::CONTRACT_DEF, string, string> contractCache(pContractDb.get());
+    CSimpleKVCache<dbk::BEST_BLOCKHASH, string> bestBlockCache(pAccountDb.get());
+    CCompositeKVCache<dbk::REGID_KEYID, string, string> childCache(&accountCache);
+
+    accountCache.SetData("regid-1", "keyid-1");
+    contractCache.SetData("contract-1", "code-1");
+    bestBlockCache.SetData("block-1");
+
+    // staged while flushing and readable from the frozen layers until written
+    BOOST_CHECK(flusher.BeginFlush());
+    accountCache.Flush();
+    contractCache.Flush();
+    bestBlockCache.Flush();
+    BOOST_CHECK(flusher.EndFlush(true));
+
+    string value;
+    BOOST_CHECK(childCache.GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(contractCache.GetData(string("contract-1"), value) && value == "code-1");
+    BOOST_CHECK(bestBlockCache.GetData(value) && value == "block-1");
+
+    // the next flush waits for the write, which touched two dbs through the journal
+    childCache.SetData("regid-1", "keyid-2");
+    childCache.Flush();
+    BOOST_CHECK(flusher.BeginFlush());
+    accountCache.Flush();
+    BOOST_CHECK(flusher.EndFlush(false));
+    BOOST_CHECK(!boost::filesystem::exists(pathJournal));
+
+    CDBFlushStats stats;
+    flusher.GetStats(stats);
+    BOOST_CHECK(stats.flushCount == 2 && stats.journalCount == 1);
+
+    BOOST_CHECK(pAccountDb->GetData(dbk::REGID_KEYID, string("regid-1"), value) && value == "keyid-2");
+    BOOST_CHECK(pContractDb->GetData(dbk::CONTRACT_DEF, string("contract-1"), value) && value == "code-1");
+    BOOST_CHECK(pAccountDb->GetData(dbk::BEST_BLOCKHASH, value) && value == "block-1");
+}
+
+BOOST_AUTO_TEST_CASE(address_index_test)
+{
+    const bool isWipe = true;
+    shared_ptr<CDBAccess> pContractDb = make_shared<CDBAccess>(DBNameType::CONTRACT, 100000, false, isWipe);
+    CContractDBCache contractCache(pContractDb.get());
+    const CKeyID keyId = MakeKeyId(1);
+    vector<uint256> txids = {GetRandHash(), GetRandHash(), GetRandHash(), GetRandHash()};
+
+    // 256 is sorted before 1 by the little-endian height, the half in db, the other half in cache
+    BOOST_CHECK(contractCache.SetTxHashByAddress(keyId, 256, 0, txids[2]));
+    BOOST_CHECK(contractCache.SetTxHashByAddress(keyId, 1, 3, txids[0]));
+    BOOST_CHECK(contractCache.SetTxHashByAddress(MakeKeyId(2), 2, 0, GetRandHash()));
+    contractCache.Flush();
+    BOOST_CHECK(contractCache.SetTxHashByAddress(keyId, 65536, 1, txids[3]));
+    BOOST_CHECK(contractCache.SetTxHashByAddress(keyId, 1, 256, txids[1]));
+
+    auto pGetter = contractCache.CreateAddressTxsGetter(keyId, 0, 0, 0);
+    BOOST_CHECK(pGetter->Execute());
+    BOOST_CHECK(pGetter->data_list.size() == txids.size());
+    for (uint32_t i = 0; i < pGetter->data_list.size(); ++i)
+        BOOST_CHECK(pGetter->GetTxid(pGetter->data_list[i]) == txids[i]);
+
+    // the next page after the last returned tx
+    pGetter = contractCache.CreateAddressTxsGetter(keyId, 2, 0, 0);
+    BOOST_CHECK(pGetter->Execute() && pGetter->data_list.size() == 2 && pGetter->have_next);
+    uint32_t lastHeight = pGetter->GetHeight(pGetter->data_list.back());
+    uint32_t lastIndex  = pGetter->GetIndex(pGetter->data_list.back());
+    pGetter = contractCache.CreateAddressTxsGetter(keyId, 2, lastHeight, lastIndex);
+    BOOST_CHECK(pGetter->Execute() && pGetter->data_list.size() == 2 && !pGetter->have_next);
+    BOOST_CHECK(pGetter->GetTxid(pGetter->data_list[0]) == txids[2]);
+    BOOST_CHECK(pGetter->GetHeight(pGetter->data_list[1]) == 65536);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -76,9 +293,9 @@ BOOST_AUTO_TEST_CASE(dbcache_multi_value_Level3_test)
     pDBCache3->SetData("regid-1", "keyid-1", *pDbOpLogMap);
     pDBCache3->SetData("regid-2", "keyid-2", *pDbOpLogMap);
     pDBCache3->SetData("regid-3", "keyid-3", *pDbOpLogMap);
-    assert(pDbOpLogMap->GetDbOpLogs(prefix).size() == 3);
+    assert(pDbOpLogMap->GetDbOpLogsPtr(prefix)->size() == 3);
     string opKey3, opValue3;
-    pDbOpLogMap->GetDbOpLogs(prefix).at(2).Get(opKey3, opValue3);
+    pDbOpLogMap->GetDbOpLogsPtr(prefix)->at(2).Get(opKey3, opValue3);
     assert(opKey3 == "regid-3" && opValue3 == "");
 
     pDBCache3->Flush();
@@ -97,6 +314,64 @@ BOOST_AUTO_TEST_CASE(dbcache_multi_value_Level3_test)
 }
 
 
+BOOST_AUTO_TEST_CASE(dbcache_missing_key_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, 100000, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    auto pDBCache3 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache2.get());
+
+    // the miss is remembered by the bottom layer
+    string value1;
+    BOOST_CHECK(!pDBCache3->GetData(string("regid-1"), value1));
+    BOOST_CHECK(!pDBCache3->GetData(string("regid-1"), value1));
+
+    // and overridden by the writes in any layer
+    pDBCache3->SetData("regid-1", "keyid-1");
+    BOOST_CHECK(pDBCache3->GetData(string("regid-1"), value1) && value1 == "keyid-1");
+    BOOST_CHECK(!pDBCache2->GetData(string("regid-1"), value1));
+    pDBCache3->Flush();
+    pDBCache2->Flush();
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value1) && value1 == "keyid-1");
+
+    // and forgotten once written to db
+    pDBCache1->Flush();
+    value1.clear();
+    BOOST_CHECK(pDBCache1->GetData(string("regid-1"), value1) && value1 == "keyid-1");
+    BOOST_CHECK(pDBCache3->GetData(string("regid-1"), value1) && value1 == "keyid-1");
+
+    // the middle layer is not filled by the reads through it
+    BOOST_CHECK(pDBCache2->GetMapData().empty());
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_layer_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    const bool isWipe = true;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        DBNameType::ACCOUNT, 100000, false, isWipe);
+
+    map<CKeyID, CAccount> accounts;
+    for (uint32_t i = 0; i < BENCH_ACCOUNT_COUNT; ++i) {
+        CKeyID keyId = MakeKeyId(i);
+        accounts.emplace(keyId, CAccount(keyId));
+    }
+    pDBAccess->BatchWrite<CKeyID, CAccount>(dbk::KEYID_ACCOUNT, accounts);
+
+    for (uint32_t layers : {1, 2, 4}) {
+        int64_t nTime = BenchAccountCache(*pDBAccess, layers);
+        BOOST_TEST_MESSAGE(strprintf("dbcache_layer_bench: %u layers, %u ops (70%% hit, 10%% miss, 20%% write): "
+                                     "%.3fus/op, %.0f ops/s", layers, BENCH_OP_COUNT,
+                                     (double)nTime / BENCH_OP_COUNT, BENCH_OP_COUNT * 1000000.0 / nTime));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbcache_scalar_value_Level3_test)
 {
     const bool isWipe = true;
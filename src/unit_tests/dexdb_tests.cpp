@@ -0,0 +1,295 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/util.h"
+#include "config/const.h"
+#include "config/scoin.h"
+#include "persistence/dexdb.h"
+#include "unit_tests/testutil.h"
+
+#include <algorithm>
+#include <limits>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TEST_ORDER_COUNT      = 2000;
+static const uint32_t BENCH_ORDER_COUNT     = 100000;
+static const uint32_t BENCH_OTHER_PAIR_RATE = 4;    // the orders of the other pairs for one order of the bench book
+static const uint32_t BENCH_DEPTH_LEVELS    = 20;
+static const uint32_t BENCH_FLUSH_BATCH     = 10000;
+
+static uint256 MakeOrderId(uint32_t i) {
+    uint256 id;
+    *(uint32_t *)id.begin() = i + 1;
+    return id;
+}
+
+// the orders of two pairs and both sides, a few market orders, the prices around 1.0 with many on the same level
+static CDEXOrderDetail MakeOrder(uint32_t i) {
+    CDEXOrderDetail order;
+    order.generate_type = (i % 11 == 0) ? SYSTEM_GEN_ORDER : USER_GEN_ORDER;
+    order.order_type    = (i % 13 == 0) ? ORDER_MARKET_PRICE : ORDER_LIMIT_PRICE;
+    order.order_side    = (i % 2 == 0) ? ORDER_BUY : ORDER_SELL;
+    order.coin_symbol   = SYMB::WUSD;
+    order.asset_symbol  = (i % 3 == 0) ? SYMB::WGRT : SYMB::WICC;
+    order.tx_cord       = CTxCord(i / 10 + 1, i % 10 + 1);
+    order.user_regid    = CRegID(i / 1000 + 1, i % 1000);
+    if (order.order_type == ORDER_LIMIT_PRICE) {
+        uint64_t offset    = ((i * 7919ULL) % 200) * 100000;
+        order.price        = (order.order_side == ORDER_BUY) ? PRICE_BOOST - offset : PRICE_BOOST + offset;
+        order.asset_amount = (i % 50 + 1) * COIN;
+        order.coin_amount  = (order.order_side == ORDER_BUY) ? order.asset_amount / PRICE_BOOST * order.price : 0;
+    } else if (order.order_side == ORDER_BUY) {
+        order.coin_amount  = (i % 50 + 1) * COIN;
+    } else {
+        order.asset_amount = (i % 50 + 1) * COIN;
+    }
+    return order;
+}
+
+// a part of the order dealt
+static CDEXOrderDetail DealOrder(const CDEXOrderDetail &order) {
+    CDEXOrderDetail dealtOrder = order;
+    dealtOrder.total_deal_asset_amount += DEX_DB::GetResidualAssetAmount(order) / 2;
+    dealtOrder.total_deal_coin_amount += DEX_DB::GetResidualCoinAmount(order) / 2;
+    return dealtOrder;
+}
+
+// the price-time priority of a book, as the matchers sort the orders pulled from the node
+static bool IsBetterOrder(const pair<uint256, CDEXOrderDetail> &a, const pair<uint256, CDEXOrderDetail> &b) {
+    const CDEXOrderDetail &x = a.second, &y = b.second;
+    if (x.order_type != y.order_type)
+        return x.order_type == ORDER_MARKET_PRICE;
+    if (x.order_type == ORDER_LIMIT_PRICE && x.price != y.price)
+        return (x.order_side == ORDER_BUY) ? x.price > y.price : x.price < y.price;
+    if (x.tx_cord.GetHeight() != y.tx_cord.GetHeight())
+        return x.tx_cord.GetHeight() < y.tx_cord.GetHeight();
+    return x.tx_cord.GetIndex() < y.tx_cord.GetIndex();
+}
+
+// the levels of a book rebuilt from all the active orders, the expected result of the index
+static vector<CDEXOrderBookLevel> BuildBookLevels(const map<uint256, CDEXOrderDetail> &activeOrders,
+                                                  const TokenSymbol &assetSymbol, OrderSide orderSide,
+                                                  uint32_t maxLevels) {
+    vector<pair<uint256, CDEXOrderDetail>> bookOrders;
+    for (const auto &item : activeOrders) {
+        if (item.second.asset_symbol == assetSymbol && item.second.order_side == orderSide)
+            bookOrders.push_back(item);
+    }
+    sort(bookOrders.begin(), bookOrders.end(), IsBetterOrder);
+
+    vector<CDEXOrderBookLevel> levels;
+    for (const auto &item : bookOrders) {
+        const CDEXOrderDetail &order = item.second;
+        uint64_t price = (order.order_type == ORDER_LIMIT_PRICE) ? order.price : 0;
+        if (levels.empty() || levels.back().order_type != order.order_type || levels.back().price != price) {
+            if (maxLevels != 0 && levels.size() >= maxLevels)
+                break;
+            levels.emplace_back();
+            levels.back().order_type = order.order_type;
+            levels.back().price      = price;
+        }
+        levels.back().order_count += 1;
+        levels.back().residual_asset_amount += DEX_DB::GetResidualAssetAmount(order);
+        levels.back().residual_coin_amount += DEX_DB::GetResidualCoinAmount(order);
+        levels.back().orders.push_back(item);
+    }
+    return levels;
+}
+
+static void CheckBookLevels(const vector<CDEXOrderBookLevel> &levels, const vector<CDEXOrderBookLevel> &expected) {
+    BOOST_REQUIRE_EQUAL(levels.size(), expected.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        BOOST_CHECK_EQUAL((int)levels[i].order_type, (int)expected[i].order_type);
+        BOOST_CHECK_EQUAL(levels[i].price, expected[i].price);
+        BOOST_CHECK_EQUAL(levels[i].order_count, expected[i].order_count);
+        BOOST_CHECK_EQUAL(levels[i].residual_asset_amount, expected[i].residual_asset_amount);
+        BOOST_CHECK_EQUAL(levels[i].residual_coin_amount, expected[i].residual_coin_amount);
+        BOOST_REQUIRE_EQUAL(levels[i].orders.size(), expected[i].orders.size());
+        for (size_t j = 0; j < levels[i].orders.size(); ++j)
+            BOOST_CHECK(levels[i].orders[j].first == expected[i].orders[j].first);
+    }
+}
+
+static void CheckOrderBooks(CDexDBCache &dbCache, const map<uint256, CDEXOrderDetail> &activeOrders) {
+    for (const auto &assetSymbol : {SYMB::WICC, SYMB::WGRT}) {
+        for (OrderSide orderSide : {ORDER_BUY, ORDER_SELL}) {
+            for (uint32_t maxLevels : {1U, 20U, 0U}) {
+                auto pGetter = dbCache.CreateOrderBookGetter();
+                BOOST_CHECK(pGetter->Execute(SYMB::WUSD, assetSymbol, orderSide, maxLevels, true));
+                CheckBookLevels(pGetter->levels, BuildBookLevels(activeOrders, assetSymbol, orderSide, maxLevels));
+            }
+        }
+    }
+}
+
+// the orders of a block: every 5th order dealt, every 7th erased, and new orders created
+static map<uint256, CDEXOrderDetail> ApplyBlock(CDexDBCache &cache, const map<uint256, CDEXOrderDetail> &activeOrders,
+                                                uint32_t height, uint32_t firstNewOrder, uint32_t newOrderCount) {
+    map<uint256, CDEXOrderDetail> blockOrders = activeOrders;
+    for (uint32_t i = height % 5; i < firstNewOrder; i += 5) {
+        auto it = blockOrders.find(MakeOrderId(i));
+        if (it == blockOrders.end())
+            continue;
+        if (i % 7 == 0) {
+            BOOST_CHECK(cache.EraseActiveOrder(it->first, it->second, height));
+            blockOrders.erase(it);
+        } else {
+            it->second = DealOrder(it->second);
+            BOOST_CHECK(cache.UpdateActiveOrder(it->first, it->second, height));
+        }
+    }
+    for (uint32_t i = firstNewOrder; i < firstNewOrder + newOrderCount; ++i) {
+        CDEXOrderDetail order = MakeOrder(i);
+        order.tx_cord         = CTxCord(height, i - firstNewOrder + 1);
+        BOOST_CHECK(cache.CreateActiveOrder(MakeOrderId(i), order));
+        blockOrders.emplace(MakeOrderId(i), order);
+    }
+    return blockOrders;
+}
+
+BOOST_AUTO_TEST_SUITE(dexdb_tests)
+
+BOOST_AUTO_TEST_CASE(dex_order_book_test)
+{
+    shared_ptr<CDBAccess> pDbAccess = make_shared<CDBAccess>(DBNameType::DEX, 1 << 20, false, true);
+
+    // the active orders written before the order book existed are indexed once, when the db is opened
+    map<uint256, CDEXOrderDetail> activeOrders;
+    for (uint32_t i = 0; i < TEST_ORDER_COUNT / 2; ++i)
+        activeOrders.emplace(MakeOrderId(i), MakeOrder(i));
+    pDbAccess->BatchWrite<uint256, CDEXOrderDetail>(dbk::DEX_ACTIVE_ORDER, activeOrders);
+
+    CDexDBCache dbCache(pDbAccess.get());
+    CheckOrderBooks(dbCache, activeOrders);
+
+    // the orders in the map data of the top level cache are merged over the db
+    for (uint32_t i = TEST_ORDER_COUNT / 2; i < TEST_ORDER_COUNT; ++i) {
+        BOOST_CHECK(dbCache.CreateActiveOrder(MakeOrderId(i), MakeOrder(i)));
+        activeOrders.emplace(MakeOrderId(i), MakeOrder(i));
+    }
+    CheckOrderBooks(dbCache, activeOrders);
+    dbCache.Flush();
+    CheckOrderBooks(dbCache, activeOrders);
+
+    uint32_t height = TEST_ORDER_COUNT / 10 + 10;
+    map<uint256, CDEXOrderDetail> blockOrders = ApplyBlock(dbCache, activeOrders, height, TEST_ORDER_COUNT, 0);
+    CheckOrderBooks(dbCache, blockOrders);
+    dbCache.Flush();
+    CheckOrderBooks(dbCache, blockOrders);
+    activeOrders = blockOrders;
+
+    // the changes of a block in an overlay, undone or flushed
+    ++height;
+    {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dbCache);
+        CDBOpLogMap dbOpLogMap;
+        blockCache.SetDbOpLogMap(&dbOpLogMap);
+        ApplyBlock(blockCache, activeOrders, height, TEST_ORDER_COUNT, 100);
+        BOOST_CHECK(blockCache.UndoDatas());
+        blockCache.Flush();
+        CheckOrderBooks(dbCache, activeOrders);
+
+        auto pGetter = dbCache.CreateOrderBookChangesGetter();
+        BOOST_CHECK(pGetter->Execute(height - 1, height, 0));
+        BOOST_CHECK(pGetter->changes.empty());
+    }
+    {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dbCache);
+        blockOrders = ApplyBlock(blockCache, activeOrders, height, TEST_ORDER_COUNT, 100);
+        blockCache.Flush();
+        CheckOrderBooks(dbCache, blockOrders);
+    }
+
+    // the changes since the height before the block bring the snapshot to the book after it
+    auto pGetter = dbCache.CreateOrderBookChangesGetter();
+    BOOST_CHECK(pGetter->Execute(height - 1, height, 0));
+    BOOST_CHECK_EQUAL(pGetter->end_height, height);
+    BOOST_CHECK(!pGetter->has_more);
+    map<uint256, CDEXOrderDetail> followedOrders = activeOrders;
+    for (const auto &item : pGetter->changes) {
+        BOOST_CHECK_EQUAL(DEX_DB::GetHeight(item.first), height);
+        if (item.second.action == ORDER_BOOK_PUT)
+            followedOrders[DEX_DB::GetOrderId(item.first)] = item.second.order;
+        else
+            followedOrders.erase(DEX_DB::GetOrderId(item.first));
+    }
+    BOOST_CHECK_EQUAL(followedOrders.size(), blockOrders.size());
+    for (const auto &item : blockOrders) {
+        auto it = followedOrders.find(item.first);
+        BOOST_REQUIRE(it != followedOrders.end());
+        BOOST_CHECK_EQUAL(it->second.total_deal_asset_amount, item.second.total_deal_asset_amount);
+    }
+
+    // the changes of a height are never split by max_count, and pruned when too old
+    pGetter = dbCache.CreateOrderBookChangesGetter();
+    BOOST_CHECK(pGetter->Execute(0, height, 1));
+    BOOST_CHECK(pGetter->has_more);
+    BOOST_REQUIRE(pGetter->changes.size() > 1);
+    for (const auto &item : pGetter->changes)
+        BOOST_CHECK_EQUAL(DEX_DB::GetHeight(item.first), pGetter->end_height);
+
+    BOOST_CHECK(dbCache.PruneOrderBookChanges(height - 1 + DEX_ORDER_BOOK_CHANGE_KEEP_HEIGHT));
+    pGetter = dbCache.CreateOrderBookChangesGetter();
+    BOOST_CHECK(pGetter->Execute(0, height, 0));
+    BOOST_CHECK(!pGetter->changes.empty());
+    for (const auto &item : pGetter->changes)
+        BOOST_CHECK_EQUAL(DEX_DB::GetHeight(item.first), height);
+}
+
+BOOST_AUTO_TEST_CASE(dex_order_book_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    shared_ptr<CDBAccess> pDbAccess = make_shared<CDBAccess>(DBNameType::DEX, 8 << 20, false, true);
+    CDexDBCache dbCache(pDbAccess.get());
+    uint32_t orderCount = BENCH_ORDER_COUNT * (BENCH_OTHER_PAIR_RATE + 1);
+    for (uint32_t i = 0; i < orderCount; ++i) {
+        CDEXOrderDetail order = MakeOrder(i);
+        // the wicc orders of one in BENCH_OTHER_PAIR_RATE + 1, the other pairs made up of wgrt
+        order.asset_symbol = (i % (BENCH_OTHER_PAIR_RATE + 1) == 0) ? SYMB::WICC : SYMB::WGRT;
+        dbCache.CreateActiveOrder(MakeOrderId(i), order);
+        if ((i + 1) % BENCH_FLUSH_BATCH == 0)
+            dbCache.Flush();
+    }
+    dbCache.Flush();
+
+    // all the orders pulled by height range and the book rebuilt, as the matchers do before the index
+    int64_t nStart = GetTimeMicros();
+    map<uint256, CDEXOrderDetail> activeOrders;
+    {
+        auto pGetter = dbCache.CreateOrdersGetter();
+        BOOST_CHECK(pGetter->Execute(0, std::numeric_limits<uint32_t>::max(), 0, DEXBlockOrdersCache::KeyType()));
+        for (const auto &item : pGetter->orders)
+            activeOrders.emplace(DEX_DB::GetOrderId(item.first), item.second);
+    }
+    vector<CDEXOrderBookLevel> rebuiltLevels = BuildBookLevels(activeOrders, SYMB::WICC, ORDER_SELL,
+                                                               BENCH_DEPTH_LEVELS);
+    int64_t nRebuildTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+    BOOST_CHECK_EQUAL(activeOrders.size(), orderCount);
+
+    // the range scan of the order book, only the best levels read
+    nStart       = GetTimeMicros();
+    auto pGetter = dbCache.CreateOrderBookGetter();
+    BOOST_CHECK(pGetter->Execute(SYMB::WUSD, SYMB::WICC, ORDER_SELL, BENCH_DEPTH_LEVELS, true));
+    int64_t nScanTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+    CheckBookLevels(pGetter->levels, rebuiltLevels);
+
+    nStart  = GetTimeMicros();
+    pGetter = dbCache.CreateOrderBookGetter();
+    BOOST_CHECK(pGetter->Execute(SYMB::WUSD, SYMB::WICC, ORDER_SELL, 1, false));
+    int64_t nTopTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+    BOOST_CHECK_EQUAL(pGetter->levels.size(), 1U);
+
+    BOOST_TEST_MESSAGE(strprintf("dex_order_book_bench: %u orders, %u in the book, pull all and rebuild: %lld us, "
+                                 "depth of %u levels: %lld us, top of book: %lld us",
+                                 orderCount, BENCH_ORDER_COUNT, nRebuildTime, BENCH_DEPTH_LEVELS, nScanTime,
+                                 nTopTime));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
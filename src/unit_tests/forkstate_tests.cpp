@@ -0,0 +1,252 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "persistence/forkstate.h"
+#include "unit_tests/testutil.h"
+
+#include <map>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TEST_ACCOUNT_COUNT  = 300;
+static const uint32_t BENCH_ACCOUNT_COUNT = 3000;
+static const int32_t BENCH_FORK_DEPTH     = 6;
+static const int32_t BENCH_ROUND_COUNT    = 200;
+
+// the last vote height of the accounts by index, the accounts created by the blocks are indexed above the others
+typedef map<uint32_t, uint64_t> TestState;
+
+static CKeyID MakeKeyId(uint32_t i) {
+    uint160 id;
+    *(uint32_t *)id.begin() = i + 1;
+    return CKeyID(id);
+}
+
+static uint256 MakeBlockHash(int32_t height, uint32_t branch) {
+    uint256 hash;
+    *(int32_t *)hash.begin()        = height;
+    *(uint32_t *)(hash.begin() + 4) = branch + 1;
+    return hash;
+}
+
+// a block of the branch updating a third of the accounts and creating one, with the undo data
+static CBlockUndo ApplyBlock(CCacheWrapper &cw, int32_t height, uint32_t branch, uint32_t accountCount,
+                             TestState &state) {
+    cw.EnableTxUndoLog(uint256());
+    for (uint32_t i = 0; i < accountCount; ++i) {
+        if ((i + height + branch) % 3 != 0)
+            continue;
+
+        CAccount account;
+        BOOST_CHECK(cw.accountCache.GetAccount(MakeKeyId(i), account));
+        account.last_vote_height = height * 100 + branch;
+        cw.accountCache.SetAccount(MakeKeyId(i), account);
+        state[i] = account.last_vote_height;
+    }
+    uint32_t newIndex = accountCount + height * 100 + branch;
+    CAccount account(MakeKeyId(newIndex));
+    account.last_vote_height = height * 100 + branch;
+    cw.accountCache.SetAccount(MakeKeyId(newIndex), account);
+    state[newIndex] = account.last_vote_height;
+
+    CBlockUndo blockUndo;
+    blockUndo.vtxundo.push_back(cw.GetTxUndo());
+    cw.DisableTxUndoLog();
+    return blockUndo;
+}
+
+static void CheckState(CCacheWrapper &cw, const TestState &state, uint32_t accountCount, int32_t maxHeight) {
+    for (uint32_t i = 0; i < accountCount + (maxHeight + 1) * 100; ++i) {
+        CAccount account;
+        auto it = state.find(i);
+        if (it == state.end()) {
+            BOOST_CHECK(!cw.accountCache.GetAccount(MakeKeyId(i), account));
+        } else {
+            BOOST_CHECK(cw.accountCache.GetAccount(MakeKeyId(i), account));
+            BOOST_CHECK_EQUAL(account.last_vote_height, it->second);
+        }
+    }
+}
+
+struct ForkStateTestingSetup {
+    CCacheDBManager cdMan;
+    map<int32_t, TestState> states;       // of the active chain by height
+    map<int32_t, CBlockUndo> blockUndos;  // of the active chain by height
+
+    ForkStateTestingSetup() : cdMan(true, false, 1 << 20, 1 << 20, 1 << 20, 1 << 20) {}
+
+    void Init(uint32_t accountCount) {
+        CCacheWrapper cw(&cdMan);
+        for (uint32_t i = 0; i < accountCount; ++i) {
+            cw.accountCache.SetAccount(MakeKeyId(i), CAccount(MakeKeyId(i)));
+            states[0][i] = 0;
+        }
+        cw.Flush();
+    }
+
+    // connect a block on the tip of the active chain
+    void ConnectTip(int32_t height, uint32_t accountCount) {
+        CCacheWrapper cw(&cdMan);
+        states[height]     = states[height - 1];
+        blockUndos[height] = ApplyBlock(cw, height, 0, accountCount, states[height]);
+        cw.Flush();
+    }
+
+    // the state at the block below of the active chain, the block disconnected on the state at it
+    void AddDisconnectState(CForkStateTree &tree, int32_t height) {
+        auto spCw = tree.CreateLayer(MakeBlockHash(height, 0));
+        BOOST_CHECK(spCw->UndoDatas(blockUndos[height]));
+        tree.Add(MakeBlockHash(height - 1, 0), height - 1, MakeBlockHash(height, 0), std::move(spCw));
+    }
+
+    void AddForkState(CForkStateTree &tree, int32_t height, uint32_t branch, const uint256 &prevHash,
+                      const TestState &prevState, TestState &state, uint32_t accountCount) {
+        auto spCw = tree.CreateLayer(prevHash);
+        state     = prevState;
+        ApplyBlock(*spCw, height, branch, accountCount, state);
+        tree.Add(MakeBlockHash(height, branch), height, prevHash, std::move(spCw));
+    }
+
+    // move the root of the tree onto the block connected on the tip
+    void MoveRoot(CForkStateTree &tree, int32_t height) {
+        auto spCw = tree.CreateLayer(tree.GetRootHash());
+        BOOST_CHECK(spCw->UndoDatas(blockUndos[height]));
+        tree.MoveRoot(MakeBlockHash(height, 0), height, std::move(spCw));
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(forkstate_tests, ForkStateTestingSetup)
+
+BOOST_AUTO_TEST_CASE(fork_state_tree_test)
+{
+    Init(TEST_ACCOUNT_COUNT);
+    for (int32_t height = 1; height <= 20; ++height)
+        ConnectTip(height, TEST_ACCOUNT_COUNT);
+
+    CForkStateTree tree;
+    tree.SetRoot(&cdMan, MakeBlockHash(20, 0), 20);
+
+    // the active chain disconnected down to the forked point, once
+    for (int32_t height = 20; height > 15; --height)
+        AddDisconnectState(tree, height);
+    for (int32_t height = 15; height < 20; ++height)
+        CheckState(*tree.Get(MakeBlockHash(height, 0)), states[height], TEST_ACCOUNT_COUNT, 30);
+    BOOST_CHECK(!tree.HasForkedStates());
+
+    // two forked chains sharing the forked point, the second one forked from the first one
+    TestState state16A, state17A, state18B;
+    AddForkState(tree, 16, 1, MakeBlockHash(15, 0), states[15], state16A, TEST_ACCOUNT_COUNT);
+    AddForkState(tree, 17, 1, MakeBlockHash(16, 1), state16A, state17A, TEST_ACCOUNT_COUNT);
+    AddForkState(tree, 18, 2, MakeBlockHash(17, 1), state17A, state18B, TEST_ACCOUNT_COUNT);
+    CheckState(*tree.Get(MakeBlockHash(16, 1)), state16A, TEST_ACCOUNT_COUNT, 30);
+    CheckState(*tree.Get(MakeBlockHash(17, 1)), state17A, TEST_ACCOUNT_COUNT, 30);
+    CheckState(*tree.Get(MakeBlockHash(18, 2)), state18B, TEST_ACCOUNT_COUNT, 30);
+    BOOST_CHECK_EQUAL(tree.GetSize(), 8U);
+    BOOST_CHECK(tree.HasForkedStates());
+
+    // a block connected on the tip: the states read through the old root are kept on the state at the old root
+    ConnectTip(21, TEST_ACCOUNT_COUNT);
+    MoveRoot(tree, 21);
+    BOOST_CHECK(tree.GetRootHash() == MakeBlockHash(21, 0));
+    BOOST_CHECK_EQUAL(tree.GetSize(), 9U);
+    for (int32_t height = 15; height <= 20; ++height)
+        CheckState(*tree.Get(MakeBlockHash(height, 0)), states[height], TEST_ACCOUNT_COUNT, 30);
+    CheckState(*tree.Get(MakeBlockHash(16, 1)), state16A, TEST_ACCOUNT_COUNT, 30);
+    CheckState(*tree.Get(MakeBlockHash(18, 2)), state18B, TEST_ACCOUNT_COUNT, 30);
+    CheckState(*tree.CreateLayer(tree.GetRootHash()), states[21], TEST_ACCOUNT_COUNT, 30);
+
+    TestState state18A;
+    AddForkState(tree, 18, 1, MakeBlockHash(17, 1), state17A, state18A, TEST_ACCOUNT_COUNT);
+    CheckState(*tree.Get(MakeBlockHash(18, 1)), state18A, TEST_ACCOUNT_COUNT, 30);
+
+    // the least recently used leaf is evicted above the max cache size, not the bases of the others
+    CheckState(*tree.Get(MakeBlockHash(18, 2)), state18B, TEST_ACCOUNT_COUNT, 30);
+    uint64_t maxCacheSize = tree.GetCacheSize() + sizeof(CCacheWrapper);
+    tree.SetMaxCacheSize(maxCacheSize);
+    TestState state19B;
+    AddForkState(tree, 19, 2, MakeBlockHash(18, 2), state18B, state19B, TEST_ACCOUNT_COUNT);
+    BOOST_CHECK(tree.GetCacheSize() <= maxCacheSize);
+    BOOST_CHECK(!tree.Contains(MakeBlockHash(18, 1)));
+    BOOST_CHECK(tree.Contains(MakeBlockHash(17, 1)) && tree.Contains(MakeBlockHash(18, 2)));
+    CheckState(*tree.Get(MakeBlockHash(19, 2)), state19B, TEST_ACCOUNT_COUNT, 30);
+
+    // the states too deep below the tip are dropped with the forked chains on them
+    tree.SetMaxCacheSize(DEFAULT_FORK_STATE_CACHE_SIZE << 20);
+    int32_t tipHeight = 21 + MAX_FORK_STATE_DEPTH - 5;
+    for (int32_t height = 22; height <= tipHeight; ++height) {
+        ConnectTip(height, TEST_ACCOUNT_COUNT);
+        MoveRoot(tree, height);
+    }
+    BOOST_CHECK(!tree.Contains(MakeBlockHash(15, 0)) && !tree.Contains(MakeBlockHash(16, 1)));
+    BOOST_CHECK(!tree.Contains(MakeBlockHash(19, 2)));
+    BOOST_CHECK(!tree.HasForkedStates());
+    BOOST_CHECK_EQUAL(tree.GetSize(), (size_t)MAX_FORK_STATE_DEPTH);
+    CheckState(*tree.Get(MakeBlockHash(tipHeight - 1, 0)), states[tipHeight - 1], TEST_ACCOUNT_COUNT, tipHeight);
+    CheckState(*tree.Get(MakeBlockHash(tipHeight - MAX_FORK_STATE_DEPTH, 0)),
+               states[tipHeight - MAX_FORK_STATE_DEPTH], TEST_ACCOUNT_COUNT, tipHeight);
+
+    tree.Clear();
+    BOOST_CHECK(tree.IsEmpty() && tree.GetCacheSize() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(fork_state_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    // a forked block at the same depth below the tip after every block connected, as the short forks of the
+    // producers missing a block
+    Init(BENCH_ACCOUNT_COUNT);
+    for (int32_t height = 1; height <= BENCH_FORK_DEPTH; ++height)
+        ConnectTip(height, BENCH_ACCOUNT_COUNT);
+
+    CForkStateTree tree;
+    tree.SetRoot(&cdMan, MakeBlockHash(BENCH_FORK_DEPTH, 0), BENCH_FORK_DEPTH);
+    int64_t nDisconnectTime = 0, nTreeTime = 0;
+    for (int32_t round = 1; round <= BENCH_ROUND_COUNT; ++round) {
+        int32_t tipHeight  = BENCH_FORK_DEPTH + round;
+        int32_t forkHeight = tipHeight - BENCH_FORK_DEPTH;
+
+        ConnectTip(tipHeight, BENCH_ACCOUNT_COUNT);
+        int64_t nStart = GetTimeMicros();
+        MoveRoot(tree, tipHeight);
+        int64_t nMoveRootTime = GetTimeMicros() - nStart;
+
+        // the active chain disconnected down to the forked point for the forked block, as before the tree
+        nStart = GetTimeMicros();
+        {
+            CCacheWrapper cw(&cdMan);
+            for (int32_t height = tipHeight; height > forkHeight; --height)
+                BOOST_CHECK(cw.UndoDatas(blockUndos[height]));
+            CCacheWrapper forkCw(cw);
+            TestState state = states[forkHeight];
+            ApplyBlock(forkCw, forkHeight + 1, 1, BENCH_ACCOUNT_COUNT, state);
+        }
+        nDisconnectTime += GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        for (int32_t height = tipHeight; height > forkHeight; --height) {
+            if (!tree.Contains(MakeBlockHash(height - 1, 0)))
+                AddDisconnectState(tree, height);
+        }
+        TestState state;
+        AddForkState(tree, forkHeight + 1, 1, MakeBlockHash(forkHeight, 0), states[forkHeight], state,
+                     BENCH_ACCOUNT_COUNT);
+        nTreeTime += GetTimeMicros() - nStart + nMoveRootTime;
+
+        if (round % 50 == 0) {
+            CheckState(*tree.Get(MakeBlockHash(forkHeight + 1, 1)), state, BENCH_ACCOUNT_COUNT, tipHeight);
+            CheckState(*tree.Get(MakeBlockHash(forkHeight, 0)), states[forkHeight], BENCH_ACCOUNT_COUNT, tipHeight);
+        }
+    }
+
+    BOOST_TEST_MESSAGE(strprintf("fork_state_bench: %d rounds, %u accounts, fork depth %d, undo data in memory, "
+                                 "disconnect to the forked point: %lld us, fork state tree: %lld us, %u states, "
+                                 "%llu KB", BENCH_ROUND_COUNT, BENCH_ACCOUNT_COUNT, BENCH_FORK_DEPTH,
+                                 nDisconnectTime, nTreeTime, tree.GetSize(), tree.GetCacheSize() / 1024));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "config/const.h"
+#include "p2p/headerssync.h"
+#include "persistence/block.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+// the headers of count blocks after the block of prevHash at prevHeight
+static vector<CBlock> MakeHeaders(const uint256 &prevHash, int32_t prevHeight, int32_t count, uint32_t nonce) {
+    vector<CBlock> headers(count);
+    uint256 hash = prevHash;
+    for (int32_t i = 0; i < count; ++i) {
+        headers[i].SetPrevBlockHash(hash);
+        headers[i].SetHeight(prevHeight + i + 1);
+        headers[i].SetNonce(nonce);
+        hash = headers[i].GetHash();
+    }
+    return headers;
+}
+
+struct CTestTip {
+    uint256 hash;
+    CBlockIndex index;
+
+    CTestTip(const uint256 &hashIn, int32_t height) : hash(hashIn) {
+        index.pBlockHash = &hash;
+        index.height     = height;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(headerssync_tests)
+
+BOOST_AUTO_TEST_CASE(headerssync_test)
+{
+    CTestTip tip(uint256S("1234"), 100);
+    CHeadersSync sync;
+    BOOST_CHECK(!sync.IsSyncing() && !sync.NeedMoreHeaders());
+
+    sync.Start(7, &tip.index);
+    BOOST_CHECK(sync.IsSyncing() && sync.GetPeer() == 7 && sync.GetHeight() == 100 && sync.NeedMoreHeaders());
+    BOOST_CHECK(sync.GetHash(100) == tip.hash && sync.GetHash(101).IsNull());
+
+    // a full headers message, then the rest of the headers of the peer
+    vector<CBlock> headers = MakeHeaders(tip.hash, 100, MAX_HEADERS_RESULTS, 0);
+    sync.SetRequestTime(1);
+    BOOST_CHECK(!sync.NeedMoreHeaders());
+    BOOST_CHECK(sync.AddHeaders(headers));
+    BOOST_CHECK(sync.GetHeight() == 100 + MAX_HEADERS_RESULTS && sync.GetRequestTime() == 0 && sync.NeedMoreHeaders());
+    BOOST_CHECK(sync.GetHash(101) == headers[0].GetHash() && sync.Contains(headers.back().GetHash()));
+
+    vector<CBlock> moreHeaders = MakeHeaders(headers.back().GetHash(), sync.GetHeight(), 10, 0);
+    BOOST_CHECK(sync.AddHeaders(moreHeaders));
+    BOOST_CHECK(sync.GetHeight() == 110 + MAX_HEADERS_RESULTS && !sync.NeedMoreHeaders());
+
+    // the known headers are skipped, the headers not linking are rejected
+    BOOST_CHECK(sync.AddHeaders(moreHeaders));
+    BOOST_CHECK(sync.GetHeight() == 110 + MAX_HEADERS_RESULTS);
+    BOOST_CHECK(!sync.AddHeaders(MakeHeaders(uint256S("9999"), 100, 1, 1)));
+    BOOST_CHECK(!sync.AddHeaders(MakeHeaders(moreHeaders.back().GetHash(), sync.GetHeight() + 1, 1, 0)));
+
+    // the headers of a reorganized chain of the peer replace the old branch
+    vector<CBlock> forkHeaders = MakeHeaders(headers[99].GetHash(), 200, 2, 1);
+    BOOST_CHECK(sync.AddHeaders(forkHeaders));
+    BOOST_CHECK(sync.GetHeight() == 202 && sync.GetHash(202) == forkHeaders.back().GetHash());
+    BOOST_CHECK(sync.Contains(headers[99].GetHash()) && !sync.Contains(headers[100].GetHash()));
+
+    // the tip not advancing in the header chain stalls the sync
+    BOOST_CHECK(!sync.IsStalling(GetTimeMicros()));
+    BOOST_CHECK(sync.IsStalling(GetTimeMicros() + 2 * BLOCK_DOWNLOAD_TIMEOUT * 1000000 + 1000000));
+
+    // the headers connected to the tip are dropped
+    CTestTip newTip(headers[49].GetHash(), 150);
+    sync.UpdateTip(&newTip.index);
+    BOOST_CHECK(sync.IsSyncing() && sync.GetHash(150) == newTip.hash && sync.GetHash(149).IsNull());
+    BOOST_CHECK(!sync.Contains(headers[48].GetHash()) && sync.Contains(headers[50].GetHash()));
+
+    // the tip disconnected below the header chain is ignored, the tip leaving the header chain stops the sync
+    sync.UpdateTip(&tip.index);
+    BOOST_CHECK(sync.IsSyncing() && sync.GetHash(150) == newTip.hash);
+    CTestTip forkTip(uint256S("5678"), 151);
+    sync.UpdateTip(&forkTip.index);
+    BOOST_CHECK(!sync.IsSyncing() && !sync.Contains(headers[50].GetHash()));
+
+    // the sync is done when the tip reaches the last header of the peer
+    sync.Start(7, &tip.index);
+    headers = MakeHeaders(tip.hash, 100, 5, 0);
+    BOOST_CHECK(sync.AddHeaders(headers) && !sync.NeedMoreHeaders());
+    CTestTip lastTip(headers.back().GetHash(), 105);
+    sync.UpdateTip(&lastTip.index);
+    BOOST_CHECK(!sync.IsSyncing());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/util.h"
+#include "main.h"
+#include "rpc/core/jsonwriter.h"
+#include "rpc/core/rpcserver.h"
+#include "tx/cointransfertx.h"
+#include "tx/txmempool.h"
+#include "unit_tests/testutil.h"
+
+#include <event2/buffer.h>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace json_spirit;
+
+static const uint32_t MEMPOOL_TX_COUNT = 10000;
+
+static string GetBufferData(struct evbuffer *evb) {
+    size_t size = evbuffer_get_length(evb);
+    return size > 0 ? string((const char *)evbuffer_pullup(evb, size), size) : string();
+}
+
+// the verbose getrawmempool result as built before the streaming writer
+static Object BuildMempoolObject() {
+    LOCK(mempool.cs);
+    Object obj;
+    for (const auto &e : mempool.memPoolTxs) {
+        Object info;
+        info.push_back(Pair("size",         (int)e.GetTxSize()));
+        info.push_back(Pair("fees_type",    std::get<0>(e.GetFees())));
+        info.push_back(Pair("fees",         ValueFromAmount(std::get<1>(e.GetFees()))));
+        info.push_back(Pair("time",         e.GetTime()));
+        info.push_back(Pair("height",       (int)e.GetHeight()));
+        info.push_back(Pair("priority",     e.GetPriority()));
+        info.push_back(Pair("fee_per_kb",   e.GetFeePerKb()));
+        obj.push_back(Pair(e.GetHash().ToString(), info));
+    }
+    return obj;
+}
+
+BOOST_AUTO_TEST_SUITE(jsonwriter_tests)
+
+BOOST_AUTO_TEST_CASE(jsonwriter_test)
+{
+    Object inner;
+    inner.push_back(Pair("escaped", "quote\" backslash\\ newline\n tab\t"));
+    inner.push_back(Pair("empty_object", Object()));
+    inner.push_back(Pair("empty_array", Array()));
+
+    Array arr;
+    arr.push_back(-42);
+    arr.push_back((uint64_t)18446744073709551615ULL);
+    arr.push_back(0.5);
+    arr.push_back(1234567.123456789);
+    arr.push_back(true);
+    arr.push_back(Value::null);
+    arr.push_back(inner);
+
+    Object obj;
+    obj.push_back(Pair("name", "value"));
+    obj.push_back(Pair("array", arr));
+    obj.push_back(Pair("tree", inner));
+
+    // a tiny buffer, so the output is handed over in many chunks
+    string out;
+    uint32_t nChunks = 0;
+    CJsonWriter writer([&](const char *data, size_t size) { out.append(data, size); ++nChunks; }, 8);
+    writer.BeginObject();
+    writer.Key("name").String("value");
+    writer.Key("array").BeginArray();
+    writer.Int(-42).UInt(18446744073709551615ULL).Real(0.5).Real(1234567.123456789).Bool(true).Null();
+    writer.BeginObject();
+    writer.Key("escaped").String("quote\" backslash\\ newline\n tab\t");
+    writer.Key("empty_object").BeginObject().EndObject();
+    writer.Key("empty_array").BeginArray().EndArray();
+    writer.EndObject();
+    writer.EndArray();
+    writer.Key("tree").Write(inner);
+    writer.EndObject();
+
+    // nothing reaches the sink beyond the full chunks until flushed
+    BOOST_CHECK(out.size() < writer.GetWrittenSize());
+    writer.Flush();
+    BOOST_CHECK_EQUAL(out, write_string(Value(obj), false));
+    BOOST_CHECK_EQUAL(out.size(), writer.GetWrittenSize());
+    BOOST_CHECK(nChunks > 1);
+}
+
+BOOST_AUTO_TEST_CASE(getrawmempool_stream_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    for (uint32_t i = 0; i < MEMPOOL_TX_COUNT; ++i) {
+        auto pTx = std::make_shared<CBaseCoinTransferTx>(CRegID(i / 1000 + 1, i % 1000), CRegID(1, 1), 100,
+                                                         10000 + i, 10000, "memo");
+        mempool.memPoolTxs.insert(CTxMemPoolEntry(pTx, GetTime(), 100));
+    }
+    BOOST_REQUIRE(mempool.memPoolTxs.size() == MEMPOOL_TX_COUNT);
+
+    Array params;
+    params.push_back(true);
+    Value id("bench");
+
+    // streamed into the reply buffer, run first and kept alive so that the tree can not reuse its memory
+    struct evbuffer *streamBuffer = evbuffer_new();
+    uint64_t nStartMemory = GetResidentSize();
+    int64_t nStart        = GetTimeMicros();
+    {
+        CJsonWriter writer([streamBuffer](const char *data, size_t size) { evbuffer_add(streamBuffer, data, size); });
+        JSONRPCStreamReply("getrawmempool", params, id, writer);
+    }
+    int64_t nStreamTime     = max<int64_t>(GetTimeMicros() - nStart, 1);
+    int64_t nStreamMemory   = GetResidentSize() - nStartMemory;
+
+    // the tree, its text and the copy in the reply buffer, as replied before
+    struct evbuffer *treeBuffer = evbuffer_new();
+    nStartMemory        = GetResidentSize();
+    nStart              = GetTimeMicros();
+    int64_t nTreeMemory = 0;
+    {
+        string strReply;
+        {
+            Value result = BuildMempoolObject();
+            strReply     = JSONRPCReply(result, Value::null, id);
+            nTreeMemory  = GetResidentSize() - nStartMemory;
+        }
+        evbuffer_add(treeBuffer, strReply.data(), strReply.size());
+        // the RSS growth sampled with the tree alive and with the reply copied, not the peak in between
+        nTreeMemory = max<int64_t>(nTreeMemory, GetResidentSize() - nStartMemory);
+    }
+    int64_t nTreeTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+
+    string strStream = GetBufferData(streamBuffer);
+    BOOST_CHECK(!strStream.empty());
+    BOOST_CHECK(strStream == GetBufferData(treeBuffer));
+
+    BOOST_TEST_MESSAGE(strprintf("getrawmempool_stream_bench: %u txs, %u bytes reply, tree: %lld us, +%lld KB RSS, "
+                                 "streamed: %lld us, +%lld KB RSS",
+                                 MEMPOOL_TX_COUNT, strStream.size(), nTreeTime, nTreeMemory / 1024, nStreamTime,
+                                 nStreamMemory / 1024));
+
+    evbuffer_free(streamBuffer);
+    evbuffer_free(treeBuffer);
+    mempool.memPoolTxs.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
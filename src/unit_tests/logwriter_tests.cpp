@@ -0,0 +1,209 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/logwriter.h"
+#include "commons/util.h"
+#include "config/chainparams.h"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TEST_THREAD_COUNT = 4;
+
+static void OpenTestLogFile(DebugLogFile &log, const boost::filesystem::path &path) {
+    log.m_path          = path.string();
+    log.m_fileout       = fopen(log.m_path.c_str(), "a");
+    log.m_mutexDebugLog = new boost::mutex();
+    BOOST_REQUIRE(log.m_fileout != NULL);
+}
+
+static vector<string> ReadLines(const string &path) {
+    vector<string> lines;
+    std::ifstream file(path);
+    string line;
+    while (std::getline(file, line))
+        lines.push_back(line);
+    return lines;
+}
+
+// the lines of each thread are in order, "<thread> <seq>"
+static void CheckLines(const vector<string> &lines, uint32_t countPerThread) {
+    vector<uint32_t> nextSeqs(TEST_THREAD_COUNT, 0);
+    for (const auto &line : lines) {
+        uint32_t thread, seq;
+        BOOST_REQUIRE(sscanf(line.c_str(), "%u %u", &thread, &seq) == 2);
+        BOOST_REQUIRE(thread < TEST_THREAD_COUNT);
+        BOOST_CHECK_EQUAL(seq, nextSeqs[thread]);
+        nextSeqs[thread] = seq + 1;
+    }
+    for (auto nextSeq : nextSeqs)
+        BOOST_CHECK_EQUAL(nextSeq, countPerThread);
+}
+
+struct LogWriterTestingSetup {
+    boost::filesystem::path pathTemp;
+
+    LogWriterTestingSetup() {
+        pathTemp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("logwriter_%%%%%%%%");
+        boost::filesystem::create_directories(pathTemp);
+    }
+    ~LogWriterTestingSetup() { boost::filesystem::remove_all(pathTemp); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(logwriter_tests, LogWriterTestingSetup)
+
+BOOST_AUTO_TEST_CASE(ring_buffer_test)
+{
+    CMpscRingBuffer<pair<uint32_t, uint32_t>> queue(50);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 64U);
+
+    const uint32_t countPerThread = 20000;
+    vector<std::thread> producers;
+    for (uint32_t i = 0; i < TEST_THREAD_COUNT; ++i) {
+        producers.emplace_back([&queue, i]() {
+            for (uint32_t seq = 0; seq < countPerThread; ++seq) {
+                while (!queue.TryPush(make_pair(i, seq)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // the items of each producer are popped in order, none lost
+    vector<uint32_t> nextSeqs(TEST_THREAD_COUNT, 0);
+    pair<uint32_t, uint32_t> item;
+    for (uint32_t count = 0; count < TEST_THREAD_COUNT * countPerThread;) {
+        if (!queue.TryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        BOOST_REQUIRE_EQUAL(item.second, nextSeqs[item.first]);
+        nextSeqs[item.first]++;
+        ++count;
+    }
+    for (auto &producer : producers)
+        producer.join();
+
+    BOOST_CHECK(!queue.TryPop(item));
+    BOOST_CHECK_EQUAL(queue.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(log_writer_test)
+{
+    DebugLogFile logs[2];
+    OpenTestLogFile(logs[0], pathTemp / "a.log");
+    OpenTestLogFile(logs[1], pathTemp / "b.log");
+
+    // a small queue, so the logging threads also wait for the writer
+    CLogWriter writer;
+    writer.Start(16);
+    BOOST_CHECK(writer.IsRunning());
+
+    const uint32_t countPerThread = 2000;
+    std::atomic<uint32_t> nPushFailures(0);
+    vector<std::thread> threads;
+    for (uint32_t i = 0; i < TEST_THREAD_COUNT; ++i) {
+        threads.emplace_back([&writer, &logs, &nPushFailures, i]() {
+            for (uint32_t seq = 0; seq < countPerThread; ++seq) {
+                for (auto &log : logs) {
+                    CLogRecord record;
+                    record.pLogFile = &log;
+                    record.str      = strprintf("%u %u\n", i, seq);
+                    if (!writer.Push(std::move(record)))
+                        nPushFailures++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    BOOST_CHECK_EQUAL(nPushFailures.load(), 0U);
+
+    writer.Stop();
+    BOOST_CHECK(!writer.IsRunning());
+
+    CLogRecord record;
+    record.pLogFile = &logs[0];
+    BOOST_CHECK(!writer.Push(std::move(record)));
+
+    CLogWriterStats stats;
+    writer.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.recordCount, 2 * TEST_THREAD_COUNT * countPerThread);
+    BOOST_CHECK(stats.writeCount > 0 && stats.writeCount <= stats.recordCount);
+
+    for (auto &log : logs) {
+        vector<string> lines = ReadLines(log.m_path);
+        BOOST_CHECK_EQUAL(lines.size(), TEST_THREAD_COUNT * countPerThread);
+        CheckLines(lines, countPerThread);
+        BOOST_CHECK_EQUAL(log.m_fileSize, boost::filesystem::file_size(log.m_path));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_writer_stop_test)
+{
+    // the records queued while the writer is stopping are all written, before the ones written inline after
+    for (uint32_t round = 0; round < 20; ++round) {
+        DebugLogFile log;
+        OpenTestLogFile(log, pathTemp / strprintf("stop%u.log", round));
+
+        CLogWriter writer;
+        writer.Start(8);
+        std::atomic<uint32_t> nQueued(0);
+        vector<std::thread> threads;
+        for (uint32_t i = 0; i < TEST_THREAD_COUNT; ++i) {
+            threads.emplace_back([&writer, &log, &nQueued]() {
+                while (true) {
+                    CLogRecord record;
+                    record.pLogFile = &log;
+                    record.str      = "line\n";
+                    if (!writer.Push(std::move(record))) {
+                        WriteLogFile(log, GetTime(), "stopped\n");
+                        FlushLogFile(log);
+                        break;
+                    }
+                    nQueued++;
+                }
+            });
+        }
+        MilliSleep(1);
+        writer.Stop();
+        for (auto &thread : threads)
+            thread.join();
+
+        vector<string> lines = ReadLines(log.m_path);
+        BOOST_REQUIRE_EQUAL(lines.size(), nQueued.load() + TEST_THREAD_COUNT);
+        for (size_t i = 0; i < lines.size(); ++i)
+            BOOST_CHECK_EQUAL(lines[i] == "stopped", i >= nQueued.load());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_rotation_test)
+{
+    DebugLogFile log;
+    OpenTestLogFile(log, pathTemp / "c.log");
+
+    BOOST_CHECK_EQUAL(WriteLogFile(log, GetTime(), "first line\n"), 11);
+    BOOST_CHECK_EQUAL(log.m_fileSize, 11U);
+
+    // the counted size, not the file position, decides the rotation
+    log.m_fileSize = SysCfg().GetLogMaxSize() - 5;
+    BOOST_CHECK_EQUAL(WriteLogFile(log, GetTime(), "second line\n"), 12);
+    FlushLogFile(log);
+    BOOST_CHECK_EQUAL(log.m_fileSize, 12U);
+
+    vector<string> lines = ReadLines(log.m_path);
+    BOOST_REQUIRE_EQUAL(lines.size(), 1U);
+    BOOST_CHECK_EQUAL(lines[0], "second line");
+
+    lines = ReadLines(log.m_path + "bak");
+    BOOST_REQUIRE_EQUAL(lines.size(), 1U);
+    BOOST_CHECK_EQUAL(lines[0], "first line");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,259 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "persistence/cachewrapper.h"
+#include "tx/contracttx.h"
+#include "vm/luavm/luavmcache.h"
+#include "vm/luavm/luavmrunenv.h"
+#include "unit_tests/testutil.h"
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t BENCH_CALL_COUNT     = 2000;
+static const uint32_t BENCH_FUNCTION_COUNT = 100;
+
+static const uint32_t BENCH_ARGS_CALL_COUNT = 200;
+
+// a contract summing the 8 bytes integers of the arguments, unpacked from the byte table or read in the string
+static string MakeSumArgsContractCode(bool fStrArguments, int64_t argsSum) {
+    string code = strprintf("mylib = require \"mylib\"\n"
+                            "local sum = 0\n"
+                            "local ARGS_SUM = %d\n", argsSum);
+    if (fStrArguments) {
+        code += "for pos = 1, #contract - 7, 8 do\n"
+                "    sum = sum + mylib.StrToInteger(contract, pos, 8)\n"
+                "end\n";
+    } else {
+        code += "for pos = 1, #contract - 7, 8 do\n"
+                "    sum = sum + mylib.ByteToInteger(table.unpack(contract, pos, pos + 7))\n"
+                "end\n";
+    }
+    code += "assert(sum == ARGS_SUM, \"wrong sum of the arguments\")\n";
+    return code;
+}
+
+// a contract with many functions of which a call runs one, and fails if the globals of the last call leak
+static string MakeContractCode(uint32_t functionCount) {
+    string code = "mylib = require \"mylib\"\n";
+    for (uint32_t i = 0; i < functionCount; ++i) {
+        code += strprintf("function Method%u(args)\n"
+                          "    local sum = %u\n"
+                          "    for i = 1, #args do sum = sum + args[i] * %u end\n"
+                          "    return sum\n"
+                          "end\n", i, i, i + 1);
+    }
+    code += "assert(lastSum == nil, \"globals of the last call leaked\")\n"
+            "assert(string.leaked == nil, \"libs of the last call leaked\")\n"
+            "string.leaked = true\n"
+            "lastSum = Method7(contract)\n";
+    return code;
+}
+
+struct LuaVMTestingSetup {
+    CCacheDBManager cdMan;
+    CCacheWrapper cw;
+    CLuaContractInvokeTx tx;
+    CAccount userAccount;
+    CAccount appAccount;
+    CUniversalContract contract;
+    string arguments;
+    uint32_t height;
+
+    LuaVMTestingSetup()
+        : cdMan(true, false, 1 << 20, 1 << 20, 1 << 20, 1 << 20),
+          cw(&cdMan),
+          contract(MakeContractCode(BENCH_FUNCTION_COUNT), "bench"),
+          arguments(32, 0x11),
+          height(1) {
+        appAccount.regid = CRegID(100, 1);
+        luaVMCache.Clear();
+        // the cache serves the burner versions charging the executed steps only
+        BOOST_REQUIRE(GetFeatureForkVersion(height) == MAJOR_VER_R1);
+    }
+
+    ~LuaVMTestingSetup() { luaVMCache.Clear(); }
+
+    bool Call(uint64_t &fuel) {
+        CLuaVMContext context;
+        context.p_cw              = &cw;
+        context.height            = height;
+        context.p_base_tx         = &tx;
+        context.fuel_limit        = 10000000;
+        context.transfer_symbol   = SYMB::WICC;
+        context.transfer_amount   = 0;
+        context.p_tx_user_account = &userAccount;
+        context.p_app_account     = &appAccount;
+        context.p_contract        = &contract;
+        context.p_arguments       = &arguments;
+
+        CLuaVMRunEnv runEnv;
+        auto pErr = runEnv.ExecuteContract(&context, fuel);
+        if (pErr)
+            BOOST_TEST_MESSAGE("contract call failed: " + *pErr);
+        return pErr == nullptr;
+    }
+
+    // contract calls per second
+    double Bench(uint32_t maxChunks) {
+        luaVMCache.Clear();
+        luaVMCache.SetMaxChunks(maxChunks);
+        uint64_t fuel = 0;
+        int64_t nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < BENCH_CALL_COUNT; ++i)
+            BOOST_CHECK(Call(fuel));
+        int64_t nTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+        return BENCH_CALL_COUNT * 1000000.0 / nTime;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(luavm_tests, LuaVMTestingSetup)
+
+BOOST_AUTO_TEST_CASE(luavm_cache_test)
+{
+    luaVMCache.SetMaxChunks(0);
+    uint64_t freshFuel = 0;
+    BOOST_CHECK(Call(freshFuel));
+
+    // compiled and cached, then loaded from cache into a new state, with the same fuel burned
+    luaVMCache.SetMaxChunks(DEFAULT_LUAVM_CACHE_SIZE);
+    uint64_t missFuel = 0, hitFuel = 0;
+    BOOST_CHECK(Call(missFuel) && missFuel == freshFuel);
+    BOOST_CHECK(Call(hitFuel) && hitFuel == freshFuel);
+
+    CLuaVMCacheStats stats;
+    luaVMCache.GetStats(stats);
+    BOOST_CHECK(stats.chunkCount == 1 && stats.chunkHits == 1 && stats.chunkMisses == 1);
+
+    // the upgraded code replaces the cached chunk
+    contract.code += "lastSum = lastSum + 1\n";
+    uint64_t upgradedFuel = 0;
+    BOOST_CHECK(Call(upgradedFuel) && upgradedFuel > freshFuel);
+    luaVMCache.GetStats(stats);
+    BOOST_CHECK(stats.chunkCount == 1 && stats.chunkMisses == 2);
+
+    // the cache is not used by the burner versions charging the memory
+    height = SysCfg().GetFeatureForkHeight();
+    BOOST_CHECK(!luaVMCache.IsUsable(GetFeatureForkVersion(height)));
+    BOOST_CHECK(Call(upgradedFuel));
+    luaVMCache.GetStats(stats);
+    BOOST_CHECK(stats.chunkHits == 1 && stats.chunkMisses == 2);
+}
+
+BOOST_AUTO_TEST_CASE(luavm_cache_gc_test)
+{
+    // every call gets a new state with the real collectgarbage(), cached or not
+    contract.code = "assert(collectgarbage(\"count\") > 0, \"heap of the state not seen\")\n"
+                    "assert(lastCall == nil, \"globals of the last call seen\")\n"
+                    "lastCall = true\n"
+                    "collectgarbage(\"setpause\", 1000)\n"
+                    "assert(collectgarbage(\"isrunning\"))\n"
+                    "collectgarbage(\"stop\")\n";
+
+    luaVMCache.SetMaxChunks(0);
+    uint64_t freshFuel = 0;
+    BOOST_CHECK(Call(freshFuel));
+
+    luaVMCache.SetMaxChunks(DEFAULT_LUAVM_CACHE_SIZE);
+    uint64_t missFuel = 0, hitFuel = 0;
+    BOOST_CHECK(Call(missFuel) && missFuel == freshFuel);
+    BOOST_CHECK(Call(hitFuel) && hitFuel == freshFuel);
+
+    CLuaVMCacheStats stats;
+    luaVMCache.GetStats(stats);
+    BOOST_CHECK(stats.chunkHits == 1 && stats.chunkMisses == 1);
+}
+
+BOOST_AUTO_TEST_CASE(luavm_cache_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    double uncachedRate = Bench(0);
+    double cachedRate   = Bench(DEFAULT_LUAVM_CACHE_SIZE);
+
+    BOOST_TEST_MESSAGE(strprintf("luavm_cache_bench: %u bytes of code, no cache: %.2f calls/s, cache: %.2f calls/s",
+                                 contract.code.size(), uncachedRate, cachedRate));
+}
+
+BOOST_AUTO_TEST_CASE(luavm_str_args_test)
+{
+    height    = SysCfg().GetFeatureForkV3Height();
+    arguments = ParseHexStr("0102030405060708ff");
+    contract  = CUniversalContract(VMType::LUA_VM_STR, true,
+        "mylib = require \"mylib\"\n"
+        "assert(type(contract) == \"string\" and #contract == 9)\n"
+        "assert(mylib.StrToInteger(contract, 1, 1) == 0x01)\n"
+        "assert(mylib.StrToInteger(contract, 1, 2) == 0x0201)\n"
+        "assert(mylib.StrToInteger(contract, 2, 4) == 0x05040302)\n"
+        "assert(mylib.StrToInteger(contract, 1, 8) == 0x0807060504030201)\n"
+        "assert(mylib.StrToInteger(contract, 9, 1) == 0xff)\n"
+        "assert(mylib.StrToInteger(contract, 3, 8) == nil)\n"
+        "assert(mylib.StrToInteger(contract, 0, 1) == nil)\n"
+        "assert(mylib.StrToInteger(contract, 1, 3) == nil)\n"
+        "local bytes = {mylib.StrToBytes(contract, 8, 2)}\n"
+        "assert(#bytes == 2 and bytes[1] == 0x08 and bytes[2] == 0xff)\n"
+        "assert(mylib.ByteToInteger(mylib.StrToBytes(contract, 1, 4)) == 0x04030201)\n"
+        "assert(mylib.StrToBytes(contract, 9, 2) == nil)\n", "str args", "");
+    BOOST_CHECK(contract.IsValid(height));
+
+    uint64_t fuel = 0;
+    BOOST_CHECK(Call(fuel));
+
+    // before the feature fork v3 the contract is run without the headline check, with the byte table and without
+    // the new mylib functions
+    height        = SysCfg().GetFeatureForkHeight();
+    contract.code = "mylib = require \"mylib\"\n"
+                    "assert(type(contract) == \"table\" and #contract == 9 and contract[9] == 0xff)\n"
+                    "assert(mylib.StrToInteger == nil and mylib.StrToBytes == nil)\n";
+    BOOST_CHECK(contract.IsValid(height));
+    BOOST_CHECK(Call(fuel));
+    contract.code = "-- no headline\n";
+    BOOST_CHECK(contract.IsValid(height));
+    BOOST_CHECK(!contract.IsValid(SysCfg().GetFeatureForkV3Height()));
+
+    // the arguments of the existing lua contracts are still passed as a byte table
+    height           = SysCfg().GetFeatureForkV3Height();
+    contract.vm_type = VMType::LUA_VM;
+    contract.code    = "mylib = require \"mylib\"\n"
+                       "assert(type(contract) == \"table\" and #contract == 9 and contract[9] == 0xff)\n";
+    BOOST_CHECK(Call(fuel));
+}
+
+BOOST_AUTO_TEST_CASE(luavm_str_args_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    // the burner version charging the memory and the mylib functions, with the mylib functions of the feature fork v3
+    height = SysCfg().GetFeatureForkV3Height();
+    arguments.clear();
+    int64_t sum = 0;
+    for (uint32_t i = 0; arguments.size() + 8 <= MAX_CONTRACT_ARGUMENT_SIZE; ++i) {
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << (int64_t)i;
+        arguments.append(ds.begin(), ds.end());
+        sum += i;
+    }
+
+    for (bool fStrArguments : {false, true}) {
+        contract = CUniversalContract(fStrArguments ? VMType::LUA_VM_STR : VMType::LUA_VM, true,
+                                      MakeSumArgsContractCode(fStrArguments, sum),
+                                      "bench", "");
+        uint64_t fuel  = 0;
+        int64_t nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < BENCH_ARGS_CALL_COUNT; ++i)
+            BOOST_CHECK(Call(fuel));
+        int64_t nTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+
+        BOOST_TEST_MESSAGE(strprintf("luavm_str_args_bench: %u bytes of arguments as %s: %.2f calls/s, fuel %llu",
+                                     arguments.size(), fStrArguments ? "string" : "table",
+                                     BENCH_ARGS_CALL_COUNT * 1000000.0 / nTime, fuel));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tx/txmempool.h"
+#include "tx/cointransfertx.h"
+#include "commons/util.h"
+#include "unit_tests/testutil.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t PENDING_TX_COUNT = 50000;
+
+static void MakeTxs(uint32_t count, vector<std::shared_ptr<CBaseTx>> &txs) {
+    txs.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        txs.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(i / 1000 + 1, i % 1000), CRegID(1, 1), 100,
+                                                            10000 + i, 10000, "memo"));
+    }
+}
+
+// insert the pending txs into the mempool entry set, cloning every tx as the entries used to do
+static void InsertTxs(const vector<std::shared_ptr<CBaseTx>> &txs, bool fClone, CTxMemPoolEntrySet &entries,
+                      int64_t &nTime, int64_t &nMemory) {
+    uint64_t nStartMemory = GetResidentSize();
+    int64_t nStart        = GetTimeMicros();
+    for (const auto &pTx : txs) {
+        entries.insert(CTxMemPoolEntry(fClone ? pTx->GetNewInstance() : pTx, GetTime(), 100));
+    }
+    nTime   = max<int64_t>(GetTimeMicros() - nStart, 1);
+    nMemory = GetResidentSize() - nStartMemory;
+}
+
+BOOST_AUTO_TEST_SUITE(mempool_tests)
+
+BOOST_AUTO_TEST_CASE(mempool_entry_test)
+{
+    vector<std::shared_ptr<CBaseTx>> txs;
+    MakeTxs(10, txs);
+
+    CTxMemPoolEntrySet entries;
+    for (const auto &pTx : txs) {
+        entries.insert(CTxMemPoolEntry(pTx, GetTime(), 100));
+    }
+    BOOST_CHECK(entries.size() == txs.size());
+
+    // the entry shares the tx instead of holding a copy
+    auto iter = entries.find(txs[3]->GetHash());
+    BOOST_REQUIRE(iter != entries.end());
+    BOOST_CHECK(iter->GetTransaction() == txs[3]);
+    BOOST_CHECK(iter->GetSender() == txs[3]->txUid.ToString());
+
+    // the sender index groups the txs of one account
+    auto range = entries.get<sender_tag>().equal_range(txs[3]->txUid.ToString());
+    BOOST_CHECK(std::distance(range.first, range.second) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(mempool_insert_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    vector<std::shared_ptr<CBaseTx>> txs;
+    MakeTxs(PENDING_TX_COUNT, txs);
+    for (const auto &pTx : txs)
+        pTx->GetHash();  // hash once, as the txs received from network
+
+    // keep both sets alive, so that the second one does not reuse the memory freed by the first one
+    int64_t nShareTime, nShareMemory, nCloneTime, nCloneMemory;
+    CTxMemPoolEntrySet sharedEntries, clonedEntries;
+    InsertTxs(txs, false, sharedEntries, nShareTime, nShareMemory);
+    InsertTxs(txs, true, clonedEntries, nCloneTime, nCloneMemory);
+    BOOST_CHECK(sharedEntries.size() == PENDING_TX_COUNT);
+    BOOST_CHECK(clonedEntries.size() == PENDING_TX_COUNT);
+
+    BOOST_TEST_MESSAGE(strprintf("mempool_insert_bench: %u pending txs, shared: %.0f txs/s, +%lld KB RSS, "
+                                 "cloned: %.0f txs/s, +%lld KB RSS",
+                                 PENDING_TX_COUNT, PENDING_TX_COUNT * 1000000.0 / nShareTime, nShareMemory / 1024,
+                                 PENDING_TX_COUNT * 1000000.0 / nCloneTime, nCloneMemory / 1024));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
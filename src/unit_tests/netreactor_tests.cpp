@@ -0,0 +1,75 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/util.h"
+#include "netreactor.h"
+
+#include <sys/socket.h>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static uint32_t GetEventFlags(const vector<CNetReactor::Event> &events, SOCKET hSocket, void *pData) {
+    uint32_t flags = 0;
+    for (const auto &event : events) {
+        if (event.hSocket == hSocket) {
+            BOOST_CHECK(event.pData == pData);
+            flags |= event.flags;
+        }
+    }
+    return flags;
+}
+
+BOOST_AUTO_TEST_SUITE(netreactor_tests)
+
+BOOST_AUTO_TEST_CASE(netreactor_test)
+{
+    int fds[2];
+    BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    SOCKET hSocket = fds[0];
+    int nData      = 1;
+
+    CNetReactor reactor;
+    BOOST_REQUIRE(reactor.Open());
+
+    vector<CNetReactor::Event> events;
+    reactor.Watch(hSocket, &nData, true, true);
+    BOOST_CHECK(reactor.Wait(1000, events));
+    uint32_t flags = GetEventFlags(events, hSocket, &nData);
+    BOOST_CHECK((flags & CNetReactor::EVENT_SEND) && !(flags & CNetReactor::EVENT_RECV));
+
+    BOOST_CHECK(send(fds[1], "ping", 4, 0) == 4);
+    reactor.Watch(hSocket, &nData, true, false);
+    BOOST_CHECK(reactor.Wait(1000, events));
+    BOOST_CHECK(GetEventFlags(events, hSocket, &nData) & CNetReactor::EVENT_RECV);
+
+    // edge-triggered: the undrained data is not reported again
+    reactor.Watch(hSocket, &nData, true, false);
+    BOOST_CHECK(reactor.Wait(0, events));
+    BOOST_CHECK(GetEventFlags(events, hSocket, &nData) == (reactor.IsEdgeTriggered() ? 0 : CNetReactor::EVENT_RECV));
+
+    // woken by another thread
+    char buf[16];
+    BOOST_CHECK(recv(hSocket, buf, sizeof(buf), MSG_DONTWAIT) == 4);
+    reactor.Watch(hSocket, &nData, true, false);
+    thread waker([&reactor]() { reactor.Wakeup(); });
+    int64_t nStart = GetTimeMillis();
+    BOOST_CHECK(reactor.Wait(10000, events));
+    BOOST_CHECK(GetTimeMillis() - nStart < 5000);
+    waker.join();
+
+    // the peer closed
+    close(fds[1]);
+    reactor.Watch(hSocket, &nData, true, false);
+    BOOST_CHECK(reactor.Wait(1000, events));
+    BOOST_CHECK(GetEventFlags(events, hSocket, &nData) & (CNetReactor::EVENT_RECV | CNetReactor::EVENT_ERROR));
+
+    // the sockets not watched in a round are not reported
+    BOOST_CHECK(reactor.Wait(0, events));
+    BOOST_CHECK(events.empty());
+    close(fds[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
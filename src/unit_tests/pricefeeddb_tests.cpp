@@ -0,0 +1,179 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "commons/util.h"
+#include "config/const.h"
+#include "persistence/pricefeeddb.h"
+#include "unit_tests/testutil.h"
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint64_t SLIDE_WINDOW         = 11;
+static const uint32_t FEEDER_COUNT         = 25;
+static const int32_t TEST_BLOCK_COUNT      = 200;
+static const int32_t BENCH_BLOCK_COUNT     = 2000;
+static const uint32_t BENCH_READS_PER_BLOCK = 50;  // the median reads of a block: miner, txs, rpcs
+
+static const CoinPricePair BCOIN_PRICE_PAIR(SYMB::WICC, SYMB::USD);
+static const CoinPricePair FCOIN_PRICE_PAIR(SYMB::WGRT, SYMB::USD);
+
+static uint64_t MakePrice(int32_t height, uint32_t feeder) {
+    return 100000000 + ((height * 7919ULL + feeder * 104729ULL) % 20000000);
+}
+
+// the feeders of a block, a few of them skip some blocks
+static void AddBlockPrices(CPricePointMemCache &cache, int32_t height, BlockUserPriceMap &blockUserPrices) {
+    for (uint32_t feeder = 0; feeder < FEEDER_COUNT; ++feeder) {
+        if ((height + feeder) % 5 == 0)
+            continue;
+
+        CRegID regId(feeder + 1, 1);
+        uint64_t price = MakePrice(height, feeder);
+        vector<CPricePoint> pps = {CPricePoint(BCOIN_PRICE_PAIR, price), CPricePoint(FCOIN_PRICE_PAIR, price / 10)};
+        BOOST_CHECK(cache.AddBlockPricePointInBatch(height, regId, pps));
+        blockUserPrices[height][regId] = price;
+    }
+}
+
+// the median sorted out of all the prices of the window, as computed before the median windows
+static uint64_t ComputeMedianPrice(const BlockUserPriceMap &blockUserPrices, int32_t height) {
+    vector<uint64_t> prices;
+    for (int32_t h = height; h > height - (int32_t)SLIDE_WINDOW; --h) {
+        auto iter = blockUserPrices.find(h);
+        if (iter != blockUserPrices.end()) {
+            for (const auto &userPrice : iter->second)
+                prices.push_back(userPrice.second);
+        }
+    }
+    if (prices.empty())
+        return 0;
+
+    sort(prices.begin(), prices.end());
+    size_t size = prices.size();
+    return (size % 2 == 0) ? (prices[size / 2 - 1] + prices[size / 2]) / 2 : prices[size / 2];
+}
+
+BOOST_AUTO_TEST_SUITE(pricefeeddb_tests)
+
+BOOST_AUTO_TEST_CASE(median_price_window_test)
+{
+    CMedianPriceWindow window;
+    BOOST_CHECK_EQUAL(window.GetMedian(), 0);
+
+    multiset<uint64_t> prices;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint64_t price = (i * 7919) % 101;
+        if (i % 3 == 2 && !prices.empty()) {
+            auto iter = prices.begin();
+            std::advance(iter, (i * 31) % prices.size());
+            window.RemovePrice(*iter);
+            prices.erase(iter);
+        } else {
+            window.AddPrice(price);
+            prices.insert(price);
+        }
+
+        vector<uint64_t> sorted(prices.begin(), prices.end());
+        size_t size     = sorted.size();
+        uint64_t median = size == 0 ? 0 : (size % 2 == 0 ? (sorted[size / 2 - 1] + sorted[size / 2]) / 2
+                                                         : sorted[size / 2]);
+        BOOST_CHECK_EQUAL(window.GetMedian(), median);
+        BOOST_CHECK_EQUAL(window.GetSize(), size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(median_price_layers_test)
+{
+    CPricePointMemCache baseCache;
+    BlockUserPriceMap blockUserPrices;
+    for (int32_t height = 1; height <= TEST_BLOCK_COUNT; ++height) {
+        // a block connected in its own layer: the median at the tip first, then the prices of the block
+        CPricePointMemCache blockCache;
+        blockCache.SetBaseViewPtr(&baseCache);
+        BOOST_CHECK_EQUAL(blockCache.GetMedianPrice(height - 1, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                          ComputeMedianPrice(blockUserPrices, height - 1));
+
+        AddBlockPrices(blockCache, height, blockUserPrices);
+        BOOST_CHECK_EQUAL(blockCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                          ComputeMedianPrice(blockUserPrices, height));
+
+        // a tx layer on top of the block, reading the block layer
+        CPricePointMemCache txCache;
+        txCache.SetBaseViewPtr(&blockCache);
+        BOOST_CHECK_EQUAL(txCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                          ComputeMedianPrice(blockUserPrices, height));
+
+        if (height > (int32_t)SLIDE_WINDOW) {
+            blockCache.DeleteBlockPricePoint(height - SLIDE_WINDOW);
+            blockUserPrices.erase(height - SLIDE_WINDOW);
+        }
+
+        // every 10th block is disconnected before being connected
+        if (height % 10 == 0) {
+            BlockUserPriceMap blockUserPricesBefore = blockUserPrices;
+            blockCache.Flush();
+            BOOST_CHECK_EQUAL(baseCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                              ComputeMedianPrice(blockUserPrices, height));
+
+            CPricePointMemCache undoCache;
+            undoCache.SetBaseViewPtr(&baseCache);
+            undoCache.DeleteBlockPricePoint(height);
+            blockUserPrices.erase(height);
+            BOOST_CHECK_EQUAL(undoCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                              ComputeMedianPrice(blockUserPrices, height));
+            undoCache.Flush();
+
+            blockCache.SetBaseViewPtr(&baseCache);
+            AddBlockPrices(blockCache, height, blockUserPrices);
+            BOOST_CHECK(blockUserPrices == blockUserPricesBefore);
+        }
+        blockCache.Flush();
+
+        BOOST_CHECK_EQUAL(baseCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR),
+                          ComputeMedianPrice(blockUserPrices, height));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(median_price_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    CPricePointMemCache baseCache;
+    BlockUserPriceMap blockUserPrices;
+    int64_t nWindowTime = 0, nSortTime = 0;
+    for (int32_t height = 1; height <= BENCH_BLOCK_COUNT; ++height) {
+        CPricePointMemCache blockCache;
+        blockCache.SetBaseViewPtr(&baseCache);
+        AddBlockPrices(blockCache, height, blockUserPrices);
+
+        int64_t nStart = GetTimeMicros();
+        uint64_t windowMedian = 0;
+        for (uint32_t i = 0; i < BENCH_READS_PER_BLOCK; ++i)
+            windowMedian = blockCache.GetMedianPrice(height, SLIDE_WINDOW, BCOIN_PRICE_PAIR);
+        nWindowTime += GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        uint64_t sortMedian = 0;
+        for (uint32_t i = 0; i < BENCH_READS_PER_BLOCK; ++i)
+            sortMedian = ComputeMedianPrice(blockUserPrices, height);
+        nSortTime += GetTimeMicros() - nStart;
+        BOOST_CHECK_EQUAL(windowMedian, sortMedian);
+
+        if (height > (int32_t)SLIDE_WINDOW) {
+            blockCache.DeleteBlockPricePoint(height - SLIDE_WINDOW);
+            blockUserPrices.erase(height - SLIDE_WINDOW);
+        }
+        blockCache.Flush();
+    }
+
+    BOOST_TEST_MESSAGE(strprintf("median_price_bench: %d blocks, %u feeders, %u reads per block, "
+                                 "sorted window: %lld us, median window: %lld us",
+                                 BENCH_BLOCK_COUNT, FEEDER_COUNT, BENCH_READS_PER_BLOCK, nSortTime, nWindowTime));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
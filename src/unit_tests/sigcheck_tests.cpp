@@ -0,0 +1,98 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sigcache.h"
+#include "entities/key.h"
+#include "commons/util.h"
+#include "unit_tests/testutil.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+using namespace std;
+
+static const uint32_t BENCH_BLOCK_COUNT   = 20;
+static const uint32_t BENCH_TXS_PER_BLOCK = 500;
+
+static void MakeSignatureChecks(uint32_t count, vector<CSignatureCheck> &checks) {
+    vector<CKey> keys(16);
+    for (auto &key : keys)
+        key.MakeNewKey();
+
+    checks.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const CKey &key = keys[i % keys.size()];
+        uint256 sigHash = GetRandHash();
+        vector<unsigned char> vchSig;
+        BOOST_REQUIRE(key.Sign(sigHash, vchSig));
+        checks.emplace_back(sigHash, vchSig, key.GetPubKey());
+    }
+}
+
+// blocks per second by verifying every block as one batch, a fresh cache each time
+static double BenchBlocks(CSignatureCheckQueue &queue, const vector<vector<CSignatureCheck>> &blocks) {
+    int64_t nStart = GetTimeMicros();
+    for (const auto &block : blocks) {
+        CSignatureCache sigCache;
+        BOOST_CHECK(queue.Verify(block, sigCache));
+    }
+    int64_t nTime = max<int64_t>(GetTimeMicros() - nStart, 1);
+    return blocks.size() * 1000000.0 / nTime;
+}
+
+struct SigCheckTestingSetup {
+    SigCheckTestingSetup() { ECC_Start(); }
+    ~SigCheckTestingSetup() { ECC_Stop(); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(sigcheck_tests, SigCheckTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sigcheck_queue_test)
+{
+    vector<CSignatureCheck> checks;
+    MakeSignatureChecks(200, checks);
+
+    CSignatureCheckQueue queue;
+    queue.Start(3);
+    BOOST_CHECK(queue.GetThreadCount() == 4);
+
+    CSignatureCache sigCache;
+    BOOST_CHECK(queue.Verify(checks, sigCache));
+    for (const auto &check : checks)
+        BOOST_CHECK(sigCache.Get(check.sigHash, check.vchSig, check.pubKey));
+
+    // one bad signature fails the whole batch
+    checks[137].sigHash = GetRandHash();
+    CSignatureCache sigCache2;
+    BOOST_CHECK(!queue.Verify(checks, sigCache2));
+
+    queue.Stop();
+    BOOST_CHECK(!queue.IsRunning());
+    BOOST_CHECK(!queue.Verify(checks, sigCache2));
+}
+
+BOOST_AUTO_TEST_CASE(sigcheck_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    vector<vector<CSignatureCheck>> blocks(BENCH_BLOCK_COUNT);
+    for (auto &block : blocks)
+        MakeSignatureChecks(BENCH_TXS_PER_BLOCK, block);
+
+    CSignatureCheckQueue serialQueue;
+    double serialRate = BenchBlocks(serialQueue, blocks);
+
+    uint32_t nThreads = max<uint32_t>(boost::thread::hardware_concurrency(), 2);
+    CSignatureCheckQueue parallelQueue;
+    parallelQueue.Start(nThreads - 1);
+    double parallelRate = BenchBlocks(parallelQueue, blocks);
+    parallelQueue.Stop();
+
+    BOOST_TEST_MESSAGE(strprintf("sigcheck_bench: %u txs/block, serial: %.2f blocks/s, %u threads: %.2f blocks/s",
+                                 BENCH_TXS_PER_BLOCK, serialRate, nThreads, parallelRate));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,26 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "testutil.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include <boost/test/unit_test.hpp>
+
+bool IsBenchEnabled() {
+    if (getenv("UNIT_TEST_BENCH") != nullptr)
+        return true;
+
+    BOOST_TEST_MESSAGE("bench skipped, set UNIT_TEST_BENCH to run it");
+    return false;
+}
+
+uint64_t GetResidentSize() {
+    uint64_t pages = 0, residentPages = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (!(statm >> pages >> residentPages))
+        return 0;
+    return residentPages * sysconf(_SC_PAGESIZE);
+}
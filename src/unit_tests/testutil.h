@@ -0,0 +1,20 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNIT_TESTS_TESTUTIL_H
+#define UNIT_TESTS_TESTUTIL_H
+
+#include <cstdint>
+
+/**
+ * Whether the bench cases run, which is when the env var UNIT_TEST_BENCH is set, e.g.
+ * UNIT_TEST_BENCH=1 ./unit_test --run_test=sigcheck_tests/sigcheck_bench
+ * Otherwise they return at once, so make check runs the tests only.
+ */
+bool IsBenchEnabled();
+
+/** The resident set size of the process in bytes, 0 if unknown. */
+uint64_t GetResidentSize();
+
+#endif  // UNIT_TESTS_TESTUTIL_H
@@ -0,0 +1,114 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "persistence/txdb.h"
+#include "tx/cointransfertx.h"
+#include "unit_tests/testutil.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TXS_PER_BLOCK = 1000;
+static const uint32_t LOOKUP_COUNT  = 10000;
+
+static void MakeBlocks(uint32_t txCount, vector<CBlock> &blocks) {
+    uint32_t blockCount = txCount / TXS_PER_BLOCK;
+    blocks.resize(blockCount);
+    for (uint32_t height = 0; height < blockCount; ++height) {
+        CBlock &block = blocks[height];
+        block.SetHeight(height + 1);
+        block.vptx.reserve(TXS_PER_BLOCK);
+        for (uint32_t i = 0; i < TXS_PER_BLOCK; ++i) {
+            block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(
+                CRegID(height + 1, i), CRegID(1, 1), height + 1, i + 1, 10000, ""));
+        }
+    }
+}
+
+// the lookup before indexing: scan the tx hash set of every cached block
+static uint256 ScanTx(CTxMemCache &txCache, const uint256 &txid) {
+    for (auto &item : txCache.GetTxHashCache()) {
+        if (item.second.count(txid))
+            return item.first;
+    }
+    return uint256();
+}
+
+BOOST_AUTO_TEST_SUITE(txcache_tests)
+
+BOOST_AUTO_TEST_CASE(txcache_layer_test)
+{
+    vector<CBlock> blocks;
+    MakeBlocks(3 * TXS_PER_BLOCK, blocks);
+    const uint256 txid0 = blocks[0].vptx[5]->GetHash();
+    const uint256 txid1 = blocks[1].vptx[5]->GetHash();
+    const uint256 txid2 = blocks[2].vptx[5]->GetHash();
+
+    CTxMemCache baseCache;
+    baseCache.AddBlockToCache(blocks[0]);
+    baseCache.AddBlockToCache(blocks[1]);
+    BOOST_CHECK(baseCache.HaveTx(txid0) == blocks[0].GetHash());
+    BOOST_CHECK(baseCache.HaveTx(txid2) == uint256());
+
+    CTxMemCache childCache(&baseCache);
+    childCache.AddBlockToCache(blocks[2]);
+    childCache.DeleteBlockFromCache(blocks[0]);
+    BOOST_CHECK(childCache.HaveTx(txid2) == blocks[2].GetHash());
+    BOOST_CHECK(childCache.HaveTx(txid0) == uint256());
+    BOOST_CHECK(baseCache.HaveTx(txid0) == blocks[0].GetHash());
+    BOOST_CHECK(baseCache.HaveTx(txid2) == uint256());
+    // the tx of a block held in the base only is not seen through the child
+    BOOST_CHECK(childCache.HaveTx(txid1) == uint256());
+
+    childCache.Flush();
+    BOOST_CHECK(baseCache.HaveTx(txid0) == uint256());
+    BOOST_CHECK(baseCache.HaveTx(txid2) == blocks[2].GetHash());
+    BOOST_CHECK(baseCache.GetSize() == 2);
+
+    baseCache.SetTxHashCache(map<uint256, UnorderedHashSet>());
+    BOOST_CHECK(baseCache.HaveTx(txid2) == uint256());
+}
+
+BOOST_AUTO_TEST_CASE(txcache_bench)
+{
+    if (!IsBenchEnabled())
+        return;
+
+    for (uint32_t txCount : {10000, 100000}) {
+        vector<CBlock> blocks;
+        MakeBlocks(txCount, blocks);
+
+        CTxMemCache txCache;
+        for (const auto &block : blocks)
+            txCache.AddBlockToCache(block);
+
+        vector<uint256> txids;
+        txids.reserve(LOOKUP_COUNT);
+        for (uint32_t i = 0; i < LOOKUP_COUNT; ++i) {
+            // half hits, half misses
+            txids.push_back(i % 2 ? blocks[i % blocks.size()].vptx[i % TXS_PER_BLOCK]->GetHash() : GetRandHash());
+        }
+
+        int64_t nStart = GetTimeMicros();
+        for (const auto &txid : txids)
+            ScanTx(txCache, txid);
+        int64_t nScanTime = GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        for (const auto &txid : txids)
+            txCache.HaveTx(txid);
+        int64_t nIndexTime = GetTimeMicros() - nStart;
+
+        for (const auto &txid : txids)
+            BOOST_CHECK(txCache.HaveTx(txid) == ScanTx(txCache, txid));
+
+        BOOST_TEST_MESSAGE(strprintf("txcache_bench: %u cached txs, scan: %.3fus/lookup, index: %.3fus/lookup",
+                                     txCount, (double)nScanTime / LOOKUP_COUNT, (double)nIndexTime / LOOKUP_COUNT));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
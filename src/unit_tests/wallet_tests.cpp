@@ -0,0 +1,55 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "wallet/wallet.h"
+#include "tx/cointransfertx.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+struct WalletTestingSetup {
+    CCacheDBManager cdMan;
+    CCacheDBManager *pOldCdMan;
+
+    WalletTestingSetup() : cdMan(true, false, 1 << 20, 1 << 20, 1 << 20, 1 << 20), pOldCdMan(pCdMan) {
+        ECC_Start();
+        pCdMan = &cdMan;
+    }
+
+    ~WalletTestingSetup() {
+        pCdMan = pOldCdMan;
+        ECC_Stop();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(wallet_tests, WalletTestingSetup)
+
+BOOST_AUTO_TEST_CASE(wallet_is_mine_test)
+{
+    CKey senderKey, receiverKey, otherKey;
+    senderKey.MakeNewKey();
+    receiverKey.MakeNewKey();
+    otherKey.MakeNewKey();
+
+    // the keys are loaded without the wallet file
+    CWallet senderWallet("wallet_tests.dat"), receiverWallet("wallet_tests.dat"), otherWallet("wallet_tests.dat");
+    BOOST_CHECK(senderWallet.LoadKeyCombi(senderKey.GetPubKey().GetKeyId(), CKeyCombi(senderKey, 0)));
+    BOOST_CHECK(receiverWallet.LoadKeyCombi(receiverKey.GetPubKey().GetKeyId(), CKeyCombi(receiverKey, 0)));
+    BOOST_CHECK(otherWallet.LoadKeyCombi(otherKey.GetPubKey().GetKeyId(), CKeyCombi(otherKey, 0)));
+
+    // sent to an unregistered address
+    CBaseCoinTransferTx toAddressTx(senderKey.GetPubKey(), receiverKey.GetPubKey().GetKeyId(), 100, COIN, 10000, "");
+    BOOST_CHECK(senderWallet.IsMine(&toAddressTx));
+    BOOST_CHECK(receiverWallet.IsMine(&toAddressTx));
+    BOOST_CHECK(!otherWallet.IsMine(&toAddressTx));
+
+    // sent to a regid not registered, the sender still finds its own tx
+    CBaseCoinTransferTx toRegIdTx(senderKey.GetPubKey(), CRegID(1000000, 1), 100, COIN, 10000, "");
+    BOOST_CHECK(senderWallet.IsMine(&toRegIdTx));
+    BOOST_CHECK(!otherWallet.IsMine(&toRegIdTx));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1025,6 +1025,69 @@ int32_t ExIntegerToByte8Func(lua_State *L) {
     vector<uint8_t> TMP(tep.begin(), tep.end());
     return RetRstToLua(L, TMP);
 }
+// get the bytes [pos, pos + size) of the string at stack index 1 in place, pos starting from 1 as string.sub()
+static const uint8_t *GetStrRange(lua_State *L, lua_Integer &size) {
+    if (lua_type(L, 1) != LUA_TSTRING || !lua_isinteger(L, 2) || !lua_isinteger(L, 3))
+        return nullptr;
+
+    size_t len       = 0;
+    const char *pStr = lua_tolstring(L, 1, &len);
+    lua_Integer pos  = lua_tointeger(L, 2);
+    size             = lua_tointeger(L, 3);
+    if (pos < 1 || size < 0 || (size_t)(pos - 1) > len || (size_t)size > len - (pos - 1))
+        return nullptr;
+
+    return (const uint8_t *)pStr + (pos - 1);
+}
+
+/**
+ * integer mylib.StrToInteger(str, pos, size)
+ * read the little-endian integer of 1, 2, 4 or 8 bytes at pos of str, e.g. the contract arguments of a
+ * LUA_VM_STR contract, without unpacking str into a byte table for ByteToInteger().
+ * The 8 bytes integer is signed and the others are unsigned, as ByteToInteger().
+ */
+int32_t ExStrToIntegerFunc(lua_State *L) {
+    lua_Integer size     = 0;
+    const uint8_t *pData = GetStrRange(L, size);
+    if (pData == nullptr || (size != 1 && size != 2 && size != 4 && size != 8)) {
+        return RetFalse("ExStrToIntegerFunc para err1");
+    }
+
+    LUA_BurnFuncCall(L, FUEL_CALL_StrToInteger, BURN_VER_R2);
+    uint64_t value = 0;
+    for (lua_Integer i = size - 1; i >= 0; i--) {
+        value = (value << 8) | pData[i];
+    }
+
+    if (lua_checkstack(L, sizeof(lua_Integer))) {
+        lua_pushinteger(L, (lua_Integer)value);
+        return 1;
+    } else {
+        return RetFalse("ExStrToIntegerFunc stack overflow");
+    }
+}
+
+/**
+ * byte... mylib.StrToBytes(str, pos, size)
+ * return the size bytes at pos of str as the byte values taken by the other mylib functions.
+ */
+int32_t ExStrToBytesFunc(lua_State *L) {
+    lua_Integer size     = 0;
+    const uint8_t *pData = GetStrRange(L, size);
+    if (pData == nullptr || size <= 0 || size > LUA_C_BUFFER_SIZE) {
+        return RetFalse("ExStrToBytesFunc para err1");
+    }
+
+    LUA_BurnFuncData(L, FUEL_CALL_StrToBytes, size, 1, FUEL_DATA1_StrToBytes, BURN_VER_R2);
+    if (!lua_checkstack(L, size)) {
+        return RetFalse("ExStrToBytesFunc stack overflow");
+    }
+    for (lua_Integer i = 0; i < size; i++) {
+        lua_pushinteger(L, (lua_Integer)pData[i]);
+    }
+    return size;
+}
+
 /**
  *uint16_t GetAccountPublickey(const void* const accountId,void * const pubkey,const uint16_t maxlength)
  * 这个函数式从中间层传了一个参数过来:
@@ -2452,6 +2515,15 @@ static const luaL_Reg mylib[] = {
 
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// new function add in the feature fork v3, for the contracts of LUA_VM_STR
+static const luaL_Reg mylibV3[] = {
+    {"StrToInteger",                ExStrToIntegerFunc},
+    {"StrToBytes",                  ExStrToBytesFunc},
+
+    {nullptr, nullptr}
+};
+
 // replace all global(in the _G) functions
 static const luaL_Reg baseLibsEx[] = {
     {"print",                       ExLuaPrint},        // replace default print function
@@ -2479,3 +2551,15 @@ bool InitLuaLibsEx(lua_State *L) {
     lua_pop(L, 1);  // pop the global table
     return true;
 }
+
+bool InitLuaLibsV3(lua_State *L) {
+    // the mylib returned by require "mylib", also the global mylib
+    lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
+    if (lua_getfield(L, -1, "mylib") != LUA_TTABLE) {
+        lua_pop(L, 2);
+        return false;
+    }
+    luaL_setfuncs(L, mylibV3, 0);
+    lua_pop(L, 2);  // pop the mylib and _LOADED tables
+    return true;
+}
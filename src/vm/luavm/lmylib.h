@@ -94,6 +94,10 @@ int32_t ExIntegerToByte4Func(lua_State *L);
 
 int32_t ExIntegerToByte8Func(lua_State *L);
 
+int32_t ExStrToIntegerFunc(lua_State *L);
+
+int32_t ExStrToBytesFunc(lua_State *L);
+
 /**
  *unsigned short GetAccountPublickey(const void* const accounid,void * const pubkey,const unsigned short maxlength)
  * 这个函数式从中间层传了一个参数过来:
@@ -91,6 +91,10 @@ typedef int lua_burner_version;
 #define FUEL_CALL_GetTxContract         200
 #define FUEL_DATA32_GetTxContract       3
 
+#define FUEL_CALL_StrToInteger          4
+#define FUEL_CALL_StrToBytes            4
+#define FUEL_DATA1_StrToBytes           1
+
 #define FUEL_CALL_DesBasic              50
 #define FUEL_DATA8_DesBasic             2
 #define FUEL_CALL_DesTriple             140
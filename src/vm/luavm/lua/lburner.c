@@ -155,6 +155,12 @@ LUA_API int lua_StartBurner(lua_State *L, unsigned long long fuelLimit, int vers
     return 1;
 }
 
+LUA_API void lua_StopBurner(lua_State *L) {
+    L->burnerState.isStarted        = 0;
+    L->burnerState.error            = 0;
+    L->burnerState.tracer           = NULL;
+}
+
 lua_burner_state *lua_GetBurnerState(lua_State *L) {
     if (IsBurnerStarted(L)) {
         return &L->burnerState;
@@ -38,6 +38,11 @@ typedef struct lua_burner_state lua_burner_state;
  */
 int lua_StartBurner(lua_State *L, unsigned long long  fuelLimit, int version);
 
+/**
+ * stop burner, so that the burner can be started again when the lua state is reused
+ */
+LUA_API void lua_StopBurner(lua_State *L);
+
 lua_burner_state* lua_GetBurnerState(lua_State *L);
 
 /**
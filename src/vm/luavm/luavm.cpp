@@ -17,6 +17,7 @@
 #include "main.h"
 #include "tx/tx.h"
 #include "luavmrunenv.h"
+#include "luavmcache.h"
 
 #if 0
 typedef struct NumArray{
@@ -127,8 +128,9 @@ static int luaopen_array(lua_State *L){
 
 #endif
 
-CLuaVM::CLuaVM(const std::string &codeIn, const std::string &argumentsIn):
-    code(codeIn), arguments(argumentsIn) {
+CLuaVM::CLuaVM(const std::string &codeIn, const std::string &argumentsIn, const std::string &contractKeyIn,
+               bool fStrArgumentsIn):
+    code(codeIn), arguments(argumentsIn), contractKey(contractKeyIn), fStrArguments(fStrArgumentsIn) {
     assert(code.size() <= MAX_CONTRACT_CODE_SIZE);
     assert(arguments.size() <= MAX_CONTRACT_ARGUMENT_SIZE);
 }
@@ -142,6 +144,7 @@ LUAMOD_API int luaopen_mylib(lua_State *L);
 #endif
 
 bool InitLuaLibsEx(lua_State *L);
+bool InitLuaLibsV3(lua_State *L);
 
 /** ommited lua lib for safety reasons
  *
@@ -244,6 +247,10 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
         return std::make_tuple(-1, string("pVmRunEnv == NULL"));
     }
 
+    int32_t burnVersion = pVmRunEnv->GetBurnVersion();
+    // load the compiled chunk of the contract from the cache, the state is always a new one
+    const bool fCached = !contractKey.empty() && luaVMCache.IsUsable(burnVersion);
+
     // 1.创建Lua运行环境
     std::unique_ptr<lua_State, decltype(&lua_close)> lua_state_ptr(luaL_newstate(), &lua_close);
     if (!lua_state_ptr) {
@@ -253,7 +260,7 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
     lua_State *lua_state = lua_state_ptr.get();
 
     //TODO: should get burner version from the block height
-    if (!lua_StartBurner(lua_state, fuelLimit, pVmRunEnv->GetBurnVersion())) {
+    if (!lua_StartBurner(lua_state, fuelLimit, burnVersion)) {
         LogPrint("vm", "CLuaVM::Run lua_StartBurner() failed\n");
         return std::make_tuple(-1, string("CLuaVM::Run lua_StartBurner() failed\n"));
     }
@@ -269,14 +276,24 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
     // 3.注册自定义模块
     luaL_requiref(lua_state, "mylib", luaopen_mylib, 1);
 
+    if (IsFeatureForkV3(pVmRunEnv->GetConfirmHeight()) && !InitLuaLibsV3(lua_state)) {
+        LogPrint("vm", "InitLuaLibsV3 error\n");
+        return std::make_tuple(-1, string("InitLuaLibsV3 error\n"));
+    }
+
     // 4.往lua脚本传递合约内容
-    lua_newtable(lua_state);  //新建一个表,压入栈顶
-    lua_pushnumber(lua_state, -1);
-    lua_rawseti(lua_state, -2, 0);
+    if (fStrArguments) {
+        // one immutable string, read in place by mylib.StrToInteger() and mylib.StrToBytes()
+        lua_pushlstring(lua_state, arguments.data(), arguments.size());
+    } else {
+        lua_newtable(lua_state);  //新建一个表,压入栈顶
+        lua_pushnumber(lua_state, -1);
+        lua_rawseti(lua_state, -2, 0);
 
-    for (size_t i = 0; i < arguments.size(); i++) {
-        lua_pushinteger(lua_state, (uint8_t)arguments[i]);  // value值放入
-        lua_rawseti(lua_state, -2, i + 1);                         // set table at key 'n + 1'
+        for (size_t i = 0; i < arguments.size(); i++) {
+            lua_pushinteger(lua_state, (uint8_t)arguments[i]);  // value值放入
+            lua_rawseti(lua_state, -2, i + 1);                         // set table at key 'n + 1'
+        }
     }
     lua_setglobal(lua_state, "contract");
 
@@ -287,7 +304,8 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
 
     // 5. Load the contract script
     std::string strError;
-    int luaStatus = luaL_loadbuffer(lua_state, code.c_str(), code.size(), "line");
+    int luaStatus = fCached ? luaVMCache.LoadChunk(lua_state, contractKey, code)
+                            : luaL_loadbuffer(lua_state, code.c_str(), code.size(), "line");
     if (luaStatus == LUA_OK) {
         luaStatus = lua_pcallk(lua_state, 0, 0, 0, 0, NULL, BURN_VER_STEP_V1);
         if (luaStatus != LUA_OK) {
@@ -19,7 +19,8 @@ class CLuaVMRunEnv;
 
 class CLuaVM {
 public:
-    CLuaVM(const std::string &code, const std::string &arguments);
+    CLuaVM(const std::string &code, const std::string &arguments, const std::string &contractKey = "",
+           bool fStrArguments = false);
     ~CLuaVM();
 
     std::tuple<uint64_t, string> Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv);
@@ -29,6 +30,8 @@ private:
     // to hold contract call arguments
     std::string code;
     std::string arguments;
+    std::string contractKey;  // key of the compiled code in luaVMCache, not cached if empty
+    bool fStrArguments;       // pass the arguments as one string instead of a byte table
 };
 
 #endif  // LUA_VM_H
@@ -0,0 +1,91 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "luavmcache.h"
+#include "lua/lua.hpp"
+
+#include "config/const.h"
+#include "commons/util.h"
+
+CLuaVMCache luaVMCache(DEFAULT_LUAVM_CACHE_SIZE);
+
+static int32_t WriteChunk(lua_State *L, const void *p, size_t sz, void *ud) {
+    static_cast<string *>(ud)->append(static_cast<const char *>(p), sz);
+    return 0;
+}
+
+void CLuaVMCache::SetMaxChunks(uint32_t maxChunksIn) {
+    std::lock_guard<std::mutex> lock(mtx);
+    maxChunks = maxChunksIn;
+    while (chunks.size() > maxChunks) {
+        chunks.erase(lruKeys.back());
+        lruKeys.pop_back();
+    }
+}
+
+bool CLuaVMCache::IsUsable(int32_t burnVersion) const {
+    return IsEnabled() && burnVersion < BURN_VER_R2;
+}
+
+int32_t CLuaVMCache::LoadChunk(lua_State *L, const string &contractKey, const string &code) {
+    std::shared_ptr<const string> pBytecode;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = chunks.find(contractKey);
+        // the code of an upgraded contract differs from the cached one
+        if (it != chunks.end() && it->second.code == code) {
+            lruKeys.splice(lruKeys.begin(), lruKeys, it->second.lruIt);
+            pBytecode = it->second.pBytecode;
+            ++stats.chunkHits;
+        } else {
+            ++stats.chunkMisses;
+        }
+    }
+
+    if (pBytecode)
+        return luaL_loadbufferx(L, pBytecode->data(), pBytecode->size(), "line", "b");
+
+    int32_t status = luaL_loadbuffer(L, code.c_str(), code.size(), "line");
+    if (status == LUA_OK) {
+        auto pNewBytecode = std::make_shared<string>();
+        if (lua_dump(L, WriteChunk, pNewBytecode.get(), 0) == 0)
+            AddChunk(contractKey, code, pNewBytecode);
+    }
+    return status;
+}
+
+void CLuaVMCache::AddChunk(const string &contractKey, const string &code,
+                           const std::shared_ptr<const string> &pBytecode) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (maxChunks == 0)
+        return;
+
+    auto it = chunks.find(contractKey);
+    if (it == chunks.end()) {
+        if (chunks.size() >= maxChunks) {
+            chunks.erase(lruKeys.back());
+            lruKeys.pop_back();
+        }
+        lruKeys.push_front(contractKey);
+        it = chunks.emplace(contractKey, CChunk()).first;
+        it->second.lruIt = lruKeys.begin();
+    } else {
+        lruKeys.splice(lruKeys.begin(), lruKeys, it->second.lruIt);
+    }
+    it->second.code      = code;
+    it->second.pBytecode = pBytecode;
+}
+
+void CLuaVMCache::GetStats(CLuaVMCacheStats &statsOut) {
+    std::lock_guard<std::mutex> lock(mtx);
+    statsOut            = stats;
+    statsOut.chunkCount = chunks.size();
+}
+
+void CLuaVMCache::Clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    chunks.clear();
+    lruKeys.clear();
+    stats = CLuaVMCacheStats();
+}
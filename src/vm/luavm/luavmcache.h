@@ -0,0 +1,73 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LUA_VM_CACHE_H
+#define LUA_VM_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+struct lua_State;
+
+struct CLuaVMCacheStats {
+    uint64_t chunkCount  = 0;
+    uint64_t chunkHits   = 0;
+    uint64_t chunkMisses = 0;
+};
+
+/**
+ * The compiled chunks of the contracts, cached per contract regid in an LRU. Every call still runs in a new
+ * lua state with the libs opened, since a reused state could be told apart by the contract through its globals.
+ *
+ * Since BURN_VER_R2 the burner charges every memory allocation of the lua state, including the parsing of the
+ * contract, and the allocations of a loaded chunk differ, so the cache is only used by the burner versions which
+ * charge the executed steps only.
+ */
+class CLuaVMCache {
+public:
+    CLuaVMCache(uint32_t maxChunksIn = 0) : maxChunks(maxChunksIn) {}
+    ~CLuaVMCache() { Clear(); }
+
+    /** Cache the compiled code of up to maxChunksIn contracts, 0 disables the cache. */
+    void SetMaxChunks(uint32_t maxChunksIn);
+    bool IsEnabled() const { return maxChunks > 0; }
+    /** Whether the burner version burns the same fuel with the cached chunks. */
+    bool IsUsable(int32_t burnVersion) const;
+
+    /**
+     * Push the compiled chunk of the contract onto the stack of L, compiling and caching the code on miss,
+     * return the status of lua_load().
+     */
+    int32_t LoadChunk(lua_State *L, const string &contractKey, const string &code);
+
+    void GetStats(CLuaVMCacheStats &statsOut);
+    /** Drop the cached chunks and reset the stats. */
+    void Clear();
+
+private:
+    struct CChunk {
+        string code;
+        std::shared_ptr<const string> pBytecode;
+        list<string>::iterator lruIt;
+    };
+
+    void AddChunk(const string &contractKey, const string &code, const std::shared_ptr<const string> &pBytecode);
+
+private:
+    std::mutex mtx;
+    uint32_t maxChunks;
+    unordered_map<string, CChunk> chunks;
+    list<string> lruKeys;  // the most recently used first
+    CLuaVMCacheStats stats;
+};
+
+extern CLuaVMCache luaVMCache;
+
+#endif  // LUA_VM_CACHE_H
@@ -33,7 +33,9 @@ std::shared_ptr<string>  CLuaVMRunEnv::ExecuteContract(CLuaVMContext *pContextIn
     assert(p_context->p_arguments->size() <= MAX_CONTRACT_ARGUMENT_SIZE);
     assert(p_context->fuel_limit > 0);
 
-    pLua = std::make_shared<CLuaVM>(p_context->p_contract->code, *p_context->p_arguments);
+    pLua = std::make_shared<CLuaVM>(p_context->p_contract->code, *p_context->p_arguments,
+                                    p_context->p_app_account->regid.ToRawString(),
+                                    p_context->p_contract->IsStrArguments(p_context->height));
 
     LogPrint("vm", "CVmScriptRun::ExecuteContract(), prepare to execute tx. txid=%s, fuelLimit=%llu\n", p_context->p_base_tx->GetHash().GetHex(),
         p_context->fuel_limit);
@@ -22,6 +22,7 @@
 #include "net.h"
 #include "persistence/accountdb.h"
 #include "persistence/contractdb.h"
+#include "tx/txadmission.h"
 
 using namespace json_spirit;
 using namespace boost::assign;
@@ -208,6 +209,15 @@ void CWallet::ResendWalletTransactions() {
 
 //// Call after CreateTransaction unless you want to abort
 std::tuple<bool, string> CWallet::CommitTx(CBaseTx *pTx) {
+    {
+        // verify the signature before taking cs_main
+        CValidationState state;
+        if (!txAdmissionQueue.PreCheck(pTx, state)) {
+            LogPrint("INFO", "CommitTx() : invalid transaction %s\n", state.GetRejectReason());
+            return std::make_tuple(false, state.GetRejectReason());
+        }
+    }
+
     LOCK2(cs_main, cs_wallet);
     LogPrint("INFO", "CommitTx() : %s\n", pTx->ToString(*pCdMan->pAccountCache));
 
@@ -451,7 +461,10 @@ bool CWallet::IsMine(CBaseTx *pTx) const {
 
     set<CKeyID> keyIds;
     if (!pTx->GetInvolvedKeyIds(*spCW, keyIds)) {
-        return false;
+        // the receiver or the app may not resolve, e.g. an unregistered regid, the sender still does
+        keyIds.clear();
+        if (!pTx->CBaseTx::GetInvolvedKeyIds(*spCW, keyIds))
+            return false;
     }
 
     for (auto &keyid : keyIds) {